@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Contact.h"
+
+// ======================================================
+//   AddressIndex
+//   Inverted index over address tokens with BM25 ranking.
+//   - tokens: runs of ASCII letters/digits (lower-cased) and non-ASCII
+//     bytes, so "Grazhdanski pr., 28-A" -> grazhdanski pr 28 a
+//   - every term keeps a posting list sorted by contact id; a query
+//     walks the lists of its terms together, one contact at a time, and
+//     keeps the k best in a min-heap
+//   - the last query token also matches longer terms ("grazhd" finds
+//     "grazhdanski"), as in search-as-you-type
+//   add()/remove() keep it current: remove() takes the text add() got,
+//   and an updated address is removed before the new one is added.
+// ======================================================
+
+class AddressIndex {
+public:
+    struct Hit {
+        ContactId id;
+        double score;
+    };
+
+    void add(ContactId id, std::string_view address);
+    void remove(ContactId id, std::string_view address);
+    void clear();
+
+    // At most k hits, best first (ties by id). A contact needs only one
+    // of the query terms to be a hit.
+    std::vector<Hit> search(std::string_view query, std::size_t k) const;
+
+    // Contacts holding every query token (the last one as a prefix, with
+    // no limit on its expansion), ascending. estimate() bounds the number
+    // from the posting list sizes without walking them; score() is the
+    // BM25 score search() would give `id`.
+    std::vector<ContactId> matching(std::string_view query) const;
+    std::size_t estimate(std::string_view query) const;
+    double score(std::string_view query, ContactId id) const;
+
+    std::size_t documents() const { return m_documents; }
+    std::size_t terms() const { return m_postings.size(); }
+
+    static std::vector<std::string> tokenize(std::string_view text);
+
+private:
+    struct Posting {
+        ContactId id;
+        std::uint16_t frequency;   // of the term in this address
+        std::uint16_t length;      // tokens in this address
+    };
+
+    using Postings = std::map<std::string, std::vector<Posting>, std::less<>>;
+    using Term = Postings::value_type;
+
+    // Ordered, so the prefix of the last query token is a range.
+    Postings m_postings;
+    std::size_t m_documents = 0;
+    std::uint64_t m_totalLength = 0;
+
+    // Terms search() and score() use for the query, without duplicates.
+    std::vector<const Term*> queryTerms(std::string_view query) const;
+    double idf(const Term& term) const;
+    double weight(const Posting& posting, double idf) const;
+};
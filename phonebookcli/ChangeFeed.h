@@ -0,0 +1,90 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "UndoLog.h"
+
+// ======================================================
+//   ChangeFeed
+//   Typed change events for consumers that keep their own view of the
+//   book (tables, caches, exporters) and want to follow it in O(change)
+//   instead of re-reading it:
+//   - Inserted / Removed: the contact with `id` appeared / is gone
+//   - Updated: `fields` (a fieldBit() mask) of contact `id` changed
+//   - Reset: the whole book was replaced (load); re-read everything
+//   Events are delivered synchronously, after the change is applied to
+//   the book and its indexes. A batch delivers its events at commit, one
+//   per contact it changed; a rolled-back batch delivers none. Undo and
+//   redo deliver the events of the changes they make.
+//   Listeners may unsubscribe (themselves or others) while being called.
+// ======================================================
+
+constexpr std::uint16_t fieldBit(ContactField field)
+{
+    return static_cast<std::uint16_t>(1u << static_cast<unsigned>(field));
+}
+
+constexpr std::uint16_t kAllContactFields = (1u << kContactFieldCount) - 1;
+
+struct ContactChange {
+    enum class Kind : std::uint8_t { Inserted, Updated, Removed, Reset };
+    Kind kind;
+    ContactId id;
+    std::uint16_t fields;   // Updated: the changed fields; else every field
+
+    bool touches(ContactField field) const { return (fields & fieldBit(field)) != 0; }
+};
+
+class ChangeFeed {
+public:
+    using Listener = std::function<void(const ContactChange& change)>;
+
+    // Returns a token for unsubscribe(), never 0.
+    unsigned int subscribe(Listener listener) {
+        // Not into m_listeners while it is being walked.
+        (m_depth == 0 ? m_listeners : m_joining).push_back(Entry{ m_nextToken, std::move(listener), true });
+        return m_nextToken++;
+    }
+
+    void unsubscribe(unsigned int token) {
+        for (std::vector<Entry>* list : { &m_listeners, &m_joining }) {
+            for (Entry& entry : *list) {
+                if (entry.token == token) entry.live = false;
+            }
+        }
+        if (m_depth == 0) compact();
+    }
+
+    bool empty() const { return m_listeners.empty() && m_joining.empty(); }
+
+    void publish(const ContactChange& change) {
+        ++m_depth;
+        for (Entry& entry : m_listeners) {
+            if (entry.live) entry.listener(change);
+        }
+        if (--m_depth == 0) compact();
+    }
+
+private:
+    struct Entry {
+        unsigned int token;
+        Listener listener;
+        bool live;
+    };
+
+    void compact() {
+        for (Entry& entry : m_joining) m_listeners.push_back(std::move(entry));
+        m_joining.clear();
+        m_listeners.erase(std::remove_if(m_listeners.begin(), m_listeners.end(),
+                                         [](const Entry& entry) { return !entry.live; }),
+                          m_listeners.end());
+    }
+
+    std::vector<Entry> m_listeners;
+    std::vector<Entry> m_joining;   // subscribed during publish()
+    unsigned int m_nextToken = 1;
+    int m_depth = 0;
+};
@@ -1,9 +1,56 @@
 #pragma once
 #define _CRT_SECURE_NO_WARNINGS
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
+#include "Contact.h"
 
-bool isValidName(const std::string& rawName);
-bool isValidPhone(const std::string& rawPhone);
-bool isValidBirthday(const std::string& rawDate);   // dd-mm-yyyy
-bool isValidEmail(const std::string& rawEmail);
-std::string generateEmail(const std::string& firstName, const std::string& lastName);
\ No newline at end of file
+bool isValidName(std::string_view rawName);
+bool isValidPhone(std::string_view rawPhone);
+std::string normalizePhone(std::string_view rawPhone);   // "" if not a valid phone
+bool isValidBirthday(std::string_view rawDate);   // dd-mm-yyyy
+bool isValidEmail(std::string_view rawEmail);
+std::string emailDomain(std::string_view email);   // "A@Mail.RU" / "Mail.ru" -> "mail.ru"
+bool isValidAddress(std::string_view rawAddress);   // non-blank, single line
+std::string generateEmail(const std::string& firstName, const std::string& lastName);
+
+// ---------- BATCH VALIDATION ----------
+// One bit per failed rule; 0 means the record is valid. The rules are the
+// ones create_contact() applies: first/last name, email and at least one
+// phone are required; middle name, address and birthday are checked only
+// when present.
+namespace ContactError {
+enum : std::uint32_t {
+    FirstName   = 1u << 0,
+    LastName    = 1u << 1,
+    Email       = 1u << 2,
+    WorkPhone   = 1u << 3,
+    HomePhone   = 1u << 4,
+    OfficePhone = 1u << 5,
+    NoPhone     = 1u << 6,   // no valid phone at all
+    MiddleName  = 1u << 7,
+    Address     = 1u << 8,
+    Birthday    = 1u << 9,
+
+    Required = FirstName | LastName | Email | WorkPhone | HomePhone | OfficePhone | NoPhone
+};
+}
+
+// Field buffers for column-oriented imports, one entry per record.
+// A column may be left empty to mean "not supplied"; otherwise it must be
+// as long as firstName.
+struct ContactColumns {
+    std::vector<std::string_view> firstName, middleName, lastName;
+    std::vector<std::string_view> work, home, office;
+    std::vector<std::string_view> email, address, birthday;
+};
+
+std::uint32_t validateContact(const Contact& contact);
+// Checks field by field over blocks of records, split across
+// `threadCount` threads (0 = one per core). Returns one mask per record;
+// mismatched ContactColumns give an empty result.
+std::vector<std::uint32_t> validateContacts(const Contact* contacts, std::size_t count,
+                                            unsigned threadCount = 0);
+std::vector<std::uint32_t> validateContacts(const ContactColumns& columns,
+                                            unsigned threadCount = 0);
\ No newline at end of file
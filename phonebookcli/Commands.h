@@ -0,0 +1,47 @@
+#pragma once
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+class FrozenPhoneBook;
+class PhoneBook;
+
+// ======================================================
+//   Commands
+//   A line-oriented command language over PhoneBook, for scripts and
+//   other programs instead of the interactive menus:
+//     create first=Ivan last=Petrov work=+79161234567 email=ivan@mail
+//     get 12
+//     edit 12 email=petrov@mail home=
+//     delete 12
+//     search last:Petr* born:1990..2000      (query language, Query.h)
+//     list [id|first|last|email] [desc] [limit N] [after CURSOR]
+//   Assignments use the field names of the query language: first,
+//   middle, last, work, home, office, email, addr, born. A value with
+//   spaces is quoted: addr="Tverskaya 12"; an empty value clears the
+//   field.
+//
+//   Every command gets one response:
+//     ok <rows> [<cursor>]     then <rows> contact lines
+//     error <message>
+//   A contact line is tab-separated: id, then the nine fields in the
+//   order above, with tab, newline and backslash written as \t \n \\.
+//   create and edit answer with the stored contact, delete with no rows.
+//   list with a limit pages (Paging.h): the cursor, when present, is
+//   passed to `after` for the next page.
+// ======================================================
+
+// Runs one command, appending its response to *out. False if it failed.
+bool runCommand(PhoneBook& book, std::string_view line, std::string* out);
+
+// Answers one lookup in a frozen image (FrozenPhoneBook.h), in the same
+// response format: `email ADDRESS` or `phone NUMBER`, the phone in any
+// spelling of it. False if it failed.
+bool runFrozenCommand(const FrozenPhoneBook& book, std::string_view line, std::string* out);
+
+// Runs every line of `in` as a command, writing the responses to `out`.
+// Blank lines and lines starting with '#' are skipped. The commands run
+// as one batch: the book is saved once, after the last one, and only if
+// one of them changed it. A failed command is reported and the next one
+// runs. Returns false if a command failed or the save did (*error).
+bool runScript(PhoneBook& book, std::istream& in, std::ostream& out, std::string* error = nullptr);
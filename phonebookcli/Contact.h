@@ -1,14 +1,24 @@
 #pragma once
+#include <cstdint>
 #include <string>
 
+// The id a contact is known by everywhere (files, menus, the GUI). Ids
+// are issued in increasing order and never reused.
+using ContactId = std::uint64_t;
+
 struct Phone {
 	std::string number1;
 	std::string number2;
 	std::string number3;
+	// Arguments are moved into the members: pass temporaries (or
+	// std::move) to build a phone without copying its strings.
 	Phone(std::string number1 = "", std::string number2 = "", std::string number3 = "");
-	Phone(const Phone& phone);
+	Phone(const Phone& phone) = default;
+	Phone(Phone&& phone) noexcept = default;
+	Phone& operator=(const Phone& phone) = default;
+	Phone& operator=(Phone&& phone) noexcept = default;
 	void print_number()const;
-	~Phone();
+	~Phone() = default;
 };
 
 struct Contact {
@@ -21,13 +31,19 @@ public:
 	std::string address;
 	std::string birthday;
 public:
+	// As for Phone, the arguments are moved into the members.
 	Contact(std::string firstName ="", std::string middleName="", std::string lastName="",
 		 Phone numbers= {"","",""}, std::string email = "", std::string address = "", std::string birthday = "");
-	Contact(const Contact& contact);
-	~Contact();
+	// Moves are declared so that storage (rehashes, std::move into the
+	// book) moves contacts instead of copying them.
+	Contact(const Contact& contact) = default;
+	Contact(Contact&& contact) noexcept = default;
+	Contact& operator=(const Contact& contact) = default;
+	Contact& operator=(Contact&& contact) noexcept = default;
+	~Contact() = default;
 	void set_contact(std::string firstName, std::string middleName, std::string lastName,
 		Phone numbers, std::string email,std::string address , std::string birthday);
-	Contact get_contact();
+	const Contact& get_contact() const;
 	void print_contact()const;
 
 };
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include "Contact.h"
+
+// ======================================================
+//   ContactRecord
+//   The form a contact is stored in inside the book: all nine fields in
+//   one contiguous block, instead of nine std::string members.
+//   - the block is a small table of field end offsets followed by the
+//     field bytes: [width][end x 9][bytes]; offsets are 16-bit, or 32-bit
+//     for a record over 64 KiB
+//   - the record itself is two pointers (block, memory resource); an
+//     empty record holds no block at all
+//   - allocator-aware: in a PmrFlatHashMap the block comes from the
+//     map's memory resource, so a book's contacts are carved out of its
+//     arena like its index keys
+//   Fields are read through ContactView, whose members are named as in
+//   Contact (firstName, numbers.number1, ...) but are string_views into
+//   the block. A view is valid until the record is changed or destroyed.
+//   Changing a record re-encodes it as a whole.
+// ======================================================
+
+enum class ContactField : std::uint8_t {
+    FirstName, MiddleName, LastName, WorkPhone, HomePhone, OfficePhone,
+    Email, Address, Birthday
+};
+constexpr std::size_t kContactFieldCount = 9;
+
+std::string& contactField(Contact& contact, ContactField field);
+const std::string& contactField(const Contact& contact, ContactField field);
+
+class ContactRecord;
+
+struct PhoneView {
+    std::string_view number1;
+    std::string_view number2;
+    std::string_view number3;
+};
+
+struct ContactView {
+    std::string_view firstName;
+    std::string_view middleName;
+    std::string_view lastName;
+    PhoneView numbers;
+    std::string_view email;
+    std::string_view address;
+    std::string_view birthday;
+
+    ContactView() = default;
+    // Implicit, so code reading fields takes a Contact or a stored record.
+    ContactView(const Contact& contact);
+    ContactView(const ContactRecord& record);
+
+    std::string_view field(ContactField field) const;
+    Contact to_contact() const;
+    void print_contact() const;
+    // All nine fields equal.
+    bool same_fields(const ContactView& other) const;
+};
+
+class ContactRecord {
+public:
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    ContactRecord() noexcept : m_resource(std::pmr::get_default_resource()) {}
+    explicit ContactRecord(const allocator_type& alloc) noexcept : m_resource(alloc.resource()) {}
+    ContactRecord(const ContactView& contact, const allocator_type& alloc = {});
+    ContactRecord(const ContactRecord& other, const allocator_type& alloc = {});
+    ContactRecord(ContactRecord&& other) noexcept;
+    ContactRecord(ContactRecord&& other, const allocator_type& alloc);
+    ContactRecord& operator=(const ContactRecord& other);
+    ContactRecord& operator=(ContactRecord&& other);
+    ContactRecord& operator=(const ContactView& contact);
+    ~ContactRecord();
+
+    allocator_type get_allocator() const { return allocator_type(m_resource); }
+
+    std::string_view field(ContactField field) const;
+    ContactView view() const { return ContactView(*this); }
+    Contact to_contact() const { return view().to_contact(); }
+    void print_contact() const { view().print_contact(); }
+
+    // Size of the block (0 for an empty record).
+    std::size_t block_size() const;
+
+private:
+    void assign(const ContactView& contact);
+    void release();
+
+    unsigned char* m_block = nullptr;
+    std::pmr::memory_resource* m_resource;
+};
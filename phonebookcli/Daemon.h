@@ -0,0 +1,44 @@
+#pragma once
+#include <iosfwd>
+#include <string>
+
+// ======================================================
+//   Daemon (Linux only)
+//   A long-lived process that keeps one PhoneBook in memory and serves
+//   the commands of Commands.h over a Unix domain socket, so a tool
+//   pays for one round trip instead of a process start and a full load.
+//   - protocol: frames of <uint32 length, little-endian><payload>. A
+//     request payload is one command line; its response payload is the
+//     command's response text (ok/error line and contact lines)
+//   - pipelining: a client may send any number of requests without
+//     waiting; responses come back in request order
+//   - one thread, non-blocking sockets, one epoll loop. A client that
+//     does not read its responses stops being read from (its pending
+//     output is bounded) instead of growing the daemon's memory
+//   - saving: the book is saved at most once per flush interval after
+//     a change (group commit), and on SIGINT/SIGTERM. A crash loses at
+//     most the last interval of acknowledged changes
+// ======================================================
+
+#ifdef __linux__
+
+struct DaemonOptions {
+    std::string socketPath = "phonebook.sock";
+    std::string dbFile = "phonebook.db";
+    int flushMs = 1000;
+};
+
+// Serves until SIGINT or SIGTERM. False, with *error set, if the socket
+// could not be set up (another daemon already listening included). The
+// signals are blocked in the calling thread; a program with other threads
+// blocks them there too, before starting them.
+bool runDaemon(const DaemonOptions& options, std::string* error = nullptr);
+
+// Thin client: sends every line of `in` (blank and '#' lines skipped) as
+// a request, pipelined, and writes the responses to `out` in order.
+// False if the daemon could not be reached, the connection broke, or a
+// response was an error.
+bool runClient(const std::string& socketPath, std::istream& in, std::ostream& out,
+               std::string* error = nullptr);
+
+#endif
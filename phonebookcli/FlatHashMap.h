@@ -0,0 +1,630 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PHONEBOOK_FLATMAP_SSE2 1
+#endif
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+// ======================================================
+//   FlatHashMap
+//   Open-addressing hash table in the "Swiss table" style:
+//   - one control byte per slot (7 bits of hash, or EMPTY / DELETED)
+//   - slots are probed 16 at a time with SSE2 (portable fallback)
+//   - values are stored inline, no node allocation per entry
+//   - string keys can be looked up with std::string_view / const char*
+//     without building a temporary std::string
+//   - allocator-aware: with std::pmr::polymorphic_allocator the table
+//     and any pmr keys/values come from the same memory_resource
+//
+//   Interface follows the subset of std::unordered_map used by PhoneBook.
+//   Keys must not be modified through iterators.
+// ======================================================
+
+namespace flat_detail {
+
+// ---------- HASHING ----------
+
+inline std::uint64_t mulFold(std::uint64_t a, std::uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    const __uint128_t r = static_cast<__uint128_t>(a) * b;
+    return static_cast<std::uint64_t>(r) ^ static_cast<std::uint64_t>(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    std::uint64_t hi = 0;
+    const std::uint64_t lo = _umul128(a, b, &hi);
+    return lo ^ hi;
+#else
+    // Portable 64x64 -> 128 multiply.
+    const std::uint64_t aLo = a & 0xFFFFFFFFu, aHi = a >> 32;
+    const std::uint64_t bLo = b & 0xFFFFFFFFu, bHi = b >> 32;
+    const std::uint64_t ll = aLo * bLo, lh = aLo * bHi, hl = aHi * bLo, hh = aHi * bHi;
+    const std::uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFFu) + (hl & 0xFFFFFFFFu);
+    const std::uint64_t lo = (ll & 0xFFFFFFFFu) | (mid << 32);
+    const std::uint64_t hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    return lo ^ hi;
+#endif
+}
+
+inline std::uint64_t read64(const unsigned char* p) {
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline std::uint64_t read32(const unsigned char* p) {
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+constexpr std::uint64_t kSeed0 = 0xa0761d6478bd642full;
+constexpr std::uint64_t kSeed1 = 0xe7037ed1a0b428dbull;
+constexpr std::uint64_t kSeed2 = 0x8ebc6af09c88c6e3ull;
+
+// wyhash-style byte hash: 8 bytes per step, short inputs read without a loop.
+inline std::uint64_t hashBytes(const void* data, std::size_t len) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    std::uint64_t seed = kSeed0 ^ (len * kSeed2);
+    std::uint64_t a = 0, b = 0;
+
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (read32(p) << 32) | read32(p + ((len >> 3) << 2));
+            b = (read32(p + len - 4) << 32) | read32(p + len - 4 - ((len >> 3) << 2));
+        }
+        else if (len > 0) {
+            a = (static_cast<std::uint64_t>(p[0]) << 16) |
+                (static_cast<std::uint64_t>(p[len >> 1]) << 8) |
+                p[len - 1];
+        }
+    }
+    else {
+        std::size_t i = len;
+        while (i > 16) {
+            seed = mulFold(read64(p) ^ kSeed1, read64(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        a = read64(p + i - 16);
+        b = read64(p + i - 8);
+    }
+    return mulFold(kSeed1 ^ len, mulFold(a ^ kSeed1, b ^ seed));
+}
+
+inline std::uint64_t hashInt(std::uint64_t x) {
+    return mulFold(x ^ kSeed0, kSeed1);
+}
+
+// ---------- CONTROL BYTES ----------
+
+using ctrl_t = signed char;
+constexpr ctrl_t kEmpty = -128;   // 0b10000000
+constexpr ctrl_t kDeleted = -2;   // 0b11111110
+constexpr std::size_t kGroupWidth = 16;
+
+inline bool isFull(ctrl_t c) { return c >= 0; }
+
+struct alignas(kGroupWidth) CtrlGroup {
+    ctrl_t bytes[kGroupWidth];
+};
+
+// One probe window of 16 control bytes; every match returns a bit mask
+// where bit i corresponds to slot i of the group.
+struct Group {
+#ifdef PHONEBOOK_FLATMAP_SSE2
+    __m128i ctrl;
+    explicit Group(const ctrl_t* p)
+        : ctrl(_mm_load_si128(reinterpret_cast<const __m128i*>(p))) {}
+
+    std::uint32_t match(ctrl_t h2) const {
+        return static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl)));
+    }
+    std::uint32_t matchEmpty() const { return match(kEmpty); }
+    // EMPTY and DELETED both have the sign bit set.
+    std::uint32_t matchFree() const {
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl));
+    }
+#else
+    const ctrl_t* ctrl;
+    explicit Group(const ctrl_t* p) : ctrl(p) {}
+
+    std::uint32_t match(ctrl_t h2) const {
+        std::uint32_t m = 0;
+        for (std::size_t i = 0; i < kGroupWidth; ++i) {
+            if (ctrl[i] == h2) m |= (1u << i);
+        }
+        return m;
+    }
+    std::uint32_t matchEmpty() const { return match(kEmpty); }
+    std::uint32_t matchFree() const {
+        std::uint32_t m = 0;
+        for (std::size_t i = 0; i < kGroupWidth; ++i) {
+            if (ctrl[i] < 0) m |= (1u << i);
+        }
+        return m;
+    }
+#endif
+};
+
+inline unsigned lowestBit(std::uint32_t m) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctz(m));
+#else
+    unsigned i = 0;
+    while (!(m & 1u)) { m >>= 1; ++i; }
+    return i;
+#endif
+}
+
+} // namespace flat_detail
+
+// ---------- DEFAULT HASH / EQUALITY ----------
+// Transparent for strings: std::string, std::string_view and const char*
+// all hash the same bytes, so lookups never need a temporary std::string.
+struct FlatHash {
+    using is_transparent = void;
+
+    std::size_t operator()(std::string_view s) const {
+        return static_cast<std::size_t>(flat_detail::hashBytes(s.data(), s.size()));
+    }
+    std::size_t operator()(const std::string& s) const {
+        return (*this)(std::string_view(s));
+    }
+    std::size_t operator()(const char* s) const {
+        return (*this)(std::string_view(s));
+    }
+
+    template <class T, class = std::enable_if_t<std::is_integral<T>::value>>
+    std::size_t operator()(T x) const {
+        return static_cast<std::size_t>(flat_detail::hashInt(static_cast<std::uint64_t>(x)));
+    }
+};
+
+struct FlatEqual {
+    using is_transparent = void;
+
+    template <class A, class B>
+    bool operator()(const A& a, const B& b) const { return eq(a, b, 0); }
+
+private:
+    // String-like keys compare as std::string_view, so std::string and
+    // std::pmr::string (different allocators) can be mixed freely.
+    template <class A, class B>
+    static auto eq(const A& a, const B& b, int)
+        -> decltype(std::string_view(a), std::string_view(b), bool()) {
+        return std::string_view(a) == std::string_view(b);
+    }
+    template <class A, class B>
+    static bool eq(const A& a, const B& b, long) { return a == b; }
+};
+
+// ======================================================
+//                    FlatHashMap
+// ======================================================
+template <class Key, class Value, class Hash = FlatHash, class KeyEqual = FlatEqual,
+          class Allocator = std::allocator<std::pair<Key, Value>>>
+class FlatHashMap {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<Key, Value>;
+    using size_type = std::size_t;
+    using allocator_type = Allocator;
+
+private:
+    using ctrl_t = flat_detail::ctrl_t;
+    using CtrlGroup = flat_detail::CtrlGroup;
+    using Group = flat_detail::Group;
+    static constexpr std::size_t kGroupWidth = flat_detail::kGroupWidth;
+
+    using SlotAlloc = typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>;
+    using SlotTraits = std::allocator_traits<SlotAlloc>;
+    using CtrlAlloc = typename std::allocator_traits<Allocator>::template rebind_alloc<CtrlGroup>;
+    using CtrlTraits = std::allocator_traits<CtrlAlloc>;
+
+    template <bool IsConst>
+    class Iter {
+        friend class FlatHashMap;
+        using MapPtr = std::conditional_t<IsConst, const FlatHashMap*, FlatHashMap*>;
+
+        MapPtr map_ = nullptr;
+        std::size_t pos_ = 0;
+
+        Iter(MapPtr map, std::size_t pos) : map_(map), pos_(pos) { skipFree(); }
+
+        void skipFree() {
+            while (pos_ < map_->capacity_ && !flat_detail::isFull(map_->ctrl_[pos_])) ++pos_;
+        }
+
+    public:
+        using value_type = typename FlatHashMap::value_type;
+        using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+        using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::forward_iterator_tag;
+
+        Iter() = default;
+        template <bool C = IsConst, class = std::enable_if_t<C>>
+        Iter(const Iter<false>& other) : map_(other.map_), pos_(other.pos_) {}
+
+        reference operator*() const { return map_->slots_[pos_]; }
+        pointer operator->() const { return &map_->slots_[pos_]; }
+
+        Iter& operator++() { ++pos_; skipFree(); return *this; }
+        Iter operator++(int) { Iter tmp = *this; ++*this; return tmp; }
+
+        friend bool operator==(const Iter& a, const Iter& b) { return a.pos_ == b.pos_; }
+        friend bool operator!=(const Iter& a, const Iter& b) { return a.pos_ != b.pos_; }
+
+        template <bool> friend class Iter;
+    };
+
+public:
+    using iterator = Iter<false>;
+    using const_iterator = Iter<true>;
+
+    FlatHashMap() = default;
+
+    explicit FlatHashMap(const allocator_type& alloc) : alloc_(alloc) {}
+
+    FlatHashMap(const FlatHashMap& other)
+        : FlatHashMap(other,
+            std::allocator_traits<Allocator>::select_on_container_copy_construction(other.alloc_)) {}
+
+    FlatHashMap(const FlatHashMap& other, const allocator_type& alloc) : alloc_(alloc) {
+        reserve(other.size_);
+        for (const auto& kv : other) insertUnique(kv.first, kv.second);
+    }
+
+    FlatHashMap(FlatHashMap&& other) noexcept : alloc_(other.alloc_) { swapStorage(other); }
+
+    FlatHashMap& operator=(const FlatHashMap& other) {
+        if (this != &other) {
+            FlatHashMap tmp(other, alloc_);
+            swapStorage(tmp);
+        }
+        return *this;
+    }
+
+    FlatHashMap& operator=(FlatHashMap&& other) {
+        if (this == &other) return *this;
+        if (std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value ||
+            alloc_ == other.alloc_) {
+            destroyAll();
+            if (std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value) {
+                alloc_ = other.alloc_;
+            }
+            swapStorage(other);
+        }
+        else {
+            // Different memory resources: move element by element.
+            FlatHashMap tmp(alloc_);
+            tmp.reserve(other.size_);
+            for (auto& kv : other) tmp.tryEmplace(std::move(kv.first), std::move(kv.second));
+            swapStorage(tmp);
+            other.destroyAll();
+        }
+        return *this;
+    }
+
+    ~FlatHashMap() { destroyAll(); }
+
+    void swap(FlatHashMap& other) noexcept {
+        if (std::allocator_traits<Allocator>::propagate_on_container_swap::value) {
+            std::swap(alloc_, other.alloc_);
+        }
+        swapStorage(other);
+    }
+
+    allocator_type get_allocator() const { return alloc_; }
+
+    // ---------- CAPACITY ----------
+    bool empty() const { return size_ == 0; }
+    size_type size() const { return size_; }
+    size_type capacity() const { return capacity_; }
+
+    // Approximate heap footprint of the table (control bytes + slots).
+    size_type memory_usage() const {
+        return capacity_ * (sizeof(ctrl_t) + sizeof(value_type));
+    }
+
+    void reserve(size_type n) {
+        const size_type needed = capacityFor(n);
+        if (needed > capacity_) rehash(needed);
+    }
+
+    void clear() {
+        if (capacity_ == 0) return;
+        SlotAlloc slotAlloc(alloc_);
+        for (size_type i = 0; i < capacity_; ++i) {
+            if (flat_detail::isFull(ctrl_[i])) SlotTraits::destroy(slotAlloc, slots_ + i);
+        }
+        std::memset(ctrl_, static_cast<unsigned char>(flat_detail::kEmpty), capacity_);
+        size_ = 0;
+        growthLeft_ = maxLoad(capacity_);
+    }
+
+    // Destroys all elements and gives the table memory back to the allocator.
+    void reset() { destroyAll(); }
+
+    // ---------- ITERATION ----------
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, capacity_); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, capacity_); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    // ---------- LOOKUP ----------
+    template <class K>
+    iterator find(const K& key) {
+        const size_type pos = findIndex(key);
+        return pos == npos ? end() : iterator(this, pos);
+    }
+
+    template <class K>
+    const_iterator find(const K& key) const {
+        const size_type pos = findIndex(key);
+        return pos == npos ? end() : const_iterator(this, pos);
+    }
+
+    template <class K>
+    bool contains(const K& key) const { return findIndex(key) != npos; }
+
+    template <class K>
+    size_type count(const K& key) const { return contains(key) ? 1 : 0; }
+
+    template <class K>
+    Value& at(const K& key) {
+        const size_type pos = findIndex(key);
+        if (pos == npos) throw std::out_of_range("FlatHashMap::at: key not found");
+        return slots_[pos].second;
+    }
+
+    template <class K>
+    const Value& at(const K& key) const {
+        const size_type pos = findIndex(key);
+        if (pos == npos) throw std::out_of_range("FlatHashMap::at: key not found");
+        return slots_[pos].second;
+    }
+
+    // ---------- MODIFIERS ----------
+    template <class K>
+    Value& operator[](K&& key) {
+        return tryEmplace(std::forward<K>(key)).first->second;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& kv) {
+        return tryEmplace(kv.first, kv.second);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& kv) {
+        return tryEmplace(std::move(kv.first), std::move(kv.second));
+    }
+
+    template <class K, class... Args>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+        return tryEmplace(std::forward<K>(key), std::forward<Args>(args)...);
+    }
+
+    template <class K, class V>
+    std::pair<iterator, bool> insert_or_assign(K&& key, V&& value) {
+        auto res = tryEmplace(std::forward<K>(key), std::forward<V>(value));
+        if (!res.second) res.first->second = std::forward<V>(value);
+        return res;
+    }
+
+    iterator erase(const_iterator it) {
+        eraseAt(it.pos_);
+        return iterator(this, it.pos_ + 1);
+    }
+
+    iterator erase(iterator it) {
+        eraseAt(it.pos_);
+        return iterator(this, it.pos_ + 1);
+    }
+
+    template <class K, class = std::enable_if_t<!std::is_convertible<K, const_iterator>::value>>
+    size_type erase(const K& key) {
+        const size_type pos = findIndex(key);
+        if (pos == npos) return 0;
+        eraseAt(pos);
+        return 1;
+    }
+
+private:
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+    allocator_type alloc_;
+    CtrlGroup* groups_ = nullptr;
+    ctrl_t* ctrl_ = nullptr;
+    value_type* slots_ = nullptr;
+    size_type capacity_ = 0;     // always 0 or a power of two >= kGroupWidth
+    size_type size_ = 0;
+    size_type growthLeft_ = 0;   // inserts allowed before the next rehash
+
+    // 7/8 maximum load factor.
+    static size_type maxLoad(size_type cap) { return cap - cap / 8; }
+
+    static size_type capacityFor(size_type n) {
+        if (n == 0) return 0;
+        size_type cap = kGroupWidth;
+        while (maxLoad(cap) < n) cap *= 2;
+        return cap;
+    }
+
+    static std::size_t h1(std::size_t hash) { return hash >> 7; }
+    static ctrl_t h2(std::size_t hash) { return static_cast<ctrl_t>(hash & 0x7F); }
+
+    size_type groupMask() const { return capacity_ / kGroupWidth - 1; }
+
+    template <class K>
+    size_type findIndex(const K& key) const {
+        if (size_ == 0) return npos;
+        const std::size_t hash = Hash{}(key);
+        const ctrl_t tag = h2(hash);
+        const size_type mask = groupMask();
+        size_type g = h1(hash) & mask;
+
+        for (size_type step = 1;; ++step) {
+            const Group group(ctrl_ + g * kGroupWidth);
+            std::uint32_t m = group.match(tag);
+            while (m) {
+                const size_type pos = g * kGroupWidth + flat_detail::lowestBit(m);
+                if (KeyEqual{}(slots_[pos].first, key)) return pos;
+                m &= m - 1;
+            }
+            if (group.matchEmpty()) return npos;
+            g = (g + step) & mask;   // triangular probing visits every group
+        }
+    }
+
+    // First EMPTY or DELETED slot on the probe sequence of `hash`.
+    size_type findFree(std::size_t hash) const {
+        const size_type mask = groupMask();
+        size_type g = h1(hash) & mask;
+        for (size_type step = 1;; ++step) {
+            const Group group(ctrl_ + g * kGroupWidth);
+            const std::uint32_t m = group.matchFree();
+            if (m) return g * kGroupWidth + flat_detail::lowestBit(m);
+            g = (g + step) & mask;
+        }
+    }
+
+    template <class K, class... Args>
+    std::pair<iterator, bool> tryEmplace(K&& key, Args&&... args) {
+        const size_type found = findIndex(key);
+        if (found != npos) return { iterator(this, found), false };
+
+        const std::size_t hash = Hash{}(key);
+        if (capacity_ == 0) rehash(kGroupWidth);
+
+        size_type pos = findFree(hash);
+        if (growthLeft_ == 0 && ctrl_[pos] != flat_detail::kDeleted) {
+            // Grow, or just drop tombstones if the table is mostly deleted slots.
+            rehash(size_ + 1 > maxLoad(capacity_) / 2 ? capacity_ * 2 : capacity_);
+            pos = findFree(hash);
+        }
+
+        SlotAlloc slotAlloc(alloc_);
+        SlotTraits::construct(slotAlloc, slots_ + pos,
+            std::piecewise_construct,
+            std::forward_as_tuple(std::forward<K>(key)),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+
+        if (ctrl_[pos] == flat_detail::kEmpty) --growthLeft_;
+        ctrl_[pos] = h2(hash);
+        ++size_;
+        return { iterator(this, pos), true };
+    }
+
+    // Used by copy construction: key is known to be absent.
+    void insertUnique(const Key& key, const Value& value) {
+        const std::size_t hash = Hash{}(key);
+        const size_type pos = findFree(hash);
+        SlotAlloc slotAlloc(alloc_);
+        SlotTraits::construct(slotAlloc, slots_ + pos, key, value);
+        ctrl_[pos] = h2(hash);
+        --growthLeft_;
+        ++size_;
+    }
+
+    void eraseAt(size_type pos) {
+        SlotAlloc slotAlloc(alloc_);
+        SlotTraits::destroy(slotAlloc, slots_ + pos);
+        --size_;
+        // If the group still has an EMPTY slot, no probe sequence ever continued
+        // past it, so this slot can become EMPTY again instead of a tombstone.
+        const Group group(ctrl_ + (pos / kGroupWidth) * kGroupWidth);
+        if (group.matchEmpty()) {
+            ctrl_[pos] = flat_detail::kEmpty;
+            ++growthLeft_;
+        }
+        else {
+            ctrl_[pos] = flat_detail::kDeleted;
+        }
+    }
+
+    void rehash(size_type newCapacity) {
+        CtrlGroup* oldGroups = groups_;
+        ctrl_t* oldCtrl = ctrl_;
+        value_type* oldSlots = slots_;
+        const size_type oldCapacity = capacity_;
+
+        CtrlAlloc ctrlAlloc(alloc_);
+        SlotAlloc slotAlloc(alloc_);
+
+        groups_ = CtrlTraits::allocate(ctrlAlloc, newCapacity / kGroupWidth);
+        ctrl_ = groups_[0].bytes;
+        try {
+            slots_ = SlotTraits::allocate(slotAlloc, newCapacity);
+        }
+        catch (...) {
+            CtrlTraits::deallocate(ctrlAlloc, groups_, newCapacity / kGroupWidth);
+            groups_ = oldGroups;
+            ctrl_ = oldCtrl;
+            throw;
+        }
+        std::memset(ctrl_, static_cast<unsigned char>(flat_detail::kEmpty), newCapacity);
+        capacity_ = newCapacity;
+        growthLeft_ = maxLoad(newCapacity) - size_;
+
+        for (size_type i = 0; i < oldCapacity; ++i) {
+            if (!flat_detail::isFull(oldCtrl[i])) continue;
+            const std::size_t hash = Hash{}(oldSlots[i].first);
+            const size_type pos = findFree(hash);
+            SlotTraits::construct(slotAlloc, slots_ + pos, std::move(oldSlots[i]));
+            ctrl_[pos] = h2(hash);
+            SlotTraits::destroy(slotAlloc, oldSlots + i);
+        }
+
+        if (oldCapacity) {
+            SlotTraits::deallocate(slotAlloc, oldSlots, oldCapacity);
+            CtrlTraits::deallocate(ctrlAlloc, oldGroups, oldCapacity / kGroupWidth);
+        }
+    }
+
+    void swapStorage(FlatHashMap& other) noexcept {
+        std::swap(groups_, other.groups_);
+        std::swap(ctrl_, other.ctrl_);
+        std::swap(slots_, other.slots_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(size_, other.size_);
+        std::swap(growthLeft_, other.growthLeft_);
+    }
+
+    void destroyAll() {
+        if (capacity_ == 0) return;
+        clear();
+        SlotAlloc slotAlloc(alloc_);
+        CtrlAlloc ctrlAlloc(alloc_);
+        SlotTraits::deallocate(slotAlloc, slots_, capacity_);
+        CtrlTraits::deallocate(ctrlAlloc, groups_, capacity_ / kGroupWidth);
+        groups_ = nullptr;
+        ctrl_ = nullptr;
+        slots_ = nullptr;
+        capacity_ = 0;
+        size_ = 0;
+        growthLeft_ = 0;
+    }
+};
+
+// FlatHashMap whose table (and pmr keys/values) live in a std::pmr::memory_resource.
+template <class Key, class Value, class Hash = FlatHash, class KeyEqual = FlatEqual>
+using PmrFlatHashMap =
+    FlatHashMap<Key, Value, Hash, KeyEqual, std::pmr::polymorphic_allocator<std::pair<Key, Value>>>;
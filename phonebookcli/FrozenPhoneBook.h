@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Contact.h"
+
+class PhoneBook;
+
+// ======================================================
+//   FrozenPhoneBook
+//   Immutable, read-only snapshot of a PhoneBook:
+//   - all strings interned once in a compact blob
+//   - minimal perfect hash indexes for email and normalized phone
+//     (one probe, then a single key comparison)
+//   - the whole snapshot is one position-independent image, so it can be
+//     written to disk and opened again with a single mmap
+//
+//   Views returned by lookups point into the image and stay valid until
+//   the snapshot is closed or destroyed. `phonebook freeze` writes an
+//   image, `phonebook lookup` answers email and phone lookups from one.
+// ======================================================
+
+struct FrozenContact {
+    ContactId id = 0;
+    std::string_view firstName;
+    std::string_view middleName;
+    std::string_view lastName;
+    std::string_view work;
+    std::string_view home;
+    std::string_view office;
+    std::string_view email;
+    std::string_view address;
+    std::string_view birthday;
+
+    Contact to_contact() const;
+};
+
+class FrozenPhoneBook {
+public:
+    FrozenPhoneBook();
+    FrozenPhoneBook(FrozenPhoneBook&& other) noexcept;
+    FrozenPhoneBook& operator=(FrozenPhoneBook&& other) noexcept;
+    FrozenPhoneBook(const FrozenPhoneBook&) = delete;
+    FrozenPhoneBook& operator=(const FrozenPhoneBook&) = delete;
+    ~FrozenPhoneBook();
+
+    // Builds the snapshot in memory.
+    static FrozenPhoneBook freeze(const PhoneBook& book);
+
+    // Writes the image to disk / maps an image written by save().
+    bool save(const std::string& filename) const;
+    bool open(const std::string& filename);
+    void close();
+
+    bool is_open() const { return m_base != nullptr; }
+    std::size_t size() const;
+    ContactId get_index() const;     // PhoneBook::index at freeze time
+
+    FrozenContact contact_at(std::size_t position) const;   // ordered by ID
+
+    // Exact lookups. Phones are matched on their normalized form, so
+    // "8(999)123-45-67" finds a contact stored as "+79991234567".
+    bool find_by_email(std::string_view email, FrozenContact* out) const;
+    std::vector<FrozenContact> find_all_by_email(std::string_view email) const;
+    std::vector<FrozenContact> find_by_phone(const std::string& phone) const;
+
+private:
+    const unsigned char* m_base;
+    std::size_t m_size;
+
+    std::vector<std::uint64_t> m_owned;   // image built by freeze()
+    void* m_mapping;                      // image mapped by open()
+#ifdef _WIN32
+    void* m_fileHandle;
+    void* m_mapHandle;
+#endif
+
+    bool attach(const unsigned char* base, std::size_t size);
+    const std::uint32_t* lookup(std::uint64_t mphOffset, std::string_view key,
+                                std::uint32_t* count) const;
+    std::string_view string_at(std::uint32_t offset) const;
+};
@@ -0,0 +1,263 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Contact.h"
+#include "FlatHashMap.h"
+
+// ======================================================
+//   IdAllocator
+//   A contact has two numbers:
+//   - its id (ContactId, 64-bit): what files, menus, the GUI and every
+//     API see. Ids are issued in increasing order and never reused, so
+//     one id names one contact for the life of the book.
+//   - its slot (32-bit): where it lives inside the book. Slots are dense:
+//     a freed slot is handed out again, lowest first, so slot_count()
+//     stays close to size() however much the book churns, and anything
+//     keyed by slot can be a plain array or a bitmap.
+//   IdAllocator keeps the two in step: id -> slot hash, slot -> id
+//   array and a bitmap of live slots.
+//
+//   SlotMap is a map from id to value on top of it, with the subset of
+//   the FlatHashMap interface PhoneBook uses. Values sit in one array
+//   indexed by slot; iteration walks that array in slot order.
+// ======================================================
+
+class IdAllocator {
+public:
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+    static constexpr std::uint32_t kNoSlot = 0xFFFFFFFFu;
+
+    IdAllocator() : IdAllocator(allocator_type()) {}
+    explicit IdAllocator(const allocator_type& alloc);
+    IdAllocator(const IdAllocator& other, const allocator_type& alloc);
+    IdAllocator& operator=(const IdAllocator&) = delete;
+
+    // Gives `id` (not bound yet, not 0) the lowest free slot.
+    std::uint32_t bind(ContactId id);
+    // Frees the slot of `id`: the slot, or kNoSlot if `id` had none.
+    std::uint32_t unbind(ContactId id);
+
+    std::uint32_t slot_of(ContactId id) const;   // kNoSlot if unbound
+    ContactId id_at(std::uint32_t slot) const { return slot < m_idAt.size() ? m_idAt[slot] : 0; }
+    bool live(std::uint32_t slot) const { return id_at(slot) != 0; }
+
+    std::size_t size() const { return m_slotOf.size(); }
+    // One past the highest live slot: the length an array keyed by slot needs.
+    std::uint32_t slot_count() const { return static_cast<std::uint32_t>(m_idAt.size()); }
+    // Live slots as a bitmap, 64 slots per word (slot s is bit s % 64 of
+    // word s / 64).
+    const std::pmr::vector<std::uint64_t>& live_words() const { return m_live; }
+
+    void reserve(std::size_t ids);
+    void clear();
+
+private:
+    PmrFlatHashMap<ContactId, std::uint32_t> m_slotOf;
+    std::pmr::vector<ContactId> m_idAt;        // slot -> id, 0 when free
+    std::pmr::vector<std::uint64_t> m_live;
+    std::uint32_t m_firstFree = 0;             // no free slot below it
+};
+
+template <class Value>
+class SlotMap {
+public:
+    using key_type = ContactId;
+    using mapped_type = Value;
+    using value_type = std::pair<ContactId, Value>;
+    using size_type = std::size_t;
+    using allocator_type = std::pmr::polymorphic_allocator<value_type>;
+
+private:
+    template <bool IsConst>
+    class Iter {
+        friend class SlotMap;
+        using MapPtr = std::conditional_t<IsConst, const SlotMap*, SlotMap*>;
+
+        MapPtr map_ = nullptr;
+        std::uint32_t slot_ = 0;
+
+        Iter(MapPtr map, std::uint32_t slot) : map_(map), slot_(slot) { skipFree(); }
+
+        void skipFree() {
+            while (slot_ < map_->m_ids.slot_count() && !map_->m_ids.live(slot_)) ++slot_;
+        }
+
+    public:
+        using value_type = typename SlotMap::value_type;
+        using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+        using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::forward_iterator_tag;
+
+        Iter() = default;
+        template <bool C = IsConst, class = std::enable_if_t<C>>
+        Iter(const Iter<false>& other) : map_(other.map_), slot_(other.slot_) {}
+
+        reference operator*() const { return map_->m_values[slot_]; }
+        pointer operator->() const { return &map_->m_values[slot_]; }
+        std::uint32_t slot() const { return slot_; }
+
+        Iter& operator++() { ++slot_; skipFree(); return *this; }
+        Iter operator++(int) { Iter tmp = *this; ++*this; return tmp; }
+
+        friend bool operator==(const Iter& a, const Iter& b) { return a.slot_ == b.slot_; }
+        friend bool operator!=(const Iter& a, const Iter& b) { return a.slot_ != b.slot_; }
+
+        template <bool> friend class Iter;
+    };
+
+public:
+    using iterator = Iter<false>;
+    using const_iterator = Iter<true>;
+
+    SlotMap() : SlotMap(allocator_type()) {}
+    explicit SlotMap(const allocator_type& alloc) : m_alloc(alloc), m_ids(alloc) {}
+
+    SlotMap(const SlotMap& other) : SlotMap(other, allocator_type()) {}
+    // Slots are kept: a copy is laid out like the original.
+    SlotMap(const SlotMap& other, const allocator_type& alloc)
+        : m_alloc(alloc), m_ids(other.m_ids, alloc), m_capacity(other.m_capacity)
+    {
+        if (m_capacity) m_values = m_alloc.allocate(m_capacity);
+        for (auto it = other.begin(); it != other.end(); ++it) {
+            std::allocator_traits<allocator_type>::construct(m_alloc, m_values + it.slot(), *it);
+        }
+    }
+
+    SlotMap& operator=(const SlotMap&) = delete;
+    ~SlotMap() { reset(); }
+
+    allocator_type get_allocator() const { return m_alloc; }
+    const IdAllocator& ids() const { return m_ids; }
+
+    // ---------- CAPACITY ----------
+    bool empty() const { return m_ids.size() == 0; }
+    size_type size() const { return m_ids.size(); }
+
+    void reserve(size_type n) {
+        m_ids.reserve(n);
+        if (n > m_capacity) grow(n);
+    }
+
+    // Destroys all elements and gives the memory back to the allocator.
+    void reset() {
+        for (auto it = begin(); it != end(); ++it) {
+            std::allocator_traits<allocator_type>::destroy(m_alloc, &*it);
+        }
+        if (m_values) m_alloc.deallocate(m_values, m_capacity);
+        m_values = nullptr;
+        m_capacity = 0;
+        m_ids.clear();
+    }
+
+    // ---------- ITERATION (slot order) ----------
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, m_ids.slot_count()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, m_ids.slot_count()); }
+
+    // ---------- LOOKUP ----------
+    iterator find(ContactId id) {
+        const std::uint32_t slot = m_ids.slot_of(id);
+        return slot == IdAllocator::kNoSlot ? end() : iterator(this, slot);
+    }
+
+    const_iterator find(ContactId id) const {
+        const std::uint32_t slot = m_ids.slot_of(id);
+        return slot == IdAllocator::kNoSlot ? end() : const_iterator(this, slot);
+    }
+
+    bool contains(ContactId id) const { return m_ids.slot_of(id) != IdAllocator::kNoSlot; }
+    size_type count(ContactId id) const { return contains(id) ? 1 : 0; }
+
+    Value& at(ContactId id) {
+        const std::uint32_t slot = m_ids.slot_of(id);
+        if (slot == IdAllocator::kNoSlot) throw std::out_of_range("SlotMap::at: id not found");
+        return m_values[slot].second;
+    }
+
+    const Value& at(ContactId id) const {
+        const std::uint32_t slot = m_ids.slot_of(id);
+        if (slot == IdAllocator::kNoSlot) throw std::out_of_range("SlotMap::at: id not found");
+        return m_values[slot].second;
+    }
+
+    std::uint32_t slot_of(ContactId id) const { return m_ids.slot_of(id); }
+    std::uint32_t slot_count() const { return m_ids.slot_count(); }
+
+    // ---------- MODIFIERS ----------
+    Value& operator[](ContactId id) {
+        return try_emplace(id).first->second;
+    }
+
+    template <class... Args>
+    std::pair<iterator, bool> try_emplace(ContactId id, Args&&... args) {
+        const std::uint32_t found = m_ids.slot_of(id);
+        if (found != IdAllocator::kNoSlot) return { iterator(this, found), false };
+
+        if (m_ids.size() >= m_capacity) grow(m_capacity ? m_capacity * 2 : kMinCapacity);
+        const std::uint32_t slot = m_ids.bind(id);
+        try {
+            std::allocator_traits<allocator_type>::construct(m_alloc, m_values + slot,
+                std::piecewise_construct, std::forward_as_tuple(id),
+                std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+        catch (...) {
+            m_ids.unbind(id);
+            throw;
+        }
+        return { iterator(this, slot), true };
+    }
+
+    iterator erase(const_iterator it) {
+        const std::uint32_t slot = it.slot_;
+        eraseAt(slot);
+        // Erasing the top live slot drops the free slots below it too:
+        // the next slot may be past the new end().
+        const std::uint32_t count = m_ids.slot_count();
+        return iterator(this, slot + 1 < count ? slot + 1 : count);
+    }
+
+    iterator erase(iterator it) { return erase(const_iterator(it)); }
+
+    size_type erase(ContactId id) {
+        const std::uint32_t slot = m_ids.slot_of(id);
+        if (slot == IdAllocator::kNoSlot) return 0;
+        eraseAt(slot);
+        return 1;
+    }
+
+private:
+    static constexpr size_type kMinCapacity = 16;
+
+    allocator_type m_alloc;
+    IdAllocator m_ids;
+    value_type* m_values = nullptr;   // constructed at live slots only
+    size_type m_capacity = 0;
+
+    void eraseAt(std::uint32_t slot) {
+        const ContactId id = m_values[slot].first;
+        std::allocator_traits<allocator_type>::destroy(m_alloc, m_values + slot);
+        m_ids.unbind(id);
+    }
+
+    // Slots are dense, so the array never needs more than size() entries.
+    void grow(size_type capacity) {
+        value_type* values = m_alloc.allocate(capacity);
+        for (auto it = begin(); it != end(); ++it) {
+            std::allocator_traits<allocator_type>::construct(m_alloc, values + it.slot(), std::move(*it));
+            std::allocator_traits<allocator_type>::destroy(m_alloc, &*it);
+        }
+        if (m_values) m_alloc.deallocate(m_values, m_capacity);
+        m_values = values;
+        m_capacity = capacity;
+    }
+};
@@ -0,0 +1,112 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Contact.h"
+
+// ======================================================
+//   OrderedIndex
+//   Sorted key -> ids index for the lookups the hash indexes cannot
+//   answer: prefixes and ranges. Several contacts may share a key; their
+//   ids are kept ascending, as in emailDomainIndex.
+//   Ranges are half-open [lo, hi); an empty hi means "to the end".
+//   prefix_end() turns a prefix into the hi of its range.
+// ======================================================
+
+class OrderedIndex {
+public:
+    void add(std::string_view key, ContactId id) {
+        std::vector<ContactId>& ids = m_ids[std::string(key)];
+        if (ids.empty() || ids.back() < id) {
+            ids.push_back(id);
+            return;
+        }
+        auto pos = std::lower_bound(ids.begin(), ids.end(), id);
+        if (pos == ids.end() || *pos != id) ids.insert(pos, id);
+    }
+
+    void remove(std::string_view key, ContactId id) {
+        auto it = m_ids.find(key);
+        if (it == m_ids.end()) return;
+        std::vector<ContactId>& ids = it->second;
+        auto pos = std::lower_bound(ids.begin(), ids.end(), id);
+        if (pos != ids.end() && *pos == id) ids.erase(pos);
+        if (ids.empty()) m_ids.erase(it);
+    }
+
+    void clear() { m_ids.clear(); }
+    std::size_t keys() const { return m_ids.size(); }
+
+    // Ids under exactly `key`, ascending; nullptr if none.
+    const std::vector<ContactId>* find(std::string_view key) const {
+        auto it = m_ids.find(key);
+        return it == m_ids.end() ? nullptr : &it->second;
+    }
+
+    // Number of ids in [lo, hi). Stops counting once past `limit`, so an
+    // estimate that has already lost costs no more than the winner.
+    std::size_t count(std::string_view lo, std::string_view hi,
+                      std::size_t limit = std::numeric_limits<std::size_t>::max()) const {
+        std::size_t n = 0;
+        for (auto it = m_ids.lower_bound(lo); it != m_ids.end() && n <= limit; ++it) {
+            if (!hi.empty() && std::string_view(it->first) >= hi) break;
+            n += it->second.size();
+        }
+        return n;
+    }
+
+    // Calls f(id) for every id in [lo, hi), key by key.
+    template <class F>
+    void for_each(std::string_view lo, std::string_view hi, F&& f) const {
+        for (auto it = m_ids.lower_bound(lo); it != m_ids.end(); ++it) {
+            if (!hi.empty() && std::string_view(it->first) >= hi) break;
+            for (ContactId id : it->second) f(id);
+        }
+    }
+
+    // Calls f(key, id) in (key, id) order, ascending or descending, until
+    // f returns false. With `from` set, starts just past (fromKey, fromId)
+    // in that direction: a cursor for paging.
+    template <class F>
+    void walk(bool descending, bool from, std::string_view fromKey, ContactId fromId, F&& f) const {
+        if (!descending) {
+            for (auto it = from ? m_ids.lower_bound(fromKey) : m_ids.begin(); it != m_ids.end(); ++it) {
+                const std::vector<ContactId>& ids = it->second;
+                auto pos = ids.begin();
+                if (from && it->first == fromKey) pos = std::upper_bound(ids.begin(), ids.end(), fromId);
+                for (; pos != ids.end(); ++pos) {
+                    if (!f(std::string_view(it->first), *pos)) return;
+                }
+            }
+            return;
+        }
+        auto it = from ? m_ids.upper_bound(fromKey) : m_ids.end();
+        while (it != m_ids.begin()) {
+            --it;
+            const std::vector<ContactId>& ids = it->second;
+            auto pos = ids.end();
+            if (from && it->first == fromKey) pos = std::lower_bound(ids.begin(), ids.end(), fromId);
+            while (pos != ids.begin()) {
+                --pos;
+                if (!f(std::string_view(it->first), *pos)) return;
+            }
+        }
+    }
+
+    // Smallest key greater than every key starting with `prefix`;
+    // "" (no bound) when there is none.
+    static std::string prefix_end(std::string_view prefix) {
+        std::string end(prefix);
+        while (!end.empty() && static_cast<unsigned char>(end.back()) == 0xFF) end.pop_back();
+        if (!end.empty()) end.back() = static_cast<char>(static_cast<unsigned char>(end.back()) + 1);
+        return end;
+    }
+
+private:
+    std::map<std::string, std::vector<ContactId>, std::less<>> m_ids;
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ContactRecord.h"
+
+// ======================================================
+//   Paging
+//   PhoneBook::page() returns one page of contacts in a stable order:
+//   by the sort key (names and email compared case-insensitively), then
+//   by id. A page ends with an opaque cursor naming its last contact;
+//   passing it back continues right after that contact, so edits between
+//   calls neither repeat nor skip the contacts that were not touched.
+//   - first/last name: walk the ordered name index from the cursor,
+//     O(log n + page)
+//   - id: probe the ids after the cursor, O(page) while ids are dense
+//   - email (no ordered index): one pass keeping the best page in a
+//     bounded heap, O(n log page) instead of sorting the whole book
+//   PhoneBook::sorted_ids() is the whole ordering at once, for listings
+//   that will walk every page anyway: the index walk for names and ids,
+//   and for email the keys copied into one array and sorted on every
+//   core (ParallelSort.h).
+// ======================================================
+
+struct Contact;
+
+enum class SortKey { Id, FirstName, LastName, Email };
+
+struct PageRequest {
+    SortKey key = SortKey::Id;
+    bool descending = false;
+    std::size_t pageSize = 50;
+    std::string cursor;   // "" = first page; else nextCursor of the previous page
+};
+
+struct Page {
+    std::vector<ContactId> ids;
+    std::string nextCursor;   // "" when this is the last page
+};
+
+// For merging the pages of several books (ShardedPhoneBook): the key
+// page() orders a contact by ("" for SortKey::Id), and the cursor that
+// resumes right after the row (sortKey, id).
+std::string pageSortKey(const ContactView& contact, SortKey key);
+std::string pageCursor(SortKey key, bool descending, std::string_view sortKey, ContactId id);
+// The row a cursor resumes after; false if it belongs to another ordering.
+bool pageCursorRow(const std::string& cursor, SortKey key, bool descending,
+                   std::string* sortKey, ContactId* id);
@@ -0,0 +1,68 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// ======================================================
+//   ParallelSort
+//   Sorts a contiguous array on several threads: each thread sorts one
+//   run, then neighbouring runs are merged pairwise, the merges of one
+//   round running in parallel, until a single run is left.
+//   Callers extract the sort keys into the array first, so comparisons
+//   touch only the array and never look contacts up.
+//   Below kParallelSortMinPerThread items per thread it is std::sort.
+//   `less` must be a strict total order (break ties by id) so the result
+//   does not depend on the number of threads.
+// ======================================================
+
+constexpr std::size_t kParallelSortMinPerThread = 32 * 1024;
+
+template <class T, class Less>
+void parallelSort(std::vector<T>& items, Less less, unsigned threadCount = 0)
+{
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const std::size_t count = items.size();
+    const std::size_t runs = std::min<std::size_t>(threadCount, count / kParallelSortMinPerThread);
+    if (runs <= 1) {
+        std::sort(items.begin(), items.end(), less);
+        return;
+    }
+
+    // bounds[i] .. bounds[i + 1] is run i.
+    std::vector<std::size_t> bounds(runs + 1);
+    for (std::size_t i = 0; i <= runs; ++i) bounds[i] = count * i / runs;
+
+    auto begin = items.begin();
+    std::vector<std::thread> pool;
+    pool.reserve(runs - 1);
+    for (std::size_t i = 1; i < runs; ++i) {
+        pool.emplace_back([begin, &bounds, &less, i] {
+            std::sort(begin + bounds[i], begin + bounds[i + 1], less);
+        });
+    }
+    std::sort(begin + bounds[0], begin + bounds[1], less);
+    for (std::thread& t : pool) t.join();
+
+    while (bounds.size() > 2) {
+        // Runs (0,1), (2,3), ... merge at once; an odd last run waits.
+        const std::size_t pairs = (bounds.size() - 1) / 2;
+        pool.clear();
+        for (std::size_t p = 1; p < pairs; ++p) {
+            pool.emplace_back([begin, &bounds, &less, p] {
+                std::inplace_merge(begin + bounds[2 * p], begin + bounds[2 * p + 1],
+                                   begin + bounds[2 * p + 2], less);
+            });
+        }
+        std::inplace_merge(begin + bounds[0], begin + bounds[1], begin + bounds[2], less);
+        for (std::thread& t : pool) t.join();
+
+        std::vector<std::size_t> merged;
+        merged.reserve(pairs + 2);
+        for (std::size_t i = 0; i < bounds.size(); i += 2) merged.push_back(bounds[i]);
+        if (merged.back() != count) merged.push_back(count);
+        bounds.swap(merged);
+    }
+}
@@ -2,52 +2,240 @@
 #include <vector>
 #include <algorithm>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <utility>
+#include <memory_resource>
+#include <optional>
 #include "Contact.h"
+#include "ContactRecord.h"
+#include "FlatHashMap.h"
+#include "IdAllocator.h"
+#include "BloomFilter.h"
+#include "AddressIndex.h"
+#include "OrderedIndex.h"
+#include "Paging.h"
+#include "UndoLog.h"
+#include "ChangeFeed.h"
+
+struct MergeProposal;   // Dedup.h
 
 class PhoneBook {
+private:
+    // Memory for the tables below. Declared first so it outlives them.
+    // Tables and index keys are carved out of `arena` through `pool`:
+    // a bulk load draws a few large arena blocks, steady-state edits
+    // recycle freed blocks in the pool, and reset_storage() hands
+    // everything back at once.
+    std::pmr::monotonic_buffer_resource arena;
+    std::pmr::unsynchronized_pool_resource pool;
+
 public:
-    unsigned int index;
+    ContactId index;
+
+    // Contacts in their compact stored form (ContactRecord.h), read
+    // through ContactView. Keyed by id, laid out by dense slot
+    // (IdAllocator.h): mainStorage.slot_of(id) < slot_count() ~ size().
+    SlotMap<ContactRecord> mainStorage{ &pool };
+    PmrFlatHashMap<std::pmr::string, ContactId> firstNameIndex{ &pool };
+    PmrFlatHashMap<std::pmr::string, ContactId> lastNameIndex{ &pool };
+
+    PmrFlatHashMap<std::pmr::string, ContactId> phoneWorkIndex{ &pool };
+    PmrFlatHashMap<std::pmr::string, ContactId> phoneHomeIndex{ &pool };
+    PmrFlatHashMap<std::pmr::string, ContactId> phoneOfficeIndex{ &pool };
 
-    std::unordered_map<unsigned int, Contact> mainStorage;
-    std::unordered_map<std::string, unsigned int> firstNameIndex;
-    std::unordered_map<std::string, unsigned int> lastNameIndex;
+    PmrFlatHashMap<std::pmr::string, ContactId> emailIndex{ &pool };
 
-    std::unordered_map<std::string, unsigned int> phoneWorkIndex;
-    std::unordered_map<std::string, unsigned int> phoneHomeIndex;
-    std::unordered_map<std::string, unsigned int> phoneOfficeIndex;
+    // Email domain (see emailDomain()) -> ids of the contacts at that
+    // domain, ascending. Kept in step with emailIndex.
+    PmrFlatHashMap<std::pmr::string, std::pmr::vector<ContactId>> emailDomainIndex{ &pool };
 
-    std::unordered_map<std::string, unsigned int> emailIndex;
+    // Normalized phone (see phone_in_use()) -> ids of the contacts listing
+    // that number, ascending, once per phone. Kept in step with the three
+    // phone indexes, so another spelling of a number is one probe.
+    PmrFlatHashMap<std::pmr::string, std::pmr::vector<ContactId>> phoneKeyIndex{ &pool };
+
+    // Full-text index over addresses, for ranked address search.
+    AddressIndex addressIndex;
+
+    // Ordered indexes for prefix and range queries (Query.h) and paging.
+    // Keyed by nameKey(), phoneSuffixKey() of all three phones and
+    // birthdayKey(). Every contact is in the two name indexes, so they
+    // can list the whole book in name order.
+    OrderedIndex firstNameOrder;
+    OrderedIndex lastNameOrder;
+    OrderedIndex phoneSuffixIndex;
+    OrderedIndex birthdayIndex;
 
 private: 
     std::string storageFile;
+    // Whether add/update/remove_contact and the destructor save. Off when
+    // the caller persists on its own schedule (VersionedPhoneBook).
+    bool autosave = true;
+
+    // Open batch (begin_batch): the id counter at its start.
+    bool batchOpen = false;
+    ContactId batchIndex = 0;
+    // Each contact the current mutation or batch touched, as it was
+    // before (nullopt: did not exist). Rollback puts these back; when the
+    // change completes they become its undo step.
+    FlatHashMap<ContactId, std::optional<ContactRecord>> pendingBefore;
+    UndoLog history;
+    ChangeFeed changes;   // not copied: listeners follow one book
+
+    // Front for duplicate checks: a miss means "certainly not in use" and
+    // skips the index lookups. Keyed by email and by normalized phone;
+    // rebuilt on load, extended on every create/edit.
+    BloomFilter emailFilter;
+    BloomFilter phoneFilter;
+
+    void reset_storage(std::size_t expectedContacts);
+    void rebuild_filters();
+    void remember_email(std::string_view email);
+    void remember_phone(std::string_view phone);
+    void remember_keys(const ContactView& contact);   // email and all three phones
+    // Whether a merge proposal still applies: see apply_merges().
+    bool merge_applies(const MergeProposal& proposal) const;
+    void index_email_domain(ContactId id, std::string_view email);
+    void unindex_email_domain(ContactId id, std::string_view email);
+    void index_phone(ContactId id, std::string_view phone);
+    void unindex_phone(ContactId id, std::string_view phone);
+    void index_ordered(ContactId id, const ContactView& contact);
+    void unindex_ordered(ContactId id, const ContactView& contact);
+    // Before a mutation of `id`: its before-image, for rollback and undo.
+    void remember_before(ContactId id);
+    // After a mutation: records the undo step and saves, unless a batch
+    // or !autosave defers the save.
+    bool persist();
+    void record_step();
+    void publish_step(const UndoStep& step, bool forward);
+    void publish_reset();
+    bool apply_step(const UndoStep& step, bool forward);
+    void set_field(ContactId id, Contact& contact, ContactField field, const std::string& value);
 
 public:
     PhoneBook();
+    // Loads `storageFile` instead of phonebook.db.
+    explicit PhoneBook(const std::string& storageFile);
     PhoneBook(const PhoneBook& phoneBook);
     ~PhoneBook();
 
-    int get_index();
-    void set_index(int index);
+    ContactId get_index() const;
+    void set_index(ContactId index);
 
 public:
     void set_storage_file(const std::string& filename);
     const std::string& get_storage_file() const;
+    void set_autosave(bool on);
+    // Writes "<file>.tmp" and renames it over the file, so a failed or
+    // interrupted save leaves the previous book intact.
     bool save_to_file(const std::string& filename = "") const;
     bool load_from_file(const std::string& filename = "");
 
+    // Non-interactive mutations, as in the GUI: validated like the menus,
+    // indexed, then saved. On failure *error says why and nothing changed,
+    // except for a failed save, which is reported after the change.
+    // Contacts are taken by value: pass an rvalue to hand one over
+    // without copying its strings. The book stores a ContactRecord.
+    bool add_contact(Contact contact, std::string* error = nullptr, ContactId* newId = nullptr);
+    // add_contact() under a caller-chosen id, which must be unused
+    // (ShardedPhoneBook hands ids out across shards). index becomes at
+    // least `id`.
+    bool insert_contact(ContactId id, Contact contact, std::string* error = nullptr);
+    // insert_contact() without validation, for a record checked already:
+    // one another book stored (moving a contact between ShardedPhoneBook
+    // shards), kept as it is like a loaded one even if the rules changed
+    // since (phone_formats.txt), or one of a batch validateContacts()
+    // passed. Refused only if the id or the email is taken.
+    bool adopt_contact(ContactId id, const ContactView& contact, std::string* error = nullptr);
+    bool remove_contact(ContactId id, std::string* error = nullptr);
+    bool update_contact(ContactId id, Contact updated, std::string* error = nullptr);
+    // A copy of the contact, which outlives any later change.
+    bool get_contact(ContactId id, Contact* out) const;
+    // Views of the stored fields: no copy, but valid only until the next
+    // mutation, undo/redo or load of this book.
+    bool find_contact(ContactId id, ContactView* out) const;
+
+    // Batches: every mutation between begin_batch() and commit_batch()
+    // (the API above, the menus, apply_merges) is validated and applied
+    // to the book and its indexes at once, but the book is saved only by
+    // commit_batch(), once. rollback_batch() puts back every contact the
+    // batch touched and the id counter, in O(contacts touched).
+    // begin_batch() fails if a batch is already open. A batch still open
+    // when the book is destroyed is rolled back.
+    bool begin_batch();
+    bool commit_batch(std::string* error = nullptr);
+    void rollback_batch();
+    bool in_batch() const { return batchOpen; }
+
+    // Undo/redo (UndoLog.h) of the last create, edit, delete, merge or
+    // batch, in O(fields changed). History is bounded by a byte budget,
+    // UndoLog::kDefaultBudget unless set; 0 turns it off. Loading a file
+    // clears it.
+    bool undo(std::string* error = nullptr);
+    bool redo(std::string* error = nullptr);
+    bool can_undo() const;
+    bool can_redo() const;
+    void set_undo_budget(std::size_t bytes);
+
+    // Change events (ChangeFeed.h) after every create, edit, delete,
+    // merge, committed batch, undo, redo and load. The token is for
+    // unsubscribe(); a listener must not mutate the book.
+    unsigned int subscribe(ChangeFeed::Listener listener);
+    void unsubscribe(unsigned int token);
+
+    // Whether another contact (not `exceptId`) already uses the email /
+    // the phone number in any of its three fields, in any accepted format.
+    bool email_in_use(const std::string& email, ContactId exceptId = 0) const;
+    bool phone_in_use(const std::string& phone, ContactId exceptId = 0) const;
+
+    // Applies proposals from findDuplicates() (Dedup.h) as one batch: each
+    // keeper becomes its merged record, the duplicates are deleted and the
+    // book is saved once. A proposal is skipped if one of its contacts no
+    // longer exists or changed since the scan, if the merged record is
+    // invalid, or if its email belongs to a contact outside the cluster.
+    // Returns how many were applied.
+    std::size_t apply_merges(const std::vector<MergeProposal>& proposals);
+
+    // Contacts whose email is at `domain` ("mail.ru", "@Mail.ru" or a full
+    // address), in id order. Cost is proportional to the result.
+    std::vector<ContactId> contacts_at_domain(std::string_view domain) const;
+    std::size_t domain_count(std::string_view domain) const;
+    // Every domain with its number of contacts, largest first.
+    std::vector<std::pair<std::string, std::size_t>> domain_counts() const;
+
+    // One page of contacts in `request` order (Paging.h). Fails, with
+    // *error set, for a cursor issued for another ordering.
+    bool page(const PageRequest& request, Page* out, std::string* error = nullptr) const;
+    // Every contact id in `key` order, for callers that list the whole
+    // book. Keys without an ordered index are sorted in parallel.
+    std::vector<ContactId> sorted_ids(SortKey key, bool descending = false) const;
+
 public:
     void contact_creation_menu();
-    Contact contact_search_menu();
+    // The stored contact found (valid as find_contact()), or nullptr.
+    const ContactRecord* contact_search_menu();
     void edit_contact();
     void delete_contact();
+    // Deletes every contact at `domain` after one confirmation, as a batch.
+    void delete_contacts_at_domain(const std::string& domain);
     void contact_sort_menu();
+    void duplicates_menu();
+    // Runs a one-line query (Query.h) and lists the matches.
+    void run_query(const std::string& text);
 
 private:
     void create_contact(Contact contact);
-    Contact search(char method, const std::string& value);
-    void edit_contact_fields(PhoneBook& book, unsigned int id);
-    void delete_contact_impl(PhoneBook& book, unsigned int id);
+    const ContactRecord* search(char method, const std::string& value);
+    void edit_contact_fields(PhoneBook& book, ContactId id);
+    void delete_contact_impl(PhoneBook& book, ContactId id);
     void list_sorted_contacts(char method);
+    void list_domain_contacts(const std::string& domain);
+    void list_domain_counts();
+    void list_address_matches(const std::string& query);
+
+    static constexpr std::size_t kAddressResults = 10;
+    static constexpr std::size_t kListPageSize = 20;
+    void index_contact(ContactId id, const ContactView& contact);
+    void unindex_contact(ContactId id, const ContactView& contact);
    
 };
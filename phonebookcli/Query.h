@@ -0,0 +1,93 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ContactRecord.h"
+
+class PhoneBook;
+
+// ======================================================
+//   Query engine
+//   A query is an OR of conjunctions (AND of field predicates). Each
+//   conjunction is planned on its own:
+//   1. every predicate estimates how many contacts it can let through,
+//      from the index it could be answered with (posting list sizes,
+//      key ranges of the ordered indexes) or the book size if none;
+//   2. the smallest estimate drives: its index yields the candidates
+//      (an estimate of 0 ends the conjunction at once);
+//   3. every candidate is checked against all predicates of the
+//      conjunction, so estimates only have to bound, never be exact.
+//   Results of the conjunctions are merged into ascending ids.
+//
+//   Indexes used: ordered first/last name, phone suffix and birthday
+//   indexes (keys below), the email and email domain indexes, the
+//   address full-text index and the id itself.
+// ======================================================
+
+enum class QueryField {
+    Id, FirstName, MiddleName, LastName,
+    AnyPhone, WorkPhone, HomePhone, OfficePhone,
+    Email, EmailDomain, Address, Birthday
+};
+
+enum class QueryMatch {
+    Exact,
+    Prefix,
+    Suffix,
+    Contains,
+    Range,   // value <= x <= upper; `upper` also takes everything it prefixes
+             // ("1990".."2000" includes 2000-12-31). An empty bound is open.
+    Words    // address only: every word, the last one as a prefix
+};
+
+// Text is compared case-insensitively unless Query::caseSensitive is set.
+// Phones are compared in normalized form ("+79991234567"), and for
+// Prefix/Suffix/Contains on their digits only, so "*15-14" is "*1514".
+// Birthdays compare as yyyy-mm-dd; values may be written dd-mm-yyyy.
+// An empty field matches no predicate: born:..1980 skips contacts
+// without a birthday.
+struct QueryPredicate {
+    QueryField field = QueryField::FirstName;
+    QueryMatch match = QueryMatch::Exact;
+    std::string value;
+    std::string upper;   // Range only
+};
+
+struct Query {
+    std::vector<std::vector<QueryPredicate>> anyOf;
+    bool caseSensitive = false;
+};
+
+// What the planner did, one entry per conjunction.
+struct QueryStats {
+    std::vector<std::string> plan;   // e.g. "last name prefix 'chik' (~3)"
+    std::size_t examined = 0;        // candidates checked
+};
+
+// Ids of the matching contacts, ascending.
+std::vector<ContactId> runQuery(const PhoneBook& book, const Query& query, QueryStats* stats = nullptr);
+
+// ---------- QUERY LANGUAGE ----------
+// One line, e.g.  last:Chik* phone:*1514 born:1990..2000 OR email:*@mail.ru
+//   field:value      terms separated by spaces must all match;
+//   OR (or |)        separates alternatives
+//   value            exact; for addr, words in any order (last one as prefix)
+//   value*  *value   prefix / suffix
+//   *value*          contains
+//   lo..hi           range, either side may be left out (born:..1980);
+//                    an id range takes ids from 1 up (id:1..500)
+//   "a b"            quotes keep spaces inside one value
+// Fields: id, first, middle, last, phone (any of the three), work, home,
+// office, email, domain, addr, born. Add case:on for case-sensitive text.
+// Returns false with *error set when the line cannot be parsed.
+bool parseQuery(std::string_view text, Query* out, std::string* error = nullptr);
+
+bool matchesPredicate(const ContactView& contact, ContactId id, const QueryPredicate& predicate,
+                      bool caseSensitive);
+
+// ---------- INDEX KEYS ----------
+// Keys of the ordered indexes PhoneBook keeps for the engine.
+std::string nameKey(std::string_view name);           // ASCII lower-cased
+std::string phoneSuffixKey(std::string_view phone);   // normalized, reversed
+std::string birthdayKey(std::string_view birthday);   // "22-05-2005" -> "2005-05-22"
@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "FlatHashMap.h"
+#include "PhoneBook.h"
+#include "Query.h"
+
+// ======================================================
+//   ShardedPhoneBook
+//   Contacts partitioned by a hash of their id across N independent
+//   PhoneBooks, each with its own lock, indexes and storage file
+//   ("<file>.0" .. "<file>.N-1"), so writers to different shards run in
+//   parallel:
+//   - ids come from one atomic counter and pick the shard
+//   - email uniqueness is global: emails are claimed in a striped table
+//     (email -> id) before a shard is touched, so no writer ever holds
+//     two shard locks
+//   - queries scatter to every shard and gather the sorted id lists
+//   - page()/sorted_ids() merge the shards' own orderings; cursors are
+//     the same as PhoneBook::page() cursors
+//   - add_contacts() validates a batch with validateContacts(), then
+//     ingests it with one thread per shard and one save per shard
+//   Reads spanning shards lock them one at a time: a merged result is
+//   consistent per shard, not across shards.
+//   Loading with a different shard count moves contacts to their new
+//   shards, as stored; one that cannot be moved (its id or email is
+//   taken there) stays in its old shard or file.
+// ======================================================
+
+class ShardedPhoneBook {
+public:
+    // shardCount == 0: one shard per hardware thread.
+    explicit ShardedPhoneBook(const std::string& storageFile, std::size_t shardCount = 0);
+
+    ShardedPhoneBook(const ShardedPhoneBook&) = delete;
+    ShardedPhoneBook& operator=(const ShardedPhoneBook&) = delete;
+
+    std::size_t shard_count() const { return m_shards.size(); }
+    std::size_t size() const;
+
+    // ---------- Single contacts ----------
+    bool get_contact(ContactId id, Contact* out) const;
+    // Id of the contact with exactly this email; 0 if none.
+    ContactId find_email(const std::string& email) const;
+    bool add_contact(const Contact& contact, std::string* error = nullptr, ContactId* newId = nullptr);
+    bool update_contact(ContactId id, const Contact& updated, std::string* error = nullptr);
+    bool remove_contact(ContactId id, std::string* error = nullptr);
+
+    // ---------- Bulk ingest ----------
+    // Adds every valid contact, shards in parallel. (*ids)[i] is the id
+    // of contacts[i], or 0 if it was rejected. Returns how many were added.
+    std::size_t add_contacts(const std::vector<Contact>& contacts, std::vector<ContactId>* ids = nullptr);
+
+    // ---------- Scatter-gather reads ----------
+    std::vector<ContactId> query(const Query& query) const;
+    bool query(std::string_view text, std::vector<ContactId>* ids, std::string* error = nullptr) const;
+    bool page(const PageRequest& request, Page* out, std::string* error = nullptr) const;
+    std::vector<ContactId> sorted_ids(SortKey key, bool descending = false) const;
+
+    bool save();
+
+private:
+    struct Shard {
+        explicit Shard(const std::string& file) : book(file) { book.set_undo_budget(0); }
+        mutable std::shared_mutex mutex;
+        PhoneBook book;
+    };
+
+    static constexpr std::size_t kEmailStripes = 64;
+
+    // Global email -> id, split so unrelated claims do not contend.
+    struct alignas(64) EmailStripe {
+        std::mutex mutex;
+        FlatHashMap<std::string, ContactId> owners;
+    };
+
+    std::size_t shard_index(ContactId id) const;
+    Shard& shard_of(ContactId id) const { return *m_shards[shard_index(id)]; }
+    EmailStripe& stripe_of(const std::string& email) const;
+    bool claim_email(const std::string& email, ContactId id);
+    void release_email(const std::string& email, ContactId id);
+    bool insert(ContactId id, const Contact& contact, std::string* error);
+
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    std::unique_ptr<EmailStripe[]> m_emails;
+    std::atomic<ContactId> m_lastId{ 0 };
+};
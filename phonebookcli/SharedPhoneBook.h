@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "PhoneBook.h"
+#include "Query.h"
+
+// ======================================================
+//   SharedPhoneBook
+//   A PhoneBook that any number of threads may use at once. The book and
+//   its indexes are private; readers hold a std::shared_mutex in shared
+//   mode, so lookups run in parallel, and writers hold it exclusively, so
+//   a reader never sees a contact without its index entries or the other
+//   way round.
+//   Results are returned by value: nothing handed out points into the
+//   book, so nothing outlives the lock that protected it.
+//   read()/write() run a callback under the lock for anything the API
+//   does not cover; the callback must not keep references into the book.
+//   Saving takes the lock exclusively too: two saves must not interleave
+//   in one file.
+//   Both kinds of lock are taken through a turnstile mutex. A writer holds
+//   it while it waits, so new readers queue behind the writer: a steady
+//   stream of lookups cannot starve writers, as a reader-preferring
+//   rwlock (glibc's default) would.
+// ======================================================
+
+class SharedPhoneBook {
+public:
+    // Wraps PhoneBook(), which loads phonebook.db.
+    SharedPhoneBook() = default;
+    // Loads `storageFile` and saves every change there.
+    explicit SharedPhoneBook(const std::string& storageFile);
+
+    SharedPhoneBook(const SharedPhoneBook&) = delete;
+    SharedPhoneBook& operator=(const SharedPhoneBook&) = delete;
+
+    // ---------- Readers (shared lock) ----------
+    std::size_t size() const;
+    bool get_contact(ContactId id, Contact* out) const;
+    std::vector<ContactId> query(const Query& query, QueryStats* stats = nullptr) const;
+    // Parses `text` (parseQuery) and runs it; false with *error on a bad query.
+    bool query(std::string_view text, std::vector<ContactId>* ids, std::string* error = nullptr) const;
+    bool page(const PageRequest& request, Page* out, std::string* error = nullptr) const;
+    std::vector<ContactId> contacts_at_domain(std::string_view domain) const;
+
+    template <class F>
+    auto read(F&& f) const {
+        auto lock = read_lock();
+        return f(static_cast<const PhoneBook&>(m_book));
+    }
+
+    // ---------- Writers (exclusive lock) ----------
+    bool add_contact(Contact contact, std::string* error = nullptr, ContactId* newId = nullptr);
+    bool update_contact(ContactId id, Contact updated, std::string* error = nullptr);
+    bool remove_contact(ContactId id, std::string* error = nullptr);
+    bool save();
+
+    template <class F>
+    auto write(F&& f) {
+        auto lock = write_lock();
+        return f(m_book);
+    }
+
+private:
+    std::shared_lock<std::shared_mutex> read_lock() const {
+        std::lock_guard<std::mutex> turn(m_turnstile);
+        return std::shared_lock<std::shared_mutex>(m_mutex);
+    }
+    std::unique_lock<std::shared_mutex> write_lock() {
+        std::lock_guard<std::mutex> turn(m_turnstile);
+        return std::unique_lock<std::shared_mutex>(m_mutex);
+    }
+
+    mutable std::mutex m_turnstile;
+    mutable std::shared_mutex m_mutex;
+    PhoneBook m_book;
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include "ContactRecord.h"
+
+// ======================================================
+//   UndoLog
+//   Undo/redo history kept as field-level deltas, not contact copies:
+//   - an edit records only the fields it changed, old and new value
+//   - a delete records the contact's non-empty fields (its inverse is
+//     rebuilding the contact from them)
+//   - a create records the same for redo
+//   One step is one user action: a single mutation, or a whole batch.
+//   The log is bounded by a byte budget; the oldest steps are dropped
+//   first. Undo and redo re-index only the fields a step touches
+//   (PhoneBook::undo()/redo()), so their cost is O(delta).
+// ======================================================
+
+struct FieldDelta {
+    ContactField field;
+    std::string before;
+    std::string after;
+};
+
+struct UndoEntry {
+    enum class Kind : std::uint8_t { Create, Update, Remove };
+    Kind kind;
+    ContactId id;
+    std::vector<FieldDelta> deltas;
+};
+
+struct UndoStep {
+    std::vector<UndoEntry> entries;
+};
+
+class UndoLog {
+public:
+    static constexpr std::size_t kDefaultBudget = 1024 * 1024;
+
+    // Bytes the history may hold; 0 turns it off and clears it.
+    void set_budget(std::size_t bytes);
+    std::size_t budget() const { return m_budget; }
+    bool enabled() const { return m_budget > 0; }
+    std::size_t bytes() const { return m_bytes; }
+
+    // The entry for one contact, before and after a step (nullptr: the
+    // contact did not exist); false if nothing changed.
+    static bool diff(ContactId id, const ContactView* before, const ContactView* after, UndoEntry* out);
+
+    // A new step; clears the redo history. Steps larger than the whole
+    // budget are not kept, and the history before them is dropped.
+    void record(UndoStep step);
+
+    bool can_undo() const { return !m_undo.empty(); }
+    bool can_redo() const { return !m_redo.empty(); }
+    // Moves the newest step to the other stack and returns it there.
+    const UndoStep& take_undo();
+    const UndoStep& take_redo();
+    void clear();
+
+private:
+    static std::size_t cost(const UndoStep& step);
+    void trim();
+
+    std::deque<UndoStep> m_undo;   // oldest first
+    std::vector<UndoStep> m_redo;  // most recently undone last
+    std::size_t m_budget = kDefaultBudget;
+    std::size_t m_bytes = 0;
+};
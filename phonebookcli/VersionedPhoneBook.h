@@ -0,0 +1,132 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "PhoneBook.h"
+#include "Query.h"
+
+// ======================================================
+//   VersionedPhoneBook
+//   Readers never lock: snapshot() pins the current version of the book,
+//   an immutable PhoneBook with all its indexes, and everything read
+//   through the pin comes from that one version, however long the scan
+//   and however many writes are published meanwhile.
+//
+//   Writers (one at a time) change a private copy and publish it with a
+//   single atomic pointer store. The version it replaces is retired and
+//   reclaimed by epoch: a pin announces the global epoch before it loads
+//   the pointer, and a version retired at epoch e is free once no pin
+//   announces an epoch <= e.
+//
+//   Copies are recycled. The retired version is kept as the spare along
+//   with the change it lacks; when nobody pins it any more the next
+//   write replays that change onto it, O(change), instead of copying
+//   the book. Only a write that finds the spare still pinned (a long
+//   scan) pays for a full copy. So memory is two books, plus one per
+//   version a slow reader still holds.
+//
+//   A change given to write() is kept and run once more, later, on the
+//   spare (with error == nullptr). So it must own what it captures,
+//   depend on nothing but the book it is given, and, when it returns
+//   false, leave that book as it found it (the PhoneBook mutations do).
+//   Every published version is saved to the storage file by the writer;
+//   readers are not held up by the save.
+// ======================================================
+
+class VersionedPhoneBook {
+    struct Version;
+
+public:
+    // A pinned version. Movable, not copyable; unpins when destroyed.
+    class Snapshot {
+    public:
+        Snapshot(Snapshot&& other) noexcept;
+        Snapshot& operator=(Snapshot&& other) noexcept;
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        ~Snapshot();
+
+        const PhoneBook& book() const;
+        const PhoneBook* operator->() const { return &book(); }
+        std::uint64_t version() const;
+
+    private:
+        friend class VersionedPhoneBook;
+        Snapshot(std::atomic<std::uint64_t>* slot, const Version* version)
+            : m_slot(slot), m_version(version) {}
+        void release();
+
+        std::atomic<std::uint64_t>* m_slot;
+        const Version* m_version;
+    };
+
+    // Loads `storageFile`; every published version is saved there.
+    explicit VersionedPhoneBook(const std::string& storageFile);
+    // No Snapshot may outlive the book.
+    ~VersionedPhoneBook();
+
+    VersionedPhoneBook(const VersionedPhoneBook&) = delete;
+    VersionedPhoneBook& operator=(const VersionedPhoneBook&) = delete;
+
+    // ---------- Readers (lock-free) ----------
+    Snapshot snapshot() const;
+    std::uint64_t version() const;
+
+    bool get_contact(ContactId id, Contact* out) const;
+    std::vector<ContactId> query(const Query& query, QueryStats* stats = nullptr) const;
+    bool page(const PageRequest& request, Page* out, std::string* error = nullptr) const;
+
+    // ---------- Writers ----------
+    using Change = std::function<bool(PhoneBook& book, std::string* error)>;
+
+    // Runs `change` on the next version and publishes it if it returns
+    // true; on false nothing is published. Also false, with the change
+    // published, if the save fails.
+    bool write(Change change, std::string* error = nullptr);
+
+    bool add_contact(const Contact& contact, std::string* error = nullptr, ContactId* newId = nullptr);
+    bool update_contact(ContactId id, const Contact& updated, std::string* error = nullptr);
+    bool remove_contact(ContactId id, std::string* error = nullptr);
+
+    // Retired versions still waiting for their readers, for monitoring.
+    std::size_t retired_versions() const;
+
+private:
+    struct Version {
+        PhoneBook book;
+        std::uint64_t number = 0;
+    };
+    struct Retired {
+        Version* version;
+        std::uint64_t epoch;
+    };
+
+    static constexpr std::size_t kReaderSlots = 128;
+
+    // One announced epoch per active pin, 0 when free. A cache line each,
+    // so pins on different cores do not contend.
+    struct alignas(64) ReaderSlot {
+        std::atomic<std::uint64_t> epoch{ 0 };
+    };
+
+    bool publish(Change change, std::string* error, ContactId* newIndex);
+    bool pinned(std::uint64_t epoch) const;
+    void reclaim();
+    Version* take_spare();
+
+    mutable ReaderSlot m_slots[kReaderSlots];
+    std::atomic<std::uint64_t> m_epoch{ 1 };
+    std::atomic<Version*> m_current{ nullptr };
+
+    // Writer state, under m_writer.
+    mutable std::mutex m_writer;
+    Version* m_spare = nullptr;
+    std::uint64_t m_spareEpoch = 0;
+    Change m_spareLag;   // the change m_spare lacks; empty when it has them all
+    std::vector<Retired> m_retired;
+};
@@ -0,0 +1,150 @@
+// Index table benchmark: std::unordered_map against FlatHashMap, and
+// against PmrFlatHashMap on the arena/pool pair PhoneBook uses.
+//   flathashmap_bench [keys]        (default 900000)
+// For each table: time to insert `keys` email-like keys, time for three
+// lookups per key in a scattered order, heap allocations made by the
+// inserts and heap bytes still live once they are done. The arena never
+// gives memory back, so tables it outgrew while growing stay in its
+// live bytes.
+
+#include "FlatHashMap.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ---------- ALLOCATION COUNTING ----------
+// Every allocation carries its size in a header, so frees can be
+// subtracted from the live byte count. The aligned forms are replaced
+// too: std::pmr's default upstream resource allocates through them.
+
+namespace {
+
+std::size_t g_allocations = 0;
+std::size_t g_liveBytes = 0;
+
+// Block layout: [padding .. size, alignment][user bytes], the user
+// pointer aligned to max(alignment, 16) and both words just below it.
+void* countedAlloc(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) {
+    const std::size_t header = alignment < 16 ? 16 : alignment;
+    void* block = std::aligned_alloc(header, (size + 2 * header - 1) / header * header);
+    if (!block) throw std::bad_alloc();
+    std::size_t* user = reinterpret_cast<std::size_t*>(static_cast<char*>(block) + header);
+    user[-1] = size;
+    user[-2] = header;
+    ++g_allocations;
+    g_liveBytes += size;
+    return user;
+}
+
+void countedFree(void* p) noexcept {
+    if (!p) return;
+    const std::size_t* user = static_cast<std::size_t*>(p);
+    g_liveBytes -= user[-1];
+    std::free(static_cast<char*>(p) - user[-2]);
+}
+
+} // namespace
+
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void operator delete(void* p) noexcept { countedFree(p); }
+void operator delete[](void* p) noexcept { countedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { countedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { countedFree(p); }
+void* operator new(std::size_t size, std::align_val_t a) { return countedAlloc(size, static_cast<std::size_t>(a)); }
+void* operator new[](std::size_t size, std::align_val_t a) { return countedAlloc(size, static_cast<std::size_t>(a)); }
+void operator delete(void* p, std::align_val_t) noexcept { countedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { countedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { countedFree(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { countedFree(p); }
+
+// ---------- BENCHMARK ----------
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+template <class Map, class MakeKey>
+void run(const char* name, Map& map, const std::vector<std::string>& keys, MakeKey makeKey) {
+    const std::size_t allocationsBefore = g_allocations;
+    const std::size_t bytesBefore = g_liveBytes;
+
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < keys.size(); ++i) map[makeKey(keys[i])] = static_cast<unsigned>(i);
+    const double insertMs = millisSince(start);
+    const std::size_t allocations = g_allocations - allocationsBefore;
+    const std::size_t bytes = g_liveBytes - bytesBefore;
+
+    // Step through the keys by a stride coprime to their count, so
+    // consecutive lookups land in unrelated buckets.
+    const std::size_t n = keys.size();
+    unsigned long checksum = 0;
+    start = Clock::now();
+    for (int round = 0; round < 3; ++round) {
+        for (std::size_t i = 0; i < n; ++i) {
+            const std::string& key = keys[(i * 7919) % n];
+            auto it = map.find(makeKey(key));
+            if (it != map.end()) checksum += it->second;
+        }
+    }
+    const double lookupMs = millisSince(start);
+
+    std::printf("%-28s insert %7.1f ms   %zuk lookups %7.1f ms   allocs %8zu   live %6.1f MB   (%lu)\n",
+                name, insertMs, 3 * n / 1000, lookupMs, allocations, bytes / (1024.0 * 1024.0), checksum);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const std::size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 900000;
+
+    std::mt19937_64 rng(1);
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) keys.push_back("user" + std::to_string(rng()) + "@gmail.com");
+
+    auto copy = [](const std::string& key) -> const std::string& { return key; };
+    auto view = [](const std::string& key) { return std::string_view(key); };
+
+    {
+        std::unordered_map<std::string, unsigned> map;
+        run("std::unordered_map", map, keys, copy);
+    }
+    {
+        FlatHashMap<std::string, unsigned> map;
+        run("FlatHashMap", map, keys, copy);
+    }
+    {
+        // string_view lookups: no temporary key per find().
+        FlatHashMap<std::string, unsigned> map;
+        run("FlatHashMap (string_view)", map, keys, view);
+    }
+    {
+        std::pmr::monotonic_buffer_resource arena;
+        std::pmr::unsynchronized_pool_resource pool(&arena);
+        PmrFlatHashMap<std::pmr::string, unsigned> map(&pool);
+        run("PmrFlatHashMap (arena/pool)", map, keys, view);
+    }
+    {
+        // As PhoneBook loads: the table is reserved up front, so no
+        // outgrown tables are left behind in the arena.
+        std::pmr::monotonic_buffer_resource arena;
+        std::pmr::unsynchronized_pool_resource pool(&arena);
+        PmrFlatHashMap<std::pmr::string, unsigned> map(&pool);
+        map.reserve(keys.size());
+        run("PmrFlatHashMap (reserved)", map, keys, view);
+    }
+    return 0;
+}
@@ -1,30 +1,110 @@
 #include "Checkers.h"
+#include "PhoneFormats.h"
 
-#include <regex>
 #include <algorithm>
 #include <array>
 #include <cctype>
 #include <ctime>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PHONEBOOK_CHECKERS_SSE2 1
+#endif
+
+// The validators below are hand-written scanners over std::string_view.
+// They accept exactly what the original std::regex patterns accepted
+// (quoted above each checker) without allocating.
+
+// ---------- CHARACTER CLASSES ----------
+// Same classes the patterns used: \s / std::isspace in the "C" locale,
+// [A-Za-z] and \d = [0-9]. Non-ASCII bytes belong to none of them.
+
+static bool isSpaceChar(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static bool isDigitChar(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static bool isLetterChar(char c) {
+    const unsigned char lower = static_cast<unsigned char>(c) | 0x20;
+    return lower >= 'a' && lower <= 'z';
+}
+
+static bool isAlnumChar(char c) {
+    return isLetterChar(c) || isDigitChar(c);
+}
+
+static bool isNameChar(char c) {
+    return isAlnumChar(c) || c == ' ' || c == '-';
+}
+
+#ifdef PHONEBOOK_CHECKERS_SSE2
+// 0xFF in every byte of v that lies in [lo, hi].
+static __m128i bytesInRange(__m128i v, char lo, char hi) {
+    const __m128i offset = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+    const __m128i width = _mm_set1_epi8(static_cast<char>(hi - lo));
+    return _mm_cmpeq_epi8(_mm_max_epu8(offset, width), width);
+}
+
+static __m128i alnumBytes(__m128i v) {
+    const __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    return _mm_or_si128(bytesInRange(lower, 'a', 'z'), bytesInRange(v, '0', '9'));
+}
+
+static unsigned lowestBit(unsigned m) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctz(m));
+#else
+    unsigned i = 0;
+    while (!(m & 1u)) { m >>= 1; ++i; }
+    return i;
+#endif
+}
+#endif
+
+// Length of the leading run of [A-Za-z0-9] (plus ' ' and '-' when
+// nameChars is set), 16 bytes per step where SSE2 is available.
+static std::size_t classSpan(std::string_view s, bool nameChars) {
+    std::size_t i = 0;
+#ifdef PHONEBOOK_CHECKERS_SSE2
+    for (; i + 16 <= s.size(); i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s.data() + i));
+        __m128i ok = alnumBytes(v);
+        if (nameChars) {
+            ok = _mm_or_si128(ok, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+            ok = _mm_or_si128(ok, _mm_cmpeq_epi8(v, _mm_set1_epi8('-')));
+        }
+        const unsigned bad = ~static_cast<unsigned>(_mm_movemask_epi8(ok)) & 0xFFFFu;
+        if (bad) return i + lowestBit(bad);
+    }
+#endif
+    for (; i < s.size(); ++i) {
+        if (!(nameChars ? isNameChar(s[i]) : isAlnumChar(s[i]))) break;
+    }
+    return i;
+}
+
+static bool allDigits(std::string_view s) {
+    return std::all_of(s.begin(), s.end(), isDigitChar);
+}
 
 // ---------- ONE COMMON TRIMMER ----------
 // removes leading and trailing whitespace only
-static std::string trim(const std::string& s) {
+static std::string_view trim(std::string_view s) {
     std::size_t start = 0;
-    while (start < s.size() &&
-        std::isspace(static_cast<unsigned char>(s[start]))) {
+    while (start < s.size() && isSpaceChar(s[start])) {
         ++start;
     }
-    if (start == s.size()) {
-        return "";
-    }
 
-    std::size_t end = s.size() - 1;
-    while (end > start &&
-        std::isspace(static_cast<unsigned char>(s[end]))) {
+    std::size_t end = s.size();
+    while (end > start && isSpaceChar(s[end - 1])) {
         --end;
     }
 
-    return s.substr(start, end - start + 1);
+    return s.substr(start, end - start);
 }
 
 // ---------- DATE HELPERS ----------
@@ -47,32 +127,55 @@ static int daysInMonth(int month, int year) {
     return days[month - 1];
 }
 
+// Today's local date. localtime() dominates a birthday check, so the
+// result is reused until the clock moves to the next second.
+static void currentDate(int& year, int& month, int& day) {
+    thread_local std::time_t cachedTime = -1;
+    thread_local std::tm cached{};
+
+    const std::time_t t = std::time(nullptr);
+    if (t != cachedTime) {
+#ifdef _WIN32
+        localtime_s(&cached, &t);
+#else
+        localtime_r(&t, &cached);
+#endif
+        cachedTime = t;
+    }
+
+    year = cached.tm_year + 1900;
+    month = cached.tm_mon + 1;
+    day = cached.tm_mday;
+}
+
+static int parseDigits(std::string_view s) {
+    int value = 0;
+    for (char c : s) value = value * 10 + (c - '0');
+    return value;
+}
+
 // ---------- NAME CHECKER ----------
-// Rules:
+// Rules (was ^[A-Za-z][A-Za-z0-9 -]*$):
 // - must start with a LETTER
 // - can contain only letters, digits, spaces, and hyphens
 // - cannot end with a hyphen ('-')
-bool isValidName(const std::string& rawName) {
-    std::string name = trim(rawName);
+bool isValidName(std::string_view rawName) {
+    const std::string_view name = trim(rawName);
     if (name.empty()) {
         return false;
     }
 
-    static const std::regex pattern(R"(^[A-Za-z][A-Za-z0-9 -]*$)");
-
-    if (!std::regex_match(name, pattern)) {
-        return false;
-    }
-
-    if (name.back() == '-') {
+    if (!isLetterChar(name.front()) || name.back() == '-') {
         return false;
     }
 
-    return true;
+    return classSpan(name, true) == name.size();
 }
 
 // ---------- PHONE CHECKER ----------
-// Rules:
+// Formats come from phoneFormats() (PhoneFormats.h), loaded from
+// phone_formats.txt at startup. The built-in set is the old
+// ^(?:\+7|8)(?:\d{10}|\(\d{3}\)\d{7}|\(\d{3}\)\d{3}-\d{2}-\d{2})$:
 // - must start with +7 or 8
 // - allowed formats (area code 3 digits):
 //   +7XXXXXXXXXX
@@ -81,37 +184,36 @@ bool isValidName(const std::string& rawName) {
 //   8(XXX)XXXXXXX
 //   +7(XXX)XXX-XX-XX
 //   8(XXX)XXX-XX-XX
-bool isValidPhone(const std::string& rawPhone) {
-    std::string phone = trim(rawPhone);
-    if (phone.empty()) {
-        return false;
-    }
-
-    static const std::regex pattern(
-        R"(^(?:\+7|8)(?:\d{10}|\(\d{3}\)\d{7}|\(\d{3}\)\d{3}-\d{2}-\d{2})$)"
-    );
+bool isValidPhone(std::string_view rawPhone) {
+    return phoneFormats().match(trim(rawPhone)) >= 0;
+}
 
-    return std::regex_match(phone, pattern);
+// ---------- PHONE NORMALIZER ----------
+// Canonical form of a valid phone, used as an exact-match key. Each
+// format carries its own normalization, for the built-in ones:
+//   "8(999)123-45-67", "+79991234567" -> "+79991234567"
+// Returns "" for anything isValidPhone() rejects.
+std::string normalizePhone(std::string_view rawPhone) {
+    return phoneFormats().normalize(trim(rawPhone));
 }
 
 // ---------- BIRTHDAY CHECKER ----------
-// Format: dd-mm-yyyy
+// Format: dd-mm-yyyy (was ^(\d{2})-(\d{2})-(\d{4})$)
 // - valid day/month/year (with leap years)
 // - must be strictly less than today's date
-bool isValidBirthday(const std::string& rawDate) {
-    std::string date = trim(rawDate);
-    if (date.empty()) return false;
-
-    static const std::regex pattern(R"(^(\d{2})-(\d{2})-(\d{4})$)");
-    std::smatch match;
-
-    if (!std::regex_match(date, match, pattern)) {
+bool isValidBirthday(std::string_view rawDate) {
+    const std::string_view date = trim(rawDate);
+    if (date.size() != 10 || date[2] != '-' || date[5] != '-') {
+        return false;
+    }
+    if (!allDigits(date.substr(0, 2)) || !allDigits(date.substr(3, 2)) ||
+        !allDigits(date.substr(6, 4))) {
         return false;
     }
 
-    int day = std::stoi(match[1].str());
-    int month = std::stoi(match[2].str());
-    int year = std::stoi(match[3].str());
+    int day = parseDigits(date.substr(0, 2));
+    int month = parseDigits(date.substr(3, 2));
+    int year = parseDigits(date.substr(6, 4));
 
     if (month < 1 || month > 12) return false;
 
@@ -120,12 +222,8 @@ bool isValidBirthday(const std::string& rawDate) {
     if (day < 1 || day > maxDay) return false;
 
     // current date
-    std::time_t t = std::time(nullptr);
-    std::tm* now = std::localtime(&t);
-
-    int curYear = now->tm_year + 1900;
-    int curMonth = now->tm_mon + 1;
-    int curDay = now->tm_mday;
+    int curYear = 0, curMonth = 0, curDay = 0;
+    currentDate(curYear, curMonth, curDay);
 
     // must be strictly in the past
     if (year > curYear) return false;
@@ -136,33 +234,67 @@ bool isValidBirthday(const std::string& rawDate) {
 }
 
 // ---------- EMAIL CHECKER ----------
-// Rules:
+// Rules (was ^[A-Za-z0-9]+@[A-Za-z0-9]+$ after removing whitespace):
 //  - username: Latin letters and digits
 //  - exactly one '@' separating username and domain
 //  - domain: Latin letters and digits
 //  - all spaces (including around '@') are ignored
-bool isValidEmail(const std::string& rawEmail) {
-    // 1) trim outer spaces once with our common trimmer
-    std::string email = trim(rawEmail);
-
-    // 2) remove any remaining whitespace inside (before/after '@', etc.)
-    email.erase(
-        std::remove_if(
-            email.begin(), email.end(),
-            [](unsigned char ch) { return std::isspace(ch); }
-        ),
-        email.end()
-    );
-
-    if (email.empty()) {
-        return false;
+bool isValidEmail(std::string_view rawEmail) {
+    std::size_t userLength = 0;
+    std::size_t domainLength = 0;
+    bool seenAt = false;
+
+    for (std::size_t i = 0; i < rawEmail.size();) {
+        const char c = rawEmail[i];
+        if (isSpaceChar(c)) {
+            ++i;
+        }
+        else if (c == '@') {
+            if (seenAt || userLength == 0) return false;
+            seenAt = true;
+            ++i;
+        }
+        else {
+            const std::size_t run = classSpan(rawEmail.substr(i), false);
+            if (run == 0) return false;
+            (seenAt ? domainLength : userLength) += run;
+            i += run;
+        }
     }
 
-    // Note: dot in domain must be a literal '.' (escaped).
-    static const std::regex pattern(R"(^[A-Za-z0-9]+@[A-Za-z0-9]+$)");
+    return seenAt && domainLength > 0;
+}
+
+// ---------- EMAIL DOMAIN ----------
+// Key of the domain index: what follows the last '@', lower-cased, with
+// the spaces isValidEmail() ignores dropped. A string without '@' is
+// taken to be a bare domain ("Gmail.com" -> "gmail.com").
+std::string emailDomain(std::string_view email) {
+    const std::size_t at = email.rfind('@');
+    const std::string_view rest = at == std::string_view::npos ? email : email.substr(at + 1);
+
+    std::string domain;
+    domain.reserve(rest.size());
+    for (char c : rest) {
+        if (isSpaceChar(c)) continue;
+        domain += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+    return domain;
+}
 
-    return std::regex_match(email, pattern);
+// ---------- ADDRESS CHECKER ----------
+// Rules (was ^.*\S.*$):
+//  - at least one non-whitespace character
+//  - a single line: no '\n' or '\r'
+bool isValidAddress(std::string_view rawAddress) {
+    bool hasText = false;
+    for (char c : rawAddress) {
+        if (c == '\n' || c == '\r') return false;
+        if (!isSpaceChar(c)) hasText = true;
+    }
+    return hasText;
 }
+
 // ---------- EMAIL GENERATOR ----------
 // Generates email in format: lastname.firstletter@domain.com
 // Example: "John Doe" -> "doe.j@phonebook.com"
@@ -189,4 +321,169 @@ std::string generateEmail(const std::string& firstName, const std::string& lastN
     );
     
     return lowerLastName + firstLetter + "@gmail";
-}
\ No newline at end of file
+}
+
+// ---------- BATCH VALIDATION ----------
+// Records are processed in blocks; within a block each field is checked
+// for every record before moving to the next field, so one validator
+// (and its branch history) stays hot at a time. Blocks are shared out
+// between threads.
+
+namespace {
+
+enum class Field { First, Middle, Last, Work, Home, Office, Email, Address, Birthday };
+
+struct ContactSpanSource {
+    const Contact* contacts;
+
+    std::string_view operator()(std::size_t i, Field field) const {
+        const Contact& c = contacts[i];
+        switch (field) {
+        case Field::First:    return c.firstName;
+        case Field::Middle:   return c.middleName;
+        case Field::Last:     return c.lastName;
+        case Field::Work:     return c.numbers.number1;
+        case Field::Home:     return c.numbers.number2;
+        case Field::Office:   return c.numbers.number3;
+        case Field::Email:    return c.email;
+        case Field::Address:  return c.address;
+        case Field::Birthday: return c.birthday;
+        }
+        return {};
+    }
+};
+
+struct ColumnSource {
+    const ContactColumns* columns;
+
+    static std::string_view at(const std::vector<std::string_view>& column, std::size_t i) {
+        return column.empty() ? std::string_view() : column[i];
+    }
+
+    std::string_view operator()(std::size_t i, Field field) const {
+        switch (field) {
+        case Field::First:    return at(columns->firstName, i);
+        case Field::Middle:   return at(columns->middleName, i);
+        case Field::Last:     return at(columns->lastName, i);
+        case Field::Work:     return at(columns->work, i);
+        case Field::Home:     return at(columns->home, i);
+        case Field::Office:   return at(columns->office, i);
+        case Field::Email:    return at(columns->email, i);
+        case Field::Address:  return at(columns->address, i);
+        case Field::Birthday: return at(columns->birthday, i);
+        }
+        return {};
+    }
+};
+
+constexpr std::size_t kValidationBlock = 256;
+constexpr std::size_t kMinRecordsPerThread = 16 * 1024;
+
+// Internal marker while phones are checked; never returned.
+constexpr std::uint32_t kHasPhone = 1u << 31;
+
+template <class Source>
+void checkColumn(const Source& source, Field field, bool required,
+                 bool (*valid)(std::string_view), std::uint32_t bit,
+                 std::uint32_t* masks, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+        const std::string_view value = source(i, field);
+        if ((required || !value.empty()) && !valid(value)) {
+            masks[i] |= bit;
+        }
+    }
+}
+
+template <class Source>
+void checkPhoneColumn(const Source& source, Field field, std::uint32_t bit,
+                      std::uint32_t* masks, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+        const std::string_view value = source(i, field);
+        if (value.empty()) continue;
+        masks[i] |= isValidPhone(value) ? kHasPhone : bit;
+    }
+}
+
+template <class Source>
+void validateRange(const Source& source, std::uint32_t* masks, std::size_t begin, std::size_t end) {
+    for (std::size_t block = begin; block < end; block += kValidationBlock) {
+        const std::size_t blockEnd = std::min(end, block + kValidationBlock);
+
+        checkColumn(source, Field::First, true, isValidName, ContactError::FirstName, masks, block, blockEnd);
+        checkColumn(source, Field::Last, true, isValidName, ContactError::LastName, masks, block, blockEnd);
+        checkColumn(source, Field::Email, true, isValidEmail, ContactError::Email, masks, block, blockEnd);
+
+        checkPhoneColumn(source, Field::Work, ContactError::WorkPhone, masks, block, blockEnd);
+        checkPhoneColumn(source, Field::Home, ContactError::HomePhone, masks, block, blockEnd);
+        checkPhoneColumn(source, Field::Office, ContactError::OfficePhone, masks, block, blockEnd);
+
+        checkColumn(source, Field::Middle, false, isValidName, ContactError::MiddleName, masks, block, blockEnd);
+        checkColumn(source, Field::Address, false, isValidAddress, ContactError::Address, masks, block, blockEnd);
+        checkColumn(source, Field::Birthday, false, isValidBirthday, ContactError::Birthday, masks, block, blockEnd);
+
+        for (std::size_t i = block; i < blockEnd; ++i) {
+            masks[i] = (masks[i] & kHasPhone) ? (masks[i] & ~kHasPhone)
+                                              : (masks[i] | ContactError::NoPhone);
+        }
+    }
+}
+
+template <class Source>
+std::vector<std::uint32_t> validateAll(const Source& source, std::size_t count, unsigned threadCount) {
+    std::vector<std::uint32_t> masks(count, 0);
+
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const std::size_t useful = std::max<std::size_t>(1, count / kMinRecordsPerThread);
+    const std::size_t workers = std::min<std::size_t>(threadCount, useful);
+
+    if (workers <= 1) {
+        validateRange(source, masks.data(), 0, count);
+        return masks;
+    }
+
+    // Whole blocks per thread, so no two threads share a cache line of masks.
+    const std::size_t blocks = (count + kValidationBlock - 1) / kValidationBlock;
+    const std::size_t blocksPerWorker = (blocks + workers - 1) / workers;
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (std::size_t w = 1; w < workers; ++w) {
+        const std::size_t begin = std::min(count, w * blocksPerWorker * kValidationBlock);
+        const std::size_t end = std::min(count, begin + blocksPerWorker * kValidationBlock);
+        if (begin >= end) break;
+        pool.emplace_back([&source, &masks, begin, end] {
+            validateRange(source, masks.data(), begin, end);
+        });
+    }
+    validateRange(source, masks.data(), 0, std::min(count, blocksPerWorker * kValidationBlock));
+
+    for (std::thread& t : pool) t.join();
+    return masks;
+}
+
+} // namespace
+
+std::uint32_t validateContact(const Contact& contact) {
+    std::uint32_t mask = 0;
+    validateRange(ContactSpanSource{ &contact }, &mask, 0, 1);
+    return mask;
+}
+
+std::vector<std::uint32_t> validateContacts(const Contact* contacts, std::size_t count,
+                                            unsigned threadCount) {
+    return validateAll(ContactSpanSource{ contacts }, count, threadCount);
+}
+
+std::vector<std::uint32_t> validateContacts(const ContactColumns& columns, unsigned threadCount) {
+    const std::size_t count = columns.firstName.size();
+    for (const auto* column : { &columns.middleName, &columns.lastName, &columns.work,
+                                &columns.home, &columns.office, &columns.email,
+                                &columns.address, &columns.birthday }) {
+        if (!column->empty() && column->size() != count) {
+            return {};
+        }
+    }
+    return validateAll(ColumnSource{ &columns }, count, threadCount);
+}
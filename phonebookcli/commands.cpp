@@ -0,0 +1,286 @@
+#include "Commands.h"
+#include "FrozenPhoneBook.h"
+#include "PhoneBook.h"
+#include "Query.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <istream>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// ---------- WORDS ----------
+
+// Splits a command on spaces. Double quotes keep spaces inside a word
+// (anywhere in it: addr="a b"), with \" and \\ for a quote and a
+// backslash.
+bool splitWords(std::string_view line, std::vector<std::string>* words, std::string* error) {
+    words->clear();
+    std::size_t i = 0;
+    while (i < line.size()) {
+        while (i < line.size() && std::isspace(static_cast<unsigned char>(line[i]))) ++i;
+        if (i == line.size()) break;
+
+        std::string word;
+        bool quoted = false;
+        for (; i < line.size() && (quoted || !std::isspace(static_cast<unsigned char>(line[i]))); ++i) {
+            const char c = line[i];
+            if (c == '"') {
+                quoted = !quoted;
+            }
+            else if (quoted && c == '\\' && i + 1 < line.size()) {
+                word += line[++i];
+            }
+            else {
+                word += c;
+            }
+        }
+        if (quoted) {
+            *error = "Unterminated quote.";
+            return false;
+        }
+        words->push_back(std::move(word));
+    }
+    return true;
+}
+
+bool parseId(const std::string& text, ContactId* id) {
+    if (text.empty() || text.size() > 20 ||
+        !std::all_of(text.begin(), text.end(), [](unsigned char c) { return std::isdigit(c); })) {
+        return false;
+    }
+    *id = std::strtoull(text.c_str(), nullptr, 10);
+    return *id != 0;
+}
+
+// Field names as in the query language.
+bool fieldNamed(std::string_view name, ContactField* field) {
+    static const std::pair<std::string_view, ContactField> kNames[] = {
+        { "first", ContactField::FirstName },   { "middle", ContactField::MiddleName },
+        { "last", ContactField::LastName },     { "work", ContactField::WorkPhone },
+        { "home", ContactField::HomePhone },    { "office", ContactField::OfficePhone },
+        { "email", ContactField::Email },       { "addr", ContactField::Address },
+        { "born", ContactField::Birthday },
+    };
+    for (const auto& entry : kNames) {
+        if (entry.first == name) {
+            *field = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+// name=value words from `first` on, set on `contact`.
+bool assignFields(const std::vector<std::string>& words, std::size_t first, Contact* contact,
+                  std::string* error) {
+    for (std::size_t i = first; i < words.size(); ++i) {
+        const std::size_t eq = words[i].find('=');
+        ContactField field;
+        if (eq == std::string::npos || !fieldNamed(std::string_view(words[i]).substr(0, eq), &field)) {
+            *error = "Expected field=value, got '" + words[i] + "'.";
+            return false;
+        }
+        contactField(*contact, field) = words[i].substr(eq + 1);
+    }
+    return true;
+}
+
+// ---------- RESPONSES ----------
+
+void appendEscaped(std::string* out, std::string_view text) {
+    for (char c : text) {
+        switch (c) {
+        case '\t': *out += "\\t"; break;
+        case '\n': *out += "\\n"; break;
+        case '\\': *out += "\\\\"; break;
+        default:   *out += c; break;
+        }
+    }
+}
+
+void appendRow(std::string* out, ContactId id, const ContactView& c) {
+    *out += std::to_string(id);
+    for (std::size_t f = 0; f < kContactFieldCount; ++f) {
+        *out += '\t';
+        appendEscaped(out, c.field(static_cast<ContactField>(f)));
+    }
+    *out += '\n';
+}
+
+bool fail(std::string* out, std::string_view message) {
+    *out += "error ";
+    for (char c : message) *out += c == '\n' ? ' ' : c;
+    *out += '\n';
+    return false;
+}
+
+bool answer(std::string* out, const PhoneBook& book, const std::vector<ContactId>& ids,
+            const std::string& cursor = std::string()) {
+    const std::size_t header = out->size();
+    std::size_t rows = 0;
+    ContactView view;
+    for (ContactId id : ids) {
+        if (!book.find_contact(id, &view)) continue;
+        appendRow(out, id, view);
+        ++rows;
+    }
+    std::string line = "ok " + std::to_string(rows);
+    if (!cursor.empty()) line += ' ' + cursor;
+    out->insert(header, line + '\n');
+    return true;
+}
+
+// ---------- COMMANDS ----------
+
+bool listCommand(const PhoneBook& book, const std::vector<std::string>& words, std::string* out) {
+    PageRequest request;
+    bool paged = false;
+    for (std::size_t i = 1; i < words.size(); ++i) {
+        const std::string& w = words[i];
+        if (w == "id") request.key = SortKey::Id;
+        else if (w == "first") request.key = SortKey::FirstName;
+        else if (w == "last") request.key = SortKey::LastName;
+        else if (w == "email") request.key = SortKey::Email;
+        else if (w == "asc") request.descending = false;
+        else if (w == "desc") request.descending = true;
+        else if (w == "limit" && i + 1 < words.size()) {
+            const std::string& n = words[++i];
+            if (n.empty() || n.size() > 9 ||
+                !std::all_of(n.begin(), n.end(), [](unsigned char c) { return std::isdigit(c); })) {
+                return fail(out, "limit takes a number.");
+            }
+            request.pageSize = static_cast<std::size_t>(std::stoul(n));
+            paged = true;
+        }
+        else if (w == "after" && i + 1 < words.size()) {
+            request.cursor = words[++i];
+            paged = true;
+        }
+        else {
+            return fail(out, "Unknown list option '" + w + "'.");
+        }
+    }
+
+    if (!paged) return answer(out, book, book.sorted_ids(request.key, request.descending));
+
+    Page page;
+    std::string error;
+    if (!book.page(request, &page, &error)) return fail(out, error);
+    return answer(out, book, page.ids, page.nextCursor);
+}
+
+} // namespace
+
+bool runCommand(PhoneBook& book, std::string_view line, std::string* out)
+{
+    while (!line.empty() && std::isspace(static_cast<unsigned char>(line.back()))) line.remove_suffix(1);
+    while (!line.empty() && std::isspace(static_cast<unsigned char>(line.front()))) line.remove_prefix(1);
+
+    // Ends at the first whitespace of any kind, as splitWords() splits.
+    const auto verbEnd = std::find_if(line.begin(), line.end(), [](unsigned char c) { return std::isspace(c); });
+    const std::string_view verb = line.substr(0, static_cast<std::size_t>(verbEnd - line.begin()));
+
+    // The rest of the line is a query, with its own quoting.
+    if (verb == "search") {
+        Query query;
+        std::string error;
+        if (!parseQuery(line.substr(verb.size()), &query, &error)) return fail(out, error);
+        return answer(out, book, runQuery(book, query));
+    }
+
+    std::vector<std::string> words;
+    std::string error;
+    if (!splitWords(line, &words, &error)) return fail(out, error);
+    if (words.empty()) return fail(out, "Empty command.");
+
+    if (words[0] == "list") return listCommand(book, words, out);
+
+    if (words[0] == "create") {
+        Contact contact;
+        if (!assignFields(words, 1, &contact, &error)) return fail(out, error);
+        ContactId id = 0;
+        if (!book.add_contact(std::move(contact), &error, &id)) return fail(out, error);
+        return answer(out, book, { id });
+    }
+
+    ContactId id = 0;
+    if (words[0] == "get" || words[0] == "edit" || words[0] == "delete") {
+        if (words.size() < 2 || !parseId(words[1], &id)) return fail(out, words[0] + " takes a contact id.");
+    }
+
+    if (words[0] == "get") {
+        if (words.size() > 2) return fail(out, "get takes one contact id.");
+        if (!book.find_contact(id, nullptr)) return fail(out, "No contact with id " + words[1] + ".");
+        return answer(out, book, { id });
+    }
+
+    if (words[0] == "edit") {
+        Contact contact;
+        if (!book.get_contact(id, &contact)) return fail(out, "No contact with id " + words[1] + ".");
+        if (!assignFields(words, 2, &contact, &error)) return fail(out, error);
+        if (!book.update_contact(id, std::move(contact), &error)) return fail(out, error);
+        return answer(out, book, { id });
+    }
+
+    if (words[0] == "delete") {
+        if (words.size() > 2) return fail(out, "delete takes one contact id.");
+        if (!book.remove_contact(id, &error)) return fail(out, error);
+        return answer(out, book, {});
+    }
+
+    return fail(out, "Unknown command '" + words[0] + "'.");
+}
+
+bool runFrozenCommand(const FrozenPhoneBook& book, std::string_view line, std::string* out)
+{
+    std::vector<std::string> words;
+    std::string error;
+    if (!splitWords(line, &words, &error)) return fail(out, error);
+    if (words.empty()) return fail(out, "Empty command.");
+    if ((words[0] != "email" && words[0] != "phone") || words.size() != 2) {
+        return fail(out, "A frozen book answers 'email ADDRESS' and 'phone NUMBER'.");
+    }
+
+    std::vector<FrozenContact> hits =
+        words[0] == "email" ? book.find_all_by_email(words[1]) : book.find_by_phone(words[1]);
+    std::sort(hits.begin(), hits.end(), [](const FrozenContact& a, const FrozenContact& b) { return a.id < b.id; });
+    *out += "ok " + std::to_string(hits.size()) + '\n';
+    for (const FrozenContact& hit : hits) {
+        ContactView view;
+        view.firstName = hit.firstName;
+        view.middleName = hit.middleName;
+        view.lastName = hit.lastName;
+        view.numbers = { hit.work, hit.home, hit.office };
+        view.email = hit.email;
+        view.address = hit.address;
+        view.birthday = hit.birthday;
+        appendRow(out, hit.id, view);
+    }
+    return true;
+}
+
+bool runScript(PhoneBook& book, std::istream& in, std::ostream& out, std::string* error)
+{
+    const bool batch = book.begin_batch();
+    bool ok = true;
+    std::string line;
+    std::string response;
+
+    while (std::getline(in, line)) {
+        const std::size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') continue;
+
+        response.clear();
+        ok = runCommand(book, line, &response) && ok;
+        out << response;
+    }
+    out.flush();
+
+    if (batch && !book.commit_batch(error)) return false;
+    return ok;
+}
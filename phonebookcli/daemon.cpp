@@ -0,0 +1,433 @@
+#include "Daemon.h"
+
+#ifdef __linux__
+
+#include "Commands.h"
+#include "PhoneBook.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::size_t kHeaderSize = 4;
+constexpr std::uint32_t kMaxFrame = 1u << 20;          // larger requests close the connection
+constexpr std::size_t kMaxPendingOutput = 4u << 20;    // stop reading a client past this
+constexpr std::size_t kReadChunk = 64 * 1024;
+
+// ---------- FRAMES ----------
+
+void putLength(char* at, std::uint32_t length) {
+    for (int i = 0; i < 4; ++i) at[i] = static_cast<char>((length >> (8 * i)) & 0xFF);
+}
+
+std::uint32_t getLength(const char* at) {
+    std::uint32_t length = 0;
+    for (int i = 0; i < 4; ++i) length |= static_cast<std::uint32_t>(static_cast<unsigned char>(at[i])) << (8 * i);
+    return length;
+}
+
+void appendFrame(std::string* out, std::string_view payload) {
+    char header[kHeaderSize];
+    putLength(header, static_cast<std::uint32_t>(payload.size()));
+    out->append(header, kHeaderSize);
+    out->append(payload.data(), payload.size());
+}
+
+bool socketAddress(const std::string& path, sockaddr_un* addr, std::string* error) {
+    std::memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr->sun_path)) {
+        if (error) *error = "Socket path is empty or too long: " + path;
+        return false;
+    }
+    std::memcpy(addr->sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+bool setNonBlocking(int fd) {
+    const int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+// ---------- SERVER ----------
+
+struct Connection {
+    int fd = -1;
+    std::string in;             // bytes read, not yet a whole frame from inStart on
+    std::size_t inStart = 0;
+    std::string out;            // responses not yet written, from outStart on
+    std::size_t outStart = 0;
+    std::uint32_t events = 0;   // registered with epoll
+    bool closing = false;       // peer closed its side: flush, then close
+};
+
+class Server {
+public:
+    explicit Server(const DaemonOptions& options) : m_options(options), m_book(options.dbFile) {
+        m_book.set_autosave(false);
+        m_book.set_undo_budget(0);   // the commands have no undo: history would only grow
+        m_subscription = m_book.subscribe([this](const ContactChange&) { markDirty(); });
+    }
+
+    ~Server() {
+        m_book.unsubscribe(m_subscription);
+        for (auto& pair : m_connections) close(pair.first);
+        if (m_listen >= 0) {
+            close(m_listen);
+            unlink(m_options.socketPath.c_str());
+        }
+        if (m_signals >= 0) close(m_signals);
+        if (m_epoll >= 0) close(m_epoll);
+    }
+
+    bool open(std::string* error);
+    void run();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    DaemonOptions m_options;
+    PhoneBook m_book;
+    unsigned int m_subscription = 0;
+    int m_epoll = -1;
+    int m_listen = -1;
+    int m_signals = -1;
+    std::unordered_map<int, std::unique_ptr<Connection>> m_connections;
+    std::vector<char> m_chunk = std::vector<char>(kReadChunk);
+    bool m_dirty = false;
+    Clock::time_point m_dirtySince;
+
+    void markDirty() {
+        if (!m_dirty) m_dirtySince = Clock::now();
+        m_dirty = true;
+    }
+
+    void flush() {
+        if (!m_dirty) return;
+        if (m_book.save_to_file()) m_dirty = false;
+        else std::cerr << "Failed to save " << m_book.get_storage_file() << "; retrying.\n";
+        m_dirtySince = Clock::now();
+    }
+
+    int flushTimeout() const {
+        if (!m_dirty) return -1;
+        const auto due = m_dirtySince + std::chrono::milliseconds(m_options.flushMs);
+        const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(due - Clock::now()).count();
+        return left < 0 ? 0 : static_cast<int>(left);
+    }
+
+    void accept_all();
+    void on_readable(Connection& c);
+    void on_writable(Connection& c);
+    void handle_frames(Connection& c);
+    void update_events(Connection& c);
+    void drop(Connection& c);
+};
+
+bool Server::open(std::string* error) {
+    auto fail = [&](const std::string& msg) {
+        if (error) *error = msg + (errno ? std::string(": ") + std::strerror(errno) : std::string());
+        return false;
+    };
+
+    sockaddr_un addr;
+    if (!socketAddress(m_options.socketPath, &addr, error)) return false;
+
+    // A socket file nobody listens on is left over from a daemon that
+    // died; one that accepts belongs to a running daemon.
+    const int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe >= 0) {
+        const bool running = connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        close(probe);
+        if (running) {
+            errno = 0;
+            return fail("A daemon is already listening on " + m_options.socketPath);
+        }
+    }
+    unlink(m_options.socketPath.c_str());
+
+    m_listen = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_listen < 0) return fail("socket");
+    if (bind(m_listen, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(m_listen);
+        m_listen = -1;
+        return fail("Cannot bind " + m_options.socketPath);
+    }
+    if (listen(m_listen, SOMAXCONN) != 0) return fail("listen");
+
+    // SIGINT/SIGTERM arrive as a readable fd, so shutdown goes through
+    // the loop (and saves) like any other event.
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigprocmask(SIG_BLOCK, &mask, nullptr);
+    m_signals = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (m_signals < 0) return fail("signalfd");
+    // A client that goes away mid-write must not kill the daemon.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll < 0) return fail("epoll_create1");
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = m_listen;
+    if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_listen, &ev) != 0) return fail("epoll_ctl");
+    ev.data.fd = m_signals;
+    if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_signals, &ev) != 0) return fail("epoll_ctl");
+    return true;
+}
+
+void Server::run() {
+    std::vector<epoll_event> events(64);
+    for (;;) {
+        const int n = epoll_wait(m_epoll, events.data(), static_cast<int>(events.size()), flushTimeout());
+        if (n < 0 && errno != EINTR) break;
+
+        for (int i = 0; i < n; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == m_signals) {
+                flush();
+                return;
+            }
+            if (fd == m_listen) {
+                accept_all();
+                continue;
+            }
+            auto it = m_connections.find(fd);
+            if (it == m_connections.end()) continue;
+            Connection& c = *it->second;
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) on_readable(c);
+            if (m_connections.count(fd) && (events[i].events & EPOLLOUT)) on_writable(c);
+        }
+
+        if (m_dirty && flushTimeout() == 0) flush();
+    }
+    flush();
+}
+
+void Server::accept_all() {
+    for (;;) {
+        const int fd = accept4(m_listen, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;   // EAGAIN: none left; anything else: try again on the next event
+
+        auto c = std::make_unique<Connection>();
+        c->fd = fd;
+        c->events = EPOLLIN;
+        epoll_event ev{};
+        ev.events = c->events;
+        ev.data.fd = fd;
+        if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            continue;
+        }
+        m_connections.emplace(fd, std::move(c));
+    }
+}
+
+void Server::on_readable(Connection& c) {
+    // Reading stops while the responses already owed are over the bound.
+    while (!c.closing && c.out.size() - c.outStart < kMaxPendingOutput) {
+        const ssize_t got = read(c.fd, m_chunk.data(), m_chunk.size());
+        if (got > 0) {
+            c.in.append(m_chunk.data(), static_cast<std::size_t>(got));
+            handle_frames(c);
+            continue;
+        }
+        if (got == 0) {
+            c.closing = true;   // answer what was sent, then close
+            break;
+        }
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            drop(c);
+            return;
+        }
+        break;
+    }
+    on_writable(c);
+}
+
+// Every whole frame in the input is a request; its response is framed in
+// place at the end of the output, without an intermediate copy.
+void Server::handle_frames(Connection& c) {
+    while (c.in.size() - c.inStart >= kHeaderSize) {
+        const std::uint32_t length = getLength(&c.in[c.inStart]);
+        if (length > kMaxFrame) {
+            c.closing = true;
+            c.in.clear();
+            c.inStart = 0;
+            return;
+        }
+        if (c.in.size() - c.inStart - kHeaderSize < length) break;
+
+        const std::string_view request(&c.in[c.inStart + kHeaderSize], length);
+        const std::size_t header = c.out.size();
+        c.out.append(kHeaderSize, '\0');
+        runCommand(m_book, request, &c.out);
+        putLength(&c.out[header], static_cast<std::uint32_t>(c.out.size() - header - kHeaderSize));
+        c.inStart += kHeaderSize + length;
+    }
+    if (c.inStart == c.in.size()) {
+        c.in.clear();
+        c.inStart = 0;
+    }
+    else if (c.inStart > c.in.size() / 2) {
+        c.in.erase(0, c.inStart);
+        c.inStart = 0;
+    }
+}
+
+void Server::on_writable(Connection& c) {
+    while (c.outStart < c.out.size()) {
+        const ssize_t sent = write(c.fd, c.out.data() + c.outStart, c.out.size() - c.outStart);
+        if (sent > 0) {
+            c.outStart += static_cast<std::size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        drop(c);
+        return;
+    }
+    if (c.outStart == c.out.size()) {
+        c.out.clear();
+        c.outStart = 0;
+        if (c.closing) {
+            drop(c);
+            return;
+        }
+    }
+    update_events(c);
+}
+
+// Level-triggered: EPOLLIN while the client may send and is not owed too
+// much, EPOLLOUT while responses are pending.
+void Server::update_events(Connection& c) {
+    std::uint32_t wanted = 0;
+    if (!c.closing && c.out.size() - c.outStart < kMaxPendingOutput) wanted |= EPOLLIN;
+    if (c.outStart < c.out.size()) wanted |= EPOLLOUT;
+    if (wanted == c.events) return;
+
+    epoll_event ev{};
+    ev.events = wanted;
+    ev.data.fd = c.fd;
+    if (epoll_ctl(m_epoll, EPOLL_CTL_MOD, c.fd, &ev) == 0) c.events = wanted;
+}
+
+void Server::drop(Connection& c) {
+    const int fd = c.fd;
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    m_connections.erase(fd);
+}
+
+} // namespace
+
+bool runDaemon(const DaemonOptions& options, std::string* error)
+{
+    Server server(options);
+    if (!server.open(error)) return false;
+    server.run();
+    return true;
+}
+
+// ---------- CLIENT ----------
+
+bool runClient(const std::string& socketPath, std::istream& in, std::ostream& out, std::string* error)
+{
+    auto fail = [&](const std::string& msg) {
+        if (error) *error = msg;
+        return false;
+    };
+
+    // All requests are framed up front and written while responses are
+    // read, so neither side blocks on a full socket buffer.
+    std::string requests;
+    std::size_t expected = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        const std::size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') continue;
+        appendFrame(&requests, line);
+        ++expected;
+    }
+
+    sockaddr_un addr;
+    if (!socketAddress(socketPath, &addr, error)) return false;
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return fail(std::string("socket: ") + std::strerror(errno));
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        const std::string reason = std::strerror(errno);
+        close(fd);
+        return fail("Cannot connect to " + socketPath + ": " + reason);
+    }
+    setNonBlocking(fd);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    bool ok = true;
+    std::size_t sent = 0;
+    std::string buffer;
+    std::size_t received = 0;
+    std::vector<char> chunk(kReadChunk);
+
+    while (received < expected) {
+        pollfd p{ fd, static_cast<short>(POLLIN | (sent < requests.size() ? POLLOUT : 0)), 0 };
+        if (poll(&p, 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if ((p.revents & POLLOUT) && sent < requests.size()) {
+            const ssize_t n = write(fd, requests.data() + sent, requests.size() - sent);
+            if (n > 0) sent += static_cast<std::size_t>(n);
+            else if (n < 0 && errno != EAGAIN && errno != EINTR) break;
+        }
+        if (p.revents & (POLLIN | POLLHUP | POLLERR)) {
+            const ssize_t n = read(fd, chunk.data(), chunk.size());
+            if (n == 0) break;
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EINTR) continue;
+                break;
+            }
+            buffer.append(chunk.data(), static_cast<std::size_t>(n));
+
+            std::size_t at = 0;
+            while (buffer.size() - at >= kHeaderSize) {
+                const std::uint32_t length = getLength(&buffer[at]);
+                if (buffer.size() - at - kHeaderSize < length) break;
+                const std::string_view response(&buffer[at + kHeaderSize], length);
+                ok = ok && response.compare(0, 6, "error ") != 0;
+                out << response;
+                at += kHeaderSize + length;
+                ++received;
+            }
+            buffer.erase(0, at);
+        }
+    }
+    close(fd);
+    out.flush();
+
+    if (received < expected) {
+        return fail("Connection closed after " + std::to_string(received) + " of " +
+                    std::to_string(expected) + " responses.");
+    }
+    return ok;
+}
+
+#endif
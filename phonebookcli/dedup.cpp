@@ -0,0 +1,436 @@
+#include "Dedup.h"
+#include "Checkers.h"
+#include "FlatHashMap.h"
+#include "PhoneBook.h"
+#include "ParallelSort.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+namespace {
+
+// Below this many contacts per thread the start-up cost dominates.
+constexpr std::size_t kMinContactsPerThread = 16 * 1024;
+
+// Key namespaces, so an email and a phone with equal hashes never meet.
+constexpr std::uint64_t kPhoneKey = 0x9e3779b97f4a7c15ull;
+constexpr std::uint64_t kEmailKey = 0xc2b2ae3d27d4eb4full;
+constexpr std::uint64_t kNameKey  = 0x165667b19e3779f9ull;
+
+char lowerChar(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// "Smith-Jones " -> "smithjones"
+std::string foldName(std::string_view name) {
+    std::string folded;
+    folded.reserve(name.size());
+    for (char c : name) {
+        const char l = lowerChar(c);
+        if ((l >= 'a' && l <= 'z') || (l >= '0' && l <= '9')) folded += l;
+    }
+    return folded;
+}
+
+std::string_view trimmed(std::string_view s) {
+    auto isSpace = [](char c) { return c == ' ' || (c >= '\t' && c <= '\r'); };
+    while (!s.empty() && isSpace(s.front())) s.remove_prefix(1);
+    while (!s.empty() && isSpace(s.back())) s.remove_suffix(1);
+    return s;
+}
+
+// Field hash with 0 reserved for "empty".
+std::uint64_t fieldHash(std::string_view value) {
+    if (value.empty()) return 0;
+    const std::uint64_t h = flat_detail::hashBytes(value.data(), value.size());
+    return h ? h : 1;
+}
+
+std::uint64_t foldedHash(std::string_view value) {
+    std::string lower(value);
+    for (char& c : lower) c = lowerChar(c);
+    return fieldHash(trimmed(lower));
+}
+
+std::string phoneKey(std::string_view phone) {
+    std::string normalized = normalizePhone(phone);
+    return normalized.empty() ? std::string(phone) : normalized;
+}
+
+// American Soundex of a folded name: "robert" and "rupert" -> "R163".
+std::string soundex(const std::string& folded) {
+    static const char kCodes[] = "01230120022455012623010202";   // a..z
+    if (folded.empty() || folded[0] < 'a' || folded[0] > 'z') return folded.substr(0, 4);
+
+    std::string code(1, static_cast<char>(folded[0] - 'a' + 'A'));
+    char last = kCodes[folded[0] - 'a'];
+    for (std::size_t i = 1; i < folded.size() && code.size() < 4; ++i) {
+        const char c = folded[i];
+        if (c < 'a' || c > 'z') continue;
+        const char digit = kCodes[c - 'a'];
+        if (digit != '0' && digit != last) code += digit;
+        // h and w do not separate two letters with the same code; vowels do.
+        if (c != 'h' && c != 'w') last = digit;
+    }
+    code.resize(4, '0');
+    return code;
+}
+
+double jaroWinkler(const std::string& a, const std::string& b) {
+    if (a == b) return 1.0;
+    if (a.empty() || b.empty()) return 0.0;
+
+    const std::size_t longer = std::max(a.size(), b.size());
+    const std::size_t range = longer / 2 > 0 ? longer / 2 - 1 : 0;
+
+    // Names are short: these stay in the small-string buffer.
+    std::string usedA(a.size(), '\0');
+    std::string usedB(b.size(), '\0');
+
+    std::size_t matches = 0;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        const std::size_t lo = i > range ? i - range : 0;
+        const std::size_t hi = std::min(b.size(), i + range + 1);
+        for (std::size_t j = lo; j < hi; ++j) {
+            if (!usedB[j] && a[i] == b[j]) {
+                usedA[i] = usedB[j] = 1;
+                ++matches;
+                break;
+            }
+        }
+    }
+    if (matches == 0) return 0.0;
+
+    std::size_t transposed = 0;
+    for (std::size_t i = 0, j = 0; i < a.size(); ++i) {
+        if (!usedA[i]) continue;
+        while (!usedB[j]) ++j;
+        if (a[i] != b[j]) ++transposed;
+        ++j;
+    }
+
+    const double m = static_cast<double>(matches);
+    const double jaro = (m / a.size() + m / b.size() + (m - transposed / 2.0) / m) / 3.0;
+
+    std::size_t prefix = 0;
+    while (prefix < 4 && prefix < a.size() && prefix < b.size() && a[prefix] == b[prefix]) ++prefix;
+    return jaro + prefix * 0.1 * (1.0 - jaro);
+}
+
+// What scoring needs from a contact, computed once per contact.
+struct Profile {
+    std::string first;   // folded
+    std::string last;    // folded
+    std::uint64_t email = 0;
+    std::uint64_t phones[3] = {};
+    std::uint64_t address = 0;
+    std::uint64_t birthday = 0;
+};
+
+Profile makeProfile(const ContactView& c) {
+    Profile p;
+    p.first = foldName(c.firstName);
+    p.last = foldName(c.lastName);
+    p.email = foldedHash(c.email);
+    const std::string_view numbers[3] = { c.numbers.number1, c.numbers.number2, c.numbers.number3 };
+    for (int i = 0; i < 3; ++i) {
+        if (!numbers[i].empty()) p.phones[i] = fieldHash(phoneKey(numbers[i]));
+    }
+    p.address = foldedHash(c.address);
+    p.birthday = fieldHash(trimmed(c.birthday));
+    return p;
+}
+
+bool sharePhone(const Profile& a, const Profile& b) {
+    for (std::uint64_t x : a.phones) {
+        if (!x) continue;
+        for (std::uint64_t y : b.phones) {
+            if (x == y) return true;
+        }
+    }
+    return false;
+}
+
+// Everything but the name part of the score; cheap, so pairs that cannot
+// reach the threshold even with identical names skip Jaro-Winkler.
+double evidenceScore(const Profile& a, const Profile& b) {
+    double score = 0.0;
+    if (a.email && a.email == b.email) score += 0.25;
+    if (sharePhone(a, b)) score += 0.25;
+    if (a.address && a.address == b.address) score += 0.1;
+    if (a.birthday && a.birthday == b.birthday) score += 0.2;
+    return score;
+}
+
+bool birthdaysConflict(const Profile& a, const Profile& b) {
+    return a.birthday && b.birthday && a.birthday != b.birthday;
+}
+
+double scoreProfiles(const Profile& a, const Profile& b) {
+    const double name = 0.5 * jaroWinkler(a.last, b.last) + 0.5 * jaroWinkler(a.first, b.first);
+
+    double score = 0.6 * name + evidenceScore(a, b);
+    if (birthdaysConflict(a, b)) score *= 0.5;
+    return std::min(score, 1.0);
+}
+
+struct KeyEntry {
+    std::uint64_t key;
+    std::uint32_t record;
+
+    bool operator<(const KeyEntry& other) const {
+        return key != other.key ? key < other.key : record < other.record;
+    }
+};
+
+struct Match {
+    std::uint32_t a, b;
+    double score;
+};
+
+std::size_t partitionOf(std::uint64_t key, std::size_t partitions) {
+    return static_cast<std::size_t>(((key >> 32) * partitions) >> 32);
+}
+
+// Builds the profiles of records [begin, end) and scatters their blocking
+// keys into one bucket per partition.
+void emitKeys(const std::vector<const ContactRecord*>& records, std::vector<Profile>& profiles,
+              std::size_t begin, std::size_t end, std::vector<std::vector<KeyEntry>>& buckets) {
+    const std::size_t partitions = buckets.size();
+    auto emit = [&](std::uint64_t key, std::size_t record) {
+        buckets[partitionOf(key, partitions)].push_back({ key, static_cast<std::uint32_t>(record) });
+    };
+
+    for (std::size_t r = begin; r < end; ++r) {
+        profiles[r] = makeProfile(*records[r]);
+        const Profile& p = profiles[r];
+
+        for (int i = 0; i < 3; ++i) {
+            if (!p.phones[i]) continue;
+            // A number repeated in two slots is one key.
+            if ((i > 0 && p.phones[i] == p.phones[0]) || (i > 1 && p.phones[i] == p.phones[1])) continue;
+            emit(flat_detail::hashInt(p.phones[i] ^ kPhoneKey), r);
+        }
+        if (p.email) emit(flat_detail::hashInt(p.email ^ kEmailKey), r);
+        if (!p.last.empty()) {
+            std::string phonetic = soundex(p.last);
+            if (!p.first.empty()) phonetic += p.first[0];
+            emit(flat_detail::hashInt(fieldHash(phonetic) ^ kNameKey), r);
+        }
+    }
+}
+
+// Scores the candidate pairs of one partition.
+void scorePartition(std::vector<KeyEntry>& entries, const std::vector<Profile>& profiles,
+                    const DedupOptions& options, std::vector<Match>& matches) {
+    std::sort(entries.begin(), entries.end());
+
+    const std::size_t window = std::max<std::size_t>(options.window, 2);
+    std::vector<std::uint32_t> block;
+
+    for (std::size_t begin = 0; begin < entries.size();) {
+        std::size_t end = begin + 1;
+        while (end < entries.size() && entries[end].key == entries[begin].key) ++end;
+
+        if (end - begin > 1) {
+            block.clear();
+            for (std::size_t i = begin; i < end; ++i) block.push_back(entries[i].record);
+
+            if (block.size() > window) {
+                std::sort(block.begin(), block.end(), [&](std::uint32_t x, std::uint32_t y) {
+                    const Profile& px = profiles[x];
+                    const Profile& py = profiles[y];
+                    if (px.last != py.last) return px.last < py.last;
+                    if (px.first != py.first) return px.first < py.first;
+                    return x < y;
+                });
+            }
+
+            for (std::size_t i = 0; i < block.size(); ++i) {
+                const std::size_t last = std::min(block.size(), i + window);
+                for (std::size_t j = i + 1; j < last; ++j) {
+                    const Profile& a = profiles[block[i]];
+                    const Profile& b = profiles[block[j]];
+                    const double bound = (0.6 + evidenceScore(a, b)) * (birthdaysConflict(a, b) ? 0.5 : 1.0);
+                    if (bound < options.threshold) continue;
+
+                    const double score = scoreProfiles(a, b);
+                    if (score >= options.threshold) {
+                        matches.push_back({ std::min(block[i], block[j]), std::max(block[i], block[j]), score });
+                    }
+                }
+            }
+        }
+        begin = end;
+    }
+}
+
+std::uint32_t findRoot(std::vector<std::uint32_t>& parent, std::uint32_t x) {
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];   // path halving
+        x = parent[x];
+    }
+    return x;
+}
+
+} // namespace
+
+double contactSimilarity(const ContactView& a, const ContactView& b)
+{
+    return scoreProfiles(makeProfile(a), makeProfile(b));
+}
+
+Contact mergeContacts(const std::vector<ContactView>& cluster, std::vector<std::string>* droppedPhones)
+{
+    if (cluster.empty()) return Contact();
+
+    Contact merged = cluster.front().to_contact();
+    std::string* slots[3] = { &merged.numbers.number1, &merged.numbers.number2, &merged.numbers.number3 };
+
+    std::vector<std::string> known;
+    for (std::string* slot : slots) {
+        if (!slot->empty()) known.push_back(phoneKey(*slot));
+    }
+
+    auto fill = [](std::string& field, std::string_view value) {
+        if (trimmed(field).empty() && !trimmed(value).empty()) field = value;
+    };
+
+    for (std::size_t k = 1; k < cluster.size(); ++k) {
+        const ContactView& other = cluster[k];
+        fill(merged.middleName, other.middleName);
+        fill(merged.address, other.address);
+        fill(merged.birthday, other.birthday);
+
+        const std::string_view numbers[3] = { other.numbers.number1, other.numbers.number2, other.numbers.number3 };
+        for (int i = 0; i < 3; ++i) {
+            if (numbers[i].empty()) continue;
+            std::string key = phoneKey(numbers[i]);
+            if (std::find(known.begin(), known.end(), key) != known.end()) continue;
+            known.push_back(std::move(key));
+
+            // Same kind of number (work/home/office) if that slot is free.
+            std::string* target = slots[i]->empty() ? slots[i] : nullptr;
+            for (int s = 0; s < 3 && !target; ++s) {
+                if (slots[s]->empty()) target = slots[s];
+            }
+            if (target) *target = numbers[i];
+            else if (droppedPhones) droppedPhones->emplace_back(numbers[i]);
+        }
+    }
+    return merged;
+}
+
+std::vector<MergeProposal> findDuplicates(const PhoneBook& book, const DedupOptions& options)
+{
+    // Records in id order, so record order == id order from here on.
+    std::vector<std::pair<ContactId, const ContactRecord*>> snapshot;
+    snapshot.reserve(book.mainStorage.size());
+    for (const auto& pair : book.mainStorage) snapshot.emplace_back(pair.first, &pair.second);
+    parallelSort(snapshot, [](const auto& x, const auto& y) { return x.first < y.first; },
+                 options.threadCount);
+
+    const std::size_t count = snapshot.size();
+    std::vector<const ContactRecord*> records(count);
+    for (std::size_t i = 0; i < count; ++i) records[i] = snapshot[i].second;
+
+    unsigned threadCount = options.threadCount;
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const std::size_t useful = std::max<std::size_t>(1, count / kMinContactsPerThread);
+    const std::size_t workers = std::min<std::size_t>(threadCount, useful);
+
+    // Phase 1: profiles and keys, records split across workers; every
+    // worker scatters its keys into one bucket per partition.
+    std::vector<Profile> profiles(count);
+    std::vector<std::vector<std::vector<KeyEntry>>> buckets(
+        workers, std::vector<std::vector<KeyEntry>>(workers));
+
+    const std::size_t perWorker = (count + workers - 1) / std::max<std::size_t>(workers, 1);
+    {
+        std::vector<std::thread> pool;
+        for (std::size_t w = 1; w < workers; ++w) {
+            const std::size_t begin = std::min(count, w * perWorker);
+            const std::size_t end = std::min(count, begin + perWorker);
+            pool.emplace_back([&, w, begin, end] { emitKeys(records, profiles, begin, end, buckets[w]); });
+        }
+        emitKeys(records, profiles, 0, std::min(count, perWorker), buckets[0]);
+        for (std::thread& t : pool) t.join();
+    }
+
+    // Phase 2: each worker owns one partition of the key space, so equal
+    // keys meet in one place without locking.
+    std::vector<std::vector<Match>> matches(workers);
+    auto runPartition = [&](std::size_t p) {
+        std::vector<KeyEntry> entries;
+        std::size_t total = 0;
+        for (std::size_t w = 0; w < workers; ++w) total += buckets[w][p].size();
+        entries.reserve(total);
+        for (std::size_t w = 0; w < workers; ++w) {
+            entries.insert(entries.end(), buckets[w][p].begin(), buckets[w][p].end());
+            std::vector<KeyEntry>().swap(buckets[w][p]);
+        }
+        scorePartition(entries, profiles, options, matches[p]);
+    };
+    {
+        std::vector<std::thread> pool;
+        for (std::size_t p = 1; p < workers; ++p) pool.emplace_back(runPartition, p);
+        runPartition(0);
+        for (std::thread& t : pool) t.join();
+    }
+
+    // Phase 3: union-find, strongest pairs first, so a cluster's score is
+    // the weakest link of its maximum spanning tree whatever the thread
+    // count was.
+    std::vector<Match> all;
+    for (std::vector<Match>& part : matches) all.insert(all.end(), part.begin(), part.end());
+    std::sort(all.begin(), all.end(), [](const Match& x, const Match& y) {
+        if (x.score != y.score) return x.score > y.score;
+        return x.a != y.a ? x.a < y.a : x.b < y.b;
+    });
+
+    std::vector<std::uint32_t> parent(count);
+    for (std::size_t i = 0; i < count; ++i) parent[i] = static_cast<std::uint32_t>(i);
+    std::vector<double> weakest(count, 1.0);
+
+    for (const Match& m : all) {
+        std::uint32_t ra = findRoot(parent, m.a);
+        std::uint32_t rb = findRoot(parent, m.b);
+        if (ra == rb) continue;
+        if (rb < ra) std::swap(ra, rb);
+        parent[rb] = ra;   // the lowest record (= lowest id) stays the root
+        weakest[ra] = std::min({ weakest[ra], weakest[rb], m.score });
+    }
+
+    // (root, member) for every record that joined a cluster; sorting by
+    // root keeps members in id order and proposals in keepId order.
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> joined;
+    for (std::size_t r = 0; r < count; ++r) {
+        const std::uint32_t root = findRoot(parent, static_cast<std::uint32_t>(r));
+        if (root != r) joined.emplace_back(root, static_cast<std::uint32_t>(r));
+    }
+    std::sort(joined.begin(), joined.end());
+
+    std::vector<MergeProposal> proposals;
+    std::vector<ContactView> members;
+    for (std::size_t i = 0; i < joined.size();) {
+        const std::uint32_t root = joined[i].first;
+
+        MergeProposal proposal;
+        proposal.keepId = snapshot[root].first;
+        proposal.score = weakest[root];
+        members.assign(1, *records[root]);
+        for (; i < joined.size() && joined[i].first == root; ++i) {
+            proposal.duplicateIds.push_back(snapshot[joined[i].second].first);
+            members.push_back(*records[joined[i].second]);
+        }
+        proposal.merged = mergeContacts(members, &proposal.droppedPhones);
+        for (const ContactView& member : members) proposal.before.push_back(member.to_contact());
+        proposals.push_back(std::move(proposal));
+    }
+    return proposals;
+}
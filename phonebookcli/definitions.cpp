@@ -1,29 +1,70 @@
 #include "PhoneBook.h"
 #include "Checkers.h"
+#include "Dedup.h"
+#include "Query.h"
+#include <algorithm>
 #include <iostream>
 #include <limits>
-#include <regex>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
+#include <cstdio>
+#include <utility>
 
-PhoneBook::PhoneBook() : index(0), storageFile("phonebook.db")
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+PhoneBook::PhoneBook() : arena(64 * 1024), pool(&arena), index(0), storageFile("phonebook.db")
 {
     // Best-effort load: if the file does not exist or is invalid,
     // the phone book starts empty.
     (void)load_from_file();
 }
 
-PhoneBook::PhoneBook(const PhoneBook& other) = default;
+PhoneBook::PhoneBook(const std::string& storageFile)
+    : arena(64 * 1024), pool(&arena), index(0), storageFile(storageFile)
+{
+    (void)load_from_file();
+}
+
+// Memory resources are not copyable: the copy gets its own arena/pool
+// and the tables are copied into it.
+PhoneBook::PhoneBook(const PhoneBook& other)
+    : arena(64 * 1024), pool(&arena), index(other.index),
+      mainStorage(other.mainStorage, &pool),
+      firstNameIndex(other.firstNameIndex, &pool),
+      lastNameIndex(other.lastNameIndex, &pool),
+      phoneWorkIndex(other.phoneWorkIndex, &pool),
+      phoneHomeIndex(other.phoneHomeIndex, &pool),
+      phoneOfficeIndex(other.phoneOfficeIndex, &pool),
+      emailIndex(other.emailIndex, &pool),
+      emailDomainIndex(other.emailDomainIndex, &pool),
+      phoneKeyIndex(other.phoneKeyIndex, &pool),
+      addressIndex(other.addressIndex),
+      firstNameOrder(other.firstNameOrder),
+      lastNameOrder(other.lastNameOrder),
+      phoneSuffixIndex(other.phoneSuffixIndex),
+      birthdayIndex(other.birthdayIndex),
+      storageFile(other.storageFile),
+      autosave(other.autosave),
+      history(other.history),
+      emailFilter(other.emailFilter),
+      phoneFilter(other.phoneFilter)
+{
+}
 
 PhoneBook::~PhoneBook()
 {
+    // An unfinished batch is not saved.
+    if (batchOpen) rollback_batch();
     // Best-effort save on shutdown (changes are also saved after create/edit/delete).
-    (void)save_to_file();
+    if (autosave) (void)save_to_file();
 }
 
-int PhoneBook::get_index() { return static_cast<int>(index); }
-void PhoneBook::set_index(int idx) { index = static_cast<unsigned int>(idx); }
+ContactId PhoneBook::get_index() const { return index; }
+void PhoneBook::set_index(ContactId idx) { index = idx; }
 
 void PhoneBook::set_storage_file(const std::string& filename)
 {
@@ -35,10 +76,380 @@ const std::string& PhoneBook::get_storage_file() const
     return storageFile;
 }
 
+void PhoneBook::set_autosave(bool on)
+{
+    autosave = on;
+}
+
+// ---------- BATCHES ----------
+
+bool PhoneBook::begin_batch()
+{
+    if (batchOpen) return false;
+    record_step();
+    batchOpen = true;
+    batchIndex = index;
+    return true;
+}
+
+bool PhoneBook::commit_batch(std::string* error)
+{
+    if (!batchOpen) {
+        if (error) *error = "No batch is open.";
+        return false;
+    }
+    batchOpen = false;
+    const bool changed = !pendingBefore.empty();
+    record_step();
+    if (changed && autosave && !save_to_file()) {
+        if (error) *error = "Batch applied, but failed to save to file.";
+        return false;
+    }
+    return true;
+}
+
+void PhoneBook::rollback_batch()
+{
+    if (!batchOpen) return;
+    for (const auto& pair : pendingBefore) {
+        const ContactId id = pair.first;
+        auto it = mainStorage.find(id);
+        if (it != mainStorage.end()) {
+            unindex_contact(id, it->second);
+            mainStorage.erase(id);
+        }
+        if (pair.second) {
+            mainStorage[id] = *pair.second;
+            index_contact(id, *pair.second);
+            // A filter rebuilt during the batch no longer has this
+            // contact's keys.
+            remember_keys(*pair.second);
+        }
+    }
+    // The filters may keep keys of contacts the batch added; they only
+    // cost an index lookup on a later duplicate check.
+    index = batchIndex;
+    batchOpen = false;
+    pendingBefore.clear();
+}
+
+void PhoneBook::remember_before(ContactId id)
+{
+    if (!batchOpen && !history.enabled() && changes.empty()) return;
+    if (pendingBefore.find(id) != pendingBefore.end()) return;
+    auto it = mainStorage.find(id);
+    if (it == mainStorage.end()) pendingBefore[id] = std::nullopt;
+    else pendingBefore[id] = it->second;
+}
+
+bool PhoneBook::persist()
+{
+    if (batchOpen) return true;
+    record_step();
+    if (!autosave) return true;
+    return save_to_file();
+}
+
+void PhoneBook::reset_storage(std::size_t expectedContacts)
+{
+    // The history describes the book being dropped.
+    history.clear();
+    pendingBefore.clear();
+
+    // Destroy every table, then release the arena in one go instead of
+    // freeing index keys and table arrays one by one.
+    mainStorage.reset();
+    firstNameIndex.reset();
+    lastNameIndex.reset();
+    phoneWorkIndex.reset();
+    phoneHomeIndex.reset();
+    phoneOfficeIndex.reset();
+    emailIndex.reset();
+    emailDomainIndex.reset();
+    phoneKeyIndex.reset();
+    addressIndex.clear();
+    firstNameOrder.clear();
+    lastNameOrder.clear();
+    phoneSuffixIndex.clear();
+    birthdayIndex.clear();
+    pool.release();
+    arena.release();
+
+    // Size every table once for the bulk load that follows.
+    mainStorage.reserve(expectedContacts);
+    firstNameIndex.reserve(expectedContacts);
+    lastNameIndex.reserve(expectedContacts);
+    phoneWorkIndex.reserve(expectedContacts);
+    phoneHomeIndex.reserve(expectedContacts);
+    phoneOfficeIndex.reserve(expectedContacts);
+    emailIndex.reserve(expectedContacts);
+}
+
+// Posting lists stay sorted: new ids are the largest, so inserts are
+// appends; removal is a binary search.
+void PhoneBook::index_email_domain(ContactId id, std::string_view email)
+{
+    if (email.empty()) return;
+    std::pmr::vector<ContactId>& ids = emailDomainIndex[emailDomain(email)];
+    if (ids.empty() || ids.back() < id) {
+        ids.push_back(id);
+        return;
+    }
+    auto pos = std::lower_bound(ids.begin(), ids.end(), id);
+    if (pos == ids.end() || *pos != id) ids.insert(pos, id);
+}
+
+void PhoneBook::unindex_email_domain(ContactId id, std::string_view email)
+{
+    if (email.empty()) return;
+    auto it = emailDomainIndex.find(emailDomain(email));
+    if (it == emailDomainIndex.end()) return;
+
+    std::pmr::vector<ContactId>& ids = it->second;
+    auto pos = std::lower_bound(ids.begin(), ids.end(), id);
+    if (pos != ids.end() && *pos == id) ids.erase(pos);
+    if (ids.empty()) emailDomainIndex.erase(it);
+}
+
+void PhoneBook::index_ordered(ContactId id, const ContactView& contact)
+{
+    firstNameOrder.add(nameKey(contact.firstName), id);
+    lastNameOrder.add(nameKey(contact.lastName), id);
+    for (std::string_view phone : { contact.numbers.number1, contact.numbers.number2, contact.numbers.number3 }) {
+        if (!phone.empty()) phoneSuffixIndex.add(phoneSuffixKey(phone), id);
+    }
+    if (!contact.birthday.empty()) birthdayIndex.add(birthdayKey(contact.birthday), id);
+}
+
+void PhoneBook::unindex_ordered(ContactId id, const ContactView& contact)
+{
+    firstNameOrder.remove(nameKey(contact.firstName), id);
+    lastNameOrder.remove(nameKey(contact.lastName), id);
+    for (std::string_view phone : { contact.numbers.number1, contact.numbers.number2, contact.numbers.number3 }) {
+        if (!phone.empty()) phoneSuffixIndex.remove(phoneSuffixKey(phone), id);
+    }
+    if (!contact.birthday.empty()) birthdayIndex.remove(birthdayKey(contact.birthday), id);
+}
+
+std::vector<ContactId> PhoneBook::contacts_at_domain(std::string_view domain) const
+{
+    auto it = emailDomainIndex.find(emailDomain(domain));
+    if (it == emailDomainIndex.end()) return {};
+    return std::vector<ContactId>(it->second.begin(), it->second.end());
+}
+
+std::size_t PhoneBook::domain_count(std::string_view domain) const
+{
+    auto it = emailDomainIndex.find(emailDomain(domain));
+    return it == emailDomainIndex.end() ? 0 : it->second.size();
+}
+
+std::vector<std::pair<std::string, std::size_t>> PhoneBook::domain_counts() const
+{
+    std::vector<std::pair<std::string, std::size_t>> counts;
+    counts.reserve(emailDomainIndex.size());
+    for (const auto& pair : emailDomainIndex) {
+        counts.emplace_back(std::string(pair.first), pair.second.size());
+    }
+    std::sort(counts.begin(), counts.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    return counts;
+}
+
+// Phones are compared in normalized form, so "8(999)123-45-67" and
+// "+79991234567" are the same number. Unrecognized numbers compare as-is.
+static std::string phoneKey(std::string_view phone)
+{
+    std::string normalized = normalizePhone(phone);
+    return normalized.empty() ? std::string(phone) : normalized;
+}
+
+// A contact listing a number twice holds its id twice, so dropping one of
+// the two phones leaves the other in.
+void PhoneBook::index_phone(ContactId id, std::string_view phone)
+{
+    if (phone.empty()) return;
+    std::pmr::vector<ContactId>& ids = phoneKeyIndex[phoneKey(phone)];
+    ids.insert(std::upper_bound(ids.begin(), ids.end(), id), id);
+}
+
+void PhoneBook::unindex_phone(ContactId id, std::string_view phone)
+{
+    if (phone.empty()) return;
+    auto it = phoneKeyIndex.find(phoneKey(phone));
+    if (it == phoneKeyIndex.end()) return;
+
+    std::pmr::vector<ContactId>& ids = it->second;
+    auto pos = std::lower_bound(ids.begin(), ids.end(), id);
+    if (pos != ids.end() && *pos == id) ids.erase(pos);
+    if (ids.empty()) phoneKeyIndex.erase(it);
+}
+
+void PhoneBook::rebuild_filters()
+{
+    // Headroom so the next interactive inserts do not force a rebuild.
+    const std::size_t expected = mainStorage.size() + mainStorage.size() / 4;
+    emailFilter.reset(expected);
+    phoneFilter.reset(expected * 3);
+
+    for (const auto& pair : mainStorage) {
+        const ContactView c = pair.second;
+        if (!c.email.empty()) emailFilter.insert(c.email);
+        for (std::string_view phone : { c.numbers.number1, c.numbers.number2, c.numbers.number3 }) {
+            if (!phone.empty()) phoneFilter.insert(phoneKey(phone));
+        }
+    }
+}
+
+// Call after the contact holding the key is stored.
+void PhoneBook::remember_email(std::string_view email)
+{
+    if (email.empty()) return;
+    emailFilter.insert(email);
+    if (emailFilter.saturated()) rebuild_filters();
+}
+
+void PhoneBook::remember_phone(std::string_view phone)
+{
+    if (phone.empty()) return;
+    phoneFilter.insert(phoneKey(phone));
+    if (phoneFilter.saturated()) rebuild_filters();
+}
+
+void PhoneBook::remember_keys(const ContactView& contact)
+{
+    remember_email(contact.email);
+    remember_phone(contact.numbers.number1);
+    remember_phone(contact.numbers.number2);
+    remember_phone(contact.numbers.number3);
+}
+
+bool PhoneBook::email_in_use(const std::string& email, ContactId exceptId) const
+{
+    if (email.empty() || !emailFilter.might_contain(email)) {
+        return false;
+    }
+    auto it = emailIndex.find(email);
+    return it != emailIndex.end() && it->second != exceptId;
+}
+
+bool PhoneBook::phone_in_use(const std::string& phone, ContactId exceptId) const
+{
+    if (phone.empty()) return false;
+
+    const std::string key = phoneKey(phone);
+    if (!phoneFilter.might_contain(key)) {
+        return false;
+    }
+
+    // Any spelling of the number, or a filter false positive: one probe.
+    auto it = phoneKeyIndex.find(key);
+    if (it == phoneKeyIndex.end()) return false;
+    return std::any_of(it->second.begin(), it->second.end(), [exceptId](ContactId id) { return id != exceptId; });
+}
+
+void PhoneBook::index_contact(ContactId id, const ContactView& contact)
+{
+    firstNameIndex[contact.firstName] = id;
+    lastNameIndex[contact.lastName] = id;
+    if (!contact.numbers.number1.empty()) phoneWorkIndex[contact.numbers.number1] = id;
+    if (!contact.numbers.number2.empty()) phoneHomeIndex[contact.numbers.number2] = id;
+    if (!contact.numbers.number3.empty()) phoneOfficeIndex[contact.numbers.number3] = id;
+    for (std::string_view phone : { contact.numbers.number1, contact.numbers.number2, contact.numbers.number3 }) {
+        index_phone(id, phone);
+    }
+    emailIndex[contact.email] = id;
+    index_email_domain(id, contact.email);
+    addressIndex.add(id, contact.address);
+    index_ordered(id, contact);
+}
+
+// Only entries that still point at `id` are removed.
+void PhoneBook::unindex_contact(ContactId id, const ContactView& contact)
+{
+    auto eraseKey = [id](auto& mp, std::string_view key) {
+        if (key.empty()) return;
+        auto it = mp.find(key);
+        if (it != mp.end() && it->second == id) mp.erase(it);
+    };
+    eraseKey(firstNameIndex, contact.firstName);
+    eraseKey(lastNameIndex, contact.lastName);
+    eraseKey(phoneWorkIndex, contact.numbers.number1);
+    eraseKey(phoneHomeIndex, contact.numbers.number2);
+    eraseKey(phoneOfficeIndex, contact.numbers.number3);
+    for (std::string_view phone : { contact.numbers.number1, contact.numbers.number2, contact.numbers.number3 }) {
+        unindex_phone(id, phone);
+    }
+    eraseKey(emailIndex, contact.email);
+    unindex_email_domain(id, contact.email);
+    addressIndex.remove(id, contact.address);
+    unindex_ordered(id, contact);
+}
+
+// The proposal's contacts all exist as findDuplicates() saw them (when
+// it recorded them), and the merged record would pass update_contact().
+bool PhoneBook::merge_applies(const MergeProposal& proposal) const
+{
+    std::vector<ContactId> ids(1, proposal.keepId);
+    ids.insert(ids.end(), proposal.duplicateIds.begin(), proposal.duplicateIds.end());
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        auto it = mainStorage.find(ids[i]);
+        if (it == mainStorage.end()) return false;
+        if (i < proposal.before.size() && !ContactView(it->second).same_fields(proposal.before[i])) return false;
+    }
+    if (validateContact(proposal.merged) != 0) return false;
+    auto owner = emailIndex.find(proposal.merged.email);
+    return owner == emailIndex.end() || std::find(ids.begin(), ids.end(), owner->second) != ids.end();
+}
+
+std::size_t PhoneBook::apply_merges(const std::vector<MergeProposal>& proposals)
+{
+    std::size_t applied = 0;
+
+    for (const MergeProposal& proposal : proposals) {
+        if (!merge_applies(proposal)) continue;
+
+        remember_before(proposal.keepId);
+        for (ContactId id : proposal.duplicateIds) {
+            remember_before(id);
+            auto it = mainStorage.find(id);
+            unindex_contact(id, it->second);
+            mainStorage.erase(it);
+        }
+
+        // Iterators are not kept across erases.
+        auto keeper = mainStorage.find(proposal.keepId);
+        unindex_contact(proposal.keepId, keeper->second);
+        keeper->second = proposal.merged;
+        index_contact(proposal.keepId, proposal.merged);
+        ++applied;
+    }
+
+    if (applied > 0) {
+        rebuild_filters();
+        if (!persist()) {
+            std::cout << "Warning: could not save phone book to file ('" << storageFile << "').\n";
+        }
+    }
+    return applied;
+}
+
+// Renames `from` over `to`, replacing it in one step.
+static bool replaceFile(const std::string& from, const std::string& to)
+{
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
 bool PhoneBook::save_to_file(const std::string& filename) const
 {
     const std::string file = filename.empty() ? storageFile : filename;
-    std::ofstream out(file, std::ios::trunc);
+    const std::string temp = file + ".tmp";
+    std::ofstream out(temp, std::ios::trunc);
     if (!out.is_open()) {
         return false;
     }
@@ -50,8 +461,8 @@ bool PhoneBook::save_to_file(const std::string& filename) const
     out << mainStorage.size() << "\n";
 
     for (const auto& pair : mainStorage) {
-        const unsigned int id = pair.first;
-        const Contact& c = pair.second;
+        const ContactId id = pair.first;
+        const ContactView c = pair.second;
         out << id << ' '
             << std::quoted(c.firstName) << ' '
             << std::quoted(c.middleName) << ' '
@@ -65,7 +476,12 @@ bool PhoneBook::save_to_file(const std::string& filename) const
             << "\n";
     }
 
-    return static_cast<bool>(out);
+    out.close();
+    if (!out) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return replaceFile(temp, file);
 }
 
 bool PhoneBook::load_from_file(const std::string& filename)
@@ -85,7 +501,7 @@ bool PhoneBook::load_from_file(const std::string& filename)
         return false;
     }
 
-    unsigned int fileIndex = 0;
+    ContactId fileIndex = 0;
     std::size_t count = 0;
     {
         std::string line;
@@ -97,26 +513,22 @@ bool PhoneBook::load_from_file(const std::string& filename)
         if (!(iss2 >> count)) return false;
     }
 
-    // Reset current state
-    mainStorage.clear();
-    firstNameIndex.clear();
-    lastNameIndex.clear();
-    phoneWorkIndex.clear();
-    phoneHomeIndex.clear();
-    phoneOfficeIndex.clear();
-    emailIndex.clear();
+    // Reset current state (the header tells us how many contacts follow)
+    reset_storage(count);
     index = 0;
 
-    unsigned int maxId = 0;
+    ContactId maxId = 0;
     std::string recordLine;
     std::size_t loaded = 0;
+    std::istringstream iss;   // reused for every line to keep its buffer
+    Contact c;                // likewise: the parsed fields are copied into the record
 
     while (std::getline(in, recordLine)) {
         if (recordLine.empty()) continue;
-        std::istringstream iss(recordLine);
+        iss.clear();
+        iss.str(recordLine);
 
-        unsigned int id = 0;
-        Contact c;
+        ContactId id = 0;
         if (!(iss >> id
             >> std::quoted(c.firstName)
             >> std::quoted(c.middleName)
@@ -131,7 +543,6 @@ bool PhoneBook::load_from_file(const std::string& filename)
             continue;
         }
 
-        mainStorage[id] = c;
         maxId = std::max(maxId, id);
 
         // Rebuild indices (same behavior as your create_contact logic).
@@ -140,7 +551,16 @@ bool PhoneBook::load_from_file(const std::string& filename)
         if (!c.numbers.number1.empty()) phoneWorkIndex[c.numbers.number1] = id;
         if (!c.numbers.number2.empty()) phoneHomeIndex[c.numbers.number2] = id;
         if (!c.numbers.number3.empty()) phoneOfficeIndex[c.numbers.number3] = id;
+        index_phone(id, c.numbers.number1);
+        index_phone(id, c.numbers.number2);
+        index_phone(id, c.numbers.number3);
         if (!c.email.empty()) emailIndex[c.email] = id;
+        index_email_domain(id, c.email);
+        addressIndex.add(id, c.address);
+        index_ordered(id, c);
+
+        // One block from the book's pool per contact.
+        mainStorage[id] = c;
 
         ++loaded;
         if (count != 0 && loaded >= count) {
@@ -151,51 +571,155 @@ bool PhoneBook::load_from_file(const std::string& filename)
 
     // Keep index in sync so new IDs do not collide.
     index = std::max(fileIndex, maxId);
+    rebuild_filters();
+    publish_reset();
     return true;
 }
 
-void PhoneBook::create_contact(Contact contact)
+// Message for the first rule validateContact() reports as broken.
+static std::string contactErrorMessage(std::uint32_t errors)
 {
-    bool ok = true;
+    if (errors & ContactError::FirstName)   return "Invalid first name.";
+    if (errors & ContactError::LastName)    return "Invalid last name.";
+    if (errors & ContactError::Email)       return "Invalid email.";
+    if (errors & ContactError::WorkPhone)   return "Invalid phone: Work";
+    if (errors & ContactError::HomePhone)   return "Invalid phone: Home";
+    if (errors & ContactError::OfficePhone) return "Invalid phone: Office";
+    if (errors & ContactError::NoPhone)     return "At least one phone number is required.";
+    if (errors & ContactError::MiddleName)  return "Invalid middle name.";
+    if (errors & ContactError::Address)     return "Invalid address.";
+    return "Invalid birthday (must be dd-mm-yyyy and in the past).";
+}
 
-    // -------- REQUIRED FOR CREATING A CONTACT --------
-    // 1) First name + Last name
-    if (!isValidName(contact.firstName) || !isValidName(contact.lastName)) {
-        ok = false;
+bool PhoneBook::add_contact(Contact contact, std::string* error, ContactId* newId)
+{
+    const ContactId id = index + 1;
+    if (!insert_contact(id, std::move(contact), error)) {
+        return false;
     }
+    if (newId) *newId = id;
+    return true;
+}
 
-    // 2) Email
-    if (!isValidEmail(contact.email)) {
-        ok = false;
+bool PhoneBook::insert_contact(ContactId id, Contact contact, std::string* error)
+{
+    auto fail = [&](const std::string& msg) {
+        if (error) *error = msg;
+        return false;
+    };
+
+    if (const std::uint32_t errors = validateContact(contact)) {
+        return fail(contactErrorMessage(errors));
     }
+    return adopt_contact(id, contact, error);
+}
 
-    // 3) At least ONE valid phone from:
-    //    numbers.number1 -> work phone
-    //    numbers.number2 -> home phone
-    //    numbers.number3 -> office phone
-    bool hasAtLeastOnePhone = false;
-    bool allPhonesValid = true;
+bool PhoneBook::adopt_contact(ContactId id, const ContactView& contact, std::string* error)
+{
+    auto fail = [&](const std::string& msg) {
+        if (error) *error = msg;
+        return false;
+    };
 
-    auto checkPhoneField = [&](const std::string& p) {
-        if (!p.empty()) {
-            if (!isValidPhone(p)) {
-                allPhonesValid = false;
-            }
-            else {
-                hasAtLeastOnePhone = true;
-            }
-        }
-        };
+    if (id == 0 || mainStorage.find(id) != mainStorage.end()) {
+        return fail("Contact id " + std::to_string(id) + " is already in use.");
+    }
+    if (!contact.email.empty() && emailIndex.find(contact.email) != emailIndex.end()) {
+        return fail("A contact with this email already exists.");
+    }
 
-    checkPhoneField(contact.numbers.number1); // work
-    checkPhoneField(contact.numbers.number2); // home
-    checkPhoneField(contact.numbers.number3); // office
+    remember_before(id);
+    mainStorage[id] = contact;
+    index = std::max(index, id);
+    index_contact(id, contact);
+    remember_keys(contact);
 
-    if (!allPhonesValid || !hasAtLeastOnePhone) {
-        ok = false;
+    if (!persist()) {
+        return fail("Contact created, but failed to save to file.");
     }
+    return true;
+}
 
-    if (!ok) {
+bool PhoneBook::get_contact(ContactId id, Contact* out) const
+{
+    auto it = mainStorage.find(id);
+    if (it == mainStorage.end()) return false;
+    if (out) *out = it->second.to_contact();
+    return true;
+}
+
+bool PhoneBook::find_contact(ContactId id, ContactView* out) const
+{
+    auto it = mainStorage.find(id);
+    if (it == mainStorage.end()) return false;
+    if (out) *out = it->second;
+    return true;
+}
+
+bool PhoneBook::remove_contact(ContactId id, std::string* error)
+{
+    auto fail = [&](const std::string& msg) {
+        if (error) *error = msg;
+        return false;
+    };
+
+    auto it = mainStorage.find(id);
+    if (it == mainStorage.end()) return fail("Contact not found.");
+
+    remember_before(id);
+    unindex_contact(id, it->second);
+    mainStorage.erase(it);
+
+    if (!persist()) {
+        return fail("Contact deleted, but failed to save to file.");
+    }
+    return true;
+}
+
+bool PhoneBook::update_contact(ContactId id, Contact updated, std::string* error)
+{
+    auto fail = [&](const std::string& msg) {
+        if (error) *error = msg;
+        return false;
+    };
+
+    auto it = mainStorage.find(id);
+    if (it == mainStorage.end()) return fail("Contact not found.");
+
+    if (const std::uint32_t errors = validateContact(updated)) {
+        return fail(contactErrorMessage(errors));
+    }
+    if (email_in_use(updated.email, id)) {
+        return fail("A contact with this email already exists.");
+    }
+
+    remember_before(id);
+    unindex_contact(id, it->second);
+    it->second = updated;
+    index_contact(id, updated);
+
+    remember_email(updated.email);
+    remember_phone(updated.numbers.number1);
+    remember_phone(updated.numbers.number2);
+    remember_phone(updated.numbers.number3);
+
+    if (!persist()) {
+        return fail("Contact updated, but failed to save to file.");
+    }
+    return true;
+}
+
+void PhoneBook::create_contact(Contact contact)
+{
+    const std::uint32_t errors = validateContact(contact);
+
+    // -------- REQUIRED FOR CREATING A CONTACT --------
+    // First name, last name, email and at least ONE phone; every phone
+    // that is filled in must be valid:
+    //    numbers.number1 -> work phone
+    //    numbers.number2 -> home phone
+    //    numbers.number3 -> office phone
+    if (errors & ContactError::Required) {
         std::cout << "Missing required fields (first, last, email, one phone)." << std::endl;
         return;
     }
@@ -203,28 +727,40 @@ void PhoneBook::create_contact(Contact contact)
     // -------- ADDITIONAL FIELDS (OPTIONAL, BUT VALIDATED IF PRESENT) --------
 
     // Middle name: optional
-    if (!contact.middleName.empty() && !isValidName(contact.middleName)) {
+    if (errors & ContactError::MiddleName) {
         std::cout << "Invalid middle name." << std::endl;
         return;
     }
 
     // Address: optional – if not empty, must have at least one non-space
-    static const std::regex addressPattern(R"(^.*\S.*$)");
-    if (!contact.address.empty() &&
-        !std::regex_match(contact.address, addressPattern)) {
+    if (errors & ContactError::Address) {
         std::cout << "Invalid address (must contain at least one non-space character)." << std::endl;
         return;
     }
 
     // Birthday: optional – if not empty, must be a valid past date
-    if (!contact.birthday.empty() && !isValidBirthday(contact.birthday)) {
+    if (errors & ContactError::Birthday) {
         std::cout << "Invalid birthday." << std::endl;
         return;
     }
 
+    // Emails are unique, as in the database schema.
+    if (email_in_use(contact.email)) {
+        std::cout << "A contact with this email already exists." << std::endl;
+        return;
+    }
+
+    // Shared numbers (e.g. an office line) are allowed, just pointed out.
+    for (const std::string* phone : { &contact.numbers.number1, &contact.numbers.number2, &contact.numbers.number3 }) {
+        if (phone_in_use(*phone)) {
+            std::cout << "Note: " << *phone << " is already listed for another contact." << std::endl;
+        }
+    }
+
     // -------- STORE CONTACT AND UPDATE INDICES --------
 
-    unsigned int newId = ++index;  // index starts at 0 in constructor, so first is 1
+    ContactId newId = ++index;  // index starts at 0 in constructor, so first is 1
+    remember_before(newId);
     mainStorage[newId] = contact;
 
     // Name indices
@@ -243,19 +779,31 @@ void PhoneBook::create_contact(Contact contact)
         phoneOfficeIndex[contact.numbers.number3] = newId;
     }
 
+    index_phone(newId, contact.numbers.number1);
+    index_phone(newId, contact.numbers.number2);
+    index_phone(newId, contact.numbers.number3);
+
     // Email index
     emailIndex[contact.email] = newId;
+    index_email_domain(newId, contact.email);
+    addressIndex.add(newId, contact.address);
+    index_ordered(newId, contact);
+
+    remember_email(contact.email);
+    remember_phone(contact.numbers.number1);
+    remember_phone(contact.numbers.number2);
+    remember_phone(contact.numbers.number3);
 
     std::cout << "Contact created successfully" << std::endl;
 
     // Persist immediately so data survives program restart.
-    if (!save_to_file()) {
+    if (!persist()) {
         std::cout << "Warning: could not save phone book to file ('" << storageFile << "').\n";
     }
 }
 
 
-Contact PhoneBook::search(char method, const std::string& value)
+const ContactRecord* PhoneBook::search(char method, const std::string& value)
 {
     // Re-validate the search value based on the method
     switch (method) {
@@ -263,7 +811,7 @@ Contact PhoneBook::search(char method, const std::string& value)
     case '2': // last name
         if (!isValidName(value)) {
             std::cout << "Search value is not a valid name.\n";
-            return Contact{};
+            return nullptr;
         }
         break;
 
@@ -272,102 +820,69 @@ Contact PhoneBook::search(char method, const std::string& value)
     case '5': // office phone
         if (!isValidPhone(value)) {
             std::cout << "Search value is not a valid phone number.\n";
-            return Contact{};
+            return nullptr;
         }
         break;
 
     case '6': // email
         if (!isValidEmail(value)) {
             std::cout << "Search value is not a valid email.\n";
-            return Contact{};
+            return nullptr;
         }
         break;
 
     default:
         std::cout << "Unknown search method.\n";
-        return Contact{};
+        return nullptr;
     }
 
-    // Now we know the value is valid for this method.
-    unsigned int id = 0;
-    bool found = false;
-
+    // Now we know the value is valid for this method. The lookup goes
+    // through the query engine, which also finds contacts sharing a name.
+    QueryPredicate predicate;
+    predicate.match = QueryMatch::Exact;
+    predicate.value = value;
     switch (method) {
-    case '1': { // first name
-        auto it = firstNameIndex.find(value);
-        if (it != firstNameIndex.end()) {
-            id = it->second;
-            found = true;
-        }
-        break;
-    }
-    case '2': { // last name
-        auto it = lastNameIndex.find(value);
-        if (it != lastNameIndex.end()) {
-            id = it->second;
-            found = true;
-        }
-        break;
-    }
-    case '3': { // work phone
-        auto it = phoneWorkIndex.find(value);
-        if (it != phoneWorkIndex.end()) {
-            id = it->second;
-            found = true;
-        }
-        break;
-    }
-    case '4': { // home phone
-        auto it = phoneHomeIndex.find(value);
-        if (it != phoneHomeIndex.end()) {
-            id = it->second;
-            found = true;
-        }
-        break;
-    }
-    case '5': { // office phone
-        auto it = phoneOfficeIndex.find(value);
-        if (it != phoneOfficeIndex.end()) {
-            id = it->second;
-            found = true;
-        }
-        break;
-    }
-    case '6': { // email
-        auto it = emailIndex.find(value);
-        if (it != emailIndex.end()) {
-            id = it->second;
-            found = true;
-        }
-        break;
-    }
+    case '1': predicate.field = QueryField::FirstName; break;
+    case '2': predicate.field = QueryField::LastName; break;
+    case '3': predicate.field = QueryField::WorkPhone; break;
+    case '4': predicate.field = QueryField::HomePhone; break;
+    case '5': predicate.field = QueryField::OfficePhone; break;
+    case '6': predicate.field = QueryField::Email; break;
     }
 
-    if (!found) {
+    Query query;
+    query.anyOf.push_back({ predicate });
+    query.caseSensitive = true;
+    const std::vector<ContactId> ids = runQuery(*this, query);
+
+    if (ids.empty()) {
         std::cout << "No contact found for the given search value.\n";
-        return Contact{};
+        return nullptr;
     }
 
-    // Retrieve contact from mainStorage by id
-    auto itMain = mainStorage.find(id);
-    if (itMain != mainStorage.end()) {
-        return itMain->second;
-    }
-    else {
-        std::cout << "Internal error: contact not found in main storage.\n";
-        return Contact{};
+    // The first match is returned; any others are listed here.
+    if (ids.size() > 1) {
+        std::cout << ids.size() << " contacts match. Also matching:\n";
+        for (std::size_t i = 1; i < ids.size(); ++i) {
+            std::cout << "\n[ID: " << ids[i] << "]\n";
+            mainStorage.at(ids[i]).print_contact();
+        }
     }
+    return &mainStorage.at(ids.front());
 }
 
- void PhoneBook::edit_contact_fields(PhoneBook& book, unsigned int id)
+ void PhoneBook::edit_contact_fields(PhoneBook& book, ContactId id)
 {
     auto itMain = book.mainStorage.find(id);
     if (itMain == book.mainStorage.end()) {
         std::cout << "Internal error: contact not found.\n";
         return;
     }
+    book.remember_before(id);
 
-    Contact& contact = itMain->second;
+    // Edited unpacked, stored back once when done; the indexes follow
+    // each field as it changes, the Bloom filters the stored record.
+    Contact contact = itMain->second.to_contact();
 
     while (true) {
         std::cout << "\n===== EDIT MENU for ID " << id << " =====\n";
@@ -411,7 +926,9 @@ Contact PhoneBook::search(char method, const std::string& value)
                     book.firstNameIndex.erase(itIndex);
                 }
                 book.firstNameIndex[input] = id;
+                book.unindex_ordered(id, contact);
                 contact.firstName = input;
+                book.index_ordered(id, contact);
             }
             break;
         }
@@ -431,7 +948,9 @@ Contact PhoneBook::search(char method, const std::string& value)
                     book.lastNameIndex.erase(itIndex);
                 }
                 book.lastNameIndex[input] = id;
+                book.unindex_ordered(id, contact);
                 contact.lastName = input;
+                book.index_ordered(id, contact);
             }
             break;
         }
@@ -455,8 +974,10 @@ Contact PhoneBook::search(char method, const std::string& value)
             std::cout << "Enter new EMAIL (leave empty to keep '" << oldVal << "'): ";
             std::getline(std::cin, input);
 
-            while (!input.empty() && !isValidEmail(input)) {
-                std::cout << "Invalid email. Try again (or empty to keep current): ";
+            while (!input.empty() && (!isValidEmail(input) || book.email_in_use(input, id))) {
+                std::cout << (isValidEmail(input) ? "Email already belongs to another contact."
+                                                  : "Invalid email.")
+                          << " Try again (or empty to keep current): ";
                 std::getline(std::cin, input);
             }
 
@@ -466,6 +987,8 @@ Contact PhoneBook::search(char method, const std::string& value)
                     book.emailIndex.erase(itIndex);
                 }
                 book.emailIndex[input] = id;
+                book.unindex_email_domain(id, oldVal);
+                book.index_email_domain(id, input);
                 contact.email = input;
             }
             break;
@@ -488,7 +1011,11 @@ Contact PhoneBook::search(char method, const std::string& value)
                     }
                 }
                 book.phoneWorkIndex[input] = id;
+                book.unindex_phone(id, oldVal);
+                book.index_phone(id, input);
+                book.unindex_ordered(id, contact);
                 contact.numbers.number1 = input;
+                book.index_ordered(id, contact);
             }
             break;
         }
@@ -510,7 +1037,11 @@ Contact PhoneBook::search(char method, const std::string& value)
                     }
                 }
                 book.phoneHomeIndex[input] = id;
+                book.unindex_phone(id, oldVal);
+                book.index_phone(id, input);
+                book.unindex_ordered(id, contact);
                 contact.numbers.number2 = input;
+                book.index_ordered(id, contact);
             }
             break;
         }
@@ -532,29 +1063,34 @@ Contact PhoneBook::search(char method, const std::string& value)
                     }
                 }
                 book.phoneOfficeIndex[input] = id;
+                book.unindex_phone(id, oldVal);
+                book.index_phone(id, input);
+                book.unindex_ordered(id, contact);
                 contact.numbers.number3 = input;
+                book.index_ordered(id, contact);
             }
             break;
         }
-        case '8': { // Address (no index map)
+        case '8': { // Address (full-text index)
             std::string oldVal = contact.address;
-            static const std::regex addressPattern(R"(^.*\S.*$)");
 
             std::cout << "Enter new ADDRESS (leave empty to keep '" << oldVal << "'): ";
             std::getline(std::cin, input);
 
-            while (!input.empty() && !std::regex_match(input, addressPattern)) {
+            while (!input.empty() && !isValidAddress(input)) {
                 std::cout << "Invalid address. Must contain at least one non-space.\n"
                     "Try again (or empty to keep current): ";
                 std::getline(std::cin, input);
             }
 
             if (!input.empty()) {
+                book.addressIndex.remove(id, oldVal);
+                book.addressIndex.add(id, input);
                 contact.address = input;
             }
             break;
         }
-        case '9': { // Birthday (no index map)
+        case '9': { // Birthday (ordered index)
             std::string oldVal = contact.birthday;
             std::cout << "Enter new BIRTHDAY (dd-mm-yyyy, leave empty to keep '" << oldVal << "'): ";
             std::getline(std::cin, input);
@@ -566,7 +1102,9 @@ Contact PhoneBook::search(char method, const std::string& value)
             }
 
             if (!input.empty()) {
+                book.unindex_ordered(id, contact);
                 contact.birthday = input;
+                book.index_ordered(id, contact);
             }
             break;
         }
@@ -576,11 +1114,16 @@ Contact PhoneBook::search(char method, const std::string& value)
         }
     }
 
+    book.mainStorage.at(id) = contact;
+    // Only now, with the record stored: a filter that saturates rebuilds
+    // from mainStorage and would otherwise miss the new keys.
+    book.remember_keys(contact);
+
     // Persist edits immediately.
-    (void)book.save_to_file();
+    (void)book.persist();
 }
 
-void PhoneBook::delete_contact_impl(PhoneBook& book, unsigned int id)
+void PhoneBook::delete_contact_impl(PhoneBook& book, ContactId id)
 {
     auto itMain = book.mainStorage.find(id);
     if (itMain == book.mainStorage.end()) {
@@ -588,14 +1131,16 @@ void PhoneBook::delete_contact_impl(PhoneBook& book, unsigned int id)
         return;
     }
 
-    // Copy contact before erasing, so we still know the keys to remove from indices
-    Contact contact = itMain->second;
+    book.remember_before(id);
+    // Take the contact out before erasing, so we still know the keys to remove from indices
+    const ContactRecord record = std::move(itMain->second);
+    const ContactView contact = record;
 
     // Remove from main storage
     book.mainStorage.erase(itMain);
 
     // Helper lambda to erase key from a map if it belongs to this id
-    auto eraseKey = [id](auto& mp, const std::string& key) {
+    auto eraseKey = [id](auto& mp, std::string_view key) {
         if (key.empty()) return;
         auto it = mp.find(key);
         if (it != mp.end() && it->second == id) {
@@ -611,14 +1156,20 @@ void PhoneBook::delete_contact_impl(PhoneBook& book, unsigned int id)
     eraseKey(book.phoneWorkIndex, contact.numbers.number1);
     eraseKey(book.phoneHomeIndex, contact.numbers.number2);
     eraseKey(book.phoneOfficeIndex, contact.numbers.number3);
+    book.unindex_phone(id, contact.numbers.number1);
+    book.unindex_phone(id, contact.numbers.number2);
+    book.unindex_phone(id, contact.numbers.number3);
 
     // Email index
     eraseKey(book.emailIndex, contact.email);
+    book.unindex_email_domain(id, contact.email);
+    book.addressIndex.remove(id, contact.address);
+    book.unindex_ordered(id, contact);
 
     std::cout << "Contact deleted successfully.\n";
 
     // Persist immediately.
-    (void)book.save_to_file();
+    (void)book.persist();
 }
 void PhoneBook::list_sorted_contacts(char method)
 {
@@ -627,53 +1178,139 @@ void PhoneBook::list_sorted_contacts(char method)
         return;
     }
 
-    // Collect all IDs from mainStorage
-    std::vector<unsigned int> ids;
-    ids.reserve(mainStorage.size());
-    for (const auto& pair : mainStorage) {
-        ids.push_back(pair.first);
-    }
-
-    // Decide how to compare based on method:
-    // '1' -> first name, '2' -> last name
-    if (method == '1') {
-        // Sort by first name ascending, tie-break by ID
-        std::sort(ids.begin(), ids.end(),
-            [this](unsigned int a, unsigned int b) {
-                const std::string& na = mainStorage.at(a).firstName;
-                const std::string& nb = mainStorage.at(b).firstName;
-                if (na != nb)
-                    return na < nb;   // ascending lexicographical order
-                return a < b;         // tie-break: smaller ID first
-            }
-        );
-
+    // '1' -> first name, '2' -> last name, '3' -> id, '4' -> email; ties by ID
+    PageRequest request;
+    request.pageSize = kListPageSize;
+    switch (method) {
+    case '1':
+        request.key = SortKey::FirstName;
         std::cout << "==== CONTACTS SORTED BY FIRST NAME (ASC) ====\n";
+        break;
+    case '2':
+        request.key = SortKey::LastName;
+        std::cout << "==== CONTACTS SORTED BY LAST NAME (ASC) ====\n";
+        break;
+    case '3':
+        request.key = SortKey::Id;
+        std::cout << "==== CONTACTS SORTED BY ID (ASC) ====\n";
+        break;
+    case '4':
+        request.key = SortKey::Email;
+        std::cout << "==== CONTACTS SORTED BY EMAIL (ASC) ====\n";
+        break;
+    default:
+        std::cout << "Unknown sort method. Use '1'-'4'.\n";
+        return;
+    }
+
+    auto show = [this](ContactId id) {
+        std::cout << "\n[ID: " << id << "]\n";
+        mainStorage.at(id).print_contact();
+    };
+    auto more = [this](std::size_t shown) {
+        std::cout << "\n-- " << shown << " of " << mainStorage.size()
+                  << " shown. Enter for the next page, 'q' to stop: ";
+        std::string answer;
+        return std::getline(std::cin, answer) && answer != "q" && answer != "Q";
+    };
+
+    // Email has no ordered index, so every page would scan the whole
+    // book; sort it once (in parallel) and page through the result.
+    if (request.key == SortKey::Email) {
+        const std::vector<ContactId> order = sorted_ids(request.key);
+        std::size_t shown = 0;
+        while (true) {
+            const std::size_t end = std::min(order.size(), shown + kListPageSize);
+            for (; shown < end; ++shown) show(order[shown]);
+            if (shown == order.size() || !more(shown)) break;
+        }
+        return;
+    }
 
+    // One page at a time; each page costs about its own size.
+    std::size_t shown = 0;
+    Page page;
+    std::string error;
+    while (true) {
+        if (!this->page(request, &page, &error)) {
+            std::cout << "Listing stopped: " << error << "\n";
+            return;
+        }
+        for (ContactId id : page.ids) show(id);
+        shown += page.ids.size();
+        if (page.nextCursor.empty() || !more(shown)) break;
+        request.cursor = page.nextCursor;
     }
-    else if (method == '2') {
-        // Sort by last name ascending, tie-break by ID
-        std::sort(ids.begin(), ids.end(),
-            [this](unsigned int a, unsigned int b) {
-                const std::string& na = mainStorage.at(a).lastName;
-                const std::string& nb = mainStorage.at(b).lastName;
-                if (na != nb)
-                    return na < nb;   // ascending lexicographical order
-                return a < b;         // tie-break: smaller ID first
-            }
-        );
+}
 
-        std::cout << "==== CONTACTS SORTED BY LAST NAME (ASC) ====\n";
+void PhoneBook::list_domain_contacts(const std::string& domain)
+{
+    const std::vector<ContactId> ids = contacts_at_domain(domain);
+    if (ids.empty()) {
+        std::cout << "No contacts with an email at '" << emailDomain(domain) << "'.\n";
+        return;
+    }
+
+    std::cout << "==== " << ids.size() << " CONTACT(S) AT " << emailDomain(domain) << " ====\n";
+    for (ContactId id : ids) {
+        std::cout << "\n[ID: " << id << "]\n";
+        mainStorage.at(id).print_contact();
+    }
+}
+
+void PhoneBook::list_domain_counts()
+{
+    const std::vector<std::pair<std::string, std::size_t>> counts = domain_counts();
+    if (counts.empty()) {
+        std::cout << "No email domains to list.\n";
+        return;
+    }
+
+    std::cout << "==== CONTACTS PER EMAIL DOMAIN ====\n";
+    for (const auto& entry : counts) {
+        std::cout << std::setw(8) << entry.second << "  " << entry.first << "\n";
+    }
+}
+
+void PhoneBook::list_address_matches(const std::string& query)
+{
+    const std::vector<AddressIndex::Hit> hits = addressIndex.search(query, kAddressResults);
+    if (hits.empty()) {
+        std::cout << "No addresses match '" << query << "'.\n";
+        return;
+    }
 
+    std::cout << "==== BEST " << hits.size() << " ADDRESS MATCH(ES) ====\n";
+    for (const AddressIndex::Hit& hit : hits) {
+        std::cout << "\n[ID: " << hit.id << ", score " << std::fixed << std::setprecision(2)
+                  << hit.score << std::defaultfloat << "]\n";
+        mainStorage.at(hit.id).print_contact();
     }
-    else {
-        std::cout << "Unknown sort method. Use '1' for first name or '2' for last name.\n";
+}
+
+void PhoneBook::run_query(const std::string& text)
+{
+    Query query;
+    std::string error;
+    if (!parseQuery(text, &query, &error)) {
+        std::cout << "Query error: " << error << "\n";
+        return;
+    }
+
+    QueryStats stats;
+    const std::vector<ContactId> ids = runQuery(*this, query, &stats);
+    for (const std::string& step : stats.plan) {
+        std::cout << "Plan: " << step << "\n";
+    }
+
+    if (ids.empty()) {
+        std::cout << "No contacts match (" << stats.examined << " checked).\n";
         return;
     }
 
-    // Print all contacts in the sorted order
-    for (unsigned int id : ids) {
+    std::cout << "==== " << ids.size() << " MATCH(ES), " << stats.examined << " CHECKED ====\n";
+    for (ContactId id : ids) {
         std::cout << "\n[ID: " << id << "]\n";
-        mainStorage.at(id).print_contact();  // uses your Contact::print_contact()
+        mainStorage.at(id).print_contact();
     }
 }
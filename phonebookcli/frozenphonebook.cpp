@@ -0,0 +1,627 @@
+#include "FrozenPhoneBook.h"
+#include "PhoneBook.h"
+#include "Checkers.h"
+#include "FlatHashMap.h"
+#include "ParallelSort.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// ---------- IMAGE LAYOUT ----------
+// Everything is addressed by byte offset from the start of the image, so
+// the same bytes work in memory and mapped from disk. Sections are 8-byte
+// aligned. Integers are stored in host (little-endian) order.
+//
+//   ImageHeader
+//   ImageRecord[contactCount]            ordered by contact ID
+//   email index: MphHeader, pilots, entries, postings
+//   phone index: MphHeader, pilots, entries, postings
+//   blob: interned strings, each as <varint length><bytes>
+namespace {
+
+constexpr char kMagic[8] = { 'P', 'B', 'F', 'R', 'O', 'Z', 'E', 'N' };
+constexpr std::uint32_t kVersion = 2;   // 2: 64-bit contact ids
+constexpr int kFieldCount = 9;
+
+struct ImageHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t contactCount;
+    std::uint64_t nextIndex;
+    std::uint64_t imageSize;
+    std::uint64_t recordsOffset;
+    std::uint64_t emailIndexOffset;
+    std::uint64_t phoneIndexOffset;
+    std::uint64_t blobOffset;
+    std::uint64_t blobSize;
+};
+
+// Field order: first, middle, last, work, home, office, email, address, birthday.
+struct ImageRecord {
+    std::uint64_t id;
+    std::uint32_t field[kFieldCount];   // blob offsets
+    std::uint32_t reserved;             // pads the record to 8 bytes
+};
+
+struct MphHeader {
+    std::uint64_t seed;
+    std::uint32_t keyCount;
+    std::uint32_t bucketCount;
+    std::uint32_t postingCount;
+    std::uint32_t reserved;
+    std::uint64_t pilotsOffset;     // uint32_t[bucketCount]
+    std::uint64_t entriesOffset;    // MphEntry[keyCount], indexed by hash slot
+    std::uint64_t postingsOffset;   // uint32_t[postingCount], record positions
+};
+
+struct MphEntry {
+    std::uint32_t key;              // blob offset of the key
+    std::uint32_t postingStart;
+    std::uint32_t postingCount;
+};
+
+// ---------- MINIMAL PERFECT HASH ----------
+// "Hash and displace": keys are spread over n/4 buckets; buckets are placed
+// largest first, each searching for a pilot value that sends all its keys
+// to free slots. With n slots for n keys the result is minimal and a
+// lookup is one hash, one pilot read and one key comparison.
+
+std::uint64_t keyHash(std::string_view key, std::uint64_t seed) {
+    return flat_detail::hashInt(flat_detail::hashBytes(key.data(), key.size()) ^ seed);
+}
+
+std::uint32_t bucketOf(std::uint64_t hash, std::uint32_t bucketCount) {
+    return static_cast<std::uint32_t>(((hash >> 32) * bucketCount) >> 32);
+}
+
+std::uint32_t slotOf(std::uint64_t hash, std::uint32_t pilot, std::uint32_t keyCount) {
+    return static_cast<std::uint32_t>((hash ^ flat_detail::hashInt(pilot)) % keyCount);
+}
+
+struct BuiltMph {
+    std::uint64_t seed = 0;
+    std::vector<std::uint32_t> pilots;
+    std::vector<std::uint32_t> slotOfKey;
+};
+
+bool buildMph(const std::vector<std::string_view>& keys, BuiltMph& out) {
+    const std::uint32_t n = static_cast<std::uint32_t>(keys.size());
+    if (n == 0) {
+        out = BuiltMph{};
+        return true;
+    }
+
+    const std::uint32_t m = n / 4 + 1;
+    const std::uint64_t maxPilot = std::max<std::uint64_t>(1024, std::uint64_t(n) * 64);
+    std::vector<std::uint64_t> hashes(n);
+    std::vector<std::uint32_t> buckets(n);
+
+    for (std::uint64_t attempt = 0; attempt < 8; ++attempt) {
+        const std::uint64_t seed = flat_detail::kSeed2 * (attempt + 1);
+        for (std::uint32_t i = 0; i < n; ++i) hashes[i] = keyHash(keys[i], seed);
+
+        // Group keys by bucket, largest buckets first.
+        std::vector<std::uint32_t> bucketSize(m, 0);
+        for (std::uint32_t i = 0; i < n; ++i) {
+            buckets[i] = bucketOf(hashes[i], m);
+            ++bucketSize[buckets[i]];
+        }
+
+        std::vector<std::uint32_t> order(n);
+        for (std::uint32_t i = 0; i < n; ++i) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+            const std::uint32_t ba = buckets[a], bb = buckets[b];
+            if (bucketSize[ba] != bucketSize[bb]) return bucketSize[ba] > bucketSize[bb];
+            return ba < bb;
+        });
+
+        std::vector<char> taken(n, 0);
+        out.seed = seed;
+        out.pilots.assign(m, 0);
+        out.slotOfKey.assign(n, 0);
+
+        bool ok = true;
+        std::vector<std::uint32_t> slots;
+        for (std::size_t start = 0; start < order.size() && ok;) {
+            const std::uint32_t bucket = buckets[order[start]];
+            std::size_t end = start;
+            while (end < order.size() && buckets[order[end]] == bucket) ++end;
+
+            bool placed = false;
+            for (std::uint64_t pilot = 0; pilot < maxPilot && !placed; ++pilot) {
+                slots.clear();
+                bool fits = true;
+                for (std::size_t k = start; k < end && fits; ++k) {
+                    const std::uint32_t s = slotOf(hashes[order[k]], static_cast<std::uint32_t>(pilot), n);
+                    fits = !taken[s] && std::find(slots.begin(), slots.end(), s) == slots.end();
+                    slots.push_back(s);
+                }
+                if (!fits) continue;
+
+                for (std::size_t k = start; k < end; ++k) {
+                    taken[slots[k - start]] = 1;
+                    out.slotOfKey[order[k]] = slots[k - start];
+                }
+                out.pilots[bucket] = static_cast<std::uint32_t>(pilot);
+                placed = true;
+            }
+            ok = placed;
+            start = end;
+        }
+        if (ok) return true;
+    }
+    return false;
+}
+
+// ---------- IMAGE WRITER ----------
+
+void appendVarint(std::string& blob, std::uint32_t v) {
+    while (v >= 0x80) {
+        blob += static_cast<char>((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    blob += static_cast<char>(v);
+}
+
+std::size_t align8(std::size_t n) { return (n + 7) & ~static_cast<std::size_t>(7); }
+
+class ImageWriter {
+public:
+    std::vector<std::uint64_t> words;   // 8-byte aligned backing store
+    std::size_t used = 0;
+
+    std::size_t reserve(std::size_t bytes) {
+        const std::size_t offset = used;
+        used = align8(used + bytes);
+        words.resize(used / 8, 0);
+        return offset;
+    }
+    unsigned char* at(std::size_t offset) {
+        return reinterpret_cast<unsigned char*>(words.data()) + offset;
+    }
+};
+
+// Key -> record positions, ready to be laid out behind a perfect hash.
+struct KeyPostings {
+    FlatHashMap<std::string_view, std::uint32_t> slotOf;   // key -> index in keys
+    std::vector<std::string_view> keys;
+    std::vector<std::vector<std::uint32_t>> postings;
+
+    void add(std::string_view key, std::uint32_t position) {
+        auto res = slotOf.try_emplace(key, static_cast<std::uint32_t>(keys.size()));
+        if (res.second) {
+            keys.push_back(key);
+            postings.emplace_back();
+        }
+        std::vector<std::uint32_t>& list = postings[res.first->second];
+        if (list.empty() || list.back() != position) list.push_back(position);
+    }
+};
+
+bool writeIndex(ImageWriter& image, std::size_t headerOffset, const KeyPostings& input,
+                const FlatHashMap<std::string_view, std::uint32_t>& blobOffsets) {
+    BuiltMph mph;
+    if (!buildMph(input.keys, mph)) return false;
+
+    std::size_t postingCount = 0;
+    for (const auto& list : input.postings) postingCount += list.size();
+
+    const std::size_t pilotsOffset = image.reserve(mph.pilots.size() * sizeof(std::uint32_t));
+    const std::size_t entriesOffset = image.reserve(input.keys.size() * sizeof(MphEntry));
+    const std::size_t postingsOffset = image.reserve(postingCount * sizeof(std::uint32_t));
+
+    MphHeader header{};
+    header.seed = mph.seed;
+    header.keyCount = static_cast<std::uint32_t>(input.keys.size());
+    header.bucketCount = static_cast<std::uint32_t>(mph.pilots.size());
+    header.postingCount = static_cast<std::uint32_t>(postingCount);
+    header.pilotsOffset = pilotsOffset;
+    header.entriesOffset = entriesOffset;
+    header.postingsOffset = postingsOffset;
+    std::memcpy(image.at(headerOffset), &header, sizeof(header));
+
+    if (!mph.pilots.empty()) {
+        std::memcpy(image.at(pilotsOffset), mph.pilots.data(),
+                    mph.pilots.size() * sizeof(std::uint32_t));
+    }
+
+    std::uint32_t next = 0;
+    for (std::size_t k = 0; k < input.keys.size(); ++k) {
+        const auto& list = input.postings[k];
+        MphEntry entry{};
+        entry.key = blobOffsets.at(input.keys[k]);
+        entry.postingStart = next;
+        entry.postingCount = static_cast<std::uint32_t>(list.size());
+        std::memcpy(image.at(entriesOffset) + mph.slotOfKey[k] * sizeof(MphEntry), &entry, sizeof(entry));
+        std::memcpy(image.at(postingsOffset) + next * sizeof(std::uint32_t), list.data(),
+                    list.size() * sizeof(std::uint32_t));
+        next += entry.postingCount;
+    }
+    return true;
+}
+
+} // namespace
+
+// ---------- FrozenContact ----------
+
+Contact FrozenContact::to_contact() const
+{
+    return Contact(std::string(firstName), std::string(middleName), std::string(lastName),
+        Phone(std::string(work), std::string(home), std::string(office)),
+        std::string(email), std::string(address), std::string(birthday));
+}
+
+// ---------- FrozenPhoneBook ----------
+
+FrozenPhoneBook::FrozenPhoneBook() : m_base(nullptr), m_size(0), m_mapping(nullptr)
+#ifdef _WIN32
+    , m_fileHandle(nullptr), m_mapHandle(nullptr)
+#endif
+{
+}
+
+FrozenPhoneBook::FrozenPhoneBook(FrozenPhoneBook&& other) noexcept : FrozenPhoneBook()
+{
+    *this = std::move(other);
+}
+
+FrozenPhoneBook& FrozenPhoneBook::operator=(FrozenPhoneBook&& other) noexcept
+{
+    if (this != &other) {
+        close();
+        std::swap(m_base, other.m_base);
+        std::swap(m_size, other.m_size);
+        std::swap(m_owned, other.m_owned);
+        std::swap(m_mapping, other.m_mapping);
+#ifdef _WIN32
+        std::swap(m_fileHandle, other.m_fileHandle);
+        std::swap(m_mapHandle, other.m_mapHandle);
+#endif
+    }
+    return *this;
+}
+
+FrozenPhoneBook::~FrozenPhoneBook()
+{
+    close();
+}
+
+FrozenPhoneBook FrozenPhoneBook::freeze(const PhoneBook& book)
+{
+    // Contacts in ID order, so positions are stable between freezes.
+    std::vector<std::pair<ContactId, const ContactRecord*>> contacts;
+    contacts.reserve(book.mainStorage.size());
+    for (const auto& pair : book.mainStorage) {
+        contacts.emplace_back(pair.first, &pair.second);
+    }
+    parallelSort(contacts, [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    // Normalized phones must outlive the string_views that point at them.
+    std::vector<std::string> normalizedPhones;
+    normalizedPhones.reserve(contacts.size() * 3);
+
+    // Intern every distinct string once.
+    std::string blob;
+    FlatHashMap<std::string_view, std::uint32_t> blobOffsets;
+    auto intern = [&](std::string_view s) {
+        auto res = blobOffsets.try_emplace(s, static_cast<std::uint32_t>(blob.size()));
+        if (res.second) {
+            appendVarint(blob, static_cast<std::uint32_t>(s.size()));
+            blob.append(s.data(), s.size());
+        }
+        return res.first->second;
+    };
+
+    std::vector<ImageRecord> records(contacts.size());
+    KeyPostings emails;
+    KeyPostings phones;
+    blobOffsets.reserve(contacts.size() * (kFieldCount + 3));
+    emails.slotOf.reserve(contacts.size());
+    phones.slotOf.reserve(contacts.size() * 3);
+
+    for (std::size_t i = 0; i < contacts.size(); ++i) {
+        const ContactView c = *contacts[i].second;
+        const std::uint32_t position = static_cast<std::uint32_t>(i);
+        const std::string_view fields[kFieldCount] = {
+            c.firstName, c.middleName, c.lastName,
+            c.numbers.number1, c.numbers.number2, c.numbers.number3,
+            c.email, c.address, c.birthday
+        };
+
+        ImageRecord& r = records[i];
+        r.id = contacts[i].first;
+        for (int f = 0; f < kFieldCount; ++f) r.field[f] = intern(fields[f]);
+
+        if (!c.email.empty()) emails.add(c.email, position);
+
+        for (std::string_view phone : { fields[3], fields[4], fields[5] }) {
+            if (phone.empty()) continue;
+            std::string normalized = normalizePhone(phone);
+            if (normalized.empty()) normalized = phone;   // stored as-is, match as-is
+            normalizedPhones.push_back(std::move(normalized));
+            intern(normalizedPhones.back());
+            phones.add(normalizedPhones.back(), position);
+        }
+    }
+
+    ImageWriter image;
+    const std::size_t headerOffset = image.reserve(sizeof(ImageHeader));
+    const std::size_t recordsOffset = image.reserve(records.size() * sizeof(ImageRecord));
+    if (!records.empty()) {
+        std::memcpy(image.at(recordsOffset), records.data(), records.size() * sizeof(ImageRecord));
+    }
+
+    const std::size_t emailIndexOffset = image.reserve(sizeof(MphHeader));
+    const std::size_t phoneIndexOffset = image.reserve(sizeof(MphHeader));
+    if (!writeIndex(image, emailIndexOffset, emails, blobOffsets) ||
+        !writeIndex(image, phoneIndexOffset, phones, blobOffsets)) {
+        return FrozenPhoneBook{};
+    }
+
+    const std::size_t blobOffset = image.reserve(blob.size());
+    if (!blob.empty()) std::memcpy(image.at(blobOffset), blob.data(), blob.size());
+
+    ImageHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.contactCount = static_cast<std::uint32_t>(records.size());
+    header.nextIndex = book.index;
+    header.imageSize = image.used;
+    header.recordsOffset = recordsOffset;
+    header.emailIndexOffset = emailIndexOffset;
+    header.phoneIndexOffset = phoneIndexOffset;
+    header.blobOffset = blobOffset;
+    header.blobSize = blob.size();
+    std::memcpy(image.at(headerOffset), &header, sizeof(header));
+
+    FrozenPhoneBook frozen;
+    frozen.m_owned = std::move(image.words);
+    frozen.attach(reinterpret_cast<const unsigned char*>(frozen.m_owned.data()), image.used);
+    return frozen;
+}
+
+bool FrozenPhoneBook::save(const std::string& filename) const
+{
+    if (!is_open()) return false;
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) return false;
+    out.write(reinterpret_cast<const char*>(m_base), static_cast<std::streamsize>(m_size));
+    return static_cast<bool>(out);
+}
+
+bool FrozenPhoneBook::open(const std::string& filename)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    m_fileHandle = file;
+    m_mapHandle = mapping;
+    m_mapping = view;
+    const std::size_t length = static_cast<std::size_t>(size.QuadPart);
+#else
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    const std::size_t length = static_cast<std::size_t>(st.st_size);
+    void* view = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);   // the mapping keeps the file alive
+    if (view == MAP_FAILED) return false;
+    m_mapping = view;
+#endif
+
+    m_size = length;
+    if (!attach(static_cast<const unsigned char*>(view), length)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void FrozenPhoneBook::close()
+{
+    if (m_mapping) {
+#ifdef _WIN32
+        UnmapViewOfFile(m_mapping);
+        CloseHandle(static_cast<HANDLE>(m_mapHandle));
+        CloseHandle(static_cast<HANDLE>(m_fileHandle));
+        m_mapHandle = nullptr;
+        m_fileHandle = nullptr;
+#else
+        ::munmap(m_mapping, m_size);
+#endif
+        m_mapping = nullptr;
+    }
+    m_owned.clear();
+    m_owned.shrink_to_fit();
+    m_base = nullptr;
+    m_size = 0;
+}
+
+// Checks the header and that every section lies inside the image.
+// Individual strings and postings are bounds-checked when they are read.
+bool FrozenPhoneBook::attach(const unsigned char* base, std::size_t size)
+{
+    if (size < sizeof(ImageHeader)) return false;
+
+    ImageHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) return false;
+    if (header.version != kVersion || header.imageSize != size) return false;
+
+    auto inside = [size](std::uint64_t offset, std::uint64_t bytes) {
+        return offset <= size && bytes <= size - offset && offset % 8 == 0;
+    };
+    if (!inside(header.recordsOffset, std::uint64_t(header.contactCount) * sizeof(ImageRecord))) return false;
+    if (!inside(header.blobOffset, header.blobSize)) return false;
+
+    for (std::uint64_t indexOffset : { header.emailIndexOffset, header.phoneIndexOffset }) {
+        if (!inside(indexOffset, sizeof(MphHeader))) return false;
+        MphHeader mh;
+        std::memcpy(&mh, base + indexOffset, sizeof(mh));
+        if (mh.keyCount != 0 && mh.bucketCount == 0) return false;
+        if (!inside(mh.pilotsOffset, std::uint64_t(mh.bucketCount) * sizeof(std::uint32_t))) return false;
+        if (!inside(mh.entriesOffset, std::uint64_t(mh.keyCount) * sizeof(MphEntry))) return false;
+        if (!inside(mh.postingsOffset, std::uint64_t(mh.postingCount) * sizeof(std::uint32_t))) return false;
+    }
+
+    m_base = base;
+    m_size = size;
+    return true;
+}
+
+std::size_t FrozenPhoneBook::size() const
+{
+    if (!is_open()) return 0;
+    return reinterpret_cast<const ImageHeader*>(m_base)->contactCount;
+}
+
+ContactId FrozenPhoneBook::get_index() const
+{
+    if (!is_open()) return 0;
+    return reinterpret_cast<const ImageHeader*>(m_base)->nextIndex;
+}
+
+std::string_view FrozenPhoneBook::string_at(std::uint32_t offset) const
+{
+    const ImageHeader* header = reinterpret_cast<const ImageHeader*>(m_base);
+    const unsigned char* blob = m_base + header->blobOffset;
+    const std::uint64_t blobSize = header->blobSize;
+
+    std::uint64_t pos = offset;
+    std::uint32_t length = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (pos >= blobSize) return {};
+        const unsigned char byte = blob[pos++];
+        length |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            if (length > blobSize - pos) return {};
+            return std::string_view(reinterpret_cast<const char*>(blob + pos), length);
+        }
+    }
+    return {};
+}
+
+FrozenContact FrozenPhoneBook::contact_at(std::size_t position) const
+{
+    FrozenContact out;
+    if (position >= size()) return out;
+
+    const ImageHeader* header = reinterpret_cast<const ImageHeader*>(m_base);
+    const ImageRecord& r =
+        reinterpret_cast<const ImageRecord*>(m_base + header->recordsOffset)[position];
+
+    out.id = r.id;
+    std::string_view* fields[kFieldCount] = {
+        &out.firstName, &out.middleName, &out.lastName,
+        &out.work, &out.home, &out.office,
+        &out.email, &out.address, &out.birthday
+    };
+    for (int f = 0; f < kFieldCount; ++f) *fields[f] = string_at(r.field[f]);
+    return out;
+}
+
+const std::uint32_t* FrozenPhoneBook::lookup(std::uint64_t mphOffset, std::string_view key,
+                                             std::uint32_t* count) const
+{
+    *count = 0;
+    if (!is_open()) return nullptr;
+
+    const MphHeader& mh = *reinterpret_cast<const MphHeader*>(m_base + mphOffset);
+    if (mh.keyCount == 0) return nullptr;
+
+    const std::uint32_t* pilots = reinterpret_cast<const std::uint32_t*>(m_base + mh.pilotsOffset);
+    const MphEntry* entries = reinterpret_cast<const MphEntry*>(m_base + mh.entriesOffset);
+    const std::uint32_t* postings = reinterpret_cast<const std::uint32_t*>(m_base + mh.postingsOffset);
+
+    const std::uint64_t hash = keyHash(key, mh.seed);
+    const std::uint32_t slot = slotOf(hash, pilots[bucketOf(hash, mh.bucketCount)], mh.keyCount);
+    const MphEntry& entry = entries[slot];
+
+    // A perfect hash sends unknown keys somewhere too: confirm the key.
+    if (string_at(entry.key) != key) return nullptr;
+    if (entry.postingStart > mh.postingCount ||
+        entry.postingCount > mh.postingCount - entry.postingStart) {
+        return nullptr;
+    }
+
+    *count = entry.postingCount;
+    return postings + entry.postingStart;
+}
+
+bool FrozenPhoneBook::find_by_email(std::string_view email, FrozenContact* out) const
+{
+    std::uint32_t count = 0;
+    const ImageHeader* header = reinterpret_cast<const ImageHeader*>(m_base);
+    const std::uint32_t* positions = is_open() ? lookup(header->emailIndexOffset, email, &count) : nullptr;
+    if (count == 0 || positions[0] >= size()) return false;
+    if (out) *out = contact_at(positions[0]);
+    return true;
+}
+
+std::vector<FrozenContact> FrozenPhoneBook::find_all_by_email(std::string_view email) const
+{
+    std::vector<FrozenContact> result;
+    if (!is_open()) return result;
+
+    std::uint32_t count = 0;
+    const ImageHeader* header = reinterpret_cast<const ImageHeader*>(m_base);
+    const std::uint32_t* positions = lookup(header->emailIndexOffset, email, &count);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        if (positions[i] < size()) result.push_back(contact_at(positions[i]));
+    }
+    return result;
+}
+
+std::vector<FrozenContact> FrozenPhoneBook::find_by_phone(const std::string& phone) const
+{
+    std::vector<FrozenContact> result;
+    if (!is_open()) return result;
+
+    std::string key = normalizePhone(phone);
+    if (key.empty()) key = phone;
+
+    std::uint32_t count = 0;
+    const ImageHeader* header = reinterpret_cast<const ImageHeader*>(m_base);
+    const std::uint32_t* positions = lookup(header->phoneIndexOffset, key, &count);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        if (positions[i] < size()) result.push_back(contact_at(positions[i]));
+    }
+    return result;
+}
@@ -0,0 +1,84 @@
+#include "IdAllocator.h"
+
+namespace {
+
+constexpr std::uint32_t kWordBits = 64;
+
+unsigned lowestBit64(std::uint64_t m) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(m));
+#else
+    unsigned i = 0;
+    while (!(m & 1u)) { m >>= 1; ++i; }
+    return i;
+#endif
+}
+
+} // namespace
+
+IdAllocator::IdAllocator(const allocator_type& alloc)
+    : m_slotOf(alloc), m_idAt(alloc), m_live(alloc)
+{
+}
+
+IdAllocator::IdAllocator(const IdAllocator& other, const allocator_type& alloc)
+    : m_slotOf(other.m_slotOf, alloc), m_idAt(other.m_idAt, alloc), m_live(other.m_live, alloc),
+      m_firstFree(other.m_firstFree)
+{
+}
+
+// The first clear bit of the bitmap at or after m_firstFree.
+std::uint32_t IdAllocator::bind(ContactId id)
+{
+    std::uint32_t word = m_firstFree / kWordBits;
+    while (word < m_live.size() && m_live[word] == ~std::uint64_t(0)) ++word;
+    if (word == m_live.size()) m_live.push_back(0);
+
+    const std::uint32_t slot = word * kWordBits + lowestBit64(~m_live[word]);
+    m_live[word] |= std::uint64_t(1) << (slot % kWordBits);
+    if (slot >= m_idAt.size()) m_idAt.resize(slot + 1, 0);
+    m_idAt[slot] = id;
+    m_slotOf[id] = slot;
+    m_firstFree = slot + 1;
+    return slot;
+}
+
+std::uint32_t IdAllocator::unbind(ContactId id)
+{
+    auto it = m_slotOf.find(id);
+    if (it == m_slotOf.end()) return kNoSlot;
+    const std::uint32_t slot = it->second;
+    m_slotOf.erase(it);
+
+    m_live[slot / kWordBits] &= ~(std::uint64_t(1) << (slot % kWordBits));
+    m_idAt[slot] = 0;
+    if (slot < m_firstFree) m_firstFree = slot;
+
+    // Trailing free slots are dropped, so slot_count() follows the top live slot.
+    while (!m_idAt.empty() && m_idAt.back() == 0) m_idAt.pop_back();
+    while (!m_live.empty() && m_live.back() == 0 && m_live.size() * kWordBits > m_idAt.size() + kWordBits - 1) {
+        m_live.pop_back();
+    }
+    return slot;
+}
+
+std::uint32_t IdAllocator::slot_of(ContactId id) const
+{
+    auto it = m_slotOf.find(id);
+    return it == m_slotOf.end() ? kNoSlot : it->second;
+}
+
+void IdAllocator::reserve(std::size_t ids)
+{
+    m_slotOf.reserve(ids);
+    m_idAt.reserve(ids);
+    m_live.reserve((ids + kWordBits - 1) / kWordBits);
+}
+
+void IdAllocator::clear()
+{
+    m_slotOf.reset();
+    m_idAt = std::pmr::vector<ContactId>(m_idAt.get_allocator());
+    m_live = std::pmr::vector<std::uint64_t>(m_live.get_allocator());
+    m_firstFree = 0;
+}
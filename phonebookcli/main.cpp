@@ -1,9 +1,182 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include "PhoneBook.h"
+#include "PhoneFormats.h"
+#include "Commands.h"
+#include "Daemon.h"
+#include "FrozenPhoneBook.h"
+
+// phonebook exec [--db FILE] [SCRIPT | - | -c COMMAND...]
+// Runs commands (Commands.h) from a script file, from stdin (no script,
+// or "-") or one per argument after -c, without the menus. Responses go
+// to stdout; the book is saved once, at the end. Exit status 1 if a
+// command or the save failed, 2 for bad usage.
+static int exec_main(int argc, char* argv[])
+{
+    std::string dbFile = "phonebook.db";
+    int i = 0;
+    if (i + 1 < argc && std::string(argv[i]) == "--db") {
+        dbFile = argv[i + 1];
+        i += 2;
+    }
+
+    std::ifstream file;
+    std::istringstream commands;
+    std::istream* in = &std::cin;
+    if (i < argc && std::string(argv[i]) == "-c") {
+        std::string text;
+        for (++i; i < argc; ++i) text.append(argv[i]).append("\n");
+        commands.str(text);
+        in = &commands;
+    }
+    else if (i < argc && std::string(argv[i]) != "-") {
+        file.open(argv[i]);
+        if (!file.is_open()) {
+            std::cerr << "Cannot open script " << argv[i] << "\n";
+            return 2;
+        }
+        in = &file;
+        ++i;
+    }
+    else if (i < argc) {
+        ++i;
+    }
+    if (i < argc) {
+        std::cerr << "Usage: phonebook exec [--db FILE] [SCRIPT | - | -c COMMAND...]\n";
+        return 2;
+    }
+
+    PhoneBook phoneBook(dbFile);
+    phoneBook.set_undo_budget(0);   // the commands have no undo
+    std::string error;
+    const bool ok = runScript(phoneBook, *in, std::cout, &error);
+    if (!error.empty()) std::cerr << error << "\n";
+    // Saved by runScript() if anything changed; not again on the way out.
+    phoneBook.set_autosave(false);
+    return ok ? 0 : 1;
+}
+
+// phonebook freeze [--db FILE] IMAGE
+// phonebook lookup IMAGE [-c COMMAND...]
+// freeze writes a read-only snapshot of the book (FrozenPhoneBook.h);
+// lookup maps one and answers `email ADDRESS` / `phone NUMBER` lines
+// from stdin, or one per argument after -c, as exec would.
+static int frozen_main(bool freeze, int argc, char* argv[])
+{
+    std::string dbFile = "phonebook.db";
+    int i = 0;
+    if (freeze && i + 1 < argc && std::string(argv[i]) == "--db") {
+        dbFile = argv[i + 1];
+        i += 2;
+    }
+    if (i >= argc || (freeze && i + 1 != argc) || (!freeze && i + 1 < argc && std::string(argv[i + 1]) != "-c")) {
+        std::cerr << (freeze ? "Usage: phonebook freeze [--db FILE] IMAGE\n"
+                             : "Usage: phonebook lookup IMAGE [-c COMMAND...]\n");
+        return 2;
+    }
+    const std::string image = argv[i];
+
+    if (freeze) {
+        PhoneBook phoneBook(dbFile);
+        phoneBook.set_autosave(false);
+        const FrozenPhoneBook frozen = FrozenPhoneBook::freeze(phoneBook);
+        if (!frozen.is_open() || !frozen.save(image)) {
+            std::cerr << "Cannot write " << image << "\n";
+            return 1;
+        }
+        std::cout << frozen.size() << " contacts frozen into " << image << "\n";
+        return 0;
+    }
+
+    FrozenPhoneBook frozen;
+    if (!frozen.open(image)) {
+        std::cerr << "Cannot open frozen book " << image << "\n";
+        return 1;
+    }
+    std::istringstream commands;
+    std::istream* in = &std::cin;
+    if (i + 1 < argc) {
+        std::string text;
+        for (i += 2; i < argc; ++i) text.append(argv[i]).append("\n");
+        commands.str(text);
+        in = &commands;
+    }
+    bool ok = true;
+    std::string line;
+    std::string response;
+    while (std::getline(*in, line)) {
+        const std::size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') continue;
+        response.clear();
+        ok = runFrozenCommand(frozen, line, &response) && ok;
+        std::cout << response;
+    }
+    return ok ? 0 : 1;
+}
+
+// phonebook serve [--db FILE] [--socket PATH] [--flush-ms N]
+// phonebook client [--socket PATH] [-c COMMAND...]
+// The daemon (Daemon.h) and its client; the client reads commands from
+// stdin unless -c gives them.
+static int daemon_main(bool serve, int argc, char* argv[])
+{
+#ifdef __linux__
+    DaemonOptions options;
+    std::istringstream commands;
+    std::istream* in = &std::cin;
+    for (int i = 0; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) options.socketPath = argv[++i];
+        else if (serve && arg == "--db" && i + 1 < argc) options.dbFile = argv[++i];
+        else if (serve && arg == "--flush-ms" && i + 1 < argc) options.flushMs = std::max(0, std::atoi(argv[++i]));
+        else if (!serve && arg == "-c") {
+            std::string text;
+            for (++i; i < argc; ++i) text.append(argv[i]).append("\n");
+            commands.str(text);
+            in = &commands;
+        }
+        else {
+            std::cerr << (serve ? "Usage: phonebook serve [--db FILE] [--socket PATH] [--flush-ms N]\n"
+                                : "Usage: phonebook client [--socket PATH] [-c COMMAND...]\n");
+            return 2;
+        }
+    }
+
+    std::string error;
+    const bool ok = serve ? runDaemon(options, &error) : runClient(options.socketPath, *in, std::cout, &error);
+    if (!error.empty()) std::cerr << error << "\n";
+    return ok ? 0 : 1;
+#else
+    (void)serve;
+    (void)argc;
+    (void)argv;
+    std::cerr << "The daemon is only available on Linux.\n";
+    return 2;
+#endif
+}
+
 //this is the command line user interfaced 
-int main()
+int main(int argc, char* argv[])
 {
+    const std::string mode = argc > 1 ? argv[1] : "";
+    const bool scripted = mode == "exec" || mode == "serve" || mode == "client" || mode == "freeze" ||
+                          mode == "lookup";
+    if (scripted) std::ios::sync_with_stdio(false);
+    // The client only forwards commands: it needs no phone formats.
+    if (mode == "client") return daemon_main(false, argc - 2, argv + 2);
+
+    std::string formatsError;
+    if (!loadPhoneFormats("phone_formats.txt", &formatsError)) {
+        (scripted ? std::cerr : std::cout) << "Warning: " << formatsError << " Using the built-in phone formats.\n";
+    }
+    if (mode == "exec") return exec_main(argc - 2, argv + 2);
+    if (mode == "serve") return daemon_main(true, argc - 2, argv + 2);
+    if (mode == "freeze" || mode == "lookup") return frozen_main(mode == "freeze", argc - 2, argv + 2);
+
     PhoneBook phoneBook;
     std::string command;
 
@@ -20,8 +193,12 @@ int main()
         std::cout << "3) Edit contact\n";
         std::cout << "4) Delete contact\n";
         std::cout << "5) List contacts (sorted)\n";
+        std::cout << "6) Find and merge duplicates\n";
+        std::cout << "7) Undo last change\n";
+        std::cout << "8) Redo\n";
+        std::cout << "Or type a query, e.g. last:Chik* phone:*1514\n";
         std::cout << "-----------------------------------------\n";
-        std::cout << "Enter choice (1-5 or 'quit'): ";
+        std::cout << "Enter choice (1-8 or 'quit'): ";
 
         if (!std::getline(std::cin, command)) {
             std::cout << "\nInput stream closed. Exiting.\n";
@@ -36,7 +213,14 @@ int main()
 
         // Ignore empty lines
         if (command.empty()) {
-            std::cout << "Unknown command. Please enter 1-5 or 'quit'.\n\n";
+            std::cout << "Unknown command. Please enter 1-8 or 'quit'.\n\n";
+            continue;
+        }
+
+        // field:value terms are a query, answered without the menus.
+        if (command.find(':') != std::string::npos) {
+            phoneBook.run_query(command);
+            std::cout << "\n";
             continue;
         }
 
@@ -51,12 +235,9 @@ int main()
 
         case '2': {
             // SEARCH CONTACT
-            Contact result = phoneBook.contact_search_menu();
-            if (!result.firstName.empty() ||
-                !result.lastName.empty() ||
-                !result.email.empty()) {
+            if (const ContactRecord* result = phoneBook.contact_search_menu()) {
                 std::cout << "\nContact found:\n";
-                result.print_contact();
+                result->print_contact();
             }
             break;
         }
@@ -76,8 +257,27 @@ int main()
             phoneBook.contact_sort_menu();
             break;
 
+        case '6':
+            // FIND AND MERGE DUPLICATES
+            phoneBook.duplicates_menu();
+            break;
+
+        case '7':
+        case '8': {
+            // UNDO / REDO
+            std::string error;
+            const bool undo = choice == '7';
+            if (undo ? phoneBook.undo(&error) : phoneBook.redo(&error)) {
+                std::cout << (undo ? "Last change undone.\n" : "Change redone.\n");
+            }
+            else {
+                std::cout << error << "\n";
+            }
+            break;
+        }
+
         default:
-            std::cout << "Unknown command. Please enter 1-5 or 'quit'.\n";
+            std::cout << "Unknown command. Please enter 1-8 or 'quit'.\n";
             break;
         }
 
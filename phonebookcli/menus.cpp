@@ -1,8 +1,10 @@
 ﻿#include "PhoneBook.h"
 #include "Checkers.h"
+#include "Dedup.h"
+#include <iomanip>
 #include <iostream>
 #include <limits>
-#include <regex>
+#include <utility>
 
 void PhoneBook::contact_creation_menu()
 {
@@ -70,6 +72,15 @@ if (contact.email.empty()) {
     }
 }
 
+// Emails are unique: ask again while this one is taken.
+while (std::cin && email_in_use(contact.email)) {
+    std::cout << "Email '" << contact.email << "' already belongs to another contact.\n";
+    do {
+        std::cout << "Enter EMAIL (required): ";
+        std::getline(std::cin, contact.email);
+    } while (std::cin && !isValidEmail(contact.email));
+}
+
     // Main phone (required) → stored as numbers.number1 (work)
     // ... after you've already asked for firstName, lastName, email ...
 
@@ -156,12 +167,10 @@ if (contact.email.empty()) {
         }
 
         // Address (optional – at least one non-space character if provided)
-        static const std::regex addressPattern(R"(^.*\S.*$)");
-
         std::cout << "Enter ADDRESS (optional, press Enter to skip): ";
         std::getline(std::cin, contact.address);
         while (!contact.address.empty() &&
-            !std::regex_match(contact.address, addressPattern)) {
+            !isValidAddress(contact.address)) {
             std::cout << "Invalid address. Must contain at least one non-space character.\n";
             std::cout << "Enter ADDRESS (or press Enter to skip): ";
             std::getline(std::cin, contact.address);
@@ -186,10 +195,10 @@ if (contact.email.empty()) {
     }
 
     // Finally, create and store contact
-    create_contact(contact);
+    create_contact(std::move(contact));
 }
 
-Contact PhoneBook::contact_search_menu()
+const ContactRecord* PhoneBook::contact_search_menu()
 {
    
 
@@ -203,18 +212,58 @@ Contact PhoneBook::contact_search_menu()
     std::cout << "  4) Home phone\n";
     std::cout << "  5) Office phone\n";
     std::cout << "  6) Email\n";
-    std::cout << "Enter choice (1-6): ";
+    std::cout << "  7) All contacts at an email domain\n";
+    std::cout << "  8) Number of contacts per email domain\n";
+    std::cout << "  9) Address words (best matches first)\n";
+    std::cout << "  q) Query, e.g. last:Chik* phone:*1514 born:1990..2000\n";
+    std::cout << "Enter choice (1-9 or q): ";
 
     char method;
     std::cin >> method;
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 
-    while (method < '1' || method > '6') {
-        std::cout << "Invalid choice. Enter 1-6: ";
+    while ((method < '1' || method > '9') && method != 'q' && method != 'Q') {
+        std::cout << "Invalid choice. Enter 1-9 or q: ";
         std::cin >> method;
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
     }
 
+    // Domain, address and query searches list every match themselves.
+    if (method == 'q' || method == 'Q') {
+        std::string text;
+        std::cout << "Enter QUERY (fields: id first middle last phone work home office\n"
+                     "email domain addr born; value*, *value, *value*, lo..hi; OR): ";
+        std::getline(std::cin, text);
+        run_query(text);
+        return nullptr;
+    }
+    if (method == '7') {
+        std::string domain;
+        std::cout << "Enter email DOMAIN (e.g. gmail.com): ";
+        std::getline(std::cin, domain);
+        while (std::cin && emailDomain(domain).empty()) {
+            std::cout << "Invalid domain. Try again: ";
+            std::getline(std::cin, domain);
+        }
+        list_domain_contacts(domain);
+        return nullptr;
+    }
+    if (method == '8') {
+        list_domain_counts();
+        return nullptr;
+    }
+    if (method == '9') {
+        std::string query;
+        std::cout << "Enter ADDRESS words to search (e.g. grazhdanski 28): ";
+        std::getline(std::cin, query);
+        while (std::cin && AddressIndex::tokenize(query).empty()) {
+            std::cout << "Enter at least one word or number: ";
+            std::getline(std::cin, query);
+        }
+        list_address_matches(query);
+        return nullptr;
+    }
+
     std::string value;
 
     switch (method) {
@@ -274,10 +323,7 @@ Contact PhoneBook::contact_search_menu()
     }
 
     // Call the actual search function with validated input
-    Contact result = search(method, value);
-
-    
-    return result;
+    return search(method, value);
 }
 
 void PhoneBook::edit_contact()
@@ -370,7 +416,7 @@ void PhoneBook::edit_contact()
     }
 
     // ---- Find the contact ID using the right index map ----
-    unsigned int id = 0;
+    ContactId id = 0;
     bool found = false;
 
     switch (method) {
@@ -459,14 +505,15 @@ void PhoneBook::delete_contact()
     std::cout << "  4) Home phone\n";
     std::cout << "  5) Office phone\n";
     std::cout << "  6) Email\n";
-    std::cout << "Enter choice (1-6): ";
+    std::cout << "  7) Every contact at an email domain\n";
+    std::cout << "Enter choice (1-7): ";
 
     char method;
     std::cin >> method;
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 
-    while (method < '1' || method > '6') {
-        std::cout << "Invalid choice. Enter 1-6: ";
+    while (method < '1' || method > '7') {
+        std::cout << "Invalid choice. Enter 1-7: ";
         std::cin >> method;
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
     }
@@ -528,10 +575,20 @@ void PhoneBook::delete_contact()
             std::getline(std::cin, value);
         }
         break;
+
+    case '7': // email domain
+        std::cout << "Enter email DOMAIN (e.g. mail.ru): ";
+        std::getline(std::cin, value);
+        break;
+    }
+
+    if (method == '7') {
+        delete_contacts_at_domain(value);
+        return;
     }
 
     // ---- Find the contact ID using the right index map ----
-    unsigned int id = 0;
+    ContactId id = 0;
     bool found = false;
 
     switch (method) {
@@ -579,7 +636,7 @@ void PhoneBook::delete_contact()
     }
 
     // ---- Show contact and confirm ----
-    Contact& contact = itMain->second;
+    const ContactRecord& contact = itMain->second;
     
     contact.print_contact();
 
@@ -596,6 +653,36 @@ void PhoneBook::delete_contact()
     // ---- Call implementation helper ----
     delete_contact_impl(*this, id);
 }
+void PhoneBook::delete_contacts_at_domain(const std::string& domain)
+{
+    const std::vector<ContactId> ids = contacts_at_domain(domain);
+    if (ids.empty()) {
+        std::cout << "No contacts found at that domain.\n";
+        return;
+    }
+
+    std::cout << "\nAre you sure you want to DELETE " << ids.size() << " contact(s)? (y/n): ";
+    std::string answer;
+    std::getline(std::cin, answer);
+    char confirm = answer.empty() ? 'n' : answer[0];
+
+    if (confirm != 'y' && confirm != 'Y') {
+        std::cout << "Deletion cancelled.\n";
+        return;
+    }
+
+    // One batch: the file is written once, after the last delete.
+    const bool ownBatch = begin_batch();
+    std::size_t deleted = 0;
+    for (ContactId id : ids) {
+        if (remove_contact(id)) ++deleted;
+    }
+    std::string error;
+    if (ownBatch && !commit_batch(&error)) {
+        std::cout << "Warning: " << error << "\n";
+    }
+    std::cout << deleted << " contact(s) deleted.\n";
+}
 void PhoneBook::contact_sort_menu()
 {
     if (mainStorage.empty()) {
@@ -609,14 +696,16 @@ void PhoneBook::contact_sort_menu()
     std::cout << "Choose sort method:\n";
     std::cout << "  1) By FIRST name (ascending)\n";
     std::cout << "  2) By LAST name  (ascending)\n";
-    std::cout << "Enter choice (1-2): ";
+    std::cout << "  3) By ID         (ascending)\n";
+    std::cout << "  4) By EMAIL      (ascending)\n";
+    std::cout << "Enter choice (1-4): ";
 
     char method;
     std::cin >> method;
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 
-    while (method != '1' && method != '2') {
-        std::cout << "Invalid choice. Enter 1 or 2: ";
+    while (method < '1' || method > '4') {
+        std::cout << "Invalid choice. Enter 1-4: ";
         std::cin >> method;
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
     }
@@ -624,3 +713,94 @@ void PhoneBook::contact_sort_menu()
     // Call the actual sort+list function
     list_sorted_contacts(method);
 }
+void PhoneBook::duplicates_menu()
+{
+    if (mainStorage.size() < 2) {
+        std::cout << "Not enough contacts to look for duplicates.\n";
+        return;
+    }
+
+    std::cout << "==============================\n";
+    std::cout << "        FIND DUPLICATES\n";
+    std::cout << "==============================\n";
+    std::cout << "Scanning " << mainStorage.size() << " contacts...\n";
+
+    const std::vector<MergeProposal> proposals = findDuplicates(*this);
+    if (proposals.empty()) {
+        std::cout << "No likely duplicates found.\n";
+        return;
+    }
+
+    std::size_t removable = 0;
+    for (const MergeProposal& p : proposals) removable += p.duplicateIds.size();
+    std::cout << "Found " << proposals.size() << " group(s) of likely duplicates ("
+              << removable << " contact(s) would be merged away).\n";
+    std::cout << "Choose action:\n";
+    std::cout << "  1) Review groups one by one\n";
+    std::cout << "  2) Merge all groups\n";
+    std::cout << "  3) Cancel\n";
+    std::cout << "Enter choice (1-3): ";
+
+    char method;
+    std::cin >> method;
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+    while (method < '1' || method > '3') {
+        std::cout << "Invalid choice. Enter 1-3: ";
+        std::cin >> method;
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+
+    if (method == '3') {
+        std::cout << "No contacts merged.\n";
+        return;
+    }
+
+    std::vector<MergeProposal> accepted;
+    if (method == '2') {
+        accepted = proposals;
+    }
+    else {
+        auto printBrief = [this](const char* role, ContactId id) {
+            const ContactView c = mainStorage.find(id)->second;
+            std::cout << "  " << role << " ID " << id << ": " << c.firstName << " " << c.lastName
+                      << " <" << c.email << ">";
+            for (std::string_view phone : { c.numbers.number1, c.numbers.number2, c.numbers.number3 }) {
+                if (!phone.empty()) std::cout << " " << phone;
+            }
+            std::cout << "\n";
+        };
+
+        for (std::size_t i = 0; i < proposals.size(); ++i) {
+            const MergeProposal& p = proposals[i];
+            std::cout << "\n--- Group " << (i + 1) << " of " << proposals.size()
+                      << " (similarity " << std::fixed << std::setprecision(2) << p.score
+                      << std::defaultfloat << ") ---\n";
+            printBrief("Keep ", p.keepId);
+            for (ContactId id : p.duplicateIds) printBrief("Merge", id);
+            std::cout << "Merged contact:\n";
+            p.merged.print_contact();
+            for (const std::string& phone : p.droppedPhones) {
+                std::cout << "Note: no free phone slot left for " << phone << ", it will be dropped.\n";
+            }
+
+            std::cout << "Merge this group? (y = yes, n = no, q = stop reviewing): ";
+            std::string answer;
+            std::getline(std::cin, answer);
+            const char confirm = answer.empty() ? 'n' : answer[0];
+            if (confirm == 'q' || confirm == 'Q') break;
+            if (confirm == 'y' || confirm == 'Y') accepted.push_back(p);
+        }
+    }
+
+    if (accepted.empty()) {
+        std::cout << "No contacts merged.\n";
+        return;
+    }
+
+    const std::size_t applied = apply_merges(accepted);
+    std::cout << "Merged " << applied << " group(s).\n";
+    if (applied < accepted.size()) {
+        std::cout << (accepted.size() - applied) << " group(s) skipped: their contacts changed since the scan, or the merged contact is no longer valid.\n";
+    }
+}
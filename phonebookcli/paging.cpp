@@ -0,0 +1,217 @@
+#include "PhoneBook.h"
+#include "ParallelSort.h"
+#include "Query.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <queue>
+#include <utility>
+
+namespace {
+
+// Probes per requested row before the id walk gives up on a sparse
+// stretch of ids and selects from the whole book instead.
+constexpr std::size_t kProbesPerRow = 4;
+constexpr std::size_t kMinProbes = 256;
+
+char keyCode(SortKey key) {
+    switch (key) {
+    case SortKey::Id:        return 'i';
+    case SortKey::FirstName: return 'f';
+    case SortKey::LastName:  return 'l';
+    case SortKey::Email:     return 'e';
+    }
+    return '?';
+}
+
+// "<key><+|->:<id>:<hex of the sort key>". The key and direction are in
+// the cursor so one cannot be replayed against a different ordering.
+std::string encodeCursor(SortKey key, bool descending, std::string_view sortKey, ContactId id) {
+    static const char kHex[] = "0123456789abcdef";
+    std::string out;
+    out += keyCode(key);
+    out += descending ? '-' : '+';
+    out += ':';
+    out += std::to_string(id);
+    out += ':';
+    for (unsigned char c : sortKey) {
+        out += kHex[c >> 4];
+        out += kHex[c & 15];
+    }
+    return out;
+}
+
+bool decodeCursor(const std::string& cursor, SortKey key, bool descending,
+                  std::string* sortKey, ContactId* id) {
+    if (cursor.size() < 4 || cursor[0] != keyCode(key) || cursor[1] != (descending ? '-' : '+') ||
+        cursor[2] != ':') {
+        return false;
+    }
+    const std::size_t colon = cursor.find(':', 3);
+    if (colon == std::string::npos || colon == 3) return false;
+
+    const std::string idText = cursor.substr(3, colon - 3);
+    if (!std::all_of(idText.begin(), idText.end(), [](char c) { return c >= '0' && c <= '9'; })) return false;
+    *id = static_cast<ContactId>(std::strtoull(idText.c_str(), nullptr, 10));
+
+    const std::string hex = cursor.substr(colon + 1);
+    if (hex.size() % 2 != 0) return false;
+    auto nibble = [](char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    };
+    sortKey->clear();
+    for (std::size_t i = 0; i < hex.size(); i += 2) {
+        const int hi = nibble(hex[i]), lo = nibble(hex[i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        *sortKey += static_cast<char>(hi * 16 + lo);
+    }
+    return true;
+}
+
+std::string sortKeyOf(const ContactView& c, SortKey key) {
+    switch (key) {
+    case SortKey::FirstName: return nameKey(c.firstName);
+    case SortKey::LastName:  return nameKey(c.lastName);
+    case SortKey::Email:     return nameKey(c.email);
+    case SortKey::Id:        break;
+    }
+    return {};
+}
+
+} // namespace
+
+std::string pageSortKey(const ContactView& contact, SortKey key)
+{
+    return sortKeyOf(contact, key);
+}
+
+std::string pageCursor(SortKey key, bool descending, std::string_view sortKey, ContactId id)
+{
+    return encodeCursor(key, descending, sortKey, id);
+}
+
+bool pageCursorRow(const std::string& cursor, SortKey key, bool descending,
+                   std::string* sortKey, ContactId* id)
+{
+    return decodeCursor(cursor, key, descending, sortKey, id);
+}
+
+bool PhoneBook::page(const PageRequest& request, Page* out, std::string* error) const
+{
+    auto fail = [&](const std::string& msg) {
+        if (error) *error = msg;
+        return false;
+    };
+
+    out->ids.clear();
+    out->nextCursor.clear();
+    if (request.pageSize == 0) return fail("Page size must be at least 1.");
+
+    const bool desc = request.descending;
+    const bool from = !request.cursor.empty();
+    std::string fromKey;
+    ContactId fromId = 0;
+    if (from && !decodeCursor(request.cursor, request.key, desc, &fromKey, &fromId)) {
+        return fail("The cursor does not belong to this ordering.");
+    }
+
+    // One row past the page tells whether another page follows.
+    const std::size_t want = request.pageSize + 1;
+    std::vector<std::pair<std::string, ContactId>> rows;
+    rows.reserve(want);
+
+    bool done = false;
+    if (request.key == SortKey::FirstName || request.key == SortKey::LastName) {
+        const OrderedIndex& index = request.key == SortKey::FirstName ? firstNameOrder : lastNameOrder;
+        index.walk(desc, from, fromKey, fromId, [&](std::string_view key, ContactId id) {
+            rows.emplace_back(std::string(key), id);
+            return rows.size() < want;
+        });
+        done = true;
+    }
+    else if (request.key == SortKey::Id) {
+        const std::size_t budget = std::max(kMinProbes, want * kProbesPerRow);
+        std::size_t probes = 0;
+        ContactId id = from ? (desc ? fromId - 1 : fromId + 1) : (desc ? index : 1);
+        while (rows.size() < want && id >= 1 && id <= index && probes < budget) {
+            if (mainStorage.contains(id)) rows.emplace_back(std::string(), id);
+            id = desc ? id - 1 : id + 1;
+            ++probes;
+        }
+        done = rows.size() == want || id < 1 || id > index;
+        if (!done) rows.clear();
+    }
+
+    if (!done) {
+        // Selection: keep the `want` first rows after the cursor in a
+        // heap whose top is the last of them.
+        auto before = [desc](const std::pair<std::string, ContactId>& a,
+                             const std::pair<std::string, ContactId>& b) {
+            return desc ? b < a : a < b;
+        };
+        std::priority_queue<std::pair<std::string, ContactId>,
+                            std::vector<std::pair<std::string, ContactId>>, decltype(before)> best(before);
+        const std::pair<std::string, ContactId> cursor(fromKey, fromId);
+
+        for (const auto& pair : mainStorage) {
+            std::pair<std::string, ContactId> row(sortKeyOf(pair.second, request.key), pair.first);
+            if (from && !before(cursor, row)) continue;
+            if (best.size() < want) {
+                best.push(std::move(row));
+            }
+            else if (before(row, best.top())) {
+                best.pop();
+                best.push(std::move(row));
+            }
+        }
+        rows.resize(best.size());
+        for (std::size_t i = rows.size(); i-- > 0;) {
+            rows[i] = best.top();
+            best.pop();
+        }
+    }
+
+    if (rows.size() == want) {
+        rows.pop_back();
+        out->nextCursor = encodeCursor(request.key, desc, rows.back().first, rows.back().second);
+    }
+    out->ids.reserve(rows.size());
+    for (const auto& row : rows) out->ids.push_back(row.second);
+    return true;
+}
+
+std::vector<ContactId> PhoneBook::sorted_ids(SortKey key, bool descending) const
+{
+    std::vector<ContactId> ids;
+    ids.reserve(mainStorage.size());
+
+    if (key == SortKey::FirstName || key == SortKey::LastName) {
+        const OrderedIndex& order = key == SortKey::FirstName ? firstNameOrder : lastNameOrder;
+        order.walk(descending, false, {}, 0, [&](std::string_view, ContactId id) {
+            ids.push_back(id);
+            return true;
+        });
+        return ids;
+    }
+
+    if (key == SortKey::Id) {
+        for (const auto& pair : mainStorage) ids.push_back(pair.first);
+        parallelSort(ids, [descending](ContactId a, ContactId b) {
+            return descending ? b < a : a < b;
+        });
+        return ids;
+    }
+
+    // Keys copied out once, so the comparator never touches the hash map.
+    std::vector<std::pair<std::string, ContactId>> rows;
+    rows.reserve(mainStorage.size());
+    for (const auto& pair : mainStorage) rows.emplace_back(sortKeyOf(pair.second, key), pair.first);
+    parallelSort(rows, [descending](const std::pair<std::string, ContactId>& a,
+                                    const std::pair<std::string, ContactId>& b) {
+        return descending ? b < a : a < b;
+    });
+    for (const auto& row : rows) ids.push_back(row.second);
+    return ids;
+}
@@ -0,0 +1,268 @@
+#include "PhoneFormats.h"
+
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <utility>
+
+namespace {
+
+// Same accept set as the old hardcoded pattern
+//   ^(?:\+7|8)(?:\d{10}|\(\d{3}\)\d{7}|\(\d{3}\)\d{3}-\d{2}-\d{2})$
+const char* const kBuiltInFormats =
+    "RU  +7XXXXXXXXXX       +7\n"
+    "RU  8XXXXXXXXXX        +7\n"
+    "RU  +7(XXX)XXXXXXX     +7\n"
+    "RU  8(XXX)XXXXXXX      +7\n"
+    "RU  +7(XXX)XXX-XX-XX   +7\n"
+    "RU  8(XXX)XXX-XX-XX    +7\n";
+
+// phones.phone_number is VARCHAR(30)
+constexpr std::size_t kMaxPhoneLength = 30;
+
+constexpr char kDigitPlaceholder = 'X';
+
+bool isDigitChar(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool isPatternLiteral(char c) {
+    return isDigitChar(c) || c == '+' || c == '(' || c == ')' ||
+        c == '-' || c == '.' || c == '/';
+}
+
+bool symbolMatches(char symbol, unsigned char byte) {
+    if (symbol == kDigitPlaceholder) return isDigitChar(static_cast<char>(byte));
+    return static_cast<unsigned char>(symbol) == byte;
+}
+
+void setError(std::string* error, const std::string& message) {
+    if (error) *error = message;
+}
+
+} // namespace
+
+// ---------- PhoneFormatSet ----------
+
+PhoneFormatSet::PhoneFormatSet() : m_byteClass{}, m_classCount(1)
+{
+    std::istringstream in(kBuiltInFormats);
+    parse(in);
+}
+
+bool PhoneFormatSet::parse(std::istream& in, std::string* error)
+{
+    std::vector<PhoneFormat> formats;
+    std::string line;
+    int lineNumber = 0;
+
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        const std::size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+
+        std::istringstream fields(line);
+        std::vector<std::string> tokens;
+        for (std::string token; fields >> token;) tokens.push_back(token);
+        if (tokens.empty()) continue;
+
+        const std::string where = "Phone formats, line " + std::to_string(lineNumber) + ": ";
+        if (tokens.size() < 2 || tokens.size() > 3) {
+            setError(error, where + "expected 'name pattern [normalize-to]'.");
+            return false;
+        }
+
+        PhoneFormat format;
+        format.name = tokens[0];
+        format.pattern = tokens[1];
+        if (tokens.size() == 3) format.normalizedPrefix = tokens[2];
+
+        std::size_t captured = 0;
+        for (char c : format.pattern) {
+            if (c == kDigitPlaceholder) {
+                ++captured;
+            }
+            else if (!isPatternLiteral(c)) {
+                setError(error, where + "unexpected '" + std::string(1, c) +
+                    "' in pattern (use X for a digit and digits or + ( ) - . / as literals).");
+                return false;
+            }
+        }
+        for (char c : format.normalizedPrefix) {
+            if (!isDigitChar(c) && c != '+') {
+                setError(error, where + "normalize-to may contain only digits and '+'.");
+                return false;
+            }
+        }
+        if (format.pattern.size() > kMaxPhoneLength ||
+            format.normalizedPrefix.size() + captured > kMaxPhoneLength) {
+            setError(error, where + "phone numbers are limited to " +
+                std::to_string(kMaxPhoneLength) + " characters.");
+            return false;
+        }
+
+        formats.push_back(std::move(format));
+    }
+
+    if (formats.empty()) {
+        setError(error, "Phone formats: no formats defined.");
+        return false;
+    }
+    compile(std::move(formats));
+    return true;
+}
+
+bool PhoneFormatSet::load_from_file(const std::string& filename, std::string* error)
+{
+    std::ifstream in(filename);
+    if (!in.is_open()) {
+        setError(error, "Could not open phone formats file '" + filename + "'.");
+        return false;
+    }
+    return parse(in, error);
+}
+
+// Builds the DFA. Every pattern is a fixed sequence of symbols, so after
+// n characters each pattern is either dead or at position n: a DFA state
+// is (n, set of patterns still alive), and there are at most
+// (total pattern length + 1) states.
+void PhoneFormatSet::compile(std::vector<PhoneFormat> formats)
+{
+    // Byte classes: bytes that every pattern symbol treats alike share a
+    // class. Class 0 is "matches nothing".
+    std::string symbols;
+    for (const PhoneFormat& f : formats) {
+        for (char c : f.pattern) {
+            if (symbols.find(c) == std::string::npos) symbols += c;
+        }
+    }
+
+    std::array<std::uint8_t, 256> byteClass{};
+    std::vector<unsigned char> representative(1, 0);
+    std::map<std::string, std::uint8_t> classOf;
+    classOf[std::string(symbols.size(), '0')] = 0;
+    for (int b = 0; b < 256; ++b) {
+        std::string signature;
+        for (char s : symbols) signature += symbolMatches(s, static_cast<unsigned char>(b)) ? '1' : '0';
+
+        auto res = classOf.emplace(signature, static_cast<std::uint8_t>(representative.size()));
+        if (res.second) representative.push_back(static_cast<unsigned char>(b));
+        byteClass[b] = res.first->second;
+    }
+    const std::size_t classCount = representative.size();
+
+    // Subset construction over "which formats are still alive". All
+    // members of a state sit at the same position: the state's depth.
+    using AliveSet = std::vector<std::uint32_t>;
+    std::map<std::pair<std::size_t, AliveSet>, std::int32_t> stateOf;
+    std::vector<AliveSet> states;
+    std::vector<std::size_t> depthOf;
+
+    AliveSet start;
+    for (std::uint32_t f = 0; f < formats.size(); ++f) start.push_back(f);
+    stateOf.emplace(std::make_pair(std::size_t(0), start), 0);
+    states.push_back(start);
+    depthOf.push_back(0);
+
+    std::vector<std::int32_t> next;
+    std::vector<std::int32_t> accept;
+
+    for (std::size_t state = 0; state < states.size(); ++state) {
+        const std::size_t depth = depthOf[state];
+        next.resize((state + 1) * classCount, -1);
+        accept.resize(state + 1, -1);
+
+        // Formats are kept in file order, so the first complete one wins.
+        for (std::uint32_t f : states[state]) {
+            if (formats[f].pattern.size() == depth) {
+                accept[state] = static_cast<std::int32_t>(f);
+                break;
+            }
+        }
+
+        for (std::size_t cls = 1; cls < classCount; ++cls) {
+            AliveSet alive;
+            for (std::uint32_t f : states[state]) {
+                const std::string& pattern = formats[f].pattern;
+                if (depth < pattern.size() && symbolMatches(pattern[depth], representative[cls])) {
+                    alive.push_back(f);
+                }
+            }
+            if (alive.empty()) continue;
+
+            auto res = stateOf.emplace(std::make_pair(depth + 1, alive),
+                                       static_cast<std::int32_t>(states.size()));
+            if (res.second) {
+                states.push_back(alive);
+                depthOf.push_back(depth + 1);
+            }
+            next[state * classCount + cls] = res.first->second;
+        }
+    }
+
+    m_formats = std::move(formats);
+    m_byteClass = byteClass;
+    m_classCount = classCount;
+    m_next = std::move(next);
+    m_accept = std::move(accept);
+}
+
+int PhoneFormatSet::match(std::string_view phone) const
+{
+    std::int32_t state = 0;
+    for (char c : phone) {
+        state = m_next[static_cast<std::size_t>(state) * m_classCount +
+                       m_byteClass[static_cast<unsigned char>(c)]];
+        if (state < 0) return -1;
+    }
+    return m_accept[static_cast<std::size_t>(state)];
+}
+
+std::string PhoneFormatSet::normalize(std::string_view phone) const
+{
+    const int f = match(phone);
+    if (f < 0) return "";
+
+    // The match consumed the pattern position by position, so the digit
+    // captured by pattern[i] is phone[i].
+    const PhoneFormat& format = m_formats[static_cast<std::size_t>(f)];
+    std::string normalized = format.normalizedPrefix;
+    normalized.reserve(kMaxPhoneLength);
+    for (std::size_t i = 0; i < phone.size(); ++i) {
+        if (format.pattern[i] == kDigitPlaceholder) normalized += phone[i];
+    }
+    return normalized;
+}
+
+// ---------- ACTIVE FORMATS ----------
+
+static PhoneFormatSet& activeFormats()
+{
+    static PhoneFormatSet formats;
+    return formats;
+}
+
+const PhoneFormatSet& phoneFormats()
+{
+    return activeFormats();
+}
+
+void setPhoneFormats(const PhoneFormatSet& formats)
+{
+    activeFormats() = formats;
+}
+
+bool loadPhoneFormats(const std::string& filename, std::string* error)
+{
+    std::ifstream in(filename);
+    if (!in.is_open()) {
+        return true;   // optional file: keep the built-in formats
+    }
+
+    PhoneFormatSet formats;
+    if (!formats.parse(in, error)) {
+        return false;
+    }
+    setPhoneFormats(formats);
+    return true;
+}
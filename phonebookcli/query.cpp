@@ -0,0 +1,636 @@
+#include "Query.h"
+#include "PhoneBook.h"
+#include "Checkers.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+// ---------- VALUE FORMS ----------
+
+std::string foldAscii(std::string_view text) {
+    std::string out(text);
+    for (char& ch : out) {
+        if (ch >= 'A' && ch <= 'Z') ch = static_cast<char>(ch - 'A' + 'a');
+    }
+    return out;
+}
+
+std::string phoneDigits(std::string_view phone) {
+    std::string out;
+    for (char ch : phone) {
+        if ((ch >= '0' && ch <= '9') || ch == '+') out += ch;
+    }
+    return out;
+}
+
+// Normalized when recognized, digits otherwise.
+std::string phoneForm(std::string_view phone) {
+    std::string normalized = normalizePhone(phone);
+    return normalized.empty() ? phoneDigits(phone) : normalized;
+}
+
+bool isPhoneField(QueryField field) {
+    return field == QueryField::AnyPhone || field == QueryField::WorkPhone ||
+           field == QueryField::HomePhone || field == QueryField::OfficePhone;
+}
+
+bool startsWith(std::string_view text, std::string_view prefix) {
+    return text.size() >= prefix.size() && text.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool endsWith(std::string_view text, std::string_view suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// A contact id: digits, not 0, and small enough for a ContactId.
+bool parseId(const std::string& text, ContactId* out) {
+    if (text.empty() || !std::all_of(text.begin(), text.end(), [](unsigned char c) { return std::isdigit(c); })) {
+        return false;
+    }
+    ContactId id = 0;
+    for (char c : text) {
+        const ContactId digit = static_cast<ContactId>(c - '0');
+        if (id > (std::numeric_limits<ContactId>::max() - digit) / 10) return false;
+        id = id * 10 + digit;
+    }
+    if (id == 0) return false;
+    *out = id;
+    return true;
+}
+
+// A predicate with its value(s) already in the form its field is compared in.
+struct Prepared {
+    const QueryPredicate* source;
+    std::string value;
+    std::string upper;
+    std::vector<std::string> words;   // Words only
+};
+
+Prepared prepare(const QueryPredicate& p, bool caseSensitive) {
+    Prepared out{ &p, p.value, p.upper, {} };
+    auto form = [&](const std::string& v) -> std::string {
+        if (isPhoneField(p.field)) return p.match == QueryMatch::Exact ? phoneForm(v) : phoneDigits(v);
+        switch (p.field) {
+        case QueryField::Birthday:    return birthdayKey(v);
+        case QueryField::EmailDomain: return p.match == QueryMatch::Exact ? emailDomain(v) : foldAscii(v);
+        case QueryField::Id:          return v;
+        default:                      return caseSensitive ? v : foldAscii(v);
+        }
+    };
+    out.value = form(p.value);
+    out.upper = form(p.upper);
+    if (p.match == QueryMatch::Words) out.words = AddressIndex::tokenize(p.value);
+    return out;
+}
+
+// The contact's side of a comparison, in the same form.
+std::string fieldText(const ContactView& c, ContactId id, QueryField field, bool caseSensitive) {
+    auto text = [&](std::string_view v) { return caseSensitive ? std::string(v) : foldAscii(v); };
+    switch (field) {
+    case QueryField::Id:          return std::to_string(id);
+    case QueryField::FirstName:   return text(c.firstName);
+    case QueryField::MiddleName:  return text(c.middleName);
+    case QueryField::LastName:    return text(c.lastName);
+    case QueryField::WorkPhone:   return c.numbers.number1.empty() ? std::string() : phoneForm(c.numbers.number1);
+    case QueryField::HomePhone:   return c.numbers.number2.empty() ? std::string() : phoneForm(c.numbers.number2);
+    case QueryField::OfficePhone: return c.numbers.number3.empty() ? std::string() : phoneForm(c.numbers.number3);
+    case QueryField::Email:       return text(c.email);
+    case QueryField::EmailDomain: return c.email.empty() ? std::string() : emailDomain(c.email);
+    case QueryField::Address:     return text(c.address);
+    case QueryField::Birthday:    return birthdayKey(c.birthday);
+    case QueryField::AnyPhone:    break;   // handled by the caller
+    }
+    return {};
+}
+
+bool compareText(const std::string& text, const Prepared& p) {
+    // An empty field matches nothing. The ordered indexes leave such
+    // contacts out, so a scan must too, or the result of a range (even
+    // an open one, born:..1970) or of born:19* would depend on the plan.
+    if (text.empty()) return false;
+
+    switch (p.source->match) {
+    case QueryMatch::Exact:    return text == p.value;
+    case QueryMatch::Prefix:   return startsWith(text, p.value);
+    case QueryMatch::Suffix:   return endsWith(text, p.value);
+    case QueryMatch::Contains: return text.find(p.value) != std::string::npos;
+    case QueryMatch::Range:
+        return (p.value.empty() || text >= p.value) &&
+               (p.upper.empty() || text <= p.upper || startsWith(text, p.upper));
+    case QueryMatch::Words:    break;   // handled by the caller
+    }
+    return false;
+}
+
+bool matchesWords(std::string_view address, const std::vector<std::string>& words) {
+    if (words.empty()) return true;
+    const std::vector<std::string> tokens = AddressIndex::tokenize(address);
+    auto has = [&](const std::string& w) { return std::find(tokens.begin(), tokens.end(), w) != tokens.end(); };
+    for (std::size_t i = 0; i + 1 < words.size(); ++i) {
+        if (!has(words[i])) return false;
+    }
+    const std::string& last = words.back();
+    return std::any_of(tokens.begin(), tokens.end(), [&](const std::string& t) { return startsWith(t, last); });
+}
+
+bool matches(const ContactView& c, ContactId id, const Prepared& p, bool caseSensitive) {
+    const QueryPredicate& q = *p.source;
+
+    if (q.match == QueryMatch::Words) {
+        if (q.field == QueryField::Address) return matchesWords(c.address, p.words);
+        Prepared contains = p;
+        QueryPredicate asContains = q;
+        asContains.match = QueryMatch::Contains;
+        contains.source = &asContains;
+        return compareText(fieldText(c, id, q.field, caseSensitive), contains);
+    }
+
+    if (q.field == QueryField::Id && q.match == QueryMatch::Range) {
+        ContactId lo = 0, hi = 0;
+        const bool hasLo = parseId(p.value, &lo), hasHi = parseId(p.upper, &hi);
+        return (!hasLo || id >= lo) && (!hasHi || id <= hi);
+    }
+
+    if (q.field == QueryField::AnyPhone) {
+        for (QueryField f : { QueryField::WorkPhone, QueryField::HomePhone, QueryField::OfficePhone }) {
+            const std::string text = fieldText(c, id, f, caseSensitive);
+            if (!text.empty() && compareText(text, p)) return true;
+        }
+        return false;
+    }
+
+    return compareText(fieldText(c, id, q.field, caseSensitive), p);
+}
+
+// ---------- PLANNING ----------
+
+// How a predicate can produce candidates, and roughly how many.
+struct Access {
+    enum Kind { Scan, Ordered, OrderedKey, EmailKey, Domain, Words, IdRange } kind = Scan;
+    const OrderedIndex* index = nullptr;
+    std::string lo, hi;            // Ordered: [lo, hi); OrderedKey / EmailKey / Domain: lo
+    ContactId first = 0, last = 0;   // IdRange
+    std::size_t estimate = 0;
+    std::string via;
+};
+
+const OrderedIndex* orderedFor(const PhoneBook& book, QueryField field) {
+    if (field == QueryField::FirstName) return &book.firstNameOrder;
+    if (field == QueryField::LastName) return &book.lastNameOrder;
+    if (field == QueryField::Birthday) return &book.birthdayIndex;
+    if (isPhoneField(field)) return &book.phoneSuffixIndex;
+    return nullptr;
+}
+
+// `limit` is the best estimate so far: counting beyond it is wasted.
+Access planAccess(const PhoneBook& book, const Prepared& p, bool caseSensitive, std::size_t limit) {
+    const QueryPredicate& q = *p.source;
+    const std::size_t total = book.mainStorage.size();
+    Access a;
+    a.estimate = total;
+    a.via = "scan";
+
+    if (const OrderedIndex* index = orderedFor(book, q.field)) {
+        const bool phone = isPhoneField(q.field);
+        const bool names = q.field == QueryField::FirstName || q.field == QueryField::LastName;
+        // Index keys are folded; a case-sensitive value is folded to find them.
+        auto key = [&](const std::string& v) {
+            if (phone) return std::string(v.rbegin(), v.rend());
+            return names ? foldAscii(v) : v;
+        };
+        a.index = index;
+        a.via = phone ? "phone suffix index" : (q.field == QueryField::Birthday ? "birthday index" : "name index");
+
+        if (q.match == QueryMatch::Exact) {
+            a.kind = Access::OrderedKey;
+            a.lo = key(p.value);
+            const std::vector<ContactId>* ids = index->find(a.lo);
+            a.estimate = ids ? ids->size() : 0;
+            return a;
+        }
+        const bool prefixLike = phone ? q.match == QueryMatch::Suffix
+                                      : (q.match == QueryMatch::Prefix || q.match == QueryMatch::Range);
+        if (prefixLike) {
+            a.kind = Access::Ordered;
+            if (q.match == QueryMatch::Range) {
+                a.lo = key(p.value);
+                a.hi = p.upper.empty() ? std::string() : OrderedIndex::prefix_end(key(p.upper));
+            }
+            else {
+                a.lo = key(p.value);
+                a.hi = OrderedIndex::prefix_end(a.lo);
+            }
+            a.estimate = index->count(a.lo, a.hi, limit);
+            return a;
+        }
+        a.index = nullptr;
+        a.via = "scan";
+        return a;
+    }
+
+    switch (q.field) {
+    case QueryField::Email:
+        if (q.match == QueryMatch::Exact && caseSensitive) {
+            a.kind = Access::EmailKey;
+            a.lo = p.value;
+            a.estimate = book.emailIndex.find(p.value) != book.emailIndex.end() ? 1 : 0;
+            a.via = "email index";
+        }
+        else if ((q.match == QueryMatch::Exact || q.match == QueryMatch::Suffix) &&
+                 p.value.find('@') != std::string::npos) {
+            a.kind = Access::Domain;
+            a.lo = emailDomain(p.value);
+            a.estimate = book.domain_count(a.lo);
+            a.via = "email domain index";
+        }
+        break;
+    case QueryField::EmailDomain:
+        if (q.match == QueryMatch::Exact) {
+            a.kind = Access::Domain;
+            a.lo = p.value;
+            a.estimate = book.domain_count(a.lo);
+            a.via = "email domain index";
+        }
+        break;
+    case QueryField::Address:
+        if (q.match == QueryMatch::Words && !p.words.empty()) {
+            a.kind = Access::Words;
+            a.lo = q.value;
+            a.estimate = book.addressIndex.estimate(q.value);
+            a.via = "address index";
+        }
+        break;
+    case QueryField::Id: {
+        ContactId lo = 0, hi = 0;
+        if (q.match == QueryMatch::Exact && parseId(p.value, &lo)) {
+            hi = lo;
+        }
+        else if (q.match == QueryMatch::Range) {
+            if (!parseId(p.value, &lo)) lo = 1;
+            if (!parseId(p.upper, &hi)) hi = book.index;
+        }
+        else {
+            break;
+        }
+        a.kind = Access::IdRange;
+        a.first = lo;
+        a.last = hi;
+        // hi - lo, not hi - lo + 1, which wraps for the widest range.
+        a.estimate = hi < lo ? 0 : hi - lo >= total ? total : static_cast<std::size_t>(hi - lo + 1);
+        a.via = "id";
+        // Probing every id of a sparse range costs more than a scan.
+        if (hi >= lo && hi - lo >= total) {
+            a.kind = Access::Scan;
+            a.via = "scan";
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return a;
+}
+
+void collect(const PhoneBook& book, const Access& a, std::vector<ContactId>* out) {
+    switch (a.kind) {
+    case Access::Ordered:
+        a.index->for_each(a.lo, a.hi, [out](ContactId id) { out->push_back(id); });
+        std::sort(out->begin(), out->end());
+        out->erase(std::unique(out->begin(), out->end()), out->end());
+        break;
+    case Access::OrderedKey:
+        if (const std::vector<ContactId>* ids = a.index->find(a.lo)) out->assign(ids->begin(), ids->end());
+        break;
+    case Access::EmailKey: {
+        auto it = book.emailIndex.find(a.lo);
+        if (it != book.emailIndex.end()) out->push_back(it->second);
+        break;
+    }
+    case Access::Domain:
+        *out = book.contacts_at_domain(a.lo);
+        break;
+    case Access::Words:
+        *out = book.addressIndex.matching(a.lo);
+        break;
+    case Access::IdRange:
+        for (ContactId id = a.first; id <= a.last; ++id) {
+            if (book.mainStorage.contains(id)) out->push_back(id);
+            if (id == std::numeric_limits<ContactId>::max()) break;
+        }
+        break;
+    case Access::Scan:
+        break;
+    }
+}
+
+const char* fieldName(QueryField field) {
+    switch (field) {
+    case QueryField::Id:          return "id";
+    case QueryField::FirstName:   return "first name";
+    case QueryField::MiddleName:  return "middle name";
+    case QueryField::LastName:    return "last name";
+    case QueryField::AnyPhone:    return "phone";
+    case QueryField::WorkPhone:   return "work phone";
+    case QueryField::HomePhone:   return "home phone";
+    case QueryField::OfficePhone: return "office phone";
+    case QueryField::Email:       return "email";
+    case QueryField::EmailDomain: return "email domain";
+    case QueryField::Address:     return "address";
+    case QueryField::Birthday:    return "birthday";
+    }
+    return "?";
+}
+
+const char* matchName(QueryMatch match) {
+    switch (match) {
+    case QueryMatch::Exact:    return "=";
+    case QueryMatch::Prefix:   return "prefix";
+    case QueryMatch::Suffix:   return "suffix";
+    case QueryMatch::Contains: return "contains";
+    case QueryMatch::Range:    return "range";
+    case QueryMatch::Words:    return "words";
+    }
+    return "?";
+}
+
+std::string describe(const QueryPredicate& q, const Access& a) {
+    std::ostringstream out;
+    out << fieldName(q.field) << ' ' << matchName(q.match) << " '" << q.value;
+    if (q.match == QueryMatch::Range) out << ".." << q.upper;
+    out << "' via " << a.via << " (~" << a.estimate << ")";
+    return out.str();
+}
+
+} // namespace
+
+// ---------- INDEX KEYS ----------
+
+std::string nameKey(std::string_view name)
+{
+    return foldAscii(name);
+}
+
+std::string phoneSuffixKey(std::string_view phone)
+{
+    const std::string form = phoneForm(phone);
+    return std::string(form.rbegin(), form.rend());
+}
+
+std::string birthdayKey(std::string_view birthday)
+{
+    auto digit = [&](std::size_t i) { return i < birthday.size() && birthday[i] >= '0' && birthday[i] <= '9'; };
+    const bool ddmmyyyy = birthday.size() == 10 && birthday[2] == '-' && birthday[5] == '-' &&
+                          digit(0) && digit(1) && digit(3) && digit(4) &&
+                          digit(6) && digit(7) && digit(8) && digit(9);
+    if (!ddmmyyyy) return std::string(birthday);
+
+    std::string key;
+    key.reserve(10);
+    key.append(birthday.substr(6, 4)).append(1, '-');
+    key.append(birthday.substr(3, 2)).append(1, '-');
+    key.append(birthday.substr(0, 2));
+    return key;
+}
+
+// ---------- MATCHING ----------
+
+bool matchesPredicate(const ContactView& contact, ContactId id, const QueryPredicate& predicate,
+                      bool caseSensitive)
+{
+    return matches(contact, id, prepare(predicate, caseSensitive), caseSensitive);
+}
+
+// ---------- PARSING ----------
+
+namespace {
+
+struct FieldName {
+    const char* name;
+    QueryField field;
+};
+
+const FieldName kFieldNames[] = {
+    { "id", QueryField::Id },
+    { "first", QueryField::FirstName }, { "firstname", QueryField::FirstName },
+    { "middle", QueryField::MiddleName }, { "middlename", QueryField::MiddleName },
+    { "last", QueryField::LastName }, { "lastname", QueryField::LastName },
+    { "phone", QueryField::AnyPhone },
+    { "work", QueryField::WorkPhone }, { "home", QueryField::HomePhone }, { "office", QueryField::OfficePhone },
+    { "email", QueryField::Email }, { "domain", QueryField::EmailDomain },
+    { "addr", QueryField::Address }, { "address", QueryField::Address },
+    { "born", QueryField::Birthday }, { "birthday", QueryField::Birthday },
+};
+
+// Splits on unquoted whitespace; quotes are dropped, their content kept.
+bool splitTerms(std::string_view text, std::vector<std::string>* terms, std::string* error) {
+    std::string current;
+    bool inQuotes = false, inTerm = false;
+    for (char ch : text) {
+        if (ch == '"') {
+            inQuotes = !inQuotes;
+            inTerm = true;
+        }
+        else if (!inQuotes && std::isspace(static_cast<unsigned char>(ch))) {
+            if (inTerm) terms->push_back(std::move(current));
+            current.clear();
+            inTerm = false;
+        }
+        else {
+            current += ch;
+            inTerm = true;
+        }
+    }
+    if (inQuotes) {
+        if (error) *error = "Unterminated quote.";
+        return false;
+    }
+    if (inTerm) terms->push_back(std::move(current));
+    return true;
+}
+
+} // namespace
+
+bool parseQuery(std::string_view text, Query* out, std::string* error)
+{
+    auto fail = [&](const std::string& msg) {
+        if (error) *error = msg;
+        return false;
+    };
+
+    std::vector<std::string> terms;
+    if (!splitTerms(text, &terms, error)) return false;
+
+    Query query;
+    std::vector<QueryPredicate> conjunction;
+    bool sawTerm = false;
+
+    for (const std::string& term : terms) {
+        if (term == "|" || term == "OR" || term == "or") {
+            if (conjunction.empty()) return fail("'" + term + "' needs a condition on both sides.");
+            query.anyOf.push_back(std::move(conjunction));
+            conjunction.clear();
+            continue;
+        }
+
+        const std::size_t colon = term.find(':');
+        if (colon == std::string::npos || colon == 0) {
+            return fail("Expected field:value, got '" + term + "'.");
+        }
+        const std::string name = foldAscii(term.substr(0, colon));
+        std::string value = term.substr(colon + 1);
+
+        if (name == "case") {
+            const std::string flag = foldAscii(value);
+            if (flag != "on" && flag != "off") return fail("case: takes on or off.");
+            query.caseSensitive = (flag == "on");
+            continue;
+        }
+
+        const FieldName* field = nullptr;
+        for (const FieldName& f : kFieldNames) {
+            if (name == f.name) field = &f;
+        }
+        if (!field) return fail("Unknown field '" + name + "'.");
+
+        QueryPredicate p;
+        p.field = field->field;
+        const std::size_t dots = value.find("..");
+        if (dots != std::string::npos) {
+            p.match = QueryMatch::Range;
+            p.upper = value.substr(dots + 2);
+            value.resize(dots);
+            if (value.empty() && p.upper.empty()) return fail("Range for '" + name + "' has no bounds.");
+            ContactId id = 0;
+            for (const std::string* bound : { &value, &p.upper }) {
+                if (p.field == QueryField::Id && !bound->empty() && !parseId(*bound, &id)) {
+                    return fail("Invalid id '" + *bound + "'.");
+                }
+            }
+        }
+        else if (value.size() >= 2 && value.front() == '*' && value.back() == '*') {
+            p.match = QueryMatch::Contains;
+            value = value.substr(1, value.size() - 2);
+        }
+        else if (!value.empty() && value.back() == '*') {
+            p.match = QueryMatch::Prefix;
+            value.pop_back();
+        }
+        else if (!value.empty() && value.front() == '*') {
+            p.match = QueryMatch::Suffix;
+            value.erase(0, 1);
+        }
+        else {
+            p.match = p.field == QueryField::Address ? QueryMatch::Words : QueryMatch::Exact;
+        }
+        if (p.match != QueryMatch::Range && value.empty()) {
+            return fail("Missing value for '" + name + "'.");
+        }
+        p.value = std::move(value);
+        conjunction.push_back(std::move(p));
+        sawTerm = true;
+    }
+
+    if (!sawTerm) return fail("Empty query.");
+    if (conjunction.empty()) return fail("A query cannot end with OR.");
+    query.anyOf.push_back(std::move(conjunction));
+
+    *out = std::move(query);
+    return true;
+}
+
+// ---------- EXECUTION ----------
+
+std::vector<ContactId> runQuery(const PhoneBook& book, const Query& query, QueryStats* stats)
+{
+    const bool cs = query.caseSensitive;
+    std::vector<ContactId> result;
+
+    struct Plan {
+        std::vector<Prepared> predicates;
+        Access access;
+        bool empty = false;
+    };
+    std::vector<Plan> plans;
+    bool anyScan = false;
+
+    for (const std::vector<QueryPredicate>& conjunction : query.anyOf) {
+        Plan plan;
+        for (const QueryPredicate& q : conjunction) plan.predicates.push_back(prepare(q, cs));
+
+        std::size_t best = std::numeric_limits<std::size_t>::max();
+        std::string why;
+        for (const Prepared& p : plan.predicates) {
+            Access a = planAccess(book, p, cs, best);
+            if (a.estimate < best || (plan.access.kind == Access::Scan && a.kind != Access::Scan && a.estimate <= best)) {
+                best = a.estimate;
+                why = describe(*p.source, a);
+                plan.access = std::move(a);
+            }
+            if (best == 0) break;
+        }
+        if (plan.predicates.empty()) {
+            plan.access.estimate = book.mainStorage.size();
+            why = "no conditions: every contact";
+        }
+        plan.empty = plan.access.kind != Access::Scan && plan.access.estimate == 0;
+        anyScan = anyScan || (plan.access.kind == Access::Scan && !plan.empty);
+
+        if (stats) stats->plan.push_back(plan.empty ? why + ", nothing to check" : why);
+        plans.push_back(std::move(plan));
+    }
+
+    auto passes = [&](const Plan& plan, ContactId id, const ContactView& c) {
+        for (const Prepared& p : plan.predicates) {
+            if (!matches(c, id, p, cs)) return false;
+        }
+        return true;
+    };
+
+    // Contacts already in the result, as a bitmap over storage slots: a
+    // contact several conjunctions select is checked and added once.
+    std::vector<std::uint64_t> taken((book.mainStorage.slot_count() + 63) / 64, 0);
+    auto take = [&taken](std::uint32_t slot) {
+        std::uint64_t& word = taken[slot / 64];
+        const std::uint64_t bit = std::uint64_t(1) << (slot % 64);
+        const bool fresh = (word & bit) == 0;
+        word |= bit;
+        return fresh;
+    };
+    auto isTaken = [&taken](std::uint32_t slot) { return (taken[slot / 64] >> (slot % 64)) & 1; };
+
+    // One pass over the book answers every conjunction that needs a scan.
+    if (anyScan) {
+        for (auto it = book.mainStorage.begin(); it != book.mainStorage.end(); ++it) {
+            if (stats) ++stats->examined;
+            for (const Plan& plan : plans) {
+                if (plan.access.kind == Access::Scan && !plan.empty && passes(plan, it->first, it->second)) {
+                    take(it.slot());
+                    result.push_back(it->first);
+                    break;
+                }
+            }
+        }
+    }
+
+    std::vector<ContactId> candidates;
+    for (const Plan& plan : plans) {
+        if (plan.empty || plan.access.kind == Access::Scan) continue;
+        candidates.clear();
+        collect(book, plan.access, &candidates);
+        for (ContactId id : candidates) {
+            auto it = book.mainStorage.find(id);
+            if (it == book.mainStorage.end() || isTaken(it.slot())) continue;
+            if (stats) ++stats->examined;
+            if (passes(plan, id, it->second) && take(it.slot())) result.push_back(id);
+        }
+    }
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
@@ -0,0 +1,431 @@
+#include "ShardedPhoneBook.h"
+#include "Checkers.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <utility>
+
+namespace {
+
+// Below this many contacts a scatter runs the shards in turn: starting
+// threads would cost more than the lookups.
+constexpr std::size_t kMinContactsForThreads = 64 * 1024;
+
+// Id pages probe the global ids, as PhoneBook::page() does its own.
+constexpr std::size_t kProbesPerRow = 4;
+constexpr std::size_t kMinProbes = 256;
+
+struct Row {
+    std::string key;
+    ContactId id;
+};
+
+auto rowOrder(bool descending) {
+    return [descending](const Row& a, const Row& b) {
+        if (a.key != b.key) return descending ? b.key < a.key : a.key < b.key;
+        return descending ? b.id < a.id : a.id < b.id;
+    };
+}
+
+// Runs f(i) for every i < count: on threads when `parallel`, else in turn.
+template <class F>
+void forEachShard(std::size_t count, bool parallel, F&& f) {
+    if (!parallel || count < 2) {
+        for (std::size_t i = 0; i < count; ++i) f(i);
+        return;
+    }
+    std::vector<std::thread> pool;
+    pool.reserve(count - 1);
+    for (std::size_t i = 1; i < count; ++i) pool.emplace_back([&f, i] { f(i); });
+    f(0);
+    for (std::thread& t : pool) t.join();
+}
+
+} // namespace
+
+ShardedPhoneBook::ShardedPhoneBook(const std::string& storageFile, std::size_t shardCount)
+    : m_emails(new EmailStripe[kEmailStripes])
+{
+    if (shardCount == 0) {
+        shardCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    m_shards.reserve(shardCount);
+    for (std::size_t i = 0; i < shardCount; ++i) {
+        m_shards.push_back(std::make_unique<Shard>(storageFile + "." + std::to_string(i)));
+    }
+
+    // Files written with another shard count: move every contact to its
+    // shard. Records move as stored, not revalidated. A contact leaves
+    // its old shard or file only once every shard is saved, and only if
+    // it was stored in its new one; anything else stays where it was.
+    // A copy left by an interrupted move is found again next time and
+    // counts as moved.
+    for (auto& shard : m_shards) shard->book.set_autosave(false);
+    std::vector<bool> changed(shardCount, false);
+    auto moveHome = [&](PhoneBook& from, std::size_t self, std::vector<ContactId>* moved) {
+        bool all = true;
+        for (const auto& pair : from.mainStorage) {
+            const std::size_t s = shard_index(pair.first);
+            if (s == self) continue;
+            PhoneBook& home = m_shards[s]->book;
+            ContactView there;
+            bool ok = home.find_contact(pair.first, &there) && there.same_fields(pair.second);
+            if (!ok && home.adopt_contact(pair.first, pair.second)) {
+                ok = true;
+                changed[s] = true;
+            }
+            if (ok) moved->push_back(pair.first);
+            all = all && ok;
+        }
+        return all;
+    };
+
+    std::vector<std::vector<ContactId>> strays(shardCount);
+    for (std::size_t i = 0; i < shardCount; ++i) {
+        moveHome(m_shards[i]->book, i, &strays[i]);
+    }
+    // Files of shards beyond the count.
+    std::vector<std::unique_ptr<PhoneBook>> extras;
+    std::vector<std::vector<ContactId>> extraMoved;
+    std::vector<bool> extraComplete;
+    for (std::size_t k = shardCount;; ++k) {
+        const std::string file = storageFile + "." + std::to_string(k);
+        if (!std::ifstream(file).good()) break;
+        extras.push_back(std::make_unique<PhoneBook>(file));
+        PhoneBook& extra = *extras.back();
+        extra.set_autosave(false);
+        extra.set_undo_budget(0);
+        extraMoved.emplace_back();
+        extraComplete.push_back(moveHome(extra, shardCount, &extraMoved.back()));
+    }
+
+    bool saved = true;
+    for (std::size_t i = 0; i < shardCount; ++i) {
+        if (changed[i]) saved = m_shards[i]->book.save_to_file() && saved;
+    }
+    if (saved) {
+        for (std::size_t i = 0; i < shardCount; ++i) {
+            if (strays[i].empty()) continue;
+            PhoneBook& book = m_shards[i]->book;
+            for (ContactId id : strays[i]) (void)book.remove_contact(id);
+            (void)book.save_to_file();
+        }
+        for (std::size_t k = 0; k < extras.size(); ++k) {
+            PhoneBook& extra = *extras[k];
+            if (extraComplete[k]) {
+                std::remove(extra.get_storage_file().c_str());
+            }
+            else if (!extraMoved[k].empty()) {
+                // Keep what could not be moved, and only that.
+                for (ContactId id : extraMoved[k]) (void)extra.remove_contact(id);
+                (void)extra.save_to_file();
+            }
+        }
+    }
+    for (auto& shard : m_shards) shard->book.set_autosave(true);
+
+    ContactId last = 0;
+    for (std::size_t i = 0; i < shardCount; ++i) {
+        PhoneBook& book = m_shards[i]->book;
+        last = std::max(last, book.index);
+        for (const auto& pair : book.mainStorage) {
+            (void)claim_email(std::string(pair.second.field(ContactField::Email)), pair.first);
+        }
+    }
+    m_lastId.store(last);
+}
+
+std::size_t ShardedPhoneBook::shard_index(ContactId id) const
+{
+    return static_cast<std::size_t>(flat_detail::hashInt(id) % m_shards.size());
+}
+
+ShardedPhoneBook::EmailStripe& ShardedPhoneBook::stripe_of(const std::string& email) const
+{
+    return m_emails[flat_detail::hashInt(FlatHash{}(email)) % kEmailStripes];
+}
+
+std::size_t ShardedPhoneBook::size() const
+{
+    std::size_t total = 0;
+    for (const auto& shard : m_shards) {
+        std::shared_lock<std::shared_mutex> lock(shard->mutex);
+        total += shard->book.mainStorage.size();
+    }
+    return total;
+}
+
+// ---------- Email claims ----------
+
+bool ShardedPhoneBook::claim_email(const std::string& email, ContactId id)
+{
+    EmailStripe& stripe = stripe_of(email);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.owners.find(email);
+    if (it != stripe.owners.end()) return it->second == id;
+    stripe.owners[email] = id;
+    return true;
+}
+
+void ShardedPhoneBook::release_email(const std::string& email, ContactId id)
+{
+    EmailStripe& stripe = stripe_of(email);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.owners.find(email);
+    if (it != stripe.owners.end() && it->second == id) stripe.owners.erase(it);
+}
+
+ContactId ShardedPhoneBook::find_email(const std::string& email) const
+{
+    EmailStripe& stripe = stripe_of(email);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.owners.find(email);
+    return it == stripe.owners.end() ? 0 : it->second;
+}
+
+// ---------- Single contacts ----------
+
+bool ShardedPhoneBook::get_contact(ContactId id, Contact* out) const
+{
+    const Shard& shard = shard_of(id);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.book.get_contact(id, out);
+}
+
+// Claims the email, then adds to the id's shard; the claim is dropped
+// again if the shard rejects the contact.
+bool ShardedPhoneBook::insert(ContactId id, const Contact& contact, std::string* error)
+{
+    if (!claim_email(contact.email, id)) {
+        if (error) *error = "A contact with this email already exists.";
+        return false;
+    }
+
+    Shard& shard = shard_of(id);
+    bool ok = false, stored = false;
+    {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        ok = shard.book.insert_contact(id, contact, error);
+        stored = ok || shard.book.mainStorage.find(id) != shard.book.mainStorage.end();
+    }
+    if (!stored) release_email(contact.email, id);
+    return ok;
+}
+
+bool ShardedPhoneBook::add_contact(const Contact& contact, std::string* error, ContactId* newId)
+{
+    const ContactId id = m_lastId.fetch_add(1) + 1;
+    if (!insert(id, contact, error)) return false;
+    if (newId) *newId = id;
+    return true;
+}
+
+bool ShardedPhoneBook::update_contact(ContactId id, const Contact& updated, std::string* error)
+{
+    auto fail = [&](const std::string& msg) {
+        if (error) *error = msg;
+        return false;
+    };
+
+    Shard& shard = shard_of(id);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.book.mainStorage.find(id);
+    if (it == shard.book.mainStorage.end()) return fail("Contact not found.");
+
+    const std::string oldEmail(it->second.field(ContactField::Email));
+    const bool moved = updated.email != oldEmail;
+    if (moved && !claim_email(updated.email, id)) {
+        return fail("A contact with this email already exists.");
+    }
+
+    const bool ok = shard.book.update_contact(id, updated, error);
+    // Only a failed save leaves the update in place.
+    Contact now;
+    const bool applied = ok || (shard.book.get_contact(id, &now) && now.email == updated.email);
+    if (moved) release_email(applied ? oldEmail : updated.email, id);
+    return ok;
+}
+
+bool ShardedPhoneBook::remove_contact(ContactId id, std::string* error)
+{
+    Shard& shard = shard_of(id);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    Contact old;
+    if (!shard.book.get_contact(id, &old)) {
+        if (error) *error = "Contact not found.";
+        return false;
+    }
+    const bool ok = shard.book.remove_contact(id, error);
+    if (!shard.book.get_contact(id, nullptr)) release_email(old.email, id);
+    return ok;
+}
+
+// ---------- Bulk ingest ----------
+
+std::size_t ShardedPhoneBook::add_contacts(const std::vector<Contact>& contacts, std::vector<ContactId>* ids)
+{
+    const std::size_t count = contacts.size();
+    if (ids) ids->assign(count, 0);
+    if (count == 0) return 0;
+
+    // The whole batch is validated up front, on every core; the shards
+    // then store the valid contacts without checking them again.
+    const std::vector<std::uint32_t> errors = validateContacts(contacts.data(), count);
+
+    // Ids first: they decide the shards. Rejected contacts leave gaps.
+    const ContactId first = m_lastId.fetch_add(static_cast<ContactId>(count)) + 1;
+    std::vector<std::vector<std::size_t>> byShard(m_shards.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        byShard[shard_index(first + static_cast<ContactId>(i))].push_back(i);
+    }
+
+    std::atomic<std::size_t> added{ 0 };
+    forEachShard(m_shards.size(), true, [&](std::size_t s) {
+        if (byShard[s].empty()) return;
+        Shard& shard = *m_shards[s];
+        std::size_t mine = 0;
+
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.book.begin_batch();   // one save for the whole ingest
+        for (std::size_t i : byShard[s]) {
+            const ContactId id = first + static_cast<ContactId>(i);
+            if (errors[i] || !claim_email(contacts[i].email, id)) continue;
+            if (shard.book.adopt_contact(id, contacts[i])) {
+                if (ids) (*ids)[i] = id;
+                ++mine;
+            }
+            else {
+                release_email(contacts[i].email, id);
+            }
+        }
+        (void)shard.book.commit_batch();
+        added += mine;
+    });
+    return added.load();
+}
+
+// ---------- Scatter-gather reads ----------
+
+std::vector<ContactId> ShardedPhoneBook::query(const Query& query) const
+{
+    std::vector<std::vector<ContactId>> parts(m_shards.size());
+    forEachShard(m_shards.size(), size() >= kMinContactsForThreads, [&](std::size_t s) {
+        std::shared_lock<std::shared_mutex> lock(m_shards[s]->mutex);
+        parts[s] = runQuery(m_shards[s]->book, query);
+    });
+
+    std::vector<ContactId> ids;
+    for (const auto& part : parts) ids.insert(ids.end(), part.begin(), part.end());
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+bool ShardedPhoneBook::query(std::string_view text, std::vector<ContactId>* ids, std::string* error) const
+{
+    Query parsed;
+    if (!parseQuery(text, &parsed, error)) return false;
+    *ids = query(parsed);
+    return true;
+}
+
+// Every shard's own page from the cursor, merged; the first pageSize
+// rows of the merge are the page.
+bool ShardedPhoneBook::page(const PageRequest& request, Page* out, std::string* error) const
+{
+    out->ids.clear();
+    out->nextCursor.clear();
+
+    // Ids are dense across the shards but not within one, where the id
+    // walk of PhoneBook::page() would give up: walk the global ids here.
+    if (request.key == SortKey::Id && request.pageSize > 0) {
+        const bool desc = request.descending;
+        std::string key;
+        ContactId from = 0;
+        if (!request.cursor.empty() && !pageCursorRow(request.cursor, request.key, desc, &key, &from)) {
+            if (error) *error = "The cursor does not belong to this ordering.";
+            return false;
+        }
+        const ContactId last = m_lastId.load();
+        const std::size_t want = request.pageSize + 1;
+        const std::size_t budget = std::max<std::size_t>(kMinProbes, want * kProbesPerRow);
+        std::vector<ContactId> ids;
+        ContactId id = request.cursor.empty() ? (desc ? last : 1) : (desc ? from - 1 : from + 1);
+        for (std::size_t probes = 0; ids.size() < want && id >= 1 && id <= last && probes < budget; ++probes) {
+            if (get_contact(id, nullptr)) ids.push_back(id);
+            id = desc ? id - 1 : id + 1;
+        }
+        if (ids.size() == want || id < 1 || id > last) {
+            if (ids.size() == want) {
+                ids.pop_back();
+                out->nextCursor = pageCursor(request.key, desc, {}, ids.back());
+            }
+            out->ids = std::move(ids);
+            return true;
+        }
+        // A sparse stretch: merge the shards' pages instead.
+    }
+
+    std::vector<Row> rows;
+    bool more = false;
+    for (const auto& shard : m_shards) {
+        std::shared_lock<std::shared_mutex> lock(shard->mutex);
+        Page part;
+        if (!shard->book.page(request, &part, error)) return false;
+        for (ContactId id : part.ids) {
+            rows.push_back(Row{ pageSortKey(shard->book.mainStorage.at(id), request.key), id });
+        }
+        more = more || !part.nextCursor.empty();
+    }
+
+    std::sort(rows.begin(), rows.end(), rowOrder(request.descending));
+    const std::size_t take = std::min(rows.size(), request.pageSize);
+    for (std::size_t i = 0; i < take; ++i) out->ids.push_back(rows[i].id);
+    if (take > 0 && (more || rows.size() > take)) {
+        out->nextCursor = pageCursor(request.key, request.descending, rows[take - 1].key, rows[take - 1].id);
+    }
+    return true;
+}
+
+std::vector<ContactId> ShardedPhoneBook::sorted_ids(SortKey key, bool descending) const
+{
+    // Each shard sorts its own part; the sorted parts are merged pairwise.
+    std::vector<Row> rows;
+    std::vector<std::size_t> bounds{ 0 };
+    for (const auto& shard : m_shards) {
+        std::shared_lock<std::shared_mutex> lock(shard->mutex);
+        for (ContactId id : shard->book.sorted_ids(key, descending)) {
+            rows.push_back(Row{ pageSortKey(shard->book.mainStorage.at(id), key), id });
+        }
+        bounds.push_back(rows.size());
+    }
+
+    const auto order = rowOrder(descending);
+    while (bounds.size() > 2) {
+        std::vector<std::size_t> merged;
+        std::size_t i = 0;
+        for (; i + 2 < bounds.size(); i += 2) {
+            std::inplace_merge(rows.begin() + bounds[i], rows.begin() + bounds[i + 1],
+                               rows.begin() + bounds[i + 2], order);
+            merged.push_back(bounds[i]);
+        }
+        for (; i < bounds.size(); ++i) merged.push_back(bounds[i]);
+        bounds.swap(merged);
+    }
+
+    std::vector<ContactId> ids;
+    ids.reserve(rows.size());
+    for (const Row& row : rows) ids.push_back(row.id);
+    return ids;
+}
+
+bool ShardedPhoneBook::save()
+{
+    bool ok = true;
+    for (const auto& shard : m_shards) {
+        std::unique_lock<std::shared_mutex> lock(shard->mutex);
+        ok = shard->book.save_to_file() && ok;
+    }
+    return ok;
+}
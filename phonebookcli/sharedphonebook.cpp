@@ -0,0 +1,75 @@
+#include "SharedPhoneBook.h"
+
+#include <utility>
+
+SharedPhoneBook::SharedPhoneBook(const std::string& storageFile)
+    : m_book(storageFile)
+{
+}
+
+// ---------- Readers ----------
+
+std::size_t SharedPhoneBook::size() const
+{
+    auto lock = read_lock();
+    return m_book.mainStorage.size();
+}
+
+bool SharedPhoneBook::get_contact(ContactId id, Contact* out) const
+{
+    auto lock = read_lock();
+    return m_book.get_contact(id, out);
+}
+
+std::vector<ContactId> SharedPhoneBook::query(const Query& query, QueryStats* stats) const
+{
+    auto lock = read_lock();
+    return runQuery(m_book, query, stats);
+}
+
+bool SharedPhoneBook::query(std::string_view text, std::vector<ContactId>* ids, std::string* error) const
+{
+    // Parsing needs no lock.
+    Query parsed;
+    if (!parseQuery(text, &parsed, error)) return false;
+    *ids = query(parsed);
+    return true;
+}
+
+bool SharedPhoneBook::page(const PageRequest& request, Page* out, std::string* error) const
+{
+    auto lock = read_lock();
+    return m_book.page(request, out, error);
+}
+
+std::vector<ContactId> SharedPhoneBook::contacts_at_domain(std::string_view domain) const
+{
+    auto lock = read_lock();
+    return m_book.contacts_at_domain(domain);
+}
+
+// ---------- Writers ----------
+
+bool SharedPhoneBook::add_contact(Contact contact, std::string* error, ContactId* newId)
+{
+    auto lock = write_lock();
+    return m_book.add_contact(std::move(contact), error, newId);
+}
+
+bool SharedPhoneBook::update_contact(ContactId id, Contact updated, std::string* error)
+{
+    auto lock = write_lock();
+    return m_book.update_contact(id, std::move(updated), error);
+}
+
+bool SharedPhoneBook::remove_contact(ContactId id, std::string* error)
+{
+    auto lock = write_lock();
+    return m_book.remove_contact(id, error);
+}
+
+bool SharedPhoneBook::save()
+{
+    auto lock = write_lock();
+    return m_book.save_to_file();
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdio>
+
+// ======================================================
+//   Check
+//   Minimal assertions for the test programs: CHECK reports a failed
+//   condition and keeps going; a test's main() returns checkResult().
+// ======================================================
+
+inline int& checkFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++checkFailures();                                                        \
+        }                                                                             \
+    } while (0)
+
+inline int checkResult() {
+    if (checkFailures() == 0) {
+        std::puts("ok");
+        return 0;
+    }
+    std::fprintf(stderr, "%d check(s) failed\n", checkFailures());
+    return 1;
+}
@@ -0,0 +1,117 @@
+// Allocation counts of the view and move-through paths (Contact.h,
+// ContactRecord.h): global operator new is replaced by a counting one.
+//   - a Contact built from moved strings allocates nothing;
+//   - add_contact(std::move(c)) makes no copy of c's strings: it
+//     allocates exactly as many blocks fewer than add_contact(c) as c
+//     has strings too long for the small-string buffer;
+//   - find_contact() into a ContactView allocates nothing and its views
+//     point into the stored record.
+// Index and arena growth make single adds vary, so each add is measured
+// several times and the smallest count is compared.
+
+#include "Check.h"
+#include "PhoneBook.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+namespace {
+long g_allocations = 0;
+}
+
+void* operator new(std::size_t size) {
+    ++g_allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) {
+    ++g_allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+// Last name, email and address are longer than any small-string buffer;
+// the first name and the phone fit in one.
+Contact makeContact(int i) {
+    return Contact("Ivan", "", "Konstantinopolsky" + std::to_string(i), Phone("+7916" + std::to_string(1000000 + i)),
+                   "konstantinopolsky" + std::to_string(i) + "@mailserver",
+                   "Bolshaya Sadovaya street, building " + std::to_string(i), "");
+}
+constexpr long kLongStrings = 3;
+
+void constructionMovesStrings() {
+    std::string first = "Konstantin-Konstantinovich";
+    std::string last = "Konstantinopolsky";
+    std::string email = "konstantinopolsky@mailserver";
+    const long before = g_allocations;
+    Contact c(std::move(first), "", std::move(last), Phone(), std::move(email));
+    Contact moved(std::move(c));
+    CHECK(g_allocations == before);
+    CHECK(moved.email == "konstantinopolsky@mailserver");
+}
+
+void addMovesThrough() {
+    PhoneBook book("allocationtest.db");
+    book.set_autosave(false);
+    book.set_undo_budget(0);   // no before-images: they copy on purpose
+    int next = 0;
+    for (; next < 2000; ++next) CHECK(book.add_contact(makeContact(next)));
+
+    long byCopy = -1, byMove = -1;
+    for (int round = 0; round < 20; ++round) {
+        const Contact copied = makeContact(next++);
+        long before = g_allocations;
+        CHECK(book.add_contact(copied));
+        const long copyCount = g_allocations - before;
+
+        Contact moved = makeContact(next++);
+        before = g_allocations;
+        CHECK(book.add_contact(std::move(moved)));
+        const long moveCount = g_allocations - before;
+
+        byCopy = byCopy < 0 ? copyCount : std::min(byCopy, copyCount);
+        byMove = byMove < 0 ? moveCount : std::min(byMove, moveCount);
+    }
+    std::printf("add_contact: %ld allocations from a copy, %ld from an rvalue\n", byCopy, byMove);
+    CHECK(byCopy - byMove == kLongStrings);
+}
+
+void findIntoView() {
+    PhoneBook book("allocationtest.db");
+    book.set_autosave(false);
+    ContactId id = 0;
+    CHECK(book.add_contact(makeContact(7), nullptr, &id));
+
+    ContactView view;
+    const long before = g_allocations;
+    const bool found = book.find_contact(id, &view);
+    const bool same = view.email == "konstantinopolsky7@mailserver" && view.address.size() > 30;
+    CHECK(g_allocations == before);
+    CHECK(found && same);
+
+    // The view reads the stored record itself, not a copy of it.
+    const ContactRecord& stored = book.mainStorage.find(id)->second;
+    const ContactView fromRecord = stored;
+    CHECK(view.email.data() == fromRecord.email.data());
+    CHECK(view.lastName.data() == fromRecord.lastName.data());
+}
+
+} // namespace
+
+int main()
+{
+    constructionMovesStrings();
+    addMovesThrough();
+    findIntoView();
+    std::remove("allocationtest.db");
+    return checkResult();
+}
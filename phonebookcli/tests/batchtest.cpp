@@ -0,0 +1,76 @@
+// Batches: a rolled-back batch leaves the book as it was, duplicate
+// checks included. The batch below grows the Bloom filters past their
+// sizing, so they are rebuilt while a contact is deleted; after the
+// rollback that contact's email and phone must still be seen as taken.
+
+#include "Check.h"
+#include "PhoneBook.h"
+
+#include <cstdio>
+#include <string>
+
+namespace {
+
+Contact makeContact(unsigned k) {
+    char phone[32];
+    std::snprintf(phone, sizeof phone, "+7998%07u", k);
+    return Contact("Anna", "", "Petrova", Phone(phone), "u" + std::to_string(k) + "@mail", "", "");
+}
+
+void rollbackKeepsDuplicateChecks() {
+    PhoneBook book("batchtest.db");
+    book.set_autosave(false);
+
+    ContactId dup = 0;
+    CHECK(book.add_contact(Contact("Dup", "", "Licate", Phone("+79990000000"), "dup@mail", "", ""), nullptr, &dup));
+
+    CHECK(book.begin_batch());
+    CHECK(book.remove_contact(dup));
+    for (unsigned k = 0; k < 1100; ++k) CHECK(book.add_contact(makeContact(k)));
+    book.rollback_batch();
+
+    CHECK(book.mainStorage.size() == 1);
+    CHECK(book.find_contact(dup, nullptr));
+    CHECK(book.email_in_use("dup@mail"));
+    CHECK(book.phone_in_use("8(999)000-00-00"));
+
+    std::string error;
+    CHECK(!book.add_contact(Contact("Dup", "", "Again", Phone("+79990000001"), "dup@mail", "", ""), &error));
+
+    // The batch's own contacts are gone, and their keys free again.
+    CHECK(!book.email_in_use("u5@mail"));
+    CHECK(book.add_contact(makeContact(5)));
+}
+
+void rollbackRestoresEdits() {
+    PhoneBook book("batchtest.db");
+    book.set_autosave(false);
+
+    ContactId id = 0;
+    CHECK(book.add_contact(Contact("Ivan", "", "Petrov", Phone("+79990000010"), "ivan@mail", "", ""), nullptr, &id));
+    const ContactId next = book.get_index();
+
+    CHECK(book.begin_batch());
+    CHECK(!book.begin_batch());
+    CHECK(book.update_contact(id, Contact("Ivan", "", "Sidorov", Phone("+79990000011"), "sidorov@mail", "", "")));
+    for (unsigned k = 0; k < 1100; ++k) CHECK(book.add_contact(makeContact(k)));
+    book.rollback_batch();
+
+    Contact c;
+    CHECK(book.get_contact(id, &c) && c.lastName == "Petrov" && c.email == "ivan@mail");
+    CHECK(book.get_index() == next);
+    CHECK(book.email_in_use("ivan@mail"));
+    CHECK(book.phone_in_use("+79990000010"));
+    CHECK(!book.email_in_use("sidorov@mail"));
+    CHECK(!book.in_batch());
+}
+
+} // namespace
+
+int main()
+{
+    rollbackKeepsDuplicateChecks();
+    rollbackRestoresEdits();
+    std::remove("batchtest.db");
+    return checkResult();
+}
@@ -0,0 +1,369 @@
+// Differential test of the string_view validators (checkers.cpp) against
+// the std::regex validators they replaced, copied below unchanged. Every
+// input must get the same answer from both; normalizePhone() must give a
+// key exactly for the phones isValidPhone() accepts. The phone checks run
+// twice: with the built-in formats and with phone_formats.txt loaded.
+// The batch validator must give every record validateContact()'s mask.
+
+#include "Check.h"
+#include "Checkers.h"
+#include "PhoneFormats.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdio>
+#include <ctime>
+#include <functional>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+// ---------- REFERENCE: THE REGEX VALIDATORS ----------
+
+namespace reference {
+
+std::string trim(const std::string& s) {
+    std::size_t start = 0;
+    while (start < s.size() && std::isspace(static_cast<unsigned char>(s[start]))) ++start;
+    if (start == s.size()) return "";
+    std::size_t end = s.size() - 1;
+    while (end > start && std::isspace(static_cast<unsigned char>(s[end]))) --end;
+    return s.substr(start, end - start + 1);
+}
+
+bool isLeapYear(int year) {
+    return (year % 4 == 0 && year % 100 != 0) || (year % 400 == 0);
+}
+
+int daysInMonth(int month, int year) {
+    if (month < 1 || month > 12) return 0;
+    constexpr std::array<int, 12> days = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    if (month == 2 && isLeapYear(year)) return 29;
+    return days[month - 1];
+}
+
+bool isValidName(const std::string& rawName) {
+    std::string name = trim(rawName);
+    if (name.empty()) return false;
+    static const std::regex pattern(R"(^[A-Za-z][A-Za-z0-9 -]*$)");
+    if (!std::regex_match(name, pattern)) return false;
+    return name.back() != '-';
+}
+
+bool isValidPhone(const std::string& rawPhone) {
+    std::string phone = trim(rawPhone);
+    if (phone.empty()) return false;
+    static const std::regex pattern(
+        R"(^(?:\+7|8)(?:\d{10}|\(\d{3}\)\d{7}|\(\d{3}\)\d{3}-\d{2}-\d{2})$)"
+    );
+    return std::regex_match(phone, pattern);
+}
+
+bool isValidBirthday(const std::string& rawDate) {
+    std::string date = trim(rawDate);
+    if (date.empty()) return false;
+
+    static const std::regex pattern(R"(^(\d{2})-(\d{2})-(\d{4})$)");
+    std::smatch match;
+    if (!std::regex_match(date, match, pattern)) return false;
+
+    int day = std::stoi(match[1].str());
+    int month = std::stoi(match[2].str());
+    int year = std::stoi(match[3].str());
+
+    if (month < 1 || month > 12) return false;
+    int maxDay = daysInMonth(month, year);
+    if (maxDay == 0) return false;
+    if (day < 1 || day > maxDay) return false;
+
+    std::time_t t = std::time(nullptr);
+    std::tm* now = std::localtime(&t);
+    int curYear = now->tm_year + 1900;
+    int curMonth = now->tm_mon + 1;
+    int curDay = now->tm_mday;
+
+    if (year > curYear) return false;
+    if (year == curYear && month > curMonth) return false;
+    if (year == curYear && month == curMonth && day >= curDay) return false;
+    return true;
+}
+
+bool isValidEmail(const std::string& rawEmail) {
+    std::string email = trim(rawEmail);
+    email.erase(std::remove_if(email.begin(), email.end(),
+                               [](unsigned char ch) { return std::isspace(ch); }),
+                email.end());
+    if (email.empty()) return false;
+    static const std::regex pattern(R"(^[A-Za-z0-9]+@[A-Za-z0-9]+$)");
+    return std::regex_match(email, pattern);
+}
+
+bool isValidAddress(const std::string& address) {
+    static const std::regex pattern(R"(^.*\S.*$)");
+    return std::regex_match(address, pattern);
+}
+
+} // namespace reference
+
+// ---------- COMPARISON ----------
+
+namespace {
+
+long g_inputs = 0;
+long g_mismatches = 0;
+
+void report(const char* what, const std::string& input, bool expected, bool actual) {
+    ++g_mismatches;
+    if (g_mismatches > 20) return;
+    std::fprintf(stderr, "%s: regex %d, new %d for bytes [", what, expected, actual);
+    for (unsigned char c : input) std::fprintf(stderr, "%02x", c);
+    std::fprintf(stderr, "]\n");
+}
+
+void comparePhone(const std::string& s) {
+    const bool expected = reference::isValidPhone(s);
+    const bool actual = isValidPhone(s);
+    if (expected != actual) report("phone", s, expected, actual);
+    if (actual == normalizePhone(s).empty()) report("normalizePhone", s, actual, !actual);
+}
+
+void compare(const std::string& s) {
+    ++g_inputs;
+    auto same = [&](const char* what, bool expected, bool actual) {
+        if (expected != actual) report(what, s, expected, actual);
+    };
+    same("name", reference::isValidName(s), isValidName(s));
+    same("birthday", reference::isValidBirthday(s), isValidBirthday(s));
+    same("email", reference::isValidEmail(s), isValidEmail(s));
+    same("address", reference::isValidAddress(s), isValidAddress(s));
+    comparePhone(s);
+}
+
+// Every string over `alphabet` up to `maxLength` characters.
+void enumerate(const std::string& alphabet, int maxLength, const std::function<void(const std::string&)>& check) {
+    std::string s;
+    std::function<void(int)> extend = [&](int depth) {
+        check(s);
+        if (depth == maxLength) return;
+        for (char c : alphabet) {
+            s.push_back(c);
+            extend(depth + 1);
+            s.pop_back();
+        }
+    };
+    extend(0);
+}
+
+// The phone templates with one or two positions replaced, one deleted or
+// one inserted, over an alphabet of the characters that matter.
+void phoneNeighbourhood(const std::function<void(const std::string&)>& check) {
+    static const char* const templates[] = {
+        "+71234567890", "81234567890", "+7(123)4567890", "8(123)4567890",
+        "+7(123)456-78-90", "8(123)456-78-90", " 8(123)456-78-90\t",
+    };
+    const std::string alphabet = "+78()-0 a\n";
+    for (const char* t : templates) {
+        const std::string base = t;
+        check(base);
+        for (std::size_t i = 0; i < base.size(); ++i) {
+            for (char c : alphabet) {
+                std::string one = base;
+                one[i] = c;
+                check(one);
+                for (std::size_t j = i + 1; j < base.size(); ++j) {
+                    for (char d : alphabet) {
+                        std::string two = one;
+                        two[j] = d;
+                        check(two);
+                    }
+                }
+                std::string inserted = base;
+                inserted.insert(i, 1, c);
+                check(inserted);
+            }
+            check(base.substr(0, i) + base.substr(i + 1));
+        }
+    }
+}
+
+void phoneChecks() {
+    enumerate("+78()-0 ", 7, comparePhone);
+    phoneNeighbourhood(comparePhone);
+}
+
+// validateContacts() must give every record the mask validateContact()
+// gives it, however the records are split across threads. The count is
+// no multiple of the block size or of any thread count used, and large
+// enough for several threads to get work.
+void batchValidation() {
+    static const char* const names[] = { "Ivan", "", "Anna-Maria", "9lives", "Olga-", " Petr " };
+    static const char* const phones[] = { "", "+79161234567", "8(916)123-45-67", "12345", "+7(916)1234567" };
+    static const char* const emails[] = { "ivan@mail", "", "bad@", "a b@mail", "x@y" };
+    static const char* const addresses[] = { "", "Lenina 1", "   ", "two\nlines" };
+    static const char* const birthdays[] = { "", "01-02-1990", "31-02-1990", "1990-01-02", "01-01-2999" };
+
+    std::mt19937 rng(31);
+    auto pick = [&rng](const auto& pool) { return std::string(pool[rng() % (sizeof pool / sizeof pool[0])]); };
+    const std::size_t count = 5 * 16 * 1024 + 123;
+    std::vector<Contact> contacts(count);
+    ContactColumns columns;
+    for (Contact& c : contacts) {
+        c.firstName = pick(names);
+        c.middleName = rng() % 3 ? "" : pick(names);
+        c.lastName = pick(names);
+        c.numbers.number1 = pick(phones);
+        c.numbers.number2 = pick(phones);
+        c.numbers.number3 = pick(phones);
+        c.email = pick(emails);
+        c.address = pick(addresses);
+        c.birthday = pick(birthdays);
+    }
+    for (const Contact& c : contacts) {
+        columns.firstName.push_back(c.firstName);
+        columns.middleName.push_back(c.middleName);
+        columns.lastName.push_back(c.lastName);
+        columns.work.push_back(c.numbers.number1);
+        columns.home.push_back(c.numbers.number2);
+        columns.office.push_back(c.numbers.number3);
+        columns.email.push_back(c.email);
+        columns.address.push_back(c.address);
+        columns.birthday.push_back(c.birthday);
+    }
+
+    std::vector<std::uint32_t> expected(count);
+    std::size_t valid = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        expected[i] = validateContact(contacts[i]);
+        valid += expected[i] == 0;
+    }
+    CHECK(valid > 0 && valid < count);
+
+    for (unsigned threads : { 1u, 2u, 3u, 4u, 7u, 0u }) {
+        CHECK(validateContacts(contacts.data(), count, threads) == expected);
+        CHECK(validateContacts(columns, threads) == expected);
+        // A prefix, so the last block and the last thread's share are partial.
+        CHECK(validateContacts(contacts.data(), count - 1000, threads) ==
+              std::vector<std::uint32_t>(expected.begin(), expected.end() - 1000));
+    }
+    CHECK(validateContacts(contacts.data(), 0).empty());
+
+    // Columns not supplied count as empty; a column of another length
+    // gives no result.
+    ContactColumns partial;
+    partial.firstName = columns.firstName;
+    partial.lastName = columns.lastName;
+    partial.email = columns.email;
+    partial.work = columns.work;
+    const std::vector<std::uint32_t> masks = validateContacts(partial, 3);
+    CHECK(masks.size() == count);
+    for (std::size_t i = 0; i < count && i < masks.size(); i += 97) {
+        Contact c;
+        c.firstName = contacts[i].firstName;
+        c.lastName = contacts[i].lastName;
+        c.email = contacts[i].email;
+        c.numbers.number1 = contacts[i].numbers.number1;
+        CHECK(masks[i] == validateContact(c));
+    }
+    partial.home.assign(count - 1, "+79161234567");
+    CHECK(validateContacts(partial).empty());
+}
+
+} // namespace
+
+int main()
+{
+    // All strings of up to two bytes.
+    for (int a = 0; a < 256; ++a) {
+        compare(std::string(1, static_cast<char>(a)));
+        for (int b = 0; b < 256; ++b) compare(std::string{ static_cast<char>(a), static_cast<char>(b) });
+    }
+
+    // Short strings over the characters the validators distinguish,
+    // including a non-ASCII byte and NUL.
+    enumerate(std::string("aZ0 -\t@.\n\r\x80\0", 12), 5, compare);
+
+    phoneNeighbourhood(compare);
+    phoneChecks();
+
+    // Dates: every dd-mm over years around the leap rules and today,
+    // plus two-position mutations of a leap day.
+    for (int d = 0; d < 100; ++d) {
+        for (int m = 0; m < 100; ++m) {
+            for (int y : { 0, 1, 1899, 1900, 1999, 2000, 2004, 2023, 2024, 2025, 2026, 2027, 2100, 9999 }) {
+                char buf[16];
+                std::snprintf(buf, sizeof buf, "%02d-%02d-%04d", d, m, y);
+                compare(buf);
+            }
+        }
+    }
+    {
+        const std::string base = "29-02-2000";
+        const std::string alphabet = "0129-/ a";
+        for (std::size_t i = 0; i < base.size(); ++i) {
+            for (char c : alphabet) {
+                for (std::size_t j = i; j < base.size(); ++j) {
+                    for (char e : alphabet) {
+                        std::string s = base;
+                        s[i] = c;
+                        s[j] = e;
+                        compare(s);
+                    }
+                }
+            }
+        }
+    }
+    {
+        // This year around today, padded, so "strictly in the past" is hit.
+        std::time_t t = std::time(nullptr);
+        const int year = std::localtime(&t)->tm_year + 1900;
+        for (int m = 1; m <= 12; ++m) {
+            for (int d = 1; d <= 31; ++d) {
+                char buf[32];
+                std::snprintf(buf, sizeof buf, " %02d-%02d-%04d ", d, m, year);
+                compare(buf);
+            }
+        }
+    }
+
+    // Emails: short strings exhaustively, longer ones at random.
+    enumerate("a0@. \tZ", 6, compare);
+    std::mt19937 rng(42);
+    {
+        const std::string alphabet = "abcXYZ019@. \t-_\x80";
+        for (int k = 0; k < 100000; ++k) {
+            std::string s(rng() % 40, ' ');
+            for (char& c : s) c = alphabet[rng() % alphabet.size()];
+            compare(s);
+        }
+    }
+
+    // Longer names and emails, mostly valid characters, crossing the
+    // 16-byte blocks of the SIMD class checks.
+    {
+        const std::string common = "aB3 -";
+        const std::string rare = "aZ09 -@.\t\x80\xff";
+        for (int k = 0; k < 100000; ++k) {
+            std::string s(rng() % 70, ' ');
+            for (char& c : s) c = rng() % 8 ? common[rng() % common.size()] : rare[rng() % rare.size()];
+            compare(s);
+            compare("a" + s);
+            compare("user" + s + "@dom");
+        }
+    }
+
+    batchValidation();
+
+    // The shipped phone_formats.txt must describe the same formats.
+    PhoneFormatSet shipped;
+    std::string error;
+    CHECK(shipped.load_from_file(PHONEBOOK_SOURCE_DIR "/phone_formats.txt", &error));
+    CHECK(shipped.formats().size() == PhoneFormatSet().formats().size());
+    setPhoneFormats(shipped);
+    phoneChecks();
+
+    std::printf("%ld inputs, %ld mismatches\n", g_inputs, g_mismatches);
+    CHECK(g_mismatches == 0);
+    return checkResult();
+}
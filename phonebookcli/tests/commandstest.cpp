@@ -0,0 +1,245 @@
+// The command language (Commands.h): any whitespace separates the verb
+// from its arguments, as it separates the other words, so a tab after
+// `search` runs the query rather than an unknown command. Responses of
+// create/edit/delete, quoting, escaped rows, paging through `list` and
+// when runScript() saves.
+
+#include "Check.h"
+#include "Commands.h"
+#include "PhoneBook.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool run(PhoneBook& book, const std::string& line, std::string* out) {
+    out->clear();
+    return runCommand(book, line, out);
+}
+
+void whitespaceAfterVerb() {
+    PhoneBook book("commandstest.db");
+    book.set_autosave(false);
+    std::string out;
+    CHECK(run(book, "create first=Ivan last=Petrov work=+79161234567 email=ivan@mail", &out));
+    CHECK(run(book, "create first=Anna last=Smith work=+79161234568 email=anna@mail", &out));
+
+    for (const char* line : { "search last:Petrov", "search\tlast:Petrov", "\tsearch \t last:Petrov\r\n" }) {
+        CHECK(run(book, line, &out));
+        CHECK(out.compare(0, 5, "ok 1\n") == 0);
+    }
+
+    CHECK(run(book, "get\t1", &out));
+    CHECK(out.compare(0, 5, "ok 1\n") == 0);
+    CHECK(!run(book, "searchlast:Petrov", &out));
+    CHECK(out.compare(0, 6, "error ") == 0);
+}
+
+void createEditDelete() {
+    PhoneBook book("commandstest.db");
+    book.set_autosave(false);
+    std::string out;
+    CHECK(run(book, "create first=Ivan last=Petrov work=+79161234567 home=+79160000000 email=ivan@mail", &out));
+    CHECK(out == "ok 1\n1\tIvan\t\tPetrov\t+79161234567\t+79160000000\t\tivan@mail\t\t\n");
+
+    // Fields not named keep their value; an empty one is cleared.
+    CHECK(run(book, "edit 1 middle=Sergeevich home= born=01-02-1990", &out));
+    CHECK(out == "ok 1\n1\tIvan\tSergeevich\tPetrov\t+79161234567\t\t\tivan@mail\t\t01-02-1990\n");
+    CHECK(run(book, "get 1", &out) && out.find("\t+79161234567\t\t\t") != std::string::npos);
+
+    // Refused edits leave the contact as it was.
+    CHECK(run(book, "create first=Anna last=Smith work=+79161234568 email=anna@mail", &out));
+    const std::string before = out.substr(out.find('\n') + 1);
+    CHECK(!run(book, "edit 2 email=ivan@mail", &out) && out.compare(0, 6, "error ") == 0);
+    CHECK(!run(book, "edit 2 work=12345", &out) && out.compare(0, 6, "error ") == 0);
+    CHECK(!run(book, "edit 2 work=", &out) && out.compare(0, 6, "error ") == 0);
+    CHECK(!run(book, "edit 2 nickname=Ann", &out) && out == "error Expected field=value, got 'nickname=Ann'.\n");
+    CHECK(run(book, "get 2", &out) && out == "ok 1\n" + before);
+    CHECK(!run(book, "create first=Olga last=Smith work=+79161234569 email=anna@mail", &out));
+    CHECK(book.mainStorage.size() == 2);
+
+    CHECK(run(book, "delete 1", &out) && out == "ok 0\n");
+    CHECK(!run(book, "get 1", &out) && out == "error No contact with id 1.\n");
+    CHECK(!run(book, "delete 1", &out) && out.compare(0, 6, "error ") == 0);
+    CHECK(!run(book, "edit 1 first=Petr", &out) && out == "error No contact with id 1.\n");
+    CHECK(!run(book, "delete", &out) && out == "error delete takes a contact id.\n");
+    CHECK(!run(book, "get 0", &out) && out == "error get takes a contact id.\n");
+    CHECK(!run(book, "get 2 3", &out) && out == "error get takes one contact id.\n");
+    CHECK(!run(book, "frobnicate 2", &out) && out == "error Unknown command 'frobnicate'.\n");
+}
+
+// Quotes keep spaces and whitespace in a value, anywhere in a word;
+// \" and \\ inside them are a quote and a backslash. Rows escape tab,
+// newline and backslash, so a row stays one line of nine tabs.
+void quotingAndEscapes() {
+    PhoneBook book("commandstest.db");
+    book.set_autosave(false);
+    std::string out;
+    CHECK(run(book, "create first=Ivan last=Petrov work=+79161234567 email=ivan@mail "
+                    "addr=\"Lenina 1, \\\"Dom\\\" \\\\ 2\"", &out));
+    Contact c;
+    CHECK(book.get_contact(1, &c) && c.address == "Lenina 1, \"Dom\" \\ 2");
+    CHECK(out == "ok 1\n1\tIvan\t\tPetrov\t+79161234567\t\t\tivan@mail\tLenina 1, \"Dom\" \\\\ 2\t\n");
+
+    CHECK(run(book, "edit 1 \"addr=Tab\there\"", &out));
+    CHECK(book.get_contact(1, &c) && c.address == "Tab\there");
+    CHECK(out.find("\tTab\\there\t") != std::string::npos);
+    // Edits cannot put a newline in; a file written elsewhere can.
+    CHECK(!run(book, "edit 1 addr=\"Two\nlines\"", &out) && out == "error Invalid address.\n");
+    CHECK(book.adopt_contact(7, Contact("Anna", "", "Smith", Phone("+79161234568"), "anna@mail", "Two\nlines\\", "")));
+    CHECK(run(book, "get 7", &out));
+    CHECK(out.find("\tTwo\\nlines\\\\\t") != std::string::npos);
+    CHECK(std::count(out.begin(), out.end(), '\n') == 2 && std::count(out.begin(), out.end(), '\t') == 9);
+
+    // An empty quoted value clears, as an empty one does.
+    CHECK(run(book, "edit 1 addr=\"\"", &out));
+    CHECK(book.get_contact(1, &c) && c.address.empty());
+
+    CHECK(!run(book, "edit 1 addr=\"open", &out) && out == "error Unterminated quote.\n");
+    CHECK(!run(book, "edit 1 addr=\"ends in \\\"", &out) && out == "error Unterminated quote.\n");
+    CHECK(book.get_contact(1, &c) && c.address.empty());
+}
+
+// Rows of a response, header dropped; *cursor gets the header's cursor.
+std::string rows(const std::string& out, std::string* cursor = nullptr) {
+    const std::size_t end = out.find('\n');
+    const std::string header = out.substr(0, end);
+    const std::size_t space = header.find(' ', 3);
+    if (cursor) *cursor = space == std::string::npos ? std::string() : header.substr(space + 1);
+    return out.substr(end + 1);
+}
+
+// Pages of `list ... limit N after CURSOR`, followed to the end, list
+// the book as one `list` does, for every key and direction.
+void pagingThroughBook() {
+    PhoneBook book("commandstest.db");
+    book.set_autosave(false);
+    std::string out;
+    const char* const names[] = { "Anna", "Ivan", "Olga", "Petr", "Maria" };
+    for (int i = 0; i < 57; ++i) {
+        const std::string n = std::to_string(i);
+        CHECK(run(book, std::string("create first=") + names[i % 5] + " last=Smith" + std::string(1, static_cast<char>('a' + i % 7)) +
+                            " work=+7998" + std::to_string(1000000 + i) + " email=u" + std::to_string(i * 37 % 57) + "@mail", &out));
+    }
+    for (int i = 5; i < 57; i += 9) CHECK(run(book, "delete " + std::to_string(i), &out));
+
+    for (const char* key : { "id", "first", "last", "email" }) {
+        for (const char* direction : { "asc", "desc" }) {
+            const std::string order = std::string(key) + " " + direction;
+            CHECK(run(book, "list " + order, &out));
+            const std::string whole = rows(out);
+
+            for (int limit : { 1, 10, 51, 100 }) {
+                std::string walked, cursor;
+                int pages = 0;
+                CHECK(run(book, "list " + order + " limit " + std::to_string(limit), &out));
+                walked += rows(out, &cursor);
+                ++pages;
+                while (!cursor.empty() && pages <= 60) {
+                    CHECK(run(book, "list " + order + " limit " + std::to_string(limit) + " after " + cursor, &out));
+                    walked += rows(out, &cursor);
+                    ++pages;
+                }
+                if (walked != whole) {
+                    std::fprintf(stderr, "list %s limit %d: pages differ from the whole list\n", order.c_str(), limit);
+                    ++checkFailures();
+                }
+                CHECK(pages <= (static_cast<int>(book.mainStorage.size()) + limit - 1) / limit + 1);
+            }
+            // A cursor of another ordering is refused.
+            CHECK(run(book, "list " + order + " limit 5", &out));
+            std::string cursor;
+            rows(out, &cursor);
+            const std::string other = std::string(key) + (std::string(direction) == "asc" ? " desc" : " asc");
+            CHECK(!run(book, "list " + other + " limit 5 after " + cursor, &out) && out.compare(0, 6, "error ") == 0);
+        }
+    }
+    CHECK(!run(book, "list limit ten", &out) && out == "error limit takes a number.\n");
+    CHECK(!run(book, "list sideways", &out) && out == "error Unknown list option 'sideways'.\n");
+}
+
+// Gives a script line by line, noting before each whether the book file
+// exists yet.
+class WatchedScript : public std::streambuf {
+public:
+    WatchedScript(std::vector<std::string> lines, std::string file) : m_lines(std::move(lines)), m_file(std::move(file)) {}
+    std::vector<bool> existed;
+
+protected:
+    int_type underflow() override {
+        if (m_next == m_lines.size()) return traits_type::eof();
+        existed.push_back(std::ifstream(m_file).good());
+        m_current = m_lines[m_next++] + "\n";
+        setg(&m_current[0], &m_current[0], &m_current[0] + m_current.size());
+        return traits_type::to_int_type(m_current[0]);
+    }
+
+private:
+    std::vector<std::string> m_lines;
+    std::string m_file;
+    std::size_t m_next = 0;
+    std::string m_current;
+};
+
+bool exists(const char* file) {
+    return std::ifstream(file).good();
+}
+
+// A script is one batch: saved once, after its last command, and only if
+// a command changed the book.
+void scriptSavesOnce() {
+    const char* const file = "commandstest.script.db";
+    std::remove(file);
+    {
+        PhoneBook book(file);
+        WatchedScript script({ "get 1", "# create first=Ivan", "", "edit 1 first=Petr", "list", "search last:Petrov" },
+                             file);
+        std::istream in(&script);
+        std::ostringstream out;
+        std::string error;
+        CHECK(!runScript(book, in, out, &error) && error.empty());
+        CHECK(!exists(file));
+        book.set_autosave(false);
+    }
+    {
+        PhoneBook book(file);
+        WatchedScript script({ "create first=Ivan last=Petrov work=+79161234567 email=ivan@mail",
+                               "create first=Anna last=Smith work=+79161234568 email=anna@mail",
+                               "create first=Olga last=Smith work=12345 email=olga@mail",
+                               "edit 1 home=+79160000000", "delete 2", "list" },
+                             file);
+        std::istream in(&script);
+        std::ostringstream out;
+        CHECK(!runScript(book, in, out));
+        CHECK(script.existed == std::vector<bool>(6, false));
+        CHECK(exists(file));
+        book.set_autosave(false);
+    }
+    {
+        PhoneBook book(file);
+        book.set_autosave(false);
+        CHECK(book.mainStorage.size() == 1);
+        Contact c;
+        CHECK(book.get_contact(1, &c) && c.numbers.number2 == "+79160000000");
+    }
+    std::remove(file);
+}
+
+} // namespace
+
+int main()
+{
+    whitespaceAfterVerb();
+    createEditDelete();
+    quotingAndEscapes();
+    pagingThroughBook();
+    scriptSavesOnce();
+    std::remove("commandstest.db");
+    return checkResult();
+}
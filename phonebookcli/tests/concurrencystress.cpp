@@ -0,0 +1,286 @@
+// Mixed read/write stress of the three concurrent front ends, meant to
+// run under ThreadSanitizer as well as plainly:
+//   cmake -DPHONEBOOK_SANITIZER=thread ... && ./concurrencystress [seconds]
+// Each phase runs readers and writers against one book for `seconds`
+// (default 1) and checks invariants a torn read or lost update breaks:
+//   SharedPhoneBook     - every query hit matches the query; at the end
+//                         the indexes agree with the contacts
+//   VersionedPhoneBook  - a snapshot never changes while pinned, a long
+//                         scan sees one consistent version, and the saved
+//                         file equals the last version
+//   ShardedPhoneBook    - emails stay unique across shards and
+//                         find_email() agrees with every shard
+
+#include "Check.h"
+#include "ShardedPhoneBook.h"
+#include "SharedPhoneBook.h"
+#include "VersionedPhoneBook.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Contact k: last name alternates, the email is unique per k and its
+// domain is one of seven.
+Contact makeContact(unsigned k) {
+    Contact c;
+    c.firstName = "Anna";
+    c.lastName = k % 2 ? "Petrova" : "Ivanova";
+    std::string letters;
+    for (unsigned v = k;; v /= 26) {
+        letters += static_cast<char>('a' + v % 26);
+        if (v < 26) break;
+    }
+    c.email = "user" + letters + "@mail" + std::string(1, static_cast<char>('a' + k % 7)) + "ru";
+    char phone[32];
+    std::snprintf(phone, sizeof phone, "8999%07u", k % 10000000);
+    c.numbers.number1 = phone;
+    c.address = "Lenina " + std::to_string(k % 50);
+    return c;
+}
+
+void removeFile(const std::string& name) {
+    std::remove(name.c_str());
+    std::remove((name + ".tmp").c_str());
+}
+
+// Runs every worker until `seconds` have passed.
+void runFor(double seconds, std::vector<std::function<void(const std::atomic<bool>&)>> workers) {
+    std::atomic<bool> stop{ false };
+    std::vector<std::thread> threads;
+    for (auto& worker : workers) threads.emplace_back([&stop, &worker] { worker(stop); });
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& t : threads) t.join();
+}
+
+// Whether the book's email and name indexes hold exactly its contacts.
+bool indexesConsistent(const PhoneBook& book) {
+    if (book.emailIndex.size() != book.mainStorage.size()) return false;
+    for (const auto& entry : book.mainStorage) {
+        const ContactView c = entry.second;
+        auto it = book.emailIndex.find(c.email);
+        if (it == book.emailIndex.end() || it->second != entry.first) return false;
+    }
+    return book.lastNameOrder.count("", "") == book.mainStorage.size();
+}
+
+void sharedPhase(double seconds) {
+    const std::string file = "stress_shared.db";
+    removeFile(file);
+    std::atomic<long> reads{ 0 }, writes{ 0 }, bad{ 0 };
+    {
+        SharedPhoneBook book(file);
+        for (unsigned k = 0; k < 300; ++k) CHECK(book.add_contact(makeContact(k)));
+
+        std::vector<std::function<void(const std::atomic<bool>&)>> workers;
+        for (int r = 0; r < 4; ++r) {
+            workers.push_back([&, r](const std::atomic<bool>& stop) {
+                std::mt19937 rng(r);
+                while (!stop) {
+                    Contact c;
+                    book.get_contact(rng() % 2000, &c);
+                    std::vector<ContactId> ids;
+                    if (!book.query("last:Petr* domain:maildru", &ids)) ++bad;
+                    for (ContactId id : ids) {
+                        Contact hit;
+                        // A hit removed since the query ran is fine; one that is not a
+                        // Petrova was read torn.
+                        if (book.get_contact(id, &hit) && hit.lastName != "Petrova") ++bad;
+                    }
+                    PageRequest request;
+                    request.key = SortKey::LastName;
+                    Page page;
+                    book.page(request, &page);
+                    book.contacts_at_domain("mailbru");
+                    book.read([](const PhoneBook& b) { return b.addressIndex.matching("lenina 1").size(); });
+                    ++reads;
+                }
+            });
+        }
+        for (int w = 0; w < 2; ++w) {
+            workers.push_back([&, w](const std::atomic<bool>& stop) {
+                std::mt19937 rng(100 + w);
+                unsigned k = 10000 + w * 100000;
+                while (!stop) {
+                    ContactId id = 0;
+                    if (!book.add_contact(makeContact(k++), nullptr, &id)) {
+                        ++bad;
+                        continue;
+                    }
+                    Contact c;
+                    const ContactId target = rng() % id + 1;
+                    if (book.get_contact(target, &c)) {
+                        c.address = "Mira " + std::to_string(rng() % 9);
+                        book.update_contact(target, std::move(c));
+                    }
+                    book.remove_contact(rng() % id + 1);
+                    ++writes;
+                }
+            });
+        }
+        runFor(seconds, std::move(workers));
+
+        CHECK(book.read(indexesConsistent));
+        std::printf("shared:    %ld reads, %ld writes, %zu contacts\n", reads.load(), writes.load(), book.size());
+    }
+    CHECK(bad == 0);
+    removeFile(file);
+}
+
+void versionedPhase(double seconds) {
+    const std::string file = "stress_versioned.db";
+    removeFile(file);
+    std::atomic<long> reads{ 0 }, scans{ 0 }, writes{ 0 }, bad{ 0 };
+    {
+        VersionedPhoneBook book(file);
+        for (unsigned k = 0; k < 300; ++k) CHECK(book.add_contact(makeContact(k)));
+
+        std::vector<std::function<void(const std::atomic<bool>&)>> workers;
+        for (int r = 0; r < 3; ++r) {
+            workers.push_back([&, r](const std::atomic<bool>& stop) {
+                std::mt19937 rng(r);
+                Query query;
+                parseQuery("last:Petr* domain:maildru", &query);
+                while (!stop) {
+                    auto snapshot = book.snapshot();
+                    const std::uint64_t version = snapshot.version();
+                    for (ContactId id : runQuery(snapshot.book(), query)) {
+                        Contact hit;
+                        // Within one version a hit cannot disappear.
+                        if (!snapshot->get_contact(id, &hit) || hit.lastName != "Petrova") ++bad;
+                    }
+                    if (snapshot.version() != version) ++bad;
+                    ++reads;
+                }
+            });
+        }
+        // Long scans that yield between contacts, so writers publish
+        // several versions while one is pinned.
+        workers.push_back([&](const std::atomic<bool>& stop) {
+            while (!stop) {
+                auto snapshot = book.snapshot();
+                std::size_t seen = 0;
+                for (const auto& entry : snapshot->mainStorage) {
+                    const ContactView c = entry.second;
+                    auto it = snapshot->emailIndex.find(c.email);
+                    if (it == snapshot->emailIndex.end() || it->second != entry.first) ++bad;
+                    ++seen;
+                    std::this_thread::yield();
+                }
+                if (seen != snapshot->mainStorage.size()) ++bad;
+                ++scans;
+            }
+        });
+        for (int w = 0; w < 2; ++w) {
+            workers.push_back([&, w](const std::atomic<bool>& stop) {
+                std::mt19937 rng(100 + w);
+                unsigned k = 10000 + w * 100000;
+                while (!stop) {
+                    ContactId id = 0;
+                    if (!book.add_contact(makeContact(k++), nullptr, &id)) {
+                        ++bad;
+                        continue;
+                    }
+                    Contact c;
+                    const ContactId target = rng() % id + 1;
+                    if (book.get_contact(target, &c)) {
+                        c.address = "Mira " + std::to_string(rng() % 9);
+                        book.update_contact(target, c);
+                    }
+                    book.remove_contact(rng() % id + 1);
+                    ++writes;
+                }
+            });
+        }
+        runFor(seconds, std::move(workers));
+
+        auto last = book.snapshot();
+        CHECK(indexesConsistent(last.book()));
+        PhoneBook saved(file);
+        saved.set_autosave(false);
+        CHECK(saved.mainStorage.size() == last->mainStorage.size());
+        for (const auto& entry : last->mainStorage) {
+            Contact c;
+            const ContactView expected = entry.second;
+            CHECK(saved.get_contact(entry.first, &c) && c.email == expected.email && c.address == expected.address);
+        }
+        std::printf("versioned: %ld reads, %ld scans, %ld writes, %zu contacts, %zu versions retired\n",
+                    reads.load(), scans.load(), writes.load(), last->mainStorage.size(), book.retired_versions());
+    }
+    CHECK(bad == 0);
+    removeFile(file);
+}
+
+void shardedPhase(double seconds) {
+    const std::string file = "stress_sharded.db";
+    const std::size_t shards = 4;
+    for (std::size_t s = 0; s < shards; ++s) removeFile(file + "." + std::to_string(s));
+    std::atomic<long> ops{ 0 };
+    {
+        ShardedPhoneBook book(file, shards);
+        std::vector<Contact> seed;
+        for (unsigned k = 0; k < 400; ++k) seed.push_back(makeContact(k));
+        CHECK(book.add_contacts(seed) == seed.size());
+
+        // Writers race on the same 600 emails: adds of a taken email and
+        // edits onto one must be refused, whichever shard holds it.
+        std::vector<std::function<void(const std::atomic<bool>&)>> workers;
+        for (int w = 0; w < 3; ++w) {
+            workers.push_back([&, w](const std::atomic<bool>& stop) {
+                std::mt19937 rng(w);
+                while (!stop) {
+                    book.add_contact(makeContact(rng() % 600));
+                    const ContactId id = rng() % 1000 + 1;
+                    Contact c;
+                    if (book.get_contact(id, &c)) {
+                        c.email = makeContact(rng() % 600).email;
+                        book.update_contact(id, c);
+                    }
+                    if (rng() % 3 == 0) book.remove_contact(rng() % 1000 + 1);
+                    std::vector<ContactId> ids;
+                    book.query("last:Petr*", &ids);
+                    PageRequest request;
+                    Page page;
+                    book.page(request, &page);
+                    ++ops;
+                }
+            });
+        }
+        runFor(seconds, std::move(workers));
+
+        std::size_t problems = 0;
+        std::string previous;
+        for (ContactId id : book.sorted_ids(SortKey::Email)) {
+            Contact c;
+            if (!book.get_contact(id, &c)) {
+                ++problems;
+                continue;
+            }
+            if (c.email == previous || book.find_email(c.email) != id) ++problems;
+            previous = c.email;
+        }
+        CHECK(problems == 0);
+        std::printf("sharded:   %ld ops, %zu contacts\n", ops.load(), book.size());
+    }
+    for (std::size_t s = 0; s < shards; ++s) removeFile(file + "." + std::to_string(s));
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 1.0;
+    sharedPhase(seconds);
+    versionedPhase(seconds);
+    shardedPhase(seconds);
+    return checkResult();
+}
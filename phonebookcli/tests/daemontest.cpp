@@ -0,0 +1,186 @@
+// The daemon (Daemon.h), served from a thread on a socket in the build
+// directory: pipelined requests are answered in order, as runCommand()
+// answers them; an oversized frame closes the connection; a second
+// daemon on the socket is refused; SIGTERM saves the book.
+
+#include "Check.h"
+#include "Commands.h"
+#include "Daemon.h"
+#include "PhoneBook.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+const char* const kSocket = "daemontest.sock";
+const char* const kFile = "daemontest.db";
+const char* const kExpectedFile = "daemontest.expected.db";
+
+int connectTo(const char* path) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, path);
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) return fd;
+    if (fd >= 0) close(fd);
+    return -1;
+}
+
+bool waitForDaemon() {
+    for (int i = 0; i < 500; ++i) {
+        const int fd = connectTo(kSocket);
+        if (fd >= 0) {
+            close(fd);
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+std::string frame(std::uint32_t length, const std::string& payload) {
+    std::string out(4, '\0');
+    for (int i = 0; i < 4; ++i) out[i] = static_cast<char>((length >> (8 * i)) & 0xFF);
+    return out + payload;
+}
+
+// A script of creates, reads, edits, deletes and queries, one error in it.
+std::string script() {
+    std::string text;
+    for (int i = 0; i < 300; ++i) {
+        const std::string n = std::to_string(i);
+        text += "create first=Anna last=Petrova" + n.substr(0, 1) + " work=+7998" + std::to_string(1000000 + i) +
+                " email=u" + n + "@mail addr=\"Lenina " + n + "\"\n";
+    }
+    text += "# a comment, not sent\n\n";
+    for (int i = 1; i <= 300; i += 7) text += "get " + std::to_string(i) + "\n";
+    for (int i = 2; i <= 300; i += 11) text += "edit " + std::to_string(i) + " home=+79161234567\n";
+    for (int i = 3; i <= 300; i += 13) text += "delete " + std::to_string(i) + "\n";
+    text += "get 3\n";
+    text += "search last:Petrova1 home:+79161234567\n";
+    text += "list last desc limit 25\n";
+    text += "list email\n";
+    return text;
+}
+
+void pipelinedInOrder() {
+    const std::string text = script();
+    std::istringstream in(text);
+    std::ostringstream out;
+    std::string error;
+    // `get 3` asks for a deleted contact: an error, after which the rest
+    // is still answered.
+    CHECK(!runClient(kSocket, in, out, &error));
+    CHECK(error.empty());
+
+    PhoneBook expected(kExpectedFile);
+    expected.set_autosave(false);
+    std::istringstream again(text);
+    std::ostringstream wanted;
+    CHECK(!runScript(expected, again, wanted));
+    CHECK(out.str() == wanted.str());
+    CHECK(out.str().find("error No contact with id 3.") != std::string::npos);
+    CHECK(expected.save_to_file());
+}
+
+void oversizedFrameCloses() {
+    const int fd = connectTo(kSocket);
+    CHECK(fd >= 0);
+    if (fd < 0) return;
+    timeval timeout{ 10, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    // One request, then a header announcing more than the daemon takes.
+    const std::string requests = frame(5, "get 1") + frame((1u << 20) + 1, "x");
+    CHECK(write(fd, requests.data(), requests.size()) == static_cast<ssize_t>(requests.size()));
+
+    std::string received;
+    char chunk[4096];
+    ssize_t n;
+    while ((n = read(fd, chunk, sizeof chunk)) > 0) received.append(chunk, static_cast<std::size_t>(n));
+    CHECK(n == 0);   // closed, not timed out
+    close(fd);
+
+    PhoneBook book(kExpectedFile);
+    book.set_autosave(false);
+    std::string answer;
+    CHECK(runCommand(book, "get 1", &answer));
+    CHECK(received == frame(static_cast<std::uint32_t>(answer.size()), answer));
+}
+
+void secondDaemonRefused() {
+    DaemonOptions options;
+    options.socketPath = kSocket;
+    options.dbFile = kFile;
+    std::string error;
+    CHECK(!runDaemon(options, &error));
+    CHECK(error.find("already listening") != std::string::npos);
+    // The running daemon still answers.
+    std::istringstream in("get 1\n");
+    std::ostringstream out;
+    CHECK(runClient(kSocket, in, out));
+}
+
+} // namespace
+
+int main()
+{
+    std::remove(kFile);
+    std::remove(kExpectedFile);
+
+    // Blocked before the daemon thread starts, so every thread blocks
+    // them and SIGTERM reaches the daemon's signalfd.
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
+    DaemonOptions options;
+    options.socketPath = kSocket;
+    options.dbFile = kFile;
+    options.flushMs = 60 * 60 * 1000;   // only SIGTERM saves
+    bool served = false;
+    std::string error;
+    std::thread daemon([&] { served = runDaemon(options, &error); });
+
+    CHECK(waitForDaemon());
+    pipelinedInOrder();
+    oversizedFrameCloses();
+    secondDaemonRefused();
+
+    // Nothing saved yet; SIGTERM saves the book and stops the daemon.
+    {
+        PhoneBook unsaved(kFile);
+        unsaved.set_autosave(false);
+        CHECK(unsaved.mainStorage.empty());
+    }
+    kill(getpid(), SIGTERM);
+    daemon.join();
+    CHECK(served && error.empty());
+    CHECK(connectTo(kSocket) < 0);
+
+    PhoneBook saved(kFile);
+    PhoneBook expected(kExpectedFile);
+    saved.set_autosave(false);
+    expected.set_autosave(false);
+    std::string a, b;
+    CHECK(runCommand(saved, "list", &a) && runCommand(expected, "list", &b));
+    CHECK(a == b && saved.mainStorage.size() == expected.mainStorage.size() && !a.empty());
+
+    std::remove(kFile);
+    std::remove(kExpectedFile);
+    return checkResult();
+}
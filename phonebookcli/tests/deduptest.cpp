@@ -0,0 +1,172 @@
+// Duplicate detection (Dedup.h): known duplicate and non-duplicate pairs
+// score on the right side of the threshold, findDuplicates() clusters the
+// duplicates of a book, and apply_merges() applies what it found - but
+// not a proposal whose contacts changed since the scan or whose merged
+// contact is no longer valid.
+
+#include "Check.h"
+#include "Dedup.h"
+#include "PhoneBook.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+const double kThreshold = DedupOptions().threshold;
+
+Contact person(const std::string& first, const std::string& last, const std::string& work,
+               const std::string& email, const std::string& birthday = "") {
+    return Contact(first, "", last, Phone(work), email, "", birthday);
+}
+
+void knownPairs() {
+    // The same person: a typo in the name, one number or email shared.
+    const Contact ivan = person("Aleksandr", "Ivanov", "+79161234567", "ivanov@mail");
+    const Contact typo = person("Aleksander", "Ivanov", "+79161234567", "alex@mail");
+    const Contact sameEmail = person("Alexandr", "Ivanov", "+79160000000", "ivanov@mail");
+    const Contact respelled = person("aleksandr", "IVANOV", "8(916)123-45-67", "other@mail");
+    CHECK(contactSimilarity(ivan, typo) >= kThreshold);
+    CHECK(contactSimilarity(ivan, sameEmail) >= kThreshold);
+    CHECK(contactSimilarity(ivan, respelled) >= kThreshold);
+    CHECK(contactSimilarity(typo, ivan) == contactSimilarity(ivan, typo));
+
+    // Different people: a shared surname, a shared office line, the same
+    // name alone, the same name and number with another birthday.
+    const Contact olga = person("Olga", "Ivanova", "+79169999999", "olga@mail");
+    const Contact colleague = person("Petr", "Sidorov", "+79161234567", "petr@mail");
+    const Contact namesake = person("Aleksandr", "Ivanov", "+79165555555", "namesake@mail");
+    const Contact father = person("Aleksandr", "Ivanov", "+79161234567", "father@mail", "01-02-1960");
+    const Contact son = person("Aleksandr", "Ivanov", "+79161234567", "son@mail", "03-04-1990");
+    CHECK(contactSimilarity(ivan, olga) < kThreshold);
+    CHECK(contactSimilarity(ivan, colleague) < kThreshold);
+    CHECK(contactSimilarity(ivan, namesake) < kThreshold);
+    CHECK(contactSimilarity(father, son) < kThreshold);
+}
+
+void mergeFillsBlanks() {
+    Contact keep = person("Aleksandr", "Ivanov", "+79161234567", "ivanov@mail");
+    Contact other = person("Aleksander", "Ivanov", "+79161234567", "alex@mail", "01-02-1980");
+    other.middleName = "Petrovich";
+    other.address = "Lenina 1";
+    other.numbers.number2 = "+79162222222";
+    other.numbers.number3 = "+79163333333";
+    Contact third = person("Aleksandr", "Ivanov", "8(916)123-45-67", "third@mail");
+    third.numbers.number2 = "+79164444444";
+
+    std::vector<std::string> dropped;
+    const Contact merged = mergeContacts({ keep, other, third }, &dropped);
+    CHECK(merged.firstName == "Aleksandr" && merged.email == "ivanov@mail");
+    CHECK(merged.middleName == "Petrovich" && merged.address == "Lenina 1" && merged.birthday == "01-02-1980");
+    CHECK(merged.numbers.number1 == "+79161234567");
+    CHECK(merged.numbers.number2 == "+79162222222" && merged.numbers.number3 == "+79163333333");
+    // The respelled work number is the same number; the fourth is dropped.
+    CHECK(dropped == std::vector<std::string>{ "+79164444444" });
+}
+
+// A book with two clusters of duplicates among unrelated contacts.
+void buildBook(PhoneBook& book) {
+    CHECK(book.add_contact(person("Aleksandr", "Ivanov", "+79161234567", "ivanov@mail")));          // 1
+    CHECK(book.add_contact(person("Olga", "Ivanova", "+79169999999", "olga@mail")));                // 2
+    CHECK(book.add_contact(person("Aleksander", "Ivanov", "8(916)123-45-67", "alex@mail")));        // 3
+    CHECK(book.add_contact(person("Maria", "Smirnova", "+79031112233", "maria@mail", "05-06-1985")));  // 4
+    CHECK(book.add_contact(person("Petr", "Sidorov", "+79161234567", "petr@mail")));                // 5
+    Contact maria = person("Mariya", "Smirnova", "+79031112233", "masha@mail");
+    maria.address = "Tverskaya 7";
+    CHECK(book.add_contact(maria));                                                              // 6
+    CHECK(book.add_contact(person("Aleksandr", "Ivanov", "+79161234567", "sasha@mail")));           // 7
+}
+
+void findAndApply() {
+    PhoneBook book("deduptest.db");
+    book.set_autosave(false);
+    buildBook(book);
+
+    const std::vector<MergeProposal> proposals = findDuplicates(book);
+    CHECK(proposals.size() == 2);
+    if (proposals.size() != 2) return;
+    CHECK(proposals[0].keepId == 1 && proposals[0].duplicateIds == (std::vector<ContactId>{ 3, 7 }));
+    CHECK(proposals[1].keepId == 4 && proposals[1].duplicateIds == (std::vector<ContactId>{ 6 }));
+    CHECK(proposals[1].merged.address == "Tverskaya 7" && proposals[1].merged.birthday == "05-06-1985");
+    for (const MergeProposal& p : proposals) CHECK(p.score >= kThreshold && p.before.size() == 1 + p.duplicateIds.size());
+
+    CHECK(book.apply_merges(proposals) == 2);
+    CHECK(book.mainStorage.size() == 4);
+    for (ContactId gone : { 3, 6, 7 }) CHECK(!book.find_contact(gone, nullptr));
+    for (const MergeProposal& p : proposals) {
+        Contact kept;
+        CHECK(book.get_contact(p.keepId, &kept) && ContactView(kept).same_fields(p.merged));
+    }
+    CHECK(book.email_in_use("maria@mail") && !book.email_in_use("masha@mail") && !book.email_in_use("sasha@mail"));
+    CHECK(findDuplicates(book).empty());
+    // Applied once: the contacts are gone, so a second run changes nothing.
+    CHECK(book.apply_merges(proposals) == 0);
+    CHECK(book.mainStorage.size() == 4);
+}
+
+// Proposals are applied later than they are found: one whose contacts
+// were edited or removed since, or whose merged contact the book would
+// now refuse, is skipped and the rest applied.
+void staleProposalsSkipped() {
+    PhoneBook book("deduptest.db");
+    book.set_autosave(false);
+    buildBook(book);
+    std::vector<MergeProposal> proposals = findDuplicates(book);
+    CHECK(proposals.size() == 2);
+    if (proposals.size() != 2) return;
+
+    // A duplicate edited after the scan.
+    Contact edited;
+    CHECK(book.get_contact(7, &edited));
+    edited.address = "Arbat 3";
+    CHECK(book.update_contact(7, edited));
+    CHECK(book.apply_merges(proposals) == 1);
+    CHECK(book.find_contact(1, nullptr) && book.find_contact(3, nullptr) && book.find_contact(7, nullptr));
+    CHECK(!book.find_contact(6, nullptr));
+
+    // The keeper edited, and a removed duplicate.
+    PhoneBook other("deduptest.db");
+    other.set_autosave(false);
+    buildBook(other);
+    proposals = findDuplicates(other);
+    CHECK(proposals.size() == 2);
+    if (proposals.size() != 2) return;
+    Contact keeper;
+    CHECK(other.get_contact(1, &keeper));
+    keeper.numbers.number2 = "+79168888888";
+    CHECK(other.update_contact(1, keeper));
+    CHECK(other.remove_contact(6));
+    CHECK(other.apply_merges(proposals) == 0);
+    CHECK(other.mainStorage.size() == 6);
+
+    // A merged contact that is not valid, or whose email a contact outside
+    // the cluster took since.
+    PhoneBook third("deduptest.db");
+    third.set_autosave(false);
+    buildBook(third);
+    proposals = findDuplicates(third);
+    CHECK(proposals.size() == 2);
+    if (proposals.size() != 2) return;
+    proposals[0].merged.numbers.number1 = "12345";
+    proposals[1].merged.email = "olga@mail";
+    CHECK(third.apply_merges(proposals) == 0);
+    CHECK(third.mainStorage.size() == 7);
+    // An email of the cluster itself is fine.
+    proposals[1].merged.email = "masha@mail";
+    CHECK(third.apply_merges(proposals) == 1);
+    CHECK(third.email_in_use("masha@mail") && !third.email_in_use("maria@mail"));
+}
+
+} // namespace
+
+int main()
+{
+    std::remove("deduptest.db");
+    knownPairs();
+    mergeFillsBlanks();
+    findAndApply();
+    staleProposalsSkipped();
+    std::remove("deduptest.db");
+    return checkResult();
+}
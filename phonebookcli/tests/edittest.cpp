@@ -0,0 +1,103 @@
+// The interactive edit menu, driven through std::cin: a new email or
+// phone typed in is seen by the duplicate checks, also when putting it
+// into a full Bloom filter rebuilds the filter from the book. Phones are
+// found in any spelling after every kind of change.
+
+#include "Check.h"
+#include "PhoneBook.h"
+
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+Contact makeContact(unsigned k) {
+    char phone[32];
+    std::snprintf(phone, sizeof phone, "+7998%07u", k);
+    return Contact("Anna", "", "Petrova", Phone(phone), "u" + std::to_string(k) + "@mail", "", "");
+}
+
+// Runs edit_contact() on `input`, with its prompts discarded.
+void editWith(PhoneBook& book, const std::string& input) {
+    std::istringstream in(input);
+    std::ostringstream out;
+    std::streambuf* oldIn = std::cin.rdbuf(in.rdbuf());
+    std::streambuf* oldOut = std::cout.rdbuf(out.rdbuf());
+    book.edit_contact();
+    std::cin.rdbuf(oldIn);
+    std::cout.rdbuf(oldOut);
+}
+
+void editAtSaturation() {
+    PhoneBook book("edittest.db");
+    book.set_autosave(false);
+    // An empty book's filters are sized for 1024 keys (BloomFilter::kMinKeys):
+    // the edit's new email and phone each rebuild one.
+    for (unsigned k = 0; book.mainStorage.size() < 1024; ++k) CHECK(book.add_contact(makeContact(k)));
+
+    // Find by email (6), then change the email (4) and work phone (5).
+    editWith(book, "6\nu0@mail\n4\nedited@mail\n5\n+79990000000\n0\n");
+
+    Contact c;
+    CHECK(book.get_contact(1, &c) && c.email == "edited@mail" && c.numbers.number1 == "+79990000000");
+    CHECK(book.email_in_use("edited@mail"));
+    CHECK(book.phone_in_use("+79990000000"));
+    CHECK(!book.email_in_use("u0@mail"));
+    CHECK(!book.add_contact(Contact("Ivan", "", "Petrov", Phone("+79990000001"), "edited@mail", "", "")));
+
+    // Other spellings of the new number, none of the old one.
+    CHECK(book.phone_in_use("8(999)000-00-00"));
+    CHECK(!book.phone_in_use("8(999)000-00-00", 1));
+    CHECK(!book.phone_in_use("+79980000000") && !book.phone_in_use("8(998)000-00-00"));
+}
+
+void phoneSpellings() {
+    PhoneBook book("edittest.db");
+    book.set_autosave(false);
+    book.set_undo_budget(1 << 20);
+    Contact c = makeContact(1);
+    c.numbers.number2 = "8(916)555-00-00";
+    ContactId first = 0;
+    CHECK(book.add_contact(c, nullptr, &first));
+    // A second contact on the same line, spelled differently.
+    Contact colleague = makeContact(2);
+    colleague.numbers.number3 = "+79165550000";
+    ContactId second = 0;
+    CHECK(book.add_contact(colleague, nullptr, &second));
+
+    CHECK(book.phone_in_use("+79165550000", first) && book.phone_in_use("8(916)555-00-00", second));
+    CHECK(book.phone_in_use("8(998)000-00-01") && !book.phone_in_use("8(998)000-00-01", first));
+
+    // Dropped from one contact, still listed by the other.
+    c.numbers.number2.clear();
+    CHECK(book.update_contact(first, c));
+    CHECK(!book.phone_in_use("+79165550000", second) && book.phone_in_use("+79165550000", first));
+    CHECK(book.remove_contact(second));
+    CHECK(!book.phone_in_use("8(916)555-00-00"));
+    CHECK(book.undo());
+    CHECK(book.phone_in_use("8(916)555-00-00", first));
+
+    // The same number twice in one contact: clearing one slot keeps it.
+    c.numbers.number3 = "8(998)000-00-01";
+    CHECK(book.update_contact(first, c));
+    c.numbers.number1 = "+79980000009";
+    CHECK(book.update_contact(first, c));
+    CHECK(book.phone_in_use("+79980000001") && !book.phone_in_use("8(998)000-00-01", first));
+    CHECK(book.phone_in_use("+79980000009"));
+    // Undone field by field.
+    CHECK(book.undo());
+    CHECK(!book.phone_in_use("8(998)000-00-09") && book.phone_in_use("8(998)000-00-01", second));
+}
+
+} // namespace
+
+int main()
+{
+    editAtSaturation();
+    std::remove("edittest.db");
+    phoneSpellings();
+    std::remove("edittest.db");
+    return checkResult();
+}
@@ -0,0 +1,162 @@
+// FrozenPhoneBook round trip: a book is frozen, saved, mapped again, and
+// every lookup of the image must answer as the live book does - every
+// contact by email and by each phone in two spellings, and keys the book
+// does not hold. The lookup commands of `phonebook lookup` are checked
+// on the same image.
+
+#include "Check.h"
+#include "Checkers.h"
+#include "Commands.h"
+#include "FrozenPhoneBook.h"
+#include "PhoneBook.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* const kImage = "frozentest.img";
+
+bool sameContact(const FrozenContact& frozen, ContactId id, const ContactView& live) {
+    return frozen.id == id && frozen.firstName == live.firstName && frozen.middleName == live.middleName &&
+           frozen.lastName == live.lastName && frozen.work == live.numbers.number1 &&
+           frozen.home == live.numbers.number2 && frozen.office == live.numbers.number3 &&
+           frozen.email == live.email && frozen.address == live.address && frozen.birthday == live.birthday;
+}
+
+std::vector<ContactId> ids(const std::vector<FrozenContact>& contacts) {
+    std::vector<ContactId> out;
+    for (const FrozenContact& c : contacts) out.push_back(c.id);
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+// Ids of the live contacts with a phone that is the same number as `phone`.
+std::vector<ContactId> liveByPhone(const PhoneBook& book, const std::string& phone) {
+    std::string key = normalizePhone(phone);
+    if (key.empty()) key = phone;
+    std::vector<ContactId> out;
+    for (const auto& entry : book.mainStorage) {
+        const ContactView c = entry.second;
+        for (std::string_view p : { c.numbers.number1, c.numbers.number2, c.numbers.number3 }) {
+            std::string other = normalizePhone(p);
+            if (other.empty()) other = std::string(p);
+            if (!p.empty() && other == key) {
+                out.push_back(entry.first);
+                break;
+            }
+        }
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+// "+7999..." as "8(999)...".
+std::string respell(const std::string& phone) {
+    if (phone.size() != 12 || phone.compare(0, 2, "+7") != 0) return phone;
+    return "8(" + phone.substr(2, 3) + ")" + phone.substr(5);
+}
+
+void buildBook(PhoneBook& book) {
+    std::mt19937 rng(28);
+    for (int i = 0; i < 600; ++i) {
+        Contact c;
+        c.firstName = i % 3 ? "Anna" : "Ivan";
+        c.lastName = "Petrov" + std::string(1, static_cast<char>('a' + i % 26));
+        if (i % 4 == 0) c.middleName = "Sergeevich";
+        c.numbers.number1 = "+7999" + std::to_string(1000000 + i);
+        // Shared office lines, and some contacts listing a number twice.
+        if (i % 2) c.numbers.number2 = "8(916)" + std::to_string(2000000 + rng() % 50);
+        if (i % 5 == 0) c.numbers.number3 = i % 10 ? "+74950000001" : c.numbers.number1;
+        c.email = "user" + std::to_string(i) + "@mail" + std::to_string(i % 7);
+        if (i % 3 == 0) c.address = "Lenina " + std::to_string(i % 40);
+        if (i % 6 == 0) c.birthday = "0" + std::to_string(1 + i % 9) + "-05-1990";
+        CHECK(book.add_contact(std::move(c)));
+    }
+    // Gaps in the ids.
+    for (ContactId id = 10; id < 600; id += 37) CHECK(book.remove_contact(id));
+}
+
+void checkImage(const PhoneBook& book, const FrozenPhoneBook& frozen) {
+    CHECK(frozen.is_open());
+    CHECK(frozen.size() == book.mainStorage.size());
+    CHECK(frozen.get_index() == book.get_index());
+
+    long mismatches = 0;
+    std::size_t position = 0;
+    std::vector<std::pair<ContactId, const ContactRecord*>> ordered;
+    for (const auto& entry : book.mainStorage) ordered.emplace_back(entry.first, &entry.second);
+    std::sort(ordered.begin(), ordered.end());
+
+    for (const auto& entry : ordered) {
+        const ContactView c = *entry.second;
+        if (!sameContact(frozen.contact_at(position++), entry.first, c)) ++mismatches;
+
+        FrozenContact hit;
+        if (!frozen.find_by_email(c.email, &hit) || !sameContact(hit, entry.first, c)) ++mismatches;
+        if (ids(frozen.find_all_by_email(c.email)) != std::vector<ContactId>{ entry.first }) ++mismatches;
+
+        for (std::string_view p : { c.numbers.number1, c.numbers.number2, c.numbers.number3 }) {
+            if (p.empty()) continue;
+            const std::string phone(p);
+            const std::vector<ContactId> expected = liveByPhone(book, phone);
+            if (ids(frozen.find_by_phone(phone)) != expected) ++mismatches;
+            if (ids(frozen.find_by_phone(respell(phone))) != expected) ++mismatches;
+        }
+    }
+
+    // Keys the book does not hold, removed contacts' included.
+    for (int i = 0; i < 2000; ++i) {
+        const std::string email = "absent" + std::to_string(i) + "@mail0";
+        if (frozen.find_by_email(email, nullptr) || !frozen.find_all_by_email(email).empty()) ++mismatches;
+        const std::string phone = "+7998" + std::to_string(1000000 + i);
+        if (!frozen.find_by_phone(phone).empty()) ++mismatches;
+    }
+    for (ContactId id = 10; id < 600; id += 37) {
+        const std::string email = "user" + std::to_string(id - 1) + "@mail" + std::to_string((id - 1) % 7);
+        if (frozen.find_by_email(email, nullptr)) ++mismatches;
+    }
+    if (mismatches) std::fprintf(stderr, "%ld lookups differ from the live book\n", mismatches);
+    CHECK(mismatches == 0);
+}
+
+void roundTrip() {
+    PhoneBook book("frozentest.db");
+    book.set_autosave(false);
+    buildBook(book);
+
+    const FrozenPhoneBook frozen = FrozenPhoneBook::freeze(book);
+    checkImage(book, frozen);
+    CHECK(frozen.save(kImage));
+
+    FrozenPhoneBook mapped;
+    CHECK(mapped.open(kImage));
+    checkImage(book, mapped);
+
+    // The commands of `phonebook lookup` answer as `get` does.
+    std::string out, expected;
+    CHECK(runCommand(book, "get 1", &expected));
+    CHECK(runFrozenCommand(mapped, "email user0@mail0", &out) && out == expected);
+    out.clear();
+    CHECK(runFrozenCommand(mapped, "phone\t8(999)100-00-00", &out) && out == expected);
+    out.clear();
+    CHECK(runFrozenCommand(mapped, "email nobody@mail", &out) && out == "ok 0\n");
+    out.clear();
+    CHECK(!runFrozenCommand(mapped, "get 1", &out) && out.compare(0, 6, "error ") == 0);
+
+    mapped.close();
+    CHECK(!mapped.is_open());
+    CHECK(!mapped.open("frozentest.missing"));
+}
+
+} // namespace
+
+int main()
+{
+    roundTrip();
+    std::remove(kImage);
+    return checkResult();
+}
@@ -0,0 +1,190 @@
+// Query engine: the plan chosen must not change the answer. Every query
+// is answered three ways and all must agree:
+//   - runQuery(), driven by whichever index the planner picks;
+//   - a full scan through matchesPredicate();
+//   - for each contact, the query AND id:<id>, which the id drives, so
+//     every other predicate is checked on that one contact.
+// The book has contacts with no middle name, second or third phone,
+// address or birthday, which the ordered indexes leave out.
+
+#include "Check.h"
+#include "PhoneBook.h"
+#include "Query.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<ContactId> search(const PhoneBook& book, const std::string& text, QueryStats* stats = nullptr) {
+    Query query;
+    std::string error;
+    if (!parseQuery(text, &query, &error)) {
+        std::fprintf(stderr, "cannot parse '%s': %s\n", text.c_str(), error.c_str());
+        ++checkFailures();
+        return {};
+    }
+    return runQuery(book, query, stats);
+}
+
+std::vector<ContactId> scan(const PhoneBook& book, const std::string& text) {
+    Query query;
+    if (!parseQuery(text, &query)) return {};
+    std::vector<ContactId> ids;
+    for (const auto& entry : book.mainStorage) {
+        const ContactView contact = entry.second;
+        const bool any = std::any_of(query.anyOf.begin(), query.anyOf.end(), [&](const std::vector<QueryPredicate>& all) {
+            return std::all_of(all.begin(), all.end(), [&](const QueryPredicate& p) {
+                return matchesPredicate(contact, entry.first, p, query.caseSensitive);
+            });
+        });
+        if (any) ids.push_back(entry.first);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+bool planUses(const QueryStats& stats, const char* via) {
+    return !stats.plan.empty() && stats.plan[0].find(via) != std::string::npos;
+}
+
+void addContact(PhoneBook& book, Contact contact, ContactId* id = nullptr) {
+    std::string error;
+    if (!book.add_contact(std::move(contact), &error, id)) {
+        std::fprintf(stderr, "add_contact: %s\n", error.c_str());
+        ++checkFailures();
+    }
+}
+
+// An open range over birthdays: the birthday index has no entry for Ann,
+// and neither may a scan that Ann's name drives.
+void emptyFieldInRange() {
+    PhoneBook book("querytest_range.db");
+    book.set_autosave(false);
+    ContactId ann = 0, bob = 0, cid = 0, dan = 0;
+    addContact(book, Contact("Ann", "", "Abel", Phone("+79990000001"), "ann@mail", "", ""), &ann);
+    addContact(book, Contact("Bob", "", "Brown", Phone("+79990000002"), "bob@mail", "", "01-02-1960"), &bob);
+    addContact(book, Contact("Cid", "", "Clark", Phone("+79990000003"), "cid@mail", "", "03-04-1961"), &cid);
+    addContact(book, Contact("Dan", "", "Dunn", Phone("+79990000004"), "dan@mail", "", "05-06-1962"), &dan);
+
+    QueryStats byBirthday, byName;
+    CHECK((search(book, "born:..1970", &byBirthday) == std::vector<ContactId>{ bob, cid, dan }));
+    CHECK(planUses(byBirthday, "birthday index"));
+    CHECK(search(book, "born:..1970 first:Ann", &byName).empty());
+    CHECK(planUses(byName, "name index"));
+
+    CHECK((search(book, "born:1961..") == std::vector<ContactId>{ cid, dan }));
+    CHECK(search(book, "born:1961.. first:Ann").empty());
+    CHECK(search(book, "born:19* first:Ann").empty());
+    CHECK((search(book, "born:19* first:Bob") == std::vector<ContactId>{ bob }));
+}
+
+// Id ranges up to the largest id: the planner's range width must not
+// wrap, and bounds that are no id are refused rather than dropped.
+void idRangeBounds() {
+    PhoneBook book("querytest_ids.db");
+    book.set_autosave(false);
+    std::vector<ContactId> all;
+    for (int i = 0; i < 5; ++i) {
+        ContactId id = 0;
+        addContact(book, Contact("Ann", "", "Abel", Phone("+7999000001" + std::to_string(i)),
+                                 "ann" + std::to_string(i) + "@mail", "", ""), &id);
+        all.push_back(id);
+    }
+
+    CHECK(search(book, "id:1..18446744073709551615") == all);
+    CHECK(search(book, "id:..18446744073709551615") == all);
+    CHECK(search(book, "id:18446744073709551615..").empty());
+    CHECK((search(book, "id:..2") == std::vector<ContactId>{ 1, 2 }));
+    CHECK((search(book, "id:4..") == std::vector<ContactId>{ 4, 5 }));
+    CHECK(search(book, "id:3..2").empty());
+
+    Query query;
+    for (const char* text : { "id:0..99999999999999999999", "id:0..", "id:..18446744073709551616", "id:x..3" }) {
+        std::string error;
+        CHECK(!parseQuery(text, &query, &error) && error.find("Invalid id") == 0);
+    }
+}
+
+std::string digits(std::mt19937& rng, int n) {
+    std::string s;
+    for (int i = 0; i < n; ++i) s += static_cast<char>('0' + rng() % 10);
+    return s;
+}
+
+void plansAgree() {
+    PhoneBook book("querytest_random.db");
+    book.set_autosave(false);
+
+    static const char* const firstNames[] = { "Ivan", "Anna", "Olga", "Petr", "Maria" };
+    static const char* const lastNames[] = { "Ivanov", "Petrova", "Chikov", "Smith", "Orlov" };
+    static const char* const streets[] = { "Lenina", "Nevsky", "Sadovaya" };
+    static const char* const domains[] = { "mail", "gmail", "yandex" };
+
+    std::mt19937 rng(36);
+    const int count = 400;
+    for (int i = 0; i < count; ++i) {
+        Contact c;
+        c.firstName = firstNames[rng() % 5];
+        c.lastName = lastNames[rng() % 5];
+        if (rng() % 3 == 0) c.middleName = "M" + digits(rng, 1);
+        c.numbers.number1 = "+7999" + digits(rng, 7);
+        if (rng() % 2) c.numbers.number2 = "8(999)" + digits(rng, 7);
+        if (rng() % 4 == 0) c.numbers.number3 = "+7495" + digits(rng, 7);
+        c.email = "u" + std::to_string(i) + "@" + domains[rng() % 3];
+        if (rng() % 2) c.address = std::string(streets[rng() % 3]) + " " + std::to_string(1 + rng() % 20);
+        if (rng() % 3) {
+            c.birthday = std::to_string(10 + rng() % 18) + "-0" + std::to_string(1 + rng() % 9) + "-" +
+                         std::to_string(1950 + rng() % 60);
+        }
+        addContact(book, std::move(c));
+    }
+
+    // Every predicate kind, with open and closed ranges, alone and under
+    // a name that would drive instead.
+    const std::vector<std::string> predicates = {
+        "born:..1970", "born:1980..", "born:1960..1975", "born:19*", "born:*-1955",
+        "middle:..M5", "middle:M3..", "middle:M*",
+        "work:*12", "home:*3", "office:+7*", "phone:*5", "home:..+79995", "office:+7495..",
+        "addr:..M", "addr:N..", "addr:lenina", "email:*@mail", "domain:gmail",
+        "last:C..P", "last:..Iv", "first:O*",
+    };
+    const std::vector<std::string> drivers = { "", " first:Anna", " last:Smith", " domain:mail" };
+
+    long queries = 0;
+    for (const std::string& predicate : predicates) {
+        for (const std::string& driver : drivers) {
+            const std::string text = predicate + driver;
+            const std::vector<ContactId> planned = search(book, text);
+            const std::vector<ContactId> scanned = scan(book, text);
+            if (planned != scanned) {
+                std::fprintf(stderr, "'%s': planned %zu, scanned %zu\n", text.c_str(), planned.size(), scanned.size());
+                ++checkFailures();
+            }
+            for (ContactId id = 1; id <= static_cast<ContactId>(count); ++id) {
+                const bool expected = std::binary_search(planned.begin(), planned.end(), id);
+                const bool byId = !search(book, text + " id:" + std::to_string(id)).empty();
+                if (expected != byId) {
+                    std::fprintf(stderr, "'%s': id %llu %s when driven by id\n", text.c_str(),
+                                 static_cast<unsigned long long>(id), byId ? "matches only" : "misses only");
+                    ++checkFailures();
+                }
+            }
+            queries += 2 + count;
+        }
+    }
+    std::printf("%ld queries\n", queries);
+}
+
+} // namespace
+
+int main()
+{
+    emptyFieldInRange();
+    idRangeBounds();
+    plansAgree();
+    return checkResult();
+}
@@ -0,0 +1,265 @@
+// ShardedPhoneBook: reopening with another shard count moves contacts to
+// their new shards and loses none, also contacts the current rules would
+// reject and copies left behind by an interrupted move. add_contacts()
+// stores exactly the contacts of a batch that validateContact() passes.
+// page() and sorted_ids() order the shards' contacts as one book would.
+
+#include "Check.h"
+#include "Checkers.h"
+#include "ShardedPhoneBook.h"
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+const std::string kFile = "shardtest.db";
+
+std::string shardFile(std::size_t i) {
+    return kFile + "." + std::to_string(i);
+}
+
+void removeFiles() {
+    for (std::size_t i = 0; i < 16; ++i) {
+        std::remove(shardFile(i).c_str());
+        std::remove((shardFile(i) + ".tmp").c_str());
+    }
+}
+
+bool exists(const std::string& file) {
+    return std::ifstream(file).good();
+}
+
+Contact makeContact(unsigned k) {
+    char phone[32];
+    std::snprintf(phone, sizeof phone, "+7998%07u", k);
+    return Contact("Anna", "", "Petrova", Phone(phone), "u" + std::to_string(k) + "@mail",
+                   "Lenina " + std::to_string(k % 30), "");
+}
+
+bool sameContact(const Contact& a, const Contact& b) {
+    for (std::size_t f = 0; f < kContactFieldCount; ++f) {
+        if (contactField(a, static_cast<ContactField>(f)) != contactField(b, static_cast<ContactField>(f))) return false;
+    }
+    return true;
+}
+
+// Whether a book opened on the files with `shards` shards holds exactly `expected`.
+void checkBook(std::size_t shards, const std::map<ContactId, Contact>& expected) {
+    ShardedPhoneBook book(kFile, shards);
+    CHECK(book.size() == expected.size());
+    for (const auto& pair : expected) {
+        Contact c;
+        if (!book.get_contact(pair.first, &c) || !sameContact(c, pair.second)) {
+            std::fprintf(stderr, "%zu shards: contact %llu lost or changed\n", shards,
+                         static_cast<unsigned long long>(pair.first));
+            ++checkFailures();
+        }
+        CHECK(book.find_email(pair.second.email) == pair.first);
+    }
+}
+
+void reshardKeepsContacts() {
+    removeFiles();
+    std::map<ContactId, Contact> expected;
+    {
+        // One shard: every contact in file .0, with some the phone rules
+        // reject (as after a change to phone_formats.txt); a file is
+        // loaded as written.
+        PhoneBook single(shardFile(0));
+        single.set_autosave(false);
+        for (unsigned k = 0; k < 300; ++k) {
+            ContactId id = 0;
+            CHECK(single.add_contact(makeContact(k), nullptr, &id));
+            expected[id] = makeContact(k);
+        }
+        for (unsigned k = 300; k < 310; ++k) {
+            Contact odd = makeContact(k);
+            odd.numbers.number1 = "12-34-" + std::to_string(k);
+            const ContactId id = single.get_index() + 1;
+            CHECK(single.adopt_contact(id, odd));
+            expected[id] = odd;
+        }
+        CHECK(single.save_to_file());
+    }
+
+    for (std::size_t shards : { 4, 7, 2, 5, 1 }) {
+        checkBook(shards, expected);
+        CHECK(!exists(shardFile(shards)));
+    }
+
+    // An interrupted move: every contact of .0 also sits in .1.
+    {
+        ShardedPhoneBook book(kFile, 2);
+    }
+    {
+        PhoneBook first(shardFile(0));
+        PhoneBook second(shardFile(1));
+        first.set_autosave(false);
+        second.set_autosave(false);
+        std::size_t copied = 0;
+        for (const auto& pair : first.mainStorage) copied += second.adopt_contact(pair.first, pair.second);
+        CHECK(copied > 0 && copied == first.mainStorage.size());
+        CHECK(second.save_to_file());
+    }
+    checkBook(2, expected);
+    CHECK(PhoneBook(shardFile(0)).mainStorage.size() + PhoneBook(shardFile(1)).mainStorage.size() == expected.size());
+}
+
+// A contact whose id or email is taken in its new shard cannot move: it
+// stays in its old file instead of being dropped.
+void blockedMoveKeepsContact() {
+    removeFiles();
+    std::map<ContactId, Contact> expected;
+    {
+        ShardedPhoneBook book(kFile, 2);
+        for (unsigned k = 0; k < 100; ++k) {
+            ContactId id = 0;
+            CHECK(book.add_contact(makeContact(k), nullptr, &id));
+            expected[id] = makeContact(k);
+        }
+    }
+
+    // A third file, as left by a book of three shards, with a contact
+    // under an id the book already uses and one with a taken email.
+    const ContactId taken = expected.rbegin()->first;
+    const Contact kept = expected.rbegin()->second;
+    Contact clash = makeContact(1000);
+    Contact sameEmail = makeContact(1001);
+    sameEmail.email = expected.begin()->second.email;
+    {
+        PhoneBook extra(shardFile(2));
+        extra.set_autosave(false);
+        CHECK(extra.adopt_contact(taken, clash));
+        CHECK(extra.adopt_contact(5000, sameEmail));
+        CHECK(extra.adopt_contact(5001, makeContact(1002)));
+        CHECK(extra.save_to_file());
+    }
+    expected[5001] = makeContact(1002);
+
+    {
+        ShardedPhoneBook book(kFile, 2);
+        Contact c;
+        CHECK(book.get_contact(5001, &c) && sameContact(c, makeContact(1002)));
+        CHECK(!book.get_contact(5000, nullptr));
+        CHECK(book.get_contact(taken, &c) && sameContact(c, kept));
+    }
+    CHECK(exists(shardFile(2)));
+    PhoneBook left(shardFile(2));
+    left.set_autosave(false);
+    CHECK(left.mainStorage.size() == 2);
+    Contact c;
+    CHECK(left.get_contact(5000, &c) && sameContact(c, sameEmail));
+    CHECK(left.get_contact(taken, &c) && sameContact(c, clash));
+}
+
+// A batch is validated as a whole; what validateContact() rejects gets
+// no id, the rest are stored as given.
+void addContactsValidates() {
+    removeFiles();
+    ShardedPhoneBook book(kFile, 3);
+    std::vector<Contact> batch;
+    for (unsigned k = 0; k < 500; ++k) {
+        Contact c = makeContact(k);
+        if (k % 7 == 0) c.numbers.number1 = "12345";
+        if (k % 11 == 0) c.firstName = "9lives";
+        // The previous contact's email: the shards race for it.
+        if (k % 13 == 1) c.email = makeContact(k - 1).email;
+        batch.push_back(c);
+    }
+    std::vector<ContactId> ids;
+    const std::size_t added = book.add_contacts(batch, &ids);
+    CHECK(ids.size() == batch.size());
+    CHECK(added == book.size());
+
+    std::size_t expected = 0;
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        const bool valid = validateContact(batch[i]) == 0;
+        const bool paired = i % 13 == 1 || i % 13 == 0;
+        Contact c;
+        if (!valid) CHECK(ids[i] == 0);
+        else if (!paired) CHECK(ids[i] != 0);
+        if (ids[i]) CHECK(book.get_contact(ids[i], &c) && sameContact(c, batch[i]));
+        expected += valid;
+        // Of two valid contacts sharing an email, exactly one is stored.
+        if (i % 13 == 1 && valid && validateContact(batch[i - 1]) == 0) {
+            CHECK((ids[i] != 0) != (ids[i - 1] != 0));
+            --expected;
+        }
+        else if (i % 13 == 1 && valid) {
+            CHECK(ids[i] != 0);
+        }
+    }
+    CHECK(added == expected);
+}
+
+// Names that tie across shards, in mixed case, so the merge of the
+// shards' orderings is decided by the id.
+void pagingMatchesOneBook() {
+    removeFiles();
+    ShardedPhoneBook sharded(kFile, 4);
+    PhoneBook single("shardtest.single.db");
+    single.set_autosave(false);
+    const char* const firsts[] = { "Anna", "anna", "Ivan", "Olga", "Boris" };
+    const char* const lasts[] = { "Petrova", "Smith", "SMITH", "Ivanova" };
+    for (unsigned k = 0; k < 400; ++k) {
+        Contact c = makeContact(k);
+        c.firstName = firsts[k % 5];
+        c.lastName = lasts[k * 7 % 4];
+        c.email = "u" + std::to_string(k * 113 % 400) + "@mail" + std::to_string(k % 3);
+        ContactId id = 0;
+        CHECK(sharded.add_contact(c, nullptr, &id));
+        CHECK(single.adopt_contact(id, c));
+    }
+    for (ContactId id = 3; id <= 400; id += 17) {
+        CHECK(sharded.remove_contact(id));
+        CHECK(single.remove_contact(id));
+    }
+
+    for (SortKey key : { SortKey::Id, SortKey::FirstName, SortKey::LastName, SortKey::Email }) {
+        for (bool descending : { false, true }) {
+            const std::vector<ContactId> whole = single.sorted_ids(key, descending);
+            CHECK(whole.size() == single.mainStorage.size());
+            CHECK(sharded.sorted_ids(key, descending) == whole);
+
+            for (std::size_t pageSize : { 1, 7, 50, 1000 }) {
+                PageRequest request;
+                request.key = key;
+                request.descending = descending;
+                request.pageSize = pageSize;
+                std::vector<ContactId> walked;
+                std::size_t pages = 0;
+                bool same = true;
+                for (;;) {
+                    Page fromShards, fromOne;
+                    CHECK(sharded.page(request, &fromShards) && single.page(request, &fromOne));
+                    same = same && fromShards.ids == fromOne.ids && fromShards.nextCursor == fromOne.nextCursor;
+                    walked.insert(walked.end(), fromShards.ids.begin(), fromShards.ids.end());
+                    if (fromShards.nextCursor.empty() || ++pages > whole.size()) break;
+                    request.cursor = fromShards.nextCursor;
+                }
+                if (!same || walked != whole) {
+                    std::fprintf(stderr, "key %d%s, pages of %zu: the shards page differently\n",
+                                 static_cast<int>(key), descending ? " desc" : "", pageSize);
+                    ++checkFailures();
+                }
+            }
+        }
+    }
+    std::remove("shardtest.single.db");
+}
+
+} // namespace
+
+int main()
+{
+    reshardKeepsContacts();
+    blockedMoveKeepsContact();
+    addContactsValidates();
+    pagingMatchesOneBook();
+    removeFiles();
+    return checkResult();
+}
@@ -0,0 +1,88 @@
+// SlotMap (IdAllocator.h): erasing while iterating visits every other
+// contact once and ends at end(), also when the erase drops trailing
+// free slots; slots are reused lowest first.
+
+#include "Check.h"
+#include "IdAllocator.h"
+
+#include <map>
+#include <string>
+
+namespace {
+
+using Map = SlotMap<std::string>;
+
+std::map<ContactId, std::string> contents(const Map& map) {
+    std::map<ContactId, std::string> out;
+    for (const auto& pair : map) out.emplace(pair.first, pair.second);
+    return out;
+}
+
+// Erasing the last live slot, with free slots below it, drops them all:
+// the iterator returned is end(), not a slot past it.
+void eraseLastSlot() {
+    Map map;
+    for (ContactId id = 1; id <= 6; ++id) map[id] = "v" + std::to_string(id);
+    CHECK(map.erase(4) == 1 && map.erase(5) == 1);
+    CHECK(map.slot_count() == 6);
+
+    auto it = map.find(6);
+    CHECK(it != map.end());
+    it = map.erase(it);
+    CHECK(it == map.end());
+    CHECK(map.slot_count() == 3 && map.size() == 3);
+
+    it = map.erase(map.find(3));
+    CHECK(it == map.end() && map.size() == 2);
+    it = map.erase(map.begin());
+    CHECK(it == map.find(2));
+    it = map.erase(it);
+    CHECK(it == map.end() && it == map.begin() && map.empty());
+}
+
+// erase(it) in a loop, keeping some contacts, leaves exactly those.
+void eraseWhileIterating() {
+    for (unsigned stride : { 2u, 3u, 7u }) {
+        Map map;
+        std::map<ContactId, std::string> expected;
+        for (ContactId id = 1; id <= 200; ++id) {
+            map[id * 10] = std::to_string(id);
+            if (id % stride != 0 || id > 190) expected[id * 10] = std::to_string(id);
+        }
+        // Holes, so some erases are of the top slot with free slots below.
+        for (ContactId id = 196; id <= 199; ++id) {
+            map.erase(id * 10);
+            expected.erase(id * 10);
+        }
+
+        std::size_t visited = 0;
+        for (auto it = map.begin(); it != map.end();) {
+            ++visited;
+            const ContactId id = it->first / 10;
+            if ((id % stride == 0 && id <= 190) || id == 200) it = map.erase(it);
+            else ++it;
+        }
+        expected.erase(2000);
+        CHECK(visited == 196);
+        CHECK(contents(map) == expected && map.size() == expected.size());
+    }
+}
+
+void slotsReused() {
+    Map map;
+    for (ContactId id = 1; id <= 4; ++id) map[id] = "x";
+    const std::uint32_t freed = map.find(2).slot();
+    map.erase(2);
+    map[9] = "y";
+    CHECK(map.find(9).slot() == freed && map.slot_count() == 4);
+}
+
+} // namespace
+
+int main()
+{
+    eraseLastSlot();
+    eraseWhileIterating();
+    slotsReused();
+    return checkResult();
+}
@@ -0,0 +1,78 @@
+// Undo/redo: a contact brought back by undo (or an edit replayed by redo)
+// is seen by the duplicate checks, also when putting its keys into the
+// Bloom filters outgrows them and they are rebuilt from the book.
+
+#include "Check.h"
+#include "PhoneBook.h"
+
+#include <cstdio>
+#include <string>
+
+namespace {
+
+Contact makeContact(unsigned k) {
+    char phone[32];
+    std::snprintf(phone, sizeof phone, "+7998%07u", k);
+    return Contact("Anna", "", "Petrova", Phone(phone), "u" + std::to_string(k) + "@mail", "", "");
+}
+
+// Adds contacts until the next key put into the email filter rebuilds
+// it: an empty book's filter is sized for 1024 keys (BloomFilter::kMinKeys).
+void fillFilters(PhoneBook& book, unsigned* next) {
+    while (book.mainStorage.size() < 1024) CHECK(book.add_contact(makeContact((*next)++)));
+}
+
+void undoDeleteAtSaturation() {
+    PhoneBook book("undotest.db");
+    book.set_autosave(false);
+    unsigned next = 0;
+    fillFilters(book, &next);
+
+    const ContactId first = 1;
+    CHECK(book.remove_contact(first));
+    CHECK(book.undo());
+
+    CHECK(book.find_contact(first, nullptr));
+    CHECK(book.email_in_use("u0@mail"));
+    CHECK(book.phone_in_use("+79980000000"));
+    CHECK(!book.add_contact(makeContact(0)));
+
+    // And the other way: redo the delete, undo it again.
+    CHECK(book.redo());
+    CHECK(!book.email_in_use("u0@mail"));
+    CHECK(book.undo());
+    CHECK(book.email_in_use("u0@mail"));
+}
+
+void undoEditAtSaturation() {
+    PhoneBook book("undotest.db");
+    book.set_autosave(false);
+    unsigned next = 0;
+    fillFilters(book, &next);
+
+    // The edit's new email rebuilds the email filter, sized for 1280
+    // keys with 1024 in it; 256 more contacts fill it again.
+    Contact edited = makeContact(0);
+    edited.email = "edited@mail";
+    CHECK(book.update_contact(1, edited));
+    for (unsigned k = 0; k < 256; ++k) CHECK(book.add_contact(makeContact(next++)));
+    for (unsigned k = 0; k < 256; ++k) CHECK(book.undo());
+
+    // Undoing the edit puts u0@mail back and rebuilds the filter.
+    CHECK(book.undo());
+    Contact c;
+    CHECK(book.get_contact(1, &c) && c.email == "u0@mail");
+    CHECK(book.email_in_use("u0@mail"));
+    CHECK(!book.email_in_use("edited@mail"));
+    CHECK(!book.add_contact(Contact("Dup", "", "Licate", Phone("+79990000000"), "u0@mail", "", "")));
+}
+
+} // namespace
+
+int main()
+{
+    undoDeleteAtSaturation();
+    undoEditAtSaturation();
+    std::remove("undotest.db");
+    return checkResult();
+}
@@ -0,0 +1,343 @@
+#include "UndoLog.h"
+#include "PhoneBook.h"
+#include "Query.h"
+
+#include <utility>
+
+// ---------- UndoLog ----------
+
+void UndoLog::set_budget(std::size_t bytes)
+{
+    m_budget = bytes;
+    if (m_budget == 0) clear();
+    else trim();
+}
+
+bool UndoLog::diff(ContactId id, const ContactView* before, const ContactView* after, UndoEntry* out)
+{
+    if (!before && !after) return false;
+
+    out->id = id;
+    out->deltas.clear();
+    out->kind = !before ? UndoEntry::Kind::Create
+              : !after  ? UndoEntry::Kind::Remove
+                        : UndoEntry::Kind::Update;
+
+    for (std::size_t f = 0; f < kContactFieldCount; ++f) {
+        const ContactField field = static_cast<ContactField>(f);
+        const std::string_view was = before ? before->field(field) : std::string_view();
+        const std::string_view now = after ? after->field(field) : std::string_view();
+        if (was != now) out->deltas.push_back(FieldDelta{ field, std::string(was), std::string(now) });
+    }
+    return !out->deltas.empty() || out->kind != UndoEntry::Kind::Update;
+}
+
+void UndoLog::record(UndoStep step)
+{
+    if (!enabled()) return;
+    for (const UndoStep& undone : m_redo) m_bytes -= cost(undone);
+    m_redo.clear();
+
+    m_bytes += cost(step);
+    m_undo.push_back(std::move(step));
+    trim();
+}
+
+const UndoStep& UndoLog::take_undo()
+{
+    m_redo.push_back(std::move(m_undo.back()));
+    m_undo.pop_back();
+    return m_redo.back();
+}
+
+const UndoStep& UndoLog::take_redo()
+{
+    m_undo.push_back(std::move(m_redo.back()));
+    m_redo.pop_back();
+    return m_undo.back();
+}
+
+void UndoLog::clear()
+{
+    m_undo.clear();
+    m_redo.clear();
+    m_bytes = 0;
+}
+
+// Heap and bookkeeping bytes of one step.
+std::size_t UndoLog::cost(const UndoStep& step)
+{
+    std::size_t bytes = sizeof(UndoStep) + step.entries.capacity() * sizeof(UndoEntry);
+    for (const UndoEntry& entry : step.entries) {
+        bytes += entry.deltas.capacity() * sizeof(FieldDelta);
+        for (const FieldDelta& delta : entry.deltas) {
+            // Short values live inside the string object itself.
+            if (delta.before.size() >= sizeof(std::string)) bytes += delta.before.capacity() + 1;
+            if (delta.after.size() >= sizeof(std::string)) bytes += delta.after.capacity() + 1;
+        }
+    }
+    return bytes;
+}
+
+// Oldest steps go first; a step that alone exceeds the budget goes too.
+void UndoLog::trim()
+{
+    while (m_bytes > m_budget && !m_undo.empty()) {
+        m_bytes -= cost(m_undo.front());
+        m_undo.pop_front();
+    }
+    while (m_bytes > m_budget && !m_redo.empty()) {
+        m_bytes -= cost(m_redo.front());
+        m_redo.erase(m_redo.begin());
+    }
+}
+
+// ---------- PhoneBook change feed ----------
+
+unsigned int PhoneBook::subscribe(ChangeFeed::Listener listener)
+{
+    return changes.subscribe(std::move(listener));
+}
+
+void PhoneBook::unsubscribe(unsigned int token)
+{
+    changes.unsubscribe(token);
+}
+
+// After the book was replaced as a whole.
+void PhoneBook::publish_reset()
+{
+    if (!changes.empty()) changes.publish(ContactChange{ ContactChange::Kind::Reset, 0, kAllContactFields });
+}
+
+// ---------- PhoneBook undo/redo ----------
+
+void PhoneBook::set_undo_budget(std::size_t bytes)
+{
+    history.set_budget(bytes);
+}
+
+bool PhoneBook::can_undo() const
+{
+    return history.can_undo();
+}
+
+bool PhoneBook::can_redo() const
+{
+    return history.can_redo();
+}
+
+bool PhoneBook::undo(std::string* error)
+{
+    auto fail = [&](const std::string& msg) {
+        if (error) *error = msg;
+        return false;
+    };
+    if (batchOpen) return fail("Commit or roll back the open batch first.");
+    record_step();   // a failed mutation may have left its before-image
+    if (!history.can_undo()) return fail("Nothing to undo.");
+
+    const UndoStep& step = history.take_undo();
+    if (!apply_step(step, false)) {
+        history.clear();
+        return fail("The change can no longer be undone.");
+    }
+    publish_step(step, false);
+    if (autosave && !save_to_file()) {
+        return fail("Change undone, but failed to save to file.");
+    }
+    return true;
+}
+
+bool PhoneBook::redo(std::string* error)
+{
+    auto fail = [&](const std::string& msg) {
+        if (error) *error = msg;
+        return false;
+    };
+    if (batchOpen) return fail("Commit or roll back the open batch first.");
+    record_step();   // a failed mutation may have left its before-image
+    if (!history.can_redo()) return fail("Nothing to redo.");
+
+    const UndoStep& step = history.take_redo();
+    if (!apply_step(step, true)) {
+        history.clear();
+        return fail("The change can no longer be redone.");
+    }
+    publish_step(step, true);
+    if (autosave && !save_to_file()) {
+        return fail("Change redone, but failed to save to file.");
+    }
+    return true;
+}
+
+// Turns the before-images of the last mutation (or batch) into its undo
+// step and change events.
+void PhoneBook::record_step()
+{
+    if (pendingBefore.empty()) return;
+    if (!history.enabled() && changes.empty()) {
+        pendingBefore.clear();   // staged for a batch rollback only
+        return;
+    }
+
+    UndoStep step;
+    for (const auto& pair : pendingBefore) {
+        auto it = mainStorage.find(pair.first);
+        ContactView beforeView, afterView;
+        if (pair.second) beforeView = *pair.second;
+        if (it != mainStorage.end()) afterView = it->second;
+        const ContactView* before = pair.second ? &beforeView : nullptr;
+        const ContactView* after = it != mainStorage.end() ? &afterView : nullptr;
+
+        UndoEntry entry;
+        if (UndoLog::diff(pair.first, before, after, &entry)) step.entries.push_back(std::move(entry));
+    }
+    pendingBefore.clear();
+    if (step.entries.empty()) return;
+
+    publish_step(step, true);
+    history.record(std::move(step));
+}
+
+// The events of a step (forward) or of its inverse.
+void PhoneBook::publish_step(const UndoStep& step, bool forward)
+{
+    if (changes.empty()) return;
+    for (const UndoEntry& entry : step.entries) {
+        ContactChange change{ ContactChange::Kind::Updated, entry.id, kAllContactFields };
+        if (entry.kind == UndoEntry::Kind::Update) {
+            change.fields = 0;
+            for (const FieldDelta& delta : entry.deltas) change.fields |= fieldBit(delta.field);
+        }
+        else if ((entry.kind == UndoEntry::Kind::Create) == forward) {
+            change.kind = ContactChange::Kind::Inserted;
+        }
+        else {
+            change.kind = ContactChange::Kind::Removed;
+        }
+        changes.publish(change);
+    }
+}
+
+// Applies a step (forward) or its inverse. Entries touch distinct ids,
+// and every index drops only entries still pointing at their id, so the
+// order within a step does not matter.
+bool PhoneBook::apply_step(const UndoStep& step, bool forward)
+{
+    for (std::size_t n = 0; n < step.entries.size(); ++n) {
+        const UndoEntry& entry = step.entries[forward ? n : step.entries.size() - 1 - n];
+        const ContactId id = entry.id;
+        auto it = mainStorage.find(id);
+
+        if (entry.kind == UndoEntry::Kind::Update) {
+            if (it == mainStorage.end()) return false;
+            // Fields are set on an unpacked copy; the record is re-encoded once.
+            Contact contact = it->second.to_contact();
+            for (const FieldDelta& delta : entry.deltas) {
+                set_field(id, contact, delta.field, forward ? delta.after : delta.before);
+            }
+            it->second = contact;
+            // New keys go into the filters only now: a rebuild they
+            // trigger walks mainStorage, which must hold them.
+            for (const FieldDelta& delta : entry.deltas) {
+                const std::string& value = contactField(contact, delta.field);
+                if (delta.field == ContactField::Email) remember_email(value);
+                else if (delta.field == ContactField::WorkPhone || delta.field == ContactField::HomePhone ||
+                         delta.field == ContactField::OfficePhone) remember_phone(value);
+            }
+        }
+        else if ((entry.kind == UndoEntry::Kind::Create) == forward) {
+            if (it != mainStorage.end()) return false;
+            Contact contact;
+            for (const FieldDelta& delta : entry.deltas) {
+                contactField(contact, delta.field) = forward ? delta.after : delta.before;
+            }
+            index_contact(id, contact);
+            mainStorage[id] = contact;
+            remember_keys(contact);
+            index = std::max(index, id);
+        }
+        else {
+            if (it == mainStorage.end()) return false;
+            unindex_contact(id, it->second);
+            mainStorage.erase(it);
+        }
+    }
+    return true;
+}
+
+// One field of a contact unpacked from its record, re-indexing only that
+// field. The Bloom filters are left to the caller, once the record is
+// stored again.
+void PhoneBook::set_field(ContactId id, Contact& contact, ContactField field, const std::string& value)
+{
+    std::string& slot = contactField(contact, field);
+    if (slot == value) return;
+
+    auto eraseKey = [id](auto& mp, const std::string& key) {
+        if (key.empty()) return;
+        auto it = mp.find(key);
+        if (it != mp.end() && it->second == id) mp.erase(it);
+    };
+    // The phone suffix index holds (key, id) once, however many of the
+    // contact's phones share the key.
+    auto phoneSlot = [&](PmrFlatHashMap<std::pmr::string, ContactId>& exact) {
+        if (!slot.empty()) {
+            eraseKey(exact, slot);
+            unindex_phone(id, slot);
+            const std::string key = phoneSuffixKey(slot);
+            bool shared = false;
+            for (const std::string* other : { &contact.numbers.number1, &contact.numbers.number2, &contact.numbers.number3 }) {
+                shared = shared || (other != &slot && !other->empty() && phoneSuffixKey(*other) == key);
+            }
+            if (!shared) phoneSuffixIndex.remove(key, id);
+        }
+        slot = value;
+        if (!slot.empty()) {
+            exact[slot] = id;
+            index_phone(id, slot);
+            phoneSuffixIndex.add(phoneSuffixKey(slot), id);
+        }
+    };
+
+    switch (field) {
+    case ContactField::FirstName:
+        eraseKey(firstNameIndex, slot);
+        firstNameOrder.remove(nameKey(slot), id);
+        slot = value;
+        firstNameIndex[slot] = id;
+        firstNameOrder.add(nameKey(slot), id);
+        break;
+    case ContactField::LastName:
+        eraseKey(lastNameIndex, slot);
+        lastNameOrder.remove(nameKey(slot), id);
+        slot = value;
+        lastNameIndex[slot] = id;
+        lastNameOrder.add(nameKey(slot), id);
+        break;
+    case ContactField::WorkPhone:   phoneSlot(phoneWorkIndex); break;
+    case ContactField::HomePhone:   phoneSlot(phoneHomeIndex); break;
+    case ContactField::OfficePhone: phoneSlot(phoneOfficeIndex); break;
+    case ContactField::Email:
+        eraseKey(emailIndex, slot);
+        unindex_email_domain(id, slot);
+        slot = value;
+        emailIndex[slot] = id;
+        index_email_domain(id, slot);
+        break;
+    case ContactField::Address:
+        addressIndex.remove(id, slot);
+        slot = value;
+        addressIndex.add(id, slot);
+        break;
+    case ContactField::Birthday:
+        if (!slot.empty()) birthdayIndex.remove(birthdayKey(slot), id);
+        slot = value;
+        if (!slot.empty()) birthdayIndex.add(birthdayKey(slot), id);
+        break;
+    case ContactField::MiddleName:
+        slot = value;
+        break;
+    }
+}
@@ -0,0 +1,199 @@
+#include "VersionedPhoneBook.h"
+
+#include <thread>
+#include <utility>
+
+// ---------- Snapshot ----------
+
+VersionedPhoneBook::Snapshot::Snapshot(Snapshot&& other) noexcept
+    : m_slot(std::exchange(other.m_slot, nullptr)), m_version(std::exchange(other.m_version, nullptr))
+{
+}
+
+VersionedPhoneBook::Snapshot& VersionedPhoneBook::Snapshot::operator=(Snapshot&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        m_slot = std::exchange(other.m_slot, nullptr);
+        m_version = std::exchange(other.m_version, nullptr);
+    }
+    return *this;
+}
+
+VersionedPhoneBook::Snapshot::~Snapshot()
+{
+    release();
+}
+
+void VersionedPhoneBook::Snapshot::release()
+{
+    if (m_slot) m_slot->store(0);
+    m_slot = nullptr;
+    m_version = nullptr;
+}
+
+const PhoneBook& VersionedPhoneBook::Snapshot::book() const
+{
+    return m_version->book;
+}
+
+std::uint64_t VersionedPhoneBook::Snapshot::version() const
+{
+    return m_version->number;
+}
+
+// ---------- VersionedPhoneBook ----------
+
+VersionedPhoneBook::VersionedPhoneBook(const std::string& storageFile)
+{
+    Version* first = new Version{ PhoneBook(storageFile) };
+    first->book.set_autosave(false);   // saved here, per published version
+    first->book.set_undo_budget(0);    // versions are not undone, only replaced
+    m_current.store(first);
+}
+
+VersionedPhoneBook::~VersionedPhoneBook()
+{
+    for (const Retired& r : m_retired) delete r.version;
+    delete m_spare;
+    delete m_current.load();
+}
+
+VersionedPhoneBook::Snapshot VersionedPhoneBook::snapshot() const
+{
+    // Start where this thread found a free slot last time.
+    thread_local std::size_t hint = std::hash<std::thread::id>{}(std::this_thread::get_id());
+
+    for (std::size_t tries = 1;; ++tries, ++hint) {
+        std::atomic<std::uint64_t>& slot = m_slots[hint % kReaderSlots].epoch;
+        if (slot.load(std::memory_order_relaxed) == 0) {
+            // Announce the epoch first, then load the version: a writer
+            // that retires a version after this epoch was read keeps it.
+            std::uint64_t expected = 0;
+            if (slot.compare_exchange_strong(expected, m_epoch.load())) {
+                return Snapshot(&slot, m_current.load());
+            }
+        }
+        if (tries % kReaderSlots == 0) std::this_thread::yield();
+    }
+}
+
+std::uint64_t VersionedPhoneBook::version() const
+{
+    return snapshot().version();
+}
+
+bool VersionedPhoneBook::get_contact(ContactId id, Contact* out) const
+{
+    return snapshot()->get_contact(id, out);
+}
+
+std::vector<ContactId> VersionedPhoneBook::query(const Query& query, QueryStats* stats) const
+{
+    return runQuery(snapshot().book(), query, stats);
+}
+
+bool VersionedPhoneBook::page(const PageRequest& request, Page* out, std::string* error) const
+{
+    return snapshot()->page(request, out, error);
+}
+
+// ---------- Writers ----------
+
+bool VersionedPhoneBook::write(Change change, std::string* error)
+{
+    return publish(std::move(change), error, nullptr);
+}
+
+bool VersionedPhoneBook::add_contact(const Contact& contact, std::string* error, ContactId* newId)
+{
+    return publish([contact](PhoneBook& book, std::string* err) { return book.add_contact(contact, err); },
+                   error, newId);
+}
+
+bool VersionedPhoneBook::update_contact(ContactId id, const Contact& updated, std::string* error)
+{
+    return publish([id, updated](PhoneBook& book, std::string* err) { return book.update_contact(id, updated, err); },
+                   error, nullptr);
+}
+
+bool VersionedPhoneBook::remove_contact(ContactId id, std::string* error)
+{
+    return publish([id](PhoneBook& book, std::string* err) { return book.remove_contact(id, err); },
+                   error, nullptr);
+}
+
+std::size_t VersionedPhoneBook::retired_versions() const
+{
+    std::lock_guard<std::mutex> lock(m_writer);
+    return m_retired.size();
+}
+
+bool VersionedPhoneBook::publish(Change change, std::string* error, ContactId* newIndex)
+{
+    std::lock_guard<std::mutex> lock(m_writer);
+    reclaim();
+
+    Version* next = take_spare();
+    if (!change(next->book, error)) {
+        // Unchanged, so `next` matches the current version: keep it.
+        m_spare = next;
+        m_spareEpoch = 0;
+        m_spareLag = nullptr;
+        return false;
+    }
+    if (newIndex) *newIndex = next->book.index;
+
+    Version* old = m_current.load();
+    next->number = old->number + 1;
+    m_current.store(next);
+
+    // Pins that announced an epoch up to this one may still hold `old`.
+    m_spare = old;
+    m_spareEpoch = m_epoch.fetch_add(1);
+    m_spareLag = std::move(change);
+
+    if (!next->book.save_to_file()) {
+        if (error) *error = "Change published, but failed to save to file.";
+        return false;
+    }
+    return true;
+}
+
+bool VersionedPhoneBook::pinned(std::uint64_t epoch) const
+{
+    for (const ReaderSlot& slot : m_slots) {
+        const std::uint64_t announced = slot.epoch.load();
+        if (announced != 0 && announced <= epoch) return true;
+    }
+    return false;
+}
+
+void VersionedPhoneBook::reclaim()
+{
+    std::size_t kept = 0;
+    for (const Retired& r : m_retired) {
+        if (pinned(r.epoch)) m_retired[kept++] = r;
+        else delete r.version;
+    }
+    m_retired.resize(kept);
+}
+
+// A version equal to the current one that no reader can see.
+VersionedPhoneBook::Version* VersionedPhoneBook::take_spare()
+{
+    Version* spare = std::exchange(m_spare, nullptr);
+    if (spare && m_spareEpoch != 0 && pinned(m_spareEpoch)) {
+        // A slow reader still holds it: copy instead, free it later.
+        m_retired.push_back(Retired{ spare, m_spareEpoch });
+        spare = nullptr;
+    }
+    if (!spare) {
+        spare = new Version(*m_current.load());
+    }
+    else if (m_spareLag) {
+        (void)m_spareLag(spare->book, nullptr);
+    }
+    m_spareLag = nullptr;
+    return spare;
+}
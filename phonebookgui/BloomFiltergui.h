@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "FlatHashMapgui.h"
+
+// ======================================================
+//   BloomFilter
+//   Blocked Bloom filter over strings: every key sets 7 bits inside a
+//   single 64-byte block, so a lookup touches one cache line.
+//   - might_contain() == false  -> the key was never inserted
+//   - might_contain() == true   -> probably inserted (~1% false positives
+//     while at most capacity() keys have been inserted)
+//   Keys cannot be removed. Owners rebuild the filter from their data
+//   when saturated() reports that it has outgrown its sizing.
+// ======================================================
+
+class BloomFilter {
+public:
+    explicit BloomFilter(std::size_t expectedKeys = 0) { reset(expectedKeys); }
+
+    // Clears the filter and sizes it for `expectedKeys` (10 bits per key).
+    void reset(std::size_t expectedKeys) {
+        m_capacity = expectedKeys < kMinKeys ? kMinKeys : expectedKeys;
+        const std::size_t blocks = (m_capacity * kBitsPerKey + kBlockBits - 1) / kBlockBits;
+        m_blocks.assign(blocks, Block{});
+        m_inserted = 0;
+    }
+
+    void insert(std::string_view key) {
+        const std::uint64_t h = flat_detail::hashBytes(key.data(), key.size());
+        Block& block = m_blocks[blockOf(h)];
+        std::uint64_t bits = flat_detail::hashInt(h);
+        for (int i = 0; i < kBitsPerKeyInBlock; ++i, bits >>= 9) {
+            block.words[(bits >> 6) & 7] |= std::uint64_t(1) << (bits & 63);
+        }
+        ++m_inserted;
+    }
+
+    bool might_contain(std::string_view key) const {
+        const std::uint64_t h = flat_detail::hashBytes(key.data(), key.size());
+        const Block& block = m_blocks[blockOf(h)];
+        std::uint64_t bits = flat_detail::hashInt(h);
+        for (int i = 0; i < kBitsPerKeyInBlock; ++i, bits >>= 9) {
+            if (!(block.words[(bits >> 6) & 7] & (std::uint64_t(1) << (bits & 63)))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::size_t inserted() const { return m_inserted; }
+    std::size_t capacity() const { return m_capacity; }
+    bool saturated() const { return m_inserted > m_capacity; }
+
+private:
+    static constexpr std::size_t kBitsPerKey = 10;
+    static constexpr std::size_t kBlockBits = 512;
+    static constexpr int kBitsPerKeyInBlock = 7;   // 7 x 9 bits of one 64-bit hash
+    static constexpr std::size_t kMinKeys = 1024;
+
+    struct alignas(64) Block {
+        std::uint64_t words[8] = {};
+    };
+
+    std::vector<Block> m_blocks;
+    std::size_t m_capacity = 0;
+    std::size_t m_inserted = 0;
+
+    std::size_t blockOf(std::uint64_t h) const {
+        return static_cast<std::size_t>(((h >> 32) * m_blocks.size()) >> 32);
+    }
+};
@@ -60,7 +60,7 @@ QString DatabaseManager::lastError() const
     return m_lastError;
 }
 
-bool DatabaseManager::createContact(const Contact& contact, unsigned int* outId)
+bool DatabaseManager::createContact(const Contact& contact, ContactId* outId)
 {
     if (!isConnected()) {
         m_lastError = "Not connected to database";
@@ -100,9 +100,9 @@ bool DatabaseManager::createContact(const Contact& contact, unsigned int* outId)
     }
 
     // Get generated ID
-    unsigned int contactId = 0;
+    ContactId contactId = 0;
     if (query.next()) {
-        contactId = query.value(0).toUInt();
+        contactId = query.value(0).toULongLong();
         if (outId) *outId = contactId;
     } else {
         rollbackTransaction();
@@ -118,7 +118,7 @@ bool DatabaseManager::createContact(const Contact& contact, unsigned int* outId)
     return commitTransaction();
 }
 
-bool DatabaseManager::getContact(unsigned int id, Contact* out) const
+bool DatabaseManager::getContact(ContactId id, Contact* out) const
 {
     if (!isConnected() || !out) {
         return false;
@@ -129,7 +129,9 @@ bool DatabaseManager::getContact(unsigned int id, Contact* out) const
         "SELECT id, first_name, middle_name, last_name, email, address, birthday "
         "FROM contacts WHERE id = :id"
         );
-    query.bindValue(":id", id);
+    // ContactId is unsigned long on LP64, which QVariant has no
+    // constructor for: ids are bound as qulonglong throughout.
+    query.bindValue(":id", static_cast<qulonglong>(id));
 
     if (!query.exec() || !query.next()) {
         return false;
@@ -141,7 +143,7 @@ bool DatabaseManager::getContact(unsigned int id, Contact* out) const
     return true;
 }
 
-bool DatabaseManager::updateContact(unsigned int id, const Contact& contact)
+bool DatabaseManager::updateContact(ContactId id, const Contact& contact)
 {
     if (!isConnected()) {
         m_lastError = "Not connected to database";
@@ -152,7 +154,17 @@ bool DatabaseManager::updateContact(unsigned int id, const Contact& contact)
         return false;
     }
 
-    // Update contact
+    if (!writeContact(id, contact)) {
+        rollbackTransaction();
+        return false;
+    }
+
+    return commitTransaction();
+}
+
+// UPDATE of one contact and its phones; the caller owns the transaction.
+bool DatabaseManager::writeContact(ContactId id, const Contact& contact)
+{
     QSqlQuery query(m_db);
     query.prepare(
         "UPDATE contacts SET "
@@ -165,7 +177,7 @@ bool DatabaseManager::updateContact(unsigned int id, const Contact& contact)
         "WHERE id = :id"
         );
 
-    query.bindValue(":id", id);
+    query.bindValue(":id", static_cast<qulonglong>(id));
     query.bindValue(":first_name", QString::fromStdString(contact.firstName));
     query.bindValue(":middle_name", QString::fromStdString(contact.middleName));
     query.bindValue(":last_name", QString::fromStdString(contact.lastName));
@@ -181,20 +193,49 @@ bool DatabaseManager::updateContact(unsigned int id, const Contact& contact)
 
     if (!query.exec()) {
         m_lastError = query.lastError().text();
-        rollbackTransaction();
         return false;
     }
 
     // Delete old phones and insert new ones
-    if (!deletePhones(id) || !insertPhones(id, contact.numbers)) {
-        rollbackTransaction();
+    return deletePhones(id) && insertPhones(id, contact.numbers);
+}
+
+// Duplicates are deleted and keepers rewritten in one transaction, so a
+// failed merge batch leaves the database as it was.
+bool DatabaseManager::mergeContacts(const QList<QPair<ContactId, Contact>>& keepers,
+                                    const QList<ContactId>& duplicateIds)
+{
+    if (!isConnected()) {
+        m_lastError = "Not connected to database";
+        return false;
+    }
+
+    if (!beginTransaction()) {
         return false;
     }
 
+    QSqlQuery query(m_db);
+    query.prepare("DELETE FROM contacts WHERE id = :id");
+    for (ContactId id : duplicateIds) {
+        query.bindValue(":id", static_cast<qulonglong>(id));
+        if (!query.exec()) {
+            m_lastError = query.lastError().text();
+            rollbackTransaction();
+            return false;
+        }
+    }
+
+    for (const auto& keeper : keepers) {
+        if (!writeContact(keeper.first, keeper.second)) {
+            rollbackTransaction();
+            return false;
+        }
+    }
+
     return commitTransaction();
 }
 
-bool DatabaseManager::deleteContact(unsigned int id)
+bool DatabaseManager::deleteContact(ContactId id)
 {
     if (!isConnected()) {
         m_lastError = "Not connected to database";
@@ -203,7 +244,7 @@ bool DatabaseManager::deleteContact(unsigned int id)
 
     QSqlQuery query(m_db);
     query.prepare("DELETE FROM contacts WHERE id = :id");
-    query.bindValue(":id", id);
+    query.bindValue(":id", static_cast<qulonglong>(id));
 
     if (!query.exec()) {
         m_lastError = query.lastError().text();
@@ -211,12 +252,16 @@ bool DatabaseManager::deleteContact(unsigned int id)
     }
 
     // Phones are automatically deleted due to CASCADE
-    return query.numRowsAffected() > 0;
+    if (query.numRowsAffected() <= 0) {
+        m_lastError = "Contact not found in the database";
+        return false;
+    }
+    return true;
 }
 
-QList<QPair<unsigned int, Contact>> DatabaseManager::getAllContacts() const
+QList<QPair<ContactId, Contact>> DatabaseManager::getAllContacts() const
 {
-    QList<QPair<unsigned int, Contact>> result;
+    QList<QPair<ContactId, Contact>> result;
 
     if (!isConnected()) {
         return result;
@@ -233,7 +278,7 @@ QList<QPair<unsigned int, Contact>> DatabaseManager::getAllContacts() const
     }
 
     while (query.next()) {
-        unsigned int id = query.value("id").toUInt();
+        ContactId id = query.value("id").toULongLong();
         Contact contact = resultToContact(query);
         contact.numbers = getPhonesForContact(id);
         result.append(qMakePair(id, contact));
@@ -242,9 +287,9 @@ QList<QPair<unsigned int, Contact>> DatabaseManager::getAllContacts() const
     return result;
 }
 
-QList<QPair<unsigned int, Contact>> DatabaseManager::searchByFirstName(const QString& name) const
+QList<QPair<ContactId, Contact>> DatabaseManager::searchByFirstName(const QString& name) const
 {
-    QList<QPair<unsigned int, Contact>> result;
+    QList<QPair<ContactId, Contact>> result;
 
     if (!isConnected()) {
         return result;
@@ -262,7 +307,7 @@ QList<QPair<unsigned int, Contact>> DatabaseManager::searchByFirstName(const QSt
     }
 
     while (query.next()) {
-        unsigned int id = query.value("id").toUInt();
+        ContactId id = query.value("id").toULongLong();
         Contact contact = resultToContact(query);
         contact.numbers = getPhonesForContact(id);
         result.append(qMakePair(id, contact));
@@ -271,9 +316,9 @@ QList<QPair<unsigned int, Contact>> DatabaseManager::searchByFirstName(const QSt
     return result;
 }
 
-QList<QPair<unsigned int, Contact>> DatabaseManager::searchByLastName(const QString& name) const
+QList<QPair<ContactId, Contact>> DatabaseManager::searchByLastName(const QString& name) const
 {
-    QList<QPair<unsigned int, Contact>> result;
+    QList<QPair<ContactId, Contact>> result;
 
     if (!isConnected()) {
         return result;
@@ -291,7 +336,7 @@ QList<QPair<unsigned int, Contact>> DatabaseManager::searchByLastName(const QStr
     }
 
     while (query.next()) {
-        unsigned int id = query.value("id").toUInt();
+        ContactId id = query.value("id").toULongLong();
         Contact contact = resultToContact(query);
         contact.numbers = getPhonesForContact(id);
         result.append(qMakePair(id, contact));
@@ -300,9 +345,9 @@ QList<QPair<unsigned int, Contact>> DatabaseManager::searchByLastName(const QStr
     return result;
 }
 
-QList<QPair<unsigned int, Contact>> DatabaseManager::searchByEmail(const QString& email) const
+QList<QPair<ContactId, Contact>> DatabaseManager::searchByEmail(const QString& email) const
 {
-    QList<QPair<unsigned int, Contact>> result;
+    QList<QPair<ContactId, Contact>> result;
 
     if (!isConnected()) {
         return result;
@@ -320,7 +365,7 @@ QList<QPair<unsigned int, Contact>> DatabaseManager::searchByEmail(const QString
     }
 
     while (query.next()) {
-        unsigned int id = query.value("id").toUInt();
+        ContactId id = query.value("id").toULongLong();
         Contact contact = resultToContact(query);
         contact.numbers = getPhonesForContact(id);
         result.append(qMakePair(id, contact));
@@ -329,9 +374,9 @@ QList<QPair<unsigned int, Contact>> DatabaseManager::searchByEmail(const QString
     return result;
 }
 
-QList<QPair<unsigned int, Contact>> DatabaseManager::searchByPhone(const QString& phone) const
+QList<QPair<ContactId, Contact>> DatabaseManager::searchByPhone(const QString& phone) const
 {
-    QList<QPair<unsigned int, Contact>> result;
+    QList<QPair<ContactId, Contact>> result;
 
     if (!isConnected()) {
         return result;
@@ -351,7 +396,7 @@ QList<QPair<unsigned int, Contact>> DatabaseManager::searchByPhone(const QString
     }
 
     while (query.next()) {
-        unsigned int id = query.value("id").toUInt();
+        ContactId id = query.value("id").toULongLong();
         Contact contact = resultToContact(query);
         contact.numbers = getPhonesForContact(id);
         result.append(qMakePair(id, contact));
@@ -373,7 +418,7 @@ int DatabaseManager::getContactCount() const
     return 0;
 }
 
-bool DatabaseManager::contactExists(unsigned int id) const
+bool DatabaseManager::contactExists(ContactId id) const
 {
     if (!isConnected()) {
         return false;
@@ -381,13 +426,43 @@ bool DatabaseManager::contactExists(unsigned int id) const
 
     QSqlQuery query(m_db);
     query.prepare("SELECT 1 FROM contacts WHERE id = :id");
-    query.bindValue(":id", id);
+    query.bindValue(":id", static_cast<qulonglong>(id));
 
     return query.exec() && query.next();
 }
 
+bool DatabaseManager::emailExists(const QString& email) const
+{
+    if (!isConnected()) {
+        return false;
+    }
+
+    QSqlQuery query(m_db);
+    query.prepare("SELECT 1 FROM contacts WHERE email = :email");
+    query.bindValue(":email", email);
+
+    return query.exec() && query.next();
+}
+
+QStringList DatabaseManager::getAllEmails() const
+{
+    QStringList emails;
+    if (!isConnected()) {
+        return emails;
+    }
+
+    QSqlQuery query("SELECT email FROM contacts", m_db);
+    if (query.exec()) {
+        while (query.next()) {
+            emails.append(query.value(0).toString());
+        }
+    }
+    return emails;
+}
+
 bool DatabaseManager::beginTransaction()
 {
+    if (m_inBatch) return true;
     if (!m_db.transaction()) {
         m_lastError = m_db.lastError().text();
         return false;
@@ -397,6 +472,7 @@ bool DatabaseManager::beginTransaction()
 
 bool DatabaseManager::commitTransaction()
 {
+    if (m_inBatch) return true;
     if (!m_db.commit()) {
         m_lastError = m_db.lastError().text();
         return false;
@@ -406,6 +482,10 @@ bool DatabaseManager::commitTransaction()
 
 bool DatabaseManager::rollbackTransaction()
 {
+    if (m_inBatch) {
+        m_batchFailed = true;
+        return true;
+    }
     if (!m_db.rollback()) {
         m_lastError = m_db.lastError().text();
         return false;
@@ -413,6 +493,43 @@ bool DatabaseManager::rollbackTransaction()
     return true;
 }
 
+bool DatabaseManager::beginBatch()
+{
+    if (m_inBatch) {
+        m_lastError = "A batch is already open";
+        return false;
+    }
+    if (!beginTransaction()) {
+        return false;
+    }
+    m_inBatch = true;
+    m_batchFailed = false;
+    return true;
+}
+
+bool DatabaseManager::commitBatch()
+{
+    if (!m_inBatch) {
+        m_lastError = "No batch is open";
+        return false;
+    }
+    m_inBatch = false;
+    if (m_batchFailed) {
+        const QString cause = m_lastError;
+        rollbackTransaction();
+        m_lastError = cause;
+        return false;
+    }
+    return commitTransaction();
+}
+
+bool DatabaseManager::rollbackBatch()
+{
+    if (!m_inBatch) return true;
+    m_inBatch = false;
+    return rollbackTransaction();
+}
+
 Contact DatabaseManager::resultToContact(const QSqlQuery& query) const
 {
     Contact contact;
@@ -431,7 +548,7 @@ Contact DatabaseManager::resultToContact(const QSqlQuery& query) const
     return contact;
 }
 
-bool DatabaseManager::insertPhones(unsigned int contactId, const Phone& phones)
+bool DatabaseManager::insertPhones(ContactId contactId, const Phone& phones)
 {
     QSqlQuery query(m_db);
     query.prepare(
@@ -442,7 +559,7 @@ bool DatabaseManager::insertPhones(unsigned int contactId, const Phone& phones)
     auto insertPhone = [&](const std::string& number, const QString& type) -> bool {
         if (number.empty()) return true;
 
-        query.bindValue(":contact_id", contactId);
+        query.bindValue(":contact_id", static_cast<qulonglong>(contactId));
         query.bindValue(":phone_type", type);
         query.bindValue(":phone_number", QString::fromStdString(number));
 
@@ -460,11 +577,11 @@ bool DatabaseManager::insertPhones(unsigned int contactId, const Phone& phones)
     return true;
 }
 
-bool DatabaseManager::deletePhones(unsigned int contactId)
+bool DatabaseManager::deletePhones(ContactId contactId)
 {
     QSqlQuery query(m_db);
     query.prepare("DELETE FROM phones WHERE contact_id = :contact_id");
-    query.bindValue(":contact_id", contactId);
+    query.bindValue(":contact_id", static_cast<qulonglong>(contactId));
 
     if (!query.exec()) {
         m_lastError = query.lastError().text();
@@ -473,7 +590,7 @@ bool DatabaseManager::deletePhones(unsigned int contactId)
     return true;
 }
 
-Phone DatabaseManager::getPhonesForContact(unsigned int contactId) const
+Phone DatabaseManager::getPhonesForContact(ContactId contactId) const
 {
     Phone phones;
 
@@ -481,7 +598,7 @@ Phone DatabaseManager::getPhonesForContact(unsigned int contactId) const
     query.prepare(
         "SELECT phone_type, phone_number FROM phones WHERE contact_id = :contact_id"
         );
-    query.bindValue(":contact_id", contactId);
+    query.bindValue(":contact_id", static_cast<qulonglong>(contactId));
 
     if (!query.exec()) {
         return phones;
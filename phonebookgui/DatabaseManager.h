@@ -5,6 +5,7 @@
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QString>
+#include <QStringList>
 #include <QVariant>
 #include <memory>
 #include "Contactgui.h"
@@ -26,27 +27,39 @@ public:
     QString lastError() const;
 
     // CRUD operations
-    bool createContact(const Contact& contact, unsigned int* outId = nullptr);
-    bool getContact(unsigned int id, Contact* out) const;
-    bool updateContact(unsigned int id, const Contact& contact);
-    bool deleteContact(unsigned int id);
+    bool createContact(const Contact& contact, ContactId* outId = nullptr);
+    bool getContact(ContactId id, Contact* out) const;
+    bool updateContact(ContactId id, const Contact& contact);
+    bool deleteContact(ContactId id);
+    bool mergeContacts(const QList<QPair<ContactId, Contact>>& keepers,
+                       const QList<ContactId>& duplicateIds);
 
     // Search operations
-    QList<QPair<unsigned int, Contact>> getAllContacts() const;
-    QList<QPair<unsigned int, Contact>> searchByFirstName(const QString& name) const;
-    QList<QPair<unsigned int, Contact>> searchByLastName(const QString& name) const;
-    QList<QPair<unsigned int, Contact>> searchByEmail(const QString& email) const;
-    QList<QPair<unsigned int, Contact>> searchByPhone(const QString& phone) const;
+    QList<QPair<ContactId, Contact>> getAllContacts() const;
+    QList<QPair<ContactId, Contact>> searchByFirstName(const QString& name) const;
+    QList<QPair<ContactId, Contact>> searchByLastName(const QString& name) const;
+    QList<QPair<ContactId, Contact>> searchByEmail(const QString& email) const;
+    QList<QPair<ContactId, Contact>> searchByPhone(const QString& phone) const;
 
     // Utility
     int getContactCount() const;
-    bool contactExists(unsigned int id) const;
+    bool contactExists(ContactId id) const;
+    bool emailExists(const QString& email) const;
+    QStringList getAllEmails() const;
 
     // Transaction support
     bool beginTransaction();
     bool commitTransaction();
     bool rollbackTransaction();
 
+    // Batches: one transaction around many operations. Inside a batch the
+    // operations' own transactions join it, and one that fails dooms the
+    // batch: commitBatch() then rolls back and returns false.
+    bool beginBatch();
+    bool commitBatch();
+    bool rollbackBatch();
+    bool inBatch() const { return m_inBatch; }
+
 private:
     DatabaseManager();
     ~DatabaseManager();
@@ -55,13 +68,16 @@ private:
 
     QSqlDatabase m_db;
     QString m_lastError;
+    bool m_inBatch = false;
+    bool m_batchFailed = false;
 
     // Helper methods
     bool executeQuery(QSqlQuery& query) const;
     Contact resultToContact(const QSqlQuery& query) const;
-    bool insertPhones(unsigned int contactId, const Phone& phones);
-    bool deletePhones(unsigned int contactId);
-    Phone getPhonesForContact(unsigned int contactId) const;
+    bool writeContact(ContactId id, const Contact& contact);
+    bool insertPhones(ContactId contactId, const Phone& phones);
+    bool deletePhones(ContactId contactId);
+    Phone getPhonesForContact(ContactId contactId) const;
 };
 
 #endif // DATABASEMANAGER_H
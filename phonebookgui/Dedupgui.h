@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "ContactRecordgui.h"
+
+class PhoneBook;
+
+// ======================================================
+//   Duplicate detection
+//   1. Blocking: every contact emits keys - each normalized phone, the
+//      lower-cased email and a phonetic name key (Soundex of the last
+//      name + first initial). Only contacts sharing a key are compared,
+//      so the work grows with the number of keys instead of n^2.
+//   2. Scoring: a pair scores 0..1 from name similarity (Jaro-Winkler,
+//      case-insensitive, up to 0.6) plus a shared email or phone (0.25
+//      each), birthday (0.2) or address (0.1); a conflicting birthday
+//      halves the score. Names alone never reach the default threshold.
+//   3. Clustering: pairs scoring >= threshold are joined with union-find
+//      and every cluster becomes one MergeProposal.
+//   Blocks larger than `window` (a shared switchboard number, a common
+//   surname) are ordered by name and every contact is compared with its
+//   next window - 1 neighbours only.
+// ======================================================
+
+struct DedupOptions {
+    double threshold = 0.8;
+    std::size_t window = 32;
+    unsigned threadCount = 0;   // 0 = one per core
+};
+
+struct MergeProposal {
+    ContactId keepId = 0;                  // lowest id of the cluster
+    std::vector<ContactId> duplicateIds;   // deleted when the merge is applied
+    Contact merged;                           // what keepId becomes
+    std::vector<std::string> droppedPhones;   // numbers that did not fit the three slots
+    double score = 0.0;                       // weakest link holding the cluster together
+    // The cluster as findDuplicates() saw it, keeper first: a merge is
+    // skipped if any of these contacts changed since.
+    std::vector<Contact> before;
+};
+
+double contactSimilarity(const ContactView& a, const ContactView& b);
+
+// Keeps the first contact's fields and fills its blanks from the others
+// in order. Phones are compared in normalized form; numbers left over when
+// all three slots are taken go to *droppedPhones.
+Contact mergeContacts(const std::vector<ContactView>& cluster,
+                      std::vector<std::string>* droppedPhones = nullptr);
+
+// Proposals ordered by keepId.
+std::vector<MergeProposal> findDuplicates(const PhoneBook& book, const DedupOptions& options = {});
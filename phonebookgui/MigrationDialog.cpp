@@ -1,6 +1,7 @@
 #include "migrationdialog.h"
 #include "PhoneBookgui.h"
 #include "DatabaseManager.h"
+#include "BloomFiltergui.h"
 
 #include <QApplication>
 #include <QVBoxLayout>
@@ -143,26 +144,42 @@ void MigrationDialog::migrateJsonToDatabase()
 
     int migrated = 0;
     int failed = 0;
+    int skipped = 0;
+
+    // Emails already in the database. A filter miss skips the per-contact
+    // lookup; only probable duplicates cost a query.
+    const QStringList existingEmails = DatabaseManager::instance().getAllEmails();
+    BloomFilter knownEmails(static_cast<std::size_t>(existingEmails.size() + totalContacts));
+    for (const QString& email : existingEmails) {
+        knownEmails.insert(email.toStdString());
+    }
 
     for (const auto& pair : tempBook.mainStorage) {
-        const Contact& contact = pair.second;
+        // Update progress first, so skipped contacts move it too.
+        const int done = migrated + failed + skipped;
+        m_progress->setValue(done * 100 / totalContacts);
+        m_status->setText(QString("Migrating... %1/%2 contacts").arg(done).arg(totalContacts));
+        qApp->processEvents();
+
+        const Contact contact = pair.second.to_contact();
+
+        if (knownEmails.might_contain(contact.email) &&
+            DatabaseManager::instance().emailExists(QString::fromStdString(contact.email))) {
+            skipped++;
+            continue;
+        }
 
         // Try to add to database
         std::string error;
-        unsigned int newId = 0;
+        ContactId newId = 0;
 
         if (DatabaseManager::instance().createContact(contact, &newId)) {
             migrated++;
+            knownEmails.insert(contact.email);
         } else {
             failed++;
             qDebug() << "Failed to migrate contact:" << QString::fromStdString(error);
         }
-
-        // Update progress
-        int progress = static_cast<int>((migrated + failed) * 100 / totalContacts);
-        m_progress->setValue(progress);
-        m_status->setText(QString("Migrating... %1/%2 contacts").arg(migrated + failed).arg(totalContacts));
-        qApp->processEvents();
     }
 
     m_progress->setValue(100);
@@ -170,7 +187,8 @@ void MigrationDialog::migrateJsonToDatabase()
     // Show results
     QString resultMsg = QString("Migration completed!\n\n"
                                 "Successfully migrated: %1 contacts\n"
-                                "Failed: %2 contacts").arg(migrated).arg(failed);
+                                "Skipped (email already in database): %2 contacts\n"
+                                "Failed: %3 contacts").arg(migrated).arg(skipped).arg(failed);
 
     if (failed > 0) {
         resultMsg += "\n\nSome contacts may have duplicate emails or validation errors.";
@@ -241,7 +259,7 @@ void MigrationDialog::migrateDatabaseToJson()
     int exported = 0;
 
     for (const auto& pair : contacts) {
-        unsigned int id = pair.first;
+        ContactId id = pair.first;
         const Contact& contact = pair.second;
 
         // Add to temporary PhoneBook (bypass validation since data already valid)
@@ -1,34 +1,125 @@
 #pragma once
+#include <optional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <memory_resource>
 #include "DatabaseManager.h"
 #include "Contactgui.h"
+#include "ContactRecordgui.h"
+#include "FlatHashMapgui.h"
+#include "IdAllocatorgui.h"
+#include "BloomFiltergui.h"
+#include "AddressIndexgui.h"
+#include "OrderedIndexgui.h"
+#include "Paginggui.h"
+#include "UndoLoggui.h"
+#include "ChangeFeedgui.h"
+
+struct MergeProposal;   // Dedupgui.h
 
 class PhoneBook {
+private:
+    // Memory for the tables below. Declared first so it outlives them.
+    // Tables and index keys are carved out of `arena` through `pool`:
+    // a bulk load draws a few large arena blocks, steady-state edits
+    // recycle freed blocks in the pool, and reset_storage() hands
+    // everything back at once.
+    std::pmr::monotonic_buffer_resource arena;
+    std::pmr::unsynchronized_pool_resource pool;
+
 public:
-    unsigned int index;
+    ContactId index;
+
+    // Contacts in their compact stored form (ContactRecordgui.h), read
+    // through ContactView.
+    SlotMap<ContactRecord> mainStorage{ &pool };
+    PmrFlatHashMap<std::pmr::string, ContactId> firstNameIndex{ &pool };
+    PmrFlatHashMap<std::pmr::string, ContactId> lastNameIndex{ &pool };
+
+    PmrFlatHashMap<std::pmr::string, ContactId> phoneWorkIndex{ &pool };
+    PmrFlatHashMap<std::pmr::string, ContactId> phoneHomeIndex{ &pool };
+    PmrFlatHashMap<std::pmr::string, ContactId> phoneOfficeIndex{ &pool };
+
+    PmrFlatHashMap<std::pmr::string, ContactId> emailIndex{ &pool };
 
-    std::unordered_map<unsigned int, Contact> mainStorage;
-    std::unordered_map<std::string, unsigned int> firstNameIndex;
-    std::unordered_map<std::string, unsigned int> lastNameIndex;
+    // Email domain (see emailDomain()) -> ids of the contacts at that
+    // domain, ascending. Kept in step with emailIndex.
+    PmrFlatHashMap<std::pmr::string, std::pmr::vector<ContactId>> emailDomainIndex{ &pool };
 
-    std::unordered_map<std::string, unsigned int> phoneWorkIndex;
-    std::unordered_map<std::string, unsigned int> phoneHomeIndex;
-    std::unordered_map<std::string, unsigned int> phoneOfficeIndex;
+    // Normalized phone (see phone_in_use()) -> ids of the contacts listing
+    // that number, ascending, once per phone. Kept in step with the three
+    // phone indexes, so another spelling of a number is one probe.
+    PmrFlatHashMap<std::pmr::string, std::pmr::vector<ContactId>> phoneKeyIndex{ &pool };
 
-    std::unordered_map<std::string, unsigned int> emailIndex;
+    // Full-text index over addresses, for ranked address search.
+    AddressIndex addressIndex;
+
+    // Ordered indexes for prefix and range queries (Querygui.h) and paging.
+    // Keyed by nameKey(), phoneSuffixKey() of all three phones and
+    // birthdayKey(). Every contact is in the two name indexes, so they
+    // can list the whole book in name order.
+    OrderedIndex firstNameOrder;
+    OrderedIndex lastNameOrder;
+    OrderedIndex phoneSuffixIndex;
+    OrderedIndex birthdayIndex;
 
 private: 
     std::string storageFile;
     bool m_useDatabase;
 
+    // Open batch (begin_batch): the id counter at its start.
+    bool batchOpen = false;
+    ContactId batchIndex = 0;
+    // Each contact the current mutation or batch touched, as it was
+    // before (nullopt: did not exist). Rollback puts these back; when the
+    // change completes they become its undo step.
+    FlatHashMap<ContactId, std::optional<ContactRecord>> pendingBefore;
+    UndoLog history;
+    ChangeFeed changes;   // not copied: listeners follow one book
+
+    // Front for duplicate checks: a miss means "certainly not in use" and
+    // skips the index lookups. Keyed by email and by normalized phone;
+    // rebuilt on load, extended on every add/update.
+    BloomFilter emailFilter;
+    BloomFilter phoneFilter;
+
+    void reset_storage(std::size_t expectedContacts);
+    void rebuild_filters();
+    void remember_email(std::string_view email);
+    void remember_phone(std::string_view phone);
+    void remember_keys(const ContactView& contact);   // email and all three phones
+    // Whether a merge proposal still applies: see apply_merges().
+    bool merge_applies(const MergeProposal& proposal) const;
+    void index_email_domain(ContactId id, std::string_view email);
+    void unindex_email_domain(ContactId id, std::string_view email);
+    void index_phone(ContactId id, std::string_view phone);
+    void unindex_phone(ContactId id, std::string_view phone);
+    void index_ordered(ContactId id, const ContactView& contact);
+    void unindex_ordered(ContactId id, const ContactView& contact);
+    void index_contact(ContactId id, const ContactView& contact);
+    void unindex_contact(ContactId id, const ContactView& contact);
+
+    // Before a mutation of `id`: its before-image, for rollback and undo.
+    void remember_before(ContactId id);
+    // After a mutation: records the undo step and saves, unless a batch
+    // defers the save. Database mode has no file to save: mutations
+    // reach the database as they are made.
+    bool persist();
+    void record_step();
+    void publish_step(const UndoStep& step, bool forward);
+    void publish_reset();
+    bool apply_step(const UndoStep& step, bool forward);
+    void set_field(ContactId id, Contact& contact, ContactField field, const std::string& value);
+
 public:
     PhoneBook();
     PhoneBook(const PhoneBook& phoneBook);
     ~PhoneBook();
 
-    int get_index();
-    void set_index(int index);
+    ContactId get_index() const;
+    void set_index(ContactId index);
     bool connectToDatabase(const QString& host = "localhost",
                            int port = 5432,
                            const QString& dbName = "phonebook_db",
@@ -43,9 +134,72 @@ public:
     bool save_to_file(const std::string& filename = "") const;
     bool load_from_file(const std::string& filename = "");
 public:
-    bool add_contact(const Contact& contact, std::string* error = nullptr);
-    bool remove_contact(unsigned int id, std::string* error = nullptr);
-    bool update_contact(unsigned int id, const Contact& updated, std::string* error = nullptr);
-    bool get_contact(unsigned int id, Contact* out) const;
+    // Contacts are taken by value: pass an rvalue to hand one over
+    // without copying its strings. The book stores a ContactRecord.
+    bool add_contact(Contact contact, std::string* error = nullptr);
+    bool remove_contact(ContactId id, std::string* error = nullptr);
+    bool update_contact(ContactId id, Contact updated, std::string* error = nullptr);
+    // A copy of the contact, which outlives any later change.
+    bool get_contact(ContactId id, Contact* out) const;
+    // Views of the stored fields: no copy, but valid only until the next
+    // mutation, undo/redo or reload of this book.
+    bool find_contact(ContactId id, ContactView* out) const;
+
+    // Batches: every mutation between begin_batch() and commit_batch()
+    // is validated and indexed as usual, but the file is written by
+    // commit_batch(), once; in database mode the batch is one transaction.
+    // rollback_batch() puts back every contact the batch touched and the
+    // id counter, in O(contacts touched). A failed commit rolls back.
+    // begin_batch() fails if a batch is already open. A batch still open
+    // when the book is destroyed is rolled back.
+    bool begin_batch(std::string* error = nullptr);
+    bool commit_batch(std::string* error = nullptr);
+    void rollback_batch();
+    bool in_batch() const { return batchOpen; }
+
+    // Undo/redo (UndoLoggui.h) of the last create, edit, delete, merge or
+    // batch, in O(fields changed). History is bounded by a byte budget,
+    // UndoLog::kDefaultBudget unless set; 0 turns it off. Off in database
+    // mode, where the database is the record. Loading clears it.
+    bool undo(std::string* error = nullptr);
+    bool redo(std::string* error = nullptr);
+    bool can_undo() const;
+    bool can_redo() const;
+    void set_undo_budget(std::size_t bytes);
+
+    // Change events (ChangeFeedgui.h) after every create, edit, delete,
+    // merge, committed batch, undo, redo and load, so views can follow
+    // the book row by row. The token is for unsubscribe(); a listener
+    // must not mutate the book.
+    unsigned int subscribe(ChangeFeed::Listener listener);
+    void unsubscribe(unsigned int token);
+
+    // Whether another contact (not `exceptId`) already uses the email /
+    // the phone number in any of its three fields, in any accepted format.
+    bool email_in_use(const std::string& email, ContactId exceptId = 0) const;
+    bool phone_in_use(const std::string& phone, ContactId exceptId = 0) const;
+
+    // Applies proposals from findDuplicates() (Dedupgui.h) as one batch:
+    // each keeper becomes its merged record and the duplicates are deleted.
+    // In database mode the batch is one transaction. A proposal is skipped
+    // if one of its contacts no longer exists or changed since the scan,
+    // if the merged record is invalid, or if its email belongs to a
+    // contact outside the cluster; *applied counts the rest.
+    bool apply_merges(const std::vector<MergeProposal>& proposals,
+                      std::size_t* applied = nullptr, std::string* error = nullptr);
+
+    // Contacts whose email is at `domain` ("mail.ru", "@Mail.ru" or a full
+    // address), in id order. Cost is proportional to the result.
+    std::vector<ContactId> contacts_at_domain(std::string_view domain) const;
+    std::size_t domain_count(std::string_view domain) const;
+    // Every domain with its number of contacts, largest first.
+    std::vector<std::pair<std::string, std::size_t>> domain_counts() const;
+
+    // One page of contacts in `request` order (Paginggui.h). Fails, with
+    // *error set, for a cursor issued for another ordering.
+    bool page(const PageRequest& request, Page* out, std::string* error = nullptr) const;
+    // Every contact id in `key` order, for callers that list the whole
+    // book. Keys without an ordered index are sorted in parallel.
+    std::vector<ContactId> sorted_ids(SortKey key, bool descending = false) const;
 
 };
@@ -0,0 +1,67 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ======================================================
+//   PhoneFormatSet
+//   Accepted phone formats, one per line of a text config:
+//
+//       # name   pattern            normalize-to
+//       RU       +7XXXXXXXXXX       +7
+//       RU       8(XXX)XXX-XX-XX    +7
+//
+//   In a pattern 'X' is any digit; digits and + ( ) - . / are literals.
+//   A matching number normalizes to "normalize-to" followed by the
+//   digits that matched the X positions, e.g. "8(999)123-45-67" ->
+//   "+79991234567". The first matching line wins.
+//
+//   All patterns are compiled into one DFA over byte classes, so
+//   matching costs one table lookup per character however many
+//   formats are configured.
+// ======================================================
+
+struct PhoneFormat {
+    std::string name;
+    std::string pattern;
+    std::string normalizedPrefix;
+};
+
+class PhoneFormatSet {
+public:
+    PhoneFormatSet();   // the built-in +7 / 8 formats
+
+    // Replaces the formats. On error nothing changes and *error says why.
+    bool parse(std::istream& in, std::string* error = nullptr);
+    bool load_from_file(const std::string& filename, std::string* error = nullptr);
+
+    // Index of the first format matching the whole string, or -1.
+    // No trimming: callers pass the trimmed number.
+    int match(std::string_view phone) const;
+    // "" if no format matches.
+    std::string normalize(std::string_view phone) const;
+
+    const std::vector<PhoneFormat>& formats() const { return m_formats; }
+
+private:
+    std::vector<PhoneFormat> m_formats;
+
+    std::array<std::uint8_t, 256> m_byteClass;
+    std::size_t m_classCount;
+    std::vector<std::int32_t> m_next;     // [state * m_classCount + class], -1 = reject
+    std::vector<std::int32_t> m_accept;   // per state: format index or -1
+
+    void compile(std::vector<PhoneFormat> formats);
+};
+
+// Formats used by isValidPhone()/normalizePhone(). Replace them once at
+// startup, before any other thread validates phones.
+const PhoneFormatSet& phoneFormats();
+void setPhoneFormats(const PhoneFormatSet& formats);
+
+// Loads `filename` into phoneFormats() if it exists. A missing file keeps
+// the built-in formats; a malformed one keeps them too and returns false.
+bool loadPhoneFormats(const std::string& filename, std::string* error = nullptr);
@@ -0,0 +1,293 @@
+#include "AddressIndexgui.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <utility>
+
+namespace {
+
+// Usual BM25 constants.
+constexpr double kK1 = 1.2;
+constexpr double kB = 0.75;
+
+// A prefix matching more terms than this only uses the most frequent
+// ones; a one-letter prefix would otherwise pull in half the index.
+constexpr std::size_t kMaxPrefixTerms = 32;
+
+bool isTokenChar(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+// Term counts of one address, plus its length in tokens.
+std::vector<std::pair<std::string, std::uint16_t>> countTerms(std::string_view address, std::uint16_t* length) {
+    std::vector<std::string> tokens = AddressIndex::tokenize(address);
+    const std::size_t n = std::min<std::size_t>(tokens.size(), std::numeric_limits<std::uint16_t>::max());
+    *length = static_cast<std::uint16_t>(n);
+
+    std::sort(tokens.begin(), tokens.end());
+    std::vector<std::pair<std::string, std::uint16_t>> counts;
+    for (std::string& token : tokens) {
+        if (!counts.empty() && counts.back().first == token) {
+            if (counts.back().second < std::numeric_limits<std::uint16_t>::max()) ++counts.back().second;
+        }
+        else {
+            counts.emplace_back(std::move(token), 1);
+        }
+    }
+    return counts;
+}
+
+} // namespace
+
+std::vector<std::string> AddressIndex::tokenize(std::string_view text)
+{
+    std::vector<std::string> tokens;
+    std::string current;
+    for (char ch : text) {
+        const unsigned char c = static_cast<unsigned char>(ch);
+        if (isTokenChar(c)) {
+            current += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : ch;
+        }
+        else if (!current.empty()) {
+            tokens.push_back(std::move(current));
+            current.clear();
+        }
+    }
+    if (!current.empty()) tokens.push_back(std::move(current));
+    return tokens;
+}
+
+void AddressIndex::add(ContactId id, std::string_view address)
+{
+    std::uint16_t length = 0;
+    const auto counts = countTerms(address, &length);
+    if (counts.empty()) return;
+
+    for (const auto& term : counts) {
+        std::vector<Posting>& list = m_postings[term.first];
+        const Posting posting{ id, term.second, length };
+        // Ids mostly grow, so this is usually an append.
+        if (list.empty() || list.back().id < id) {
+            list.push_back(posting);
+            continue;
+        }
+        auto pos = std::lower_bound(list.begin(), list.end(), id,
+                                    [](const Posting& p, ContactId v) { return p.id < v; });
+        if (pos != list.end() && pos->id == id) *pos = posting;
+        else list.insert(pos, posting);
+    }
+    ++m_documents;
+    m_totalLength += length;
+}
+
+void AddressIndex::remove(ContactId id, std::string_view address)
+{
+    std::uint16_t length = 0;
+    const auto counts = countTerms(address, &length);
+    if (counts.empty()) return;
+
+    bool found = false;
+    for (const auto& term : counts) {
+        auto it = m_postings.find(term.first);
+        if (it == m_postings.end()) continue;
+
+        std::vector<Posting>& list = it->second;
+        auto pos = std::lower_bound(list.begin(), list.end(), id,
+                                    [](const Posting& p, ContactId v) { return p.id < v; });
+        if (pos == list.end() || pos->id != id) continue;
+
+        list.erase(pos);
+        found = true;
+        if (list.empty()) m_postings.erase(it);
+    }
+    if (found) {
+        --m_documents;
+        m_totalLength -= length;
+    }
+}
+
+void AddressIndex::clear()
+{
+    m_postings.clear();
+    m_documents = 0;
+    m_totalLength = 0;
+}
+
+std::vector<const AddressIndex::Term*> AddressIndex::queryTerms(std::string_view query) const
+{
+    std::vector<const Term*> terms;
+    std::vector<std::string> tokens = tokenize(query);
+    if (tokens.empty()) return terms;
+
+    // Every token exactly, the last one also as a prefix.
+    const std::string last = tokens.back();
+    tokens.pop_back();
+    for (const std::string& token : tokens) {
+        auto it = m_postings.find(token);
+        if (it != m_postings.end()) terms.push_back(&*it);
+    }
+
+    std::vector<const Term*> expanded;
+    for (auto it = m_postings.lower_bound(last);
+         it != m_postings.end() && it->first.compare(0, last.size(), last) == 0; ++it) {
+        expanded.push_back(&*it);
+    }
+    if (expanded.size() > kMaxPrefixTerms) {
+        std::partial_sort(expanded.begin(), expanded.begin() + kMaxPrefixTerms, expanded.end(),
+                          [](const Term* a, const Term* b) { return a->second.size() > b->second.size(); });
+        expanded.resize(kMaxPrefixTerms);
+    }
+    terms.insert(terms.end(), expanded.begin(), expanded.end());
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+    return terms;
+}
+
+double AddressIndex::idf(const Term& term) const
+{
+    const double n = static_cast<double>(m_documents);
+    const double df = static_cast<double>(term.second.size());
+    return std::log(1.0 + (n - df + 0.5) / (df + 0.5));
+}
+
+double AddressIndex::weight(const Posting& posting, double idf) const
+{
+    const double averageLength = static_cast<double>(m_totalLength) / static_cast<double>(m_documents);
+    const double tf = posting.frequency;
+    const double norm = kK1 * (1.0 - kB + kB * posting.length / averageLength);
+    return idf * tf * (kK1 + 1.0) / (tf + norm);
+}
+
+std::vector<AddressIndex::Hit> AddressIndex::search(std::string_view query, std::size_t k) const
+{
+    std::vector<Hit> hits;
+    if (k == 0 || m_documents == 0) return hits;
+
+    const std::vector<const Term*> terms = queryTerms(query);
+    if (terms.empty()) return hits;
+
+    struct Cursor {
+        const std::vector<Posting>* list;
+        std::size_t pos;
+        double idf;
+    };
+    std::vector<Cursor> cursors;
+    cursors.reserve(terms.size());
+    for (const Term* term : terms) {
+        cursors.push_back({ &term->second, 0, idf(*term) });
+    }
+
+    // The k best so far, worst on top: the one to beat.
+    auto better = [](const Hit& a, const Hit& b) {
+        return a.score != b.score ? a.score > b.score : a.id < b.id;
+    };
+    std::priority_queue<Hit, std::vector<Hit>, decltype(better)> best(better);
+
+    // Document at a time: the smallest id under any cursor is scored by
+    // every cursor sitting on it, then those cursors advance.
+    const ContactId kDone = std::numeric_limits<ContactId>::max();
+    for (;;) {
+        ContactId id = kDone;
+        for (const Cursor& c : cursors) {
+            if (c.pos < c.list->size()) id = std::min(id, (*c.list)[c.pos].id);
+        }
+        if (id == kDone) break;
+
+        double score = 0.0;
+        for (Cursor& c : cursors) {
+            if (c.pos >= c.list->size() || (*c.list)[c.pos].id != id) continue;
+            score += weight((*c.list)[c.pos++], c.idf);
+        }
+
+        const Hit hit{ id, score };
+        if (best.size() < k) {
+            best.push(hit);
+        }
+        else if (better(hit, best.top())) {
+            best.pop();
+            best.push(hit);
+        }
+    }
+
+    hits.reserve(best.size());
+    while (!best.empty()) {
+        hits.push_back(best.top());
+        best.pop();
+    }
+    std::reverse(hits.begin(), hits.end());
+    return hits;
+}
+
+double AddressIndex::score(std::string_view query, ContactId id) const
+{
+    if (m_documents == 0) return 0.0;
+
+    double total = 0.0;
+    for (const Term* term : queryTerms(query)) {
+        const std::vector<Posting>& list = term->second;
+        auto pos = std::lower_bound(list.begin(), list.end(), id,
+                                    [](const Posting& p, ContactId v) { return p.id < v; });
+        if (pos != list.end() && pos->id == id) total += weight(*pos, idf(*term));
+    }
+    return total;
+}
+
+std::size_t AddressIndex::estimate(std::string_view query) const
+{
+    std::vector<std::string> tokens = tokenize(query);
+    if (tokens.empty()) return m_documents;
+
+    std::size_t smallest = m_documents;
+    for (std::size_t i = 0; i + 1 < tokens.size(); ++i) {
+        auto it = m_postings.find(tokens[i]);
+        if (it == m_postings.end()) return 0;
+        smallest = std::min(smallest, it->second.size());
+    }
+
+    const std::string& last = tokens.back();
+    std::size_t prefixed = 0;
+    for (auto it = m_postings.lower_bound(last);
+         it != m_postings.end() && it->first.compare(0, last.size(), last) == 0 && prefixed < smallest; ++it) {
+        prefixed += it->second.size();
+    }
+    return std::min(smallest, prefixed);
+}
+
+std::vector<ContactId> AddressIndex::matching(std::string_view query) const
+{
+    std::vector<ContactId> result;
+    std::vector<std::string> tokens = tokenize(query);
+    if (tokens.empty()) return result;
+
+    // Ids under the last token's prefix, then narrowed by every other
+    // token, shortest posting list first.
+    const std::string last = tokens.back();
+    tokens.pop_back();
+    std::vector<const std::vector<Posting>*> lists;
+    for (const std::string& token : tokens) {
+        auto it = m_postings.find(token);
+        if (it == m_postings.end()) return result;
+        lists.push_back(&it->second);
+    }
+    std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b) { return a->size() < b->size(); });
+
+    for (auto it = m_postings.lower_bound(last);
+         it != m_postings.end() && it->first.compare(0, last.size(), last) == 0; ++it) {
+        for (const Posting& p : it->second) result.push_back(p.id);
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+
+    for (const std::vector<Posting>* list : lists) {
+        auto keep = std::remove_if(result.begin(), result.end(), [list](ContactId id) {
+            auto pos = std::lower_bound(list->begin(), list->end(), id,
+                                        [](const Posting& p, ContactId v) { return p.id < v; });
+            return pos == list->end() || pos->id != id;
+        });
+        result.erase(keep, result.end());
+        if (result.empty()) break;
+    }
+    return result;
+}
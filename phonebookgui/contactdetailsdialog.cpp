@@ -5,6 +5,10 @@
 #include <QPushButton>
 #include <QVBoxLayout>
 
+#include <string_view>
+
+static QString qs(std::string_view s) { return QString::fromUtf8(s.data(), static_cast<int>(s.size())); }
+
 static QLabel* makeLabel(const QString& s, QWidget* parent)
 {
     auto* l = new QLabel(s, parent);
@@ -13,7 +17,7 @@ static QLabel* makeLabel(const QString& s, QWidget* parent)
     return l;
 }
 
-ContactDetailsDialog::ContactDetailsDialog(unsigned int id, const Contact& c, QWidget* parent)
+ContactDetailsDialog::ContactDetailsDialog(ContactId id, const ContactView& c, QWidget* parent)
     : QDialog(parent)
 {
     setWindowTitle(QString("Contact Details (ID: %1)").arg(id));
@@ -23,17 +27,17 @@ ContactDetailsDialog::ContactDetailsDialog(unsigned int id, const Contact& c, QW
     auto* form = new QFormLayout();
     root->addLayout(form);
 
-    form->addRow("First name:",  makeLabel(QString::fromStdString(c.firstName), this));
-    form->addRow("Middle name:", makeLabel(QString::fromStdString(c.middleName), this));
-    form->addRow("Last name:",   makeLabel(QString::fromStdString(c.lastName), this));
+    form->addRow("First name:",  makeLabel(qs(c.firstName), this));
+    form->addRow("Middle name:", makeLabel(qs(c.middleName), this));
+    form->addRow("Last name:",   makeLabel(qs(c.lastName), this));
 
-    form->addRow("Email:",   makeLabel(QString::fromStdString(c.email), this));
-    form->addRow("Address:", makeLabel(QString::fromStdString(c.address), this));
-    form->addRow("Birthday:",makeLabel(QString::fromStdString(c.birthday), this));
+    form->addRow("Email:",   makeLabel(qs(c.email), this));
+    form->addRow("Address:", makeLabel(qs(c.address), this));
+    form->addRow("Birthday:",makeLabel(qs(c.birthday), this));
 
-    form->addRow("Work phone:",   makeLabel(QString::fromStdString(c.numbers.number1), this));
-    form->addRow("Home phone:",   makeLabel(QString::fromStdString(c.numbers.number2), this));
-    form->addRow("Office phone:", makeLabel(QString::fromStdString(c.numbers.number3), this));
+    form->addRow("Work phone:",   makeLabel(qs(c.numbers.number1), this));
+    form->addRow("Home phone:",   makeLabel(qs(c.numbers.number2), this));
+    form->addRow("Office phone:", makeLabel(qs(c.numbers.number3), this));
 
     auto* closeBtn = new QPushButton("Close", this);
     connect(closeBtn, &QPushButton::clicked, this, &QDialog::accept);
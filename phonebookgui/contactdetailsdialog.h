@@ -2,13 +2,13 @@
 #define CONTACTDETAILSDIALOG_H
 
 #include <QDialog>
-#include "Contactgui.h"
+#include "ContactRecordgui.h"
 
 class ContactDetailsDialog : public QDialog
 {
     Q_OBJECT
 public:
-    explicit ContactDetailsDialog(unsigned int id, const Contact& c, QWidget* parent = nullptr);
+    explicit ContactDetailsDialog(ContactId id, const ContactView& c, QWidget* parent = nullptr);
 };
 
 #endif // CONTACTDETAILSDIALOG_H
@@ -0,0 +1,235 @@
+#include "ContactRecordgui.h"
+
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+// ---------- Fields ----------
+
+std::string& contactField(Contact& contact, ContactField field)
+{
+    switch (field) {
+    case ContactField::FirstName:   return contact.firstName;
+    case ContactField::MiddleName:  return contact.middleName;
+    case ContactField::LastName:    return contact.lastName;
+    case ContactField::WorkPhone:   return contact.numbers.number1;
+    case ContactField::HomePhone:   return contact.numbers.number2;
+    case ContactField::OfficePhone: return contact.numbers.number3;
+    case ContactField::Email:       return contact.email;
+    case ContactField::Address:     return contact.address;
+    case ContactField::Birthday:    break;
+    }
+    return contact.birthday;
+}
+
+const std::string& contactField(const Contact& contact, ContactField field)
+{
+    return contactField(const_cast<Contact&>(contact), field);
+}
+
+// ---------- ContactView ----------
+
+ContactView::ContactView(const Contact& contact)
+    : firstName(contact.firstName), middleName(contact.middleName), lastName(contact.lastName),
+      numbers{ contact.numbers.number1, contact.numbers.number2, contact.numbers.number3 },
+      email(contact.email), address(contact.address), birthday(contact.birthday)
+{
+}
+
+ContactView::ContactView(const ContactRecord& record)
+    : firstName(record.field(ContactField::FirstName)),
+      middleName(record.field(ContactField::MiddleName)),
+      lastName(record.field(ContactField::LastName)),
+      numbers{ record.field(ContactField::WorkPhone), record.field(ContactField::HomePhone),
+               record.field(ContactField::OfficePhone) },
+      email(record.field(ContactField::Email)),
+      address(record.field(ContactField::Address)),
+      birthday(record.field(ContactField::Birthday))
+{
+}
+
+std::string_view ContactView::field(ContactField field) const
+{
+    switch (field) {
+    case ContactField::FirstName:   return firstName;
+    case ContactField::MiddleName:  return middleName;
+    case ContactField::LastName:    return lastName;
+    case ContactField::WorkPhone:   return numbers.number1;
+    case ContactField::HomePhone:   return numbers.number2;
+    case ContactField::OfficePhone: return numbers.number3;
+    case ContactField::Email:       return email;
+    case ContactField::Address:     return address;
+    case ContactField::Birthday:    break;
+    }
+    return birthday;
+}
+
+Contact ContactView::to_contact() const
+{
+    return Contact(std::string(firstName), std::string(middleName), std::string(lastName),
+                   Phone(std::string(numbers.number1), std::string(numbers.number2), std::string(numbers.number3)),
+                   std::string(email), std::string(address), std::string(birthday));
+}
+
+bool ContactView::same_fields(const ContactView& other) const
+{
+    for (std::size_t f = 0; f < kContactFieldCount; ++f) {
+        if (field(static_cast<ContactField>(f)) != other.field(static_cast<ContactField>(f))) return false;
+    }
+    return true;
+}
+
+void ContactView::print_contact() const
+{
+    std::cout << "First name: " << firstName << std::endl
+              << "Middle Name: " << middleName << std::endl
+              << "Last Name: " << lastName << std::endl;
+    std::cout << "Work: " << numbers.number1 << std::endl << "Home: " << numbers.number2 << std::endl
+              << "office: " << numbers.number3 << std::endl;
+    std::cout << "Email: " << email << std::endl
+              << "Address: " << address << std::endl
+              << "Birthday: " << birthday << std::endl;
+}
+
+// ---------- ContactRecord ----------
+
+namespace {
+
+// Block layout: [width][end x 9][bytes]. width is 2 or 4 (bytes per end
+// offset); end[i] is where field i stops, relative to the bytes.
+constexpr std::size_t kHeader = 1;
+
+std::size_t readEnd(const unsigned char* block, std::size_t i)
+{
+    const unsigned char* at = block + kHeader + i * block[0];
+    if (block[0] == 2) {
+        std::uint16_t end;
+        std::memcpy(&end, at, sizeof(end));
+        return end;
+    }
+    std::uint32_t end;
+    std::memcpy(&end, at, sizeof(end));
+    return end;
+}
+
+const char* fieldBytes(const unsigned char* block)
+{
+    return reinterpret_cast<const char*>(block + kHeader + kContactFieldCount * block[0]);
+}
+
+} // namespace
+
+ContactRecord::ContactRecord(const ContactView& contact, const allocator_type& alloc)
+    : m_resource(alloc.resource())
+{
+    assign(contact);
+}
+
+ContactRecord::ContactRecord(const ContactRecord& other, const allocator_type& alloc)
+    : m_resource(alloc.resource())
+{
+    assign(other.view());
+}
+
+ContactRecord::ContactRecord(ContactRecord&& other) noexcept
+    : m_block(std::exchange(other.m_block, nullptr)), m_resource(other.m_resource)
+{
+}
+
+ContactRecord::ContactRecord(ContactRecord&& other, const allocator_type& alloc)
+    : m_resource(alloc.resource())
+{
+    if (m_resource->is_equal(*other.m_resource)) m_block = std::exchange(other.m_block, nullptr);
+    else assign(other.view());
+}
+
+ContactRecord& ContactRecord::operator=(const ContactRecord& other)
+{
+    if (this != &other) assign(other.view());
+    return *this;
+}
+
+// The block stays with this record's resource, as for pmr strings.
+ContactRecord& ContactRecord::operator=(ContactRecord&& other)
+{
+    if (this == &other) return *this;
+    if (m_resource->is_equal(*other.m_resource)) {
+        release();
+        m_block = std::exchange(other.m_block, nullptr);
+    }
+    else {
+        assign(other.view());
+    }
+    return *this;
+}
+
+ContactRecord& ContactRecord::operator=(const ContactView& contact)
+{
+    assign(contact);
+    return *this;
+}
+
+ContactRecord::~ContactRecord()
+{
+    release();
+}
+
+std::string_view ContactRecord::field(ContactField field) const
+{
+    if (!m_block) return {};
+    const std::size_t i = static_cast<std::size_t>(field);
+    const std::size_t begin = i == 0 ? 0 : readEnd(m_block, i - 1);
+    return std::string_view(fieldBytes(m_block) + begin, readEnd(m_block, i) - begin);
+}
+
+std::size_t ContactRecord::block_size() const
+{
+    if (!m_block) return 0;
+    return kHeader + kContactFieldCount * m_block[0] + readEnd(m_block, kContactFieldCount - 1);
+}
+
+// Encodes into a new block before freeing the old one, so `contact` may
+// view this record.
+void ContactRecord::assign(const ContactView& contact)
+{
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < kContactFieldCount; ++i) {
+        total += contact.field(static_cast<ContactField>(i)).size();
+    }
+
+    unsigned char* block = nullptr;
+    if (total > 0) {
+        const unsigned char width = total <= 0xFFFF ? 2 : 4;
+        block = static_cast<unsigned char*>(
+            m_resource->allocate(kHeader + kContactFieldCount * width + total, 1));
+        block[0] = width;
+
+        char* bytes = reinterpret_cast<char*>(block + kHeader + kContactFieldCount * width);
+        std::size_t end = 0;
+        for (std::size_t i = 0; i < kContactFieldCount; ++i) {
+            const std::string_view value = contact.field(static_cast<ContactField>(i));
+            if (!value.empty()) std::memcpy(bytes + end, value.data(), value.size());
+            end += value.size();
+
+            unsigned char* at = block + kHeader + i * width;
+            if (width == 2) {
+                const std::uint16_t end16 = static_cast<std::uint16_t>(end);
+                std::memcpy(at, &end16, sizeof(end16));
+            }
+            else {
+                const std::uint32_t end32 = static_cast<std::uint32_t>(end);
+                std::memcpy(at, &end32, sizeof(end32));
+            }
+        }
+    }
+
+    release();
+    m_block = block;
+}
+
+void ContactRecord::release()
+{
+    if (!m_block) return;
+    m_resource->deallocate(m_block, block_size(), 1);
+    m_block = nullptr;
+}
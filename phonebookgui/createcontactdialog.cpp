@@ -12,6 +12,8 @@
 #include <QPushButton>
 #include <QLabel>
 
+#include <utility>
+
 static std::string toStdTrimmed(const QString& s)
 {
     return s.trimmed().toStdString();
@@ -157,7 +159,7 @@ void CreateContactDialog::onTryCreate()
     }
 
     std::string err;
-    if (!m_book->add_contact(c, &err)) {
+    if (!m_book->add_contact(std::move(c), &err)) {
         QMessageBox::warning(this, "Creation Failed", QString::fromStdString(err));
         return;
     }
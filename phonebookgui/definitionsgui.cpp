@@ -1,14 +1,23 @@
 #include "PhoneBookgui.h"
 #include "Checkersgui.h"
 #include "DatabaseManager.h"
+#include "Dedupgui.h"
+#include "Querygui.h"
 #include <QFile>
+#include <QSaveFile>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QMessageBox>
 
+#include <algorithm>
+#include <string_view>
+#include <utility>
 
-PhoneBook::PhoneBook() : index(0), storageFile("phonebook.db")
+static QString qs(std::string_view s) { return QString::fromUtf8(s.data(), static_cast<int>(s.size())); }
+
+
+PhoneBook::PhoneBook() : arena(64 * 1024), pool(&arena), index(0), storageFile("phonebook.db")
 {
     if (connectToDatabase()) {
         qDebug() << "Using PostgreSQL database";
@@ -33,6 +42,7 @@ bool PhoneBook::connectToDatabase(const QString& host, int port,
 
     if (DatabaseManager::instance().connect(host, port, dbName, user, pass)) {
         m_useDatabase = true;
+        history.set_budget(0);   // undo would bypass the database
         return true;
     }
 
@@ -43,22 +53,15 @@ void PhoneBook::refreshCacheFromDatabase()
 {
     if (!m_useDatabase) return;
 
-    mainStorage.clear();
-    firstNameIndex.clear();
-    lastNameIndex.clear();
-    phoneWorkIndex.clear();
-    phoneHomeIndex.clear();
-    phoneOfficeIndex.clear();
-    emailIndex.clear();
-
     auto contacts = DatabaseManager::instance().getAllContacts();
 
-    unsigned int maxId = 0;
-    for (const auto& pair : contacts) {
-        unsigned int id = pair.first;
-        const Contact& c = pair.second;
+    reset_storage(static_cast<std::size_t>(contacts.size()));
+
+    ContactId maxId = 0;
+    for (auto& pair : contacts) {
+        ContactId id = pair.first;
+        Contact& c = pair.second;
 
-        mainStorage[id] = c;
         maxId = std::max(maxId, id);
 
         if (!c.firstName.empty()) firstNameIndex[c.firstName] = id;
@@ -66,22 +69,382 @@ void PhoneBook::refreshCacheFromDatabase()
         if (!c.numbers.number1.empty()) phoneWorkIndex[c.numbers.number1] = id;
         if (!c.numbers.number2.empty()) phoneHomeIndex[c.numbers.number2] = id;
         if (!c.numbers.number3.empty()) phoneOfficeIndex[c.numbers.number3] = id;
+        index_phone(id, c.numbers.number1);
+        index_phone(id, c.numbers.number2);
+        index_phone(id, c.numbers.number3);
         if (!c.email.empty()) emailIndex[c.email] = id;
+        index_email_domain(id, c.email);
+        addressIndex.add(id, c.address);
+        index_ordered(id, c);
+
+        mainStorage[id] = c;
     }
 
     index = maxId;
+    rebuild_filters();
+    publish_reset();
+}
+
+// Memory resources are not copyable: the copy gets its own arena/pool
+// and the tables are copied into it.
+PhoneBook::PhoneBook(const PhoneBook& other)
+    : arena(64 * 1024), pool(&arena), index(other.index),
+      mainStorage(other.mainStorage, &pool),
+      firstNameIndex(other.firstNameIndex, &pool),
+      lastNameIndex(other.lastNameIndex, &pool),
+      phoneWorkIndex(other.phoneWorkIndex, &pool),
+      phoneHomeIndex(other.phoneHomeIndex, &pool),
+      phoneOfficeIndex(other.phoneOfficeIndex, &pool),
+      emailIndex(other.emailIndex, &pool),
+      emailDomainIndex(other.emailDomainIndex, &pool),
+      phoneKeyIndex(other.phoneKeyIndex, &pool),
+      addressIndex(other.addressIndex),
+      firstNameOrder(other.firstNameOrder),
+      lastNameOrder(other.lastNameOrder),
+      phoneSuffixIndex(other.phoneSuffixIndex),
+      birthdayIndex(other.birthdayIndex),
+      storageFile(other.storageFile),
+      m_useDatabase(other.m_useDatabase),
+      history(other.history),
+      emailFilter(other.emailFilter),
+      phoneFilter(other.phoneFilter)
+{
+}
+
+void PhoneBook::reset_storage(std::size_t expectedContacts)
+{
+    // The history describes the book being dropped.
+    history.clear();
+    pendingBefore.clear();
+
+    // Destroy every table, then release the arena in one go instead of
+    // freeing index keys and table arrays one by one.
+    mainStorage.reset();
+    firstNameIndex.reset();
+    lastNameIndex.reset();
+    phoneWorkIndex.reset();
+    phoneHomeIndex.reset();
+    phoneOfficeIndex.reset();
+    emailIndex.reset();
+    emailDomainIndex.reset();
+    phoneKeyIndex.reset();
+    addressIndex.clear();
+    firstNameOrder.clear();
+    lastNameOrder.clear();
+    phoneSuffixIndex.clear();
+    birthdayIndex.clear();
+    pool.release();
+    arena.release();
+
+    // Size every table once for the bulk load that follows.
+    mainStorage.reserve(expectedContacts);
+    firstNameIndex.reserve(expectedContacts);
+    lastNameIndex.reserve(expectedContacts);
+    phoneWorkIndex.reserve(expectedContacts);
+    phoneHomeIndex.reserve(expectedContacts);
+    phoneOfficeIndex.reserve(expectedContacts);
+    emailIndex.reserve(expectedContacts);
+}
+
+// Posting lists stay sorted: new ids are the largest, so inserts are
+// appends; removal is a binary search.
+void PhoneBook::index_email_domain(ContactId id, std::string_view email)
+{
+    if (email.empty()) return;
+    std::pmr::vector<ContactId>& ids = emailDomainIndex[emailDomain(email)];
+    if (ids.empty() || ids.back() < id) {
+        ids.push_back(id);
+        return;
+    }
+    auto pos = std::lower_bound(ids.begin(), ids.end(), id);
+    if (pos == ids.end() || *pos != id) ids.insert(pos, id);
+}
+
+void PhoneBook::unindex_email_domain(ContactId id, std::string_view email)
+{
+    if (email.empty()) return;
+    auto it = emailDomainIndex.find(emailDomain(email));
+    if (it == emailDomainIndex.end()) return;
+
+    std::pmr::vector<ContactId>& ids = it->second;
+    auto pos = std::lower_bound(ids.begin(), ids.end(), id);
+    if (pos != ids.end() && *pos == id) ids.erase(pos);
+    if (ids.empty()) emailDomainIndex.erase(it);
+}
+
+void PhoneBook::index_ordered(ContactId id, const ContactView& contact)
+{
+    firstNameOrder.add(nameKey(contact.firstName), id);
+    lastNameOrder.add(nameKey(contact.lastName), id);
+    for (std::string_view phone : { contact.numbers.number1, contact.numbers.number2, contact.numbers.number3 }) {
+        if (!phone.empty()) phoneSuffixIndex.add(phoneSuffixKey(phone), id);
+    }
+    if (!contact.birthday.empty()) birthdayIndex.add(birthdayKey(contact.birthday), id);
+}
+
+void PhoneBook::unindex_ordered(ContactId id, const ContactView& contact)
+{
+    firstNameOrder.remove(nameKey(contact.firstName), id);
+    lastNameOrder.remove(nameKey(contact.lastName), id);
+    for (std::string_view phone : { contact.numbers.number1, contact.numbers.number2, contact.numbers.number3 }) {
+        if (!phone.empty()) phoneSuffixIndex.remove(phoneSuffixKey(phone), id);
+    }
+    if (!contact.birthday.empty()) birthdayIndex.remove(birthdayKey(contact.birthday), id);
+}
+
+// Every index entry of a contact, as add_contact() makes them.
+void PhoneBook::index_contact(ContactId id, const ContactView& contact)
+{
+    firstNameIndex[contact.firstName] = id;
+    lastNameIndex[contact.lastName] = id;
+    emailIndex[contact.email] = id;
+    index_email_domain(id, contact.email);
+    addressIndex.add(id, contact.address);
+    index_ordered(id, contact);
+
+    if (!contact.numbers.number1.empty()) phoneWorkIndex[contact.numbers.number1] = id;
+    if (!contact.numbers.number2.empty()) phoneHomeIndex[contact.numbers.number2] = id;
+    if (!contact.numbers.number3.empty()) phoneOfficeIndex[contact.numbers.number3] = id;
+    index_phone(id, contact.numbers.number1);
+    index_phone(id, contact.numbers.number2);
+    index_phone(id, contact.numbers.number3);
+}
+
+// Removes the entries that still point at `id`.
+void PhoneBook::unindex_contact(ContactId id, const ContactView& contact)
+{
+    auto eraseIfMatches = [&](auto& mp, std::string_view key) {
+        if (key.empty()) return;
+        auto ix = mp.find(key);
+        if (ix != mp.end() && ix->second == id) mp.erase(ix);
+    };
+
+    eraseIfMatches(firstNameIndex, contact.firstName);
+    eraseIfMatches(lastNameIndex,  contact.lastName);
+    eraseIfMatches(emailIndex,     contact.email);
+    unindex_email_domain(id, contact.email);
+    addressIndex.remove(id, contact.address);
+    unindex_ordered(id, contact);
+
+    eraseIfMatches(phoneWorkIndex,   contact.numbers.number1);
+    eraseIfMatches(phoneHomeIndex,   contact.numbers.number2);
+    eraseIfMatches(phoneOfficeIndex, contact.numbers.number3);
+    unindex_phone(id, contact.numbers.number1);
+    unindex_phone(id, contact.numbers.number2);
+    unindex_phone(id, contact.numbers.number3);
+}
+
+// ---------- Batches ----------
+
+bool PhoneBook::begin_batch(std::string* error)
+{
+    if (batchOpen) {
+        if (error) *error = "A batch is already open.";
+        return false;
+    }
+    if (m_useDatabase && !DatabaseManager::instance().beginBatch()) {
+        if (error) *error = DatabaseManager::instance().lastError().toStdString();
+        return false;
+    }
+    record_step();
+    batchOpen = true;
+    batchIndex = index;
+    return true;
+}
+
+bool PhoneBook::commit_batch(std::string* error)
+{
+    auto fail = [&](const std::string& msg) {
+        if (error) *error = msg;
+        return false;
+    };
+    if (!batchOpen) return fail("No batch is open.");
+
+    if (m_useDatabase && !DatabaseManager::instance().commitBatch()) {
+        const std::string cause = DatabaseManager::instance().lastError().toStdString();
+        rollback_batch();
+        return fail(cause);
+    }
+    batchOpen = false;
+    const bool changed = !pendingBefore.empty();
+    record_step();
+    if (changed && !m_useDatabase && !save_to_file()) {
+        return fail("Batch applied, but failed to save to file.");
+    }
+    return true;
 }
 
-PhoneBook::PhoneBook(const PhoneBook& other) = default;
+void PhoneBook::rollback_batch()
+{
+    if (!batchOpen) return;
+    if (m_useDatabase) (void)DatabaseManager::instance().rollbackBatch();
+
+    for (const auto& pair : pendingBefore) {
+        const ContactId id = pair.first;
+        auto it = mainStorage.find(id);
+        if (it != mainStorage.end()) {
+            unindex_contact(id, it->second);
+            mainStorage.erase(id);
+        }
+        if (pair.second) {
+            mainStorage[id] = *pair.second;
+            index_contact(id, *pair.second);
+            // A filter rebuilt during the batch no longer has this
+            // contact's keys.
+            remember_keys(*pair.second);
+        }
+    }
+    // The filters may keep keys of contacts the batch added; they only
+    // cost an index lookup on a later duplicate check.
+    index = batchIndex;
+    batchOpen = false;
+    pendingBefore.clear();
+}
+
+void PhoneBook::remember_before(ContactId id)
+{
+    if (!batchOpen && !history.enabled() && changes.empty()) return;
+    if (pendingBefore.find(id) != pendingBefore.end()) return;
+    auto it = mainStorage.find(id);
+    if (it == mainStorage.end()) pendingBefore[id] = std::nullopt;
+    else pendingBefore[id] = it->second;
+}
+
+bool PhoneBook::persist()
+{
+    if (batchOpen) return true;
+    record_step();
+    return m_useDatabase || save_to_file();   // the database is the record: no file save
+}
+
+std::vector<ContactId> PhoneBook::contacts_at_domain(std::string_view domain) const
+{
+    auto it = emailDomainIndex.find(emailDomain(domain));
+    if (it == emailDomainIndex.end()) return {};
+    return std::vector<ContactId>(it->second.begin(), it->second.end());
+}
+
+std::size_t PhoneBook::domain_count(std::string_view domain) const
+{
+    auto it = emailDomainIndex.find(emailDomain(domain));
+    return it == emailDomainIndex.end() ? 0 : it->second.size();
+}
+
+std::vector<std::pair<std::string, std::size_t>> PhoneBook::domain_counts() const
+{
+    std::vector<std::pair<std::string, std::size_t>> counts;
+    counts.reserve(emailDomainIndex.size());
+    for (const auto& pair : emailDomainIndex) {
+        counts.emplace_back(std::string(pair.first), pair.second.size());
+    }
+    std::sort(counts.begin(), counts.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    return counts;
+}
+
+// Phones are compared in normalized form, so "8(999)123-45-67" and
+// "+79991234567" are the same number. Unrecognized numbers compare as-is.
+static std::string phoneKey(std::string_view phone)
+{
+    std::string normalized = normalizePhone(phone);
+    return normalized.empty() ? std::string(phone) : normalized;
+}
+
+// A contact listing a number twice holds its id twice, so dropping one of
+// the two phones leaves the other in.
+void PhoneBook::index_phone(ContactId id, std::string_view phone)
+{
+    if (phone.empty()) return;
+    std::pmr::vector<ContactId>& ids = phoneKeyIndex[phoneKey(phone)];
+    ids.insert(std::upper_bound(ids.begin(), ids.end(), id), id);
+}
+
+void PhoneBook::unindex_phone(ContactId id, std::string_view phone)
+{
+    if (phone.empty()) return;
+    auto it = phoneKeyIndex.find(phoneKey(phone));
+    if (it == phoneKeyIndex.end()) return;
+
+    std::pmr::vector<ContactId>& ids = it->second;
+    auto pos = std::lower_bound(ids.begin(), ids.end(), id);
+    if (pos != ids.end() && *pos == id) ids.erase(pos);
+    if (ids.empty()) phoneKeyIndex.erase(it);
+}
+
+void PhoneBook::rebuild_filters()
+{
+    // Headroom so the next interactive inserts do not force a rebuild.
+    const std::size_t expected = mainStorage.size() + mainStorage.size() / 4;
+    emailFilter.reset(expected);
+    phoneFilter.reset(expected * 3);
+
+    for (const auto& pair : mainStorage) {
+        const ContactView c = pair.second;
+        if (!c.email.empty()) emailFilter.insert(c.email);
+        for (std::string_view phone : { c.numbers.number1, c.numbers.number2, c.numbers.number3 }) {
+            if (!phone.empty()) phoneFilter.insert(phoneKey(phone));
+        }
+    }
+}
+
+// Call after the contact holding the key is stored.
+void PhoneBook::remember_email(std::string_view email)
+{
+    if (email.empty()) return;
+    emailFilter.insert(email);
+    if (emailFilter.saturated()) rebuild_filters();
+}
+
+void PhoneBook::remember_phone(std::string_view phone)
+{
+    if (phone.empty()) return;
+    phoneFilter.insert(phoneKey(phone));
+    if (phoneFilter.saturated()) rebuild_filters();
+}
+
+void PhoneBook::remember_keys(const ContactView& contact)
+{
+    remember_email(contact.email);
+    remember_phone(contact.numbers.number1);
+    remember_phone(contact.numbers.number2);
+    remember_phone(contact.numbers.number3);
+}
+
+bool PhoneBook::email_in_use(const std::string& email, ContactId exceptId) const
+{
+    if (email.empty() || !emailFilter.might_contain(email)) {
+        return false;
+    }
+    auto it = emailIndex.find(email);
+    return it != emailIndex.end() && it->second != exceptId;
+}
+
+bool PhoneBook::phone_in_use(const std::string& phone, ContactId exceptId) const
+{
+    if (phone.empty()) return false;
+
+    const std::string key = phoneKey(phone);
+    if (!phoneFilter.might_contain(key)) {
+        return false;
+    }
+
+    // Any spelling of the number, or a filter false positive: one probe.
+    auto it = phoneKeyIndex.find(key);
+    if (it == phoneKeyIndex.end()) return false;
+    return std::any_of(it->second.begin(), it->second.end(), [exceptId](ContactId id) { return id != exceptId; });
+}
 
 PhoneBook::~PhoneBook()
 {
+    // An unfinished batch is not saved.
+    if (batchOpen) rollback_batch();
     // Best-effort save on shutdown (changes are also saved after create/edit/delete).
     (void)save_to_file();
 }
 
-int PhoneBook::get_index() { return static_cast<int>(index); }
-void PhoneBook::set_index(int idx) { index = static_cast<unsigned int>(idx); }
+ContactId PhoneBook::get_index() const { return index; }
+void PhoneBook::set_index(ContactId idx) { index = idx; }
 
 void PhoneBook::set_storage_file(const std::string& filename)
 {
@@ -96,31 +459,35 @@ const std::string& PhoneBook::get_storage_file() const
 bool PhoneBook::save_to_file(const std::string& filename) const
 {
     const std::string fileStd = filename.empty() ? storageFile : filename;
-    QFile f(QString::fromStdString(fileStd));
+    // Written beside the file and renamed over it on commit(), so a
+    // failed save leaves the previous file intact.
+    QSaveFile f(QString::fromStdString(fileStd));
     if (!f.open(QIODevice::WriteOnly)) return false;
 
     QJsonObject root;
     root["version"] = 1;
-    root["index"] = static_cast<int>(index);
+    // Ids are written as decimal strings: a JSON number (a double) is
+    // exact only up to 2^53.
+    root["index"] = QString::number(index);
 
     QJsonArray contacts;
     for (const auto& pair : mainStorage) {
-        const unsigned int id = pair.first;
-        const Contact& c = pair.second;
+        const ContactId id = pair.first;
+        const ContactView c = pair.second;
 
         QJsonObject o;
-        o["id"] = static_cast<int>(id);
-        o["firstName"] = QString::fromStdString(c.firstName);
-        o["middleName"] = QString::fromStdString(c.middleName);
-        o["lastName"] = QString::fromStdString(c.lastName);
-        o["email"] = QString::fromStdString(c.email);
-        o["address"] = QString::fromStdString(c.address);
-        o["birthday"] = QString::fromStdString(c.birthday);
+        o["id"] = QString::number(id);
+        o["firstName"] = qs(c.firstName);
+        o["middleName"] = qs(c.middleName);
+        o["lastName"] = qs(c.lastName);
+        o["email"] = qs(c.email);
+        o["address"] = qs(c.address);
+        o["birthday"] = qs(c.birthday);
 
         QJsonObject phones;
-        phones["work"] = QString::fromStdString(c.numbers.number1);
-        phones["home"] = QString::fromStdString(c.numbers.number2);
-        phones["office"] = QString::fromStdString(c.numbers.number3);
+        phones["work"] = qs(c.numbers.number1);
+        phones["home"] = qs(c.numbers.number2);
+        phones["office"] = qs(c.numbers.number3);
         o["phones"] = phones;
 
         contacts.append(o);
@@ -130,7 +497,7 @@ bool PhoneBook::save_to_file(const std::string& filename) const
 
     QJsonDocument doc(root);
     f.write(doc.toJson(QJsonDocument::Indented));
-    return true;
+    return f.commit();
 }
 
 bool PhoneBook::load_from_file(const std::string& filename)
@@ -148,23 +515,19 @@ bool PhoneBook::load_from_file(const std::string& filename)
     QJsonObject root = doc.object();
     if (!root.contains("contacts") || !root.value("contacts").isArray()) return false;
 
+    const QJsonArray contacts = root.value("contacts").toArray();
+
     // Reset
-    mainStorage.clear();
-    firstNameIndex.clear();
-    lastNameIndex.clear();
-    phoneWorkIndex.clear();
-    phoneHomeIndex.clear();
-    phoneOfficeIndex.clear();
-    emailIndex.clear();
+    reset_storage(static_cast<std::size_t>(contacts.size()));
 
-    unsigned int maxId = 0;
+    ContactId maxId = 0;
 
-    const QJsonArray contacts = root.value("contacts").toArray();
     for (const QJsonValue& v : contacts) {
         if (!v.isObject()) continue;
         QJsonObject o = v.toObject();
 
-        unsigned int id = static_cast<unsigned int>(o.value("id").toInt(0));
+        // Files from before 64-bit ids hold them as numbers.
+        const ContactId id = o.value("id").toVariant().toULongLong();
         if (id == 0) continue;
 
         Contact c;
@@ -182,7 +545,6 @@ bool PhoneBook::load_from_file(const std::string& filename)
             c.numbers.number3 = p.value("office").toString().toStdString();
         }
 
-        mainStorage[id] = c;
         maxId = std::max(maxId, id);
 
         if (!c.firstName.empty()) firstNameIndex[c.firstName] = id;
@@ -190,73 +552,96 @@ bool PhoneBook::load_from_file(const std::string& filename)
         if (!c.numbers.number1.empty()) phoneWorkIndex[c.numbers.number1] = id;
         if (!c.numbers.number2.empty()) phoneHomeIndex[c.numbers.number2] = id;
         if (!c.numbers.number3.empty()) phoneOfficeIndex[c.numbers.number3] = id;
+        index_phone(id, c.numbers.number1);
+        index_phone(id, c.numbers.number2);
+        index_phone(id, c.numbers.number3);
         if (!c.email.empty()) emailIndex[c.email] = id;
+        index_email_domain(id, c.email);
+        addressIndex.add(id, c.address);
+        index_ordered(id, c);
+
+        mainStorage[id] = c;
     }
 
     index = std::max(index, maxId);
     if (root.contains("index")) {
-        index = std::max(index, static_cast<unsigned int>(root.value("index").toInt(static_cast<int>(index))));
+        index = std::max<ContactId>(index, root.value("index").toVariant().toULongLong());
     }
 
+    rebuild_filters();
+    publish_reset();
     return true;
 }
 
-bool PhoneBook::add_contact(const Contact& contact, std::string* error)
+// Message for the first rule validateContact() reports as broken.
+static std::string contactErrorMessage(std::uint32_t errors)
+{
+    if (errors & ContactError::FirstName)   return "Invalid first name.";
+    if (errors & ContactError::LastName)    return "Invalid last name.";
+    if (errors & ContactError::Email)       return "Invalid email.";
+    if (errors & ContactError::WorkPhone)   return "Invalid phone: Work";
+    if (errors & ContactError::HomePhone)   return "Invalid phone: Home";
+    if (errors & ContactError::OfficePhone) return "Invalid phone: Office";
+    if (errors & ContactError::NoPhone)     return "At least one phone number is required.";
+    if (errors & ContactError::MiddleName)  return "Invalid middle name.";
+    if (errors & ContactError::Address)     return "Invalid address.";
+    return "Invalid birthday (must be dd-mm-yyyy and in the past).";
+}
+
+bool PhoneBook::add_contact(Contact contact, std::string* error)
 {
     auto fail = [&](const std::string& msg) {
         if (error) *error = msg;
         return false;
     };
 
-    // Required: first/last/email + at least one phone (Task requirements)
-    if (!isValidName(contact.firstName)) return fail("Invalid first name.");
-    if (!isValidName(contact.lastName))  return fail("Invalid last name.");
-    if (!isValidEmail(contact.email))    return fail("Invalid email.");
-
-    bool hasAtLeastOnePhone = false;
-
-    auto checkPhone = [&](const std::string& p, const char* label) -> bool {
-        if (p.empty()) return true;
-        if (!isValidPhone(p)) {
-            return fail(std::string("Invalid phone: ") + label);
-        }
-        hasAtLeastOnePhone = true;
-        return true;
-    };
-
-    if (!checkPhone(contact.numbers.number1, "Work")) return false;
-    if (!checkPhone(contact.numbers.number2, "Home")) return false;
-    if (!checkPhone(contact.numbers.number3, "Office")) return false;
-
-    if (!hasAtLeastOnePhone) return fail("At least one phone number is required.");
+    // Required: first/last/email + at least one phone (Task requirements);
+    // optional fields validated if present
+    if (const std::uint32_t errors = validateContact(contact)) {
+        return fail(contactErrorMessage(errors));
+    }
 
-    // Optional fields validated if present
-    if (!contact.middleName.empty() && !isValidName(contact.middleName))
-        return fail("Invalid middle name.");
+    // Checked here, before a database round trip that would fail on
+    // the UNIQUE constraint.
+    if (email_in_use(contact.email)) {
+        return fail("A contact with this email already exists.");
+    }
 
-    if (!contact.birthday.empty() && !isValidBirthday(contact.birthday))
-        return fail("Invalid birthday (must be dd-mm-yyyy and in the past).");
     if (m_useDatabase) {
-        unsigned int newId = 0;
+        ContactId newId = 0;
         if (!DatabaseManager::instance().createContact(contact, &newId)) {
             return fail(DatabaseManager::instance().lastError().toStdString());
         }
 
         // Update cache
+        remember_before(newId);
         mainStorage[newId] = contact;
         firstNameIndex[contact.firstName] = newId;
         lastNameIndex[contact.lastName] = newId;
         emailIndex[contact.email] = newId;
+        index_email_domain(newId, contact.email);
+        addressIndex.add(newId, contact.address);
+        index_ordered(newId, contact);
 
         if (!contact.numbers.number1.empty()) phoneWorkIndex[contact.numbers.number1] = newId;
         if (!contact.numbers.number2.empty()) phoneHomeIndex[contact.numbers.number2] = newId;
         if (!contact.numbers.number3.empty()) phoneOfficeIndex[contact.numbers.number3] = newId;
+        index_phone(newId, contact.numbers.number1);
+        index_phone(newId, contact.numbers.number2);
+        index_phone(newId, contact.numbers.number3);
+
+        remember_email(contact.email);
+        remember_phone(contact.numbers.number1);
+        remember_phone(contact.numbers.number2);
+        remember_phone(contact.numbers.number3);
 
         index = std::max(index, newId);
+        if (!batchOpen) record_step();   // the database is the record: no file save
         return true;
     }
     // Store + indices
-    const unsigned int newId = ++index;
+    const ContactId newId = ++index;
+    remember_before(newId);
     mainStorage[newId] = contact;
 
     firstNameIndex[contact.firstName] = newId;
@@ -265,17 +650,37 @@ bool PhoneBook::add_contact(const Contact& contact, std::string* error)
     if (!contact.numbers.number1.empty()) phoneWorkIndex[contact.numbers.number1] = newId;
     if (!contact.numbers.number2.empty()) phoneHomeIndex[contact.numbers.number2] = newId;
     if (!contact.numbers.number3.empty()) phoneOfficeIndex[contact.numbers.number3] = newId;
+    index_phone(newId, contact.numbers.number1);
+    index_phone(newId, contact.numbers.number2);
+    index_phone(newId, contact.numbers.number3);
 
     emailIndex[contact.email] = newId;
 
-    if (!save_to_file()) {
+    index_email_domain(newId, contact.email);
+    addressIndex.add(newId, contact.address);
+    index_ordered(newId, contact);
+
+    remember_email(contact.email);
+    remember_phone(contact.numbers.number1);
+    remember_phone(contact.numbers.number2);
+    remember_phone(contact.numbers.number3);
+
+    if (!persist()) {
         // contact is still created; we just report persistence issue
         return fail("Contact created, but failed to save to file.");
     }
 
     return true;
 }
-bool PhoneBook::get_contact(unsigned int id, Contact* out) const
+bool PhoneBook::get_contact(ContactId id, Contact* out) const
+{
+    auto it = mainStorage.find(id);
+    if (it == mainStorage.end()) return false;
+    if (out) *out = it->second.to_contact();
+    return true;
+}
+
+bool PhoneBook::find_contact(ContactId id, ContactView* out) const
 {
     auto it = mainStorage.find(id);
     if (it == mainStorage.end()) return false;
@@ -283,7 +688,7 @@ bool PhoneBook::get_contact(unsigned int id, Contact* out) const
     return true;
 }
 
-bool PhoneBook::remove_contact(unsigned int id, std::string* error)
+bool PhoneBook::remove_contact(ContactId id, std::string* error)
 {
     auto fail = [&](const std::string& msg) {
         if (error) *error = msg;
@@ -293,10 +698,17 @@ bool PhoneBook::remove_contact(unsigned int id, std::string* error)
     auto it = mainStorage.find(id);
     if (it == mainStorage.end()) return fail("Contact not found.");
 
-    const Contact& c = it->second;
+    // The database changes first and the cache only if it did. Inside a
+    // batch the delete joins the batch's transaction.
+    if (m_useDatabase && !DatabaseManager::instance().deleteContact(id)) {
+        return fail(DatabaseManager::instance().lastError().toStdString());
+    }
+
+    remember_before(id);
+    const ContactView c = it->second;
 
     // Remove indices safely (only if they point to this ID)
-    auto eraseIfMatches = [&](auto& mp, const std::string& key) {
+    auto eraseIfMatches = [&](auto& mp, std::string_view key) {
         if (key.empty()) return;
         auto ix = mp.find(key);
         if (ix != mp.end() && ix->second == id) mp.erase(ix);
@@ -305,21 +717,27 @@ bool PhoneBook::remove_contact(unsigned int id, std::string* error)
     eraseIfMatches(firstNameIndex, c.firstName);
     eraseIfMatches(lastNameIndex,  c.lastName);
     eraseIfMatches(emailIndex,     c.email);
+    unindex_email_domain(id, c.email);
+    addressIndex.remove(id, c.address);
+    unindex_ordered(id, c);
 
     eraseIfMatches(phoneWorkIndex,   c.numbers.number1);
     eraseIfMatches(phoneHomeIndex,   c.numbers.number2);
     eraseIfMatches(phoneOfficeIndex, c.numbers.number3);
+    unindex_phone(id, c.numbers.number1);
+    unindex_phone(id, c.numbers.number2);
+    unindex_phone(id, c.numbers.number3);
 
     mainStorage.erase(it);
 
-    if (!save_to_file()) {
+    if (!persist()) {
         return fail("Contact deleted, but failed to save to file.");
     }
 
     return true;
 }
 
-bool PhoneBook::update_contact(unsigned int id, const Contact& updated, std::string* error)
+bool PhoneBook::update_contact(ContactId id, Contact updated, std::string* error)
 {
     auto fail = [&](const std::string& msg) {
         if (error) *error = msg;
@@ -329,37 +747,24 @@ bool PhoneBook::update_contact(unsigned int id, const Contact& updated, std::str
     auto it = mainStorage.find(id);
     if (it == mainStorage.end()) return fail("Contact not found.");
 
-    // Validate required fields
-    if (!isValidName(updated.firstName)) return fail("Invalid first name.");
-    if (!isValidName(updated.lastName))  return fail("Invalid last name.");
-    if (!isValidEmail(updated.email))    return fail("Invalid email.");
-
-    bool hasAtLeastOnePhone = false;
-
-    auto checkPhone = [&](const std::string& p, const char* label) -> bool {
-        if (p.empty()) return true;
-        if (!isValidPhone(p)) return fail(std::string("Invalid phone: ") + label);
-        hasAtLeastOnePhone = true;
-        return true;
-    };
-
-    if (!checkPhone(updated.numbers.number1, "Work")) return false;
-    if (!checkPhone(updated.numbers.number2, "Home")) return false;
-    if (!checkPhone(updated.numbers.number3, "Office")) return false;
-
-    if (!hasAtLeastOnePhone) return fail("At least one phone number is required.");
-
-    // Optional validation
-    if (!updated.middleName.empty() && !isValidName(updated.middleName))
-        return fail("Invalid middle name.");
+    // Validate required fields and the optional ones that are filled in
+    if (const std::uint32_t errors = validateContact(updated)) {
+        return fail(contactErrorMessage(errors));
+    }
+    if (email_in_use(updated.email, id)) {
+        return fail("A contact with this email already exists.");
+    }
+    // As in remove_contact(): database first, inside the batch if any.
+    if (m_useDatabase && !DatabaseManager::instance().updateContact(id, updated)) {
+        return fail(DatabaseManager::instance().lastError().toStdString());
+    }
 
-    if (!updated.birthday.empty() && !isValidBirthday(updated.birthday))
-        return fail("Invalid birthday (must be dd-mm-yyyy and in the past).");
+    remember_before(id);
 
     // Remove old indices (only if they point to this ID)
-    const Contact& old = it->second;
+    const ContactView old = it->second;
 
-    auto eraseIfMatches = [&](auto& mp, const std::string& key) {
+    auto eraseIfMatches = [&](auto& mp, std::string_view key) {
         if (key.empty()) return;
         auto ix = mp.find(key);
         if (ix != mp.end() && ix->second == id) mp.erase(ix);
@@ -368,10 +773,16 @@ bool PhoneBook::update_contact(unsigned int id, const Contact& updated, std::str
     eraseIfMatches(firstNameIndex, old.firstName);
     eraseIfMatches(lastNameIndex,  old.lastName);
     eraseIfMatches(emailIndex,     old.email);
+    unindex_email_domain(id, old.email);
+    addressIndex.remove(id, old.address);
+    unindex_ordered(id, old);
 
     eraseIfMatches(phoneWorkIndex,   old.numbers.number1);
     eraseIfMatches(phoneHomeIndex,   old.numbers.number2);
     eraseIfMatches(phoneOfficeIndex, old.numbers.number3);
+    unindex_phone(id, old.numbers.number1);
+    unindex_phone(id, old.numbers.number2);
+    unindex_phone(id, old.numbers.number3);
 
     // Update stored contact
     it->second = updated;
@@ -380,14 +791,93 @@ bool PhoneBook::update_contact(unsigned int id, const Contact& updated, std::str
     firstNameIndex[updated.firstName] = id;
     lastNameIndex[updated.lastName] = id;
     emailIndex[updated.email] = id;
+    index_email_domain(id, updated.email);
+    addressIndex.add(id, updated.address);
+    index_ordered(id, updated);
 
     if (!updated.numbers.number1.empty()) phoneWorkIndex[updated.numbers.number1] = id;
     if (!updated.numbers.number2.empty()) phoneHomeIndex[updated.numbers.number2] = id;
     if (!updated.numbers.number3.empty()) phoneOfficeIndex[updated.numbers.number3] = id;
+    index_phone(id, updated.numbers.number1);
+    index_phone(id, updated.numbers.number2);
+    index_phone(id, updated.numbers.number3);
 
-    if (!save_to_file()) {
+    remember_email(updated.email);
+    remember_phone(updated.numbers.number1);
+    remember_phone(updated.numbers.number2);
+    remember_phone(updated.numbers.number3);
+
+    if (!persist()) {
         return fail("Contact updated, but failed to save to file.");
     }
 
     return true;
 }
+
+// The proposal's contacts all exist as findDuplicates() saw them (when
+// it recorded them), and the merged record would pass update_contact().
+bool PhoneBook::merge_applies(const MergeProposal& proposal) const
+{
+    std::vector<ContactId> ids(1, proposal.keepId);
+    ids.insert(ids.end(), proposal.duplicateIds.begin(), proposal.duplicateIds.end());
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        auto it = mainStorage.find(ids[i]);
+        if (it == mainStorage.end()) return false;
+        if (i < proposal.before.size() && !ContactView(it->second).same_fields(proposal.before[i])) return false;
+    }
+    if (validateContact(proposal.merged) != 0) return false;
+    auto owner = emailIndex.find(proposal.merged.email);
+    return owner == emailIndex.end() || std::find(ids.begin(), ids.end(), owner->second) != ids.end();
+}
+
+bool PhoneBook::apply_merges(const std::vector<MergeProposal>& proposals,
+                             std::size_t* applied, std::string* error)
+{
+    auto fail = [&](const std::string& msg) {
+        if (error) *error = msg;
+        return false;
+    };
+    if (applied) *applied = 0;
+
+    std::vector<const MergeProposal*> current;
+    for (const MergeProposal& proposal : proposals) {
+        if (merge_applies(proposal)) current.push_back(&proposal);
+    }
+    if (current.empty()) return true;
+
+    if (m_useDatabase) {
+        QList<QPair<ContactId, Contact>> keepers;
+        QList<ContactId> duplicateIds;
+        for (const MergeProposal* proposal : current) {
+            keepers.append(qMakePair(proposal->keepId, proposal->merged));
+            for (ContactId id : proposal->duplicateIds) duplicateIds.append(id);
+        }
+        if (!DatabaseManager::instance().mergeContacts(keepers, duplicateIds)) {
+            return fail(DatabaseManager::instance().lastError().toStdString());
+        }
+    }
+
+    for (const MergeProposal* proposal : current) {
+        for (ContactId id : proposal->duplicateIds) {
+            remember_before(id);
+            auto it = mainStorage.find(id);
+            unindex_contact(id, it->second);
+            mainStorage.erase(it);
+        }
+
+        const ContactId id = proposal->keepId;
+        remember_before(id);
+        auto it = mainStorage.find(id);
+        unindex_contact(id, it->second);
+        it->second = proposal->merged;
+        index_contact(id, proposal->merged);
+    }
+
+    rebuild_filters();
+    if (applied) *applied = current.size();
+
+    if (!m_useDatabase && !persist()) {
+        return fail("Contacts merged, but failed to save to file.");
+    }
+    return true;
+}
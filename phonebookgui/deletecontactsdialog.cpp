@@ -7,9 +7,11 @@
 #include <QPushButton>
 #include <QMessageBox>
 
+#include <set>
+#include <string_view>
 #include <vector>
 
-static QString qs(const std::string& s) { return QString::fromStdString(s); }
+static QString qs(std::string_view s) { return QString::fromUtf8(s.data(), static_cast<int>(s.size())); }
 
 DeleteContactsDialog::DeleteContactsDialog(PhoneBook* book, QWidget* parent)
     : QDialog(parent), m_book(book)
@@ -24,7 +26,7 @@ DeleteContactsDialog::DeleteContactsDialog(PhoneBook* book, QWidget* parent)
     m_table->setHorizontalHeaderLabels({"ID", "First", "Last", "Email", "Work phone"});
     m_table->horizontalHeader()->setStretchLastSection(true);
     m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
-    m_table->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_table->setSelectionMode(QAbstractItemView::ExtendedSelection);
     m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
     root->addWidget(m_table);
 
@@ -33,23 +35,39 @@ DeleteContactsDialog::DeleteContactsDialog(PhoneBook* book, QWidget* parent)
 
     m_btnDelete = new QPushButton("Delete Selected", this);
     m_btnRefresh = new QPushButton("Refresh", this);
+    m_btnUndo = new QPushButton("Undo", this);
+    m_btnRedo = new QPushButton("Redo", this);
     auto* closeBtn = new QPushButton("Close", this);
 
     bottom->addWidget(m_btnDelete);
     bottom->addWidget(m_btnRefresh);
+    bottom->addWidget(m_btnUndo);
+    bottom->addWidget(m_btnRedo);
     bottom->addStretch();
     bottom->addWidget(closeBtn);
 
     connect(closeBtn, &QPushButton::clicked, this, &QDialog::accept);
     connect(m_btnRefresh, &QPushButton::clicked, this, &DeleteContactsDialog::refreshTable);
+    connect(m_btnUndo, &QPushButton::clicked, this, &DeleteContactsDialog::undoLast);
+    connect(m_btnRedo, &QPushButton::clicked, this, &DeleteContactsDialog::redoLast);
     connect(m_btnDelete, &QPushButton::clicked, this, &DeleteContactsDialog::deleteSelected);
 
     connect(m_table, &QTableWidget::cellDoubleClicked, this, [this](int, int){ deleteSelected(); });
 
+    // Follow the book's changes instead of rebuilding after each one.
+    if (m_book) {
+        m_subscription = m_book->subscribe([this](const ContactChange& change) { applyChange(change); });
+    }
+
     resize(760, 420);
     refreshTable();
 }
 
+DeleteContactsDialog::~DeleteContactsDialog()
+{
+    if (m_book) m_book->unsubscribe(m_subscription);
+}
+
 void DeleteContactsDialog::refreshTable()
 {
     if (!m_book) {
@@ -57,29 +75,91 @@ void DeleteContactsDialog::refreshTable()
         return;
     }
 
-    std::vector<std::pair<unsigned int, Contact>> rows;
+    // Views into the book: the rows are built without copying contacts.
+    std::vector<std::pair<ContactId, const ContactRecord*>> rows;
     rows.reserve(m_book->mainStorage.size());
-    for (const auto& p : m_book->mainStorage) rows.push_back(p);
+    for (const auto& p : m_book->mainStorage) rows.emplace_back(p.first, &p.second);
 
+    m_table->clearContents();
     m_table->setRowCount(static_cast<int>(rows.size()));
+    m_idItems.clear();
+    m_idItems.reserve(static_cast<int>(rows.size()));
 
     for (int r = 0; r < static_cast<int>(rows.size()); ++r) {
-        const unsigned int id = rows[r].first;
-        const Contact& c = rows[r].second;
+        setRow(r, rows[r].first, *rows[r].second);
+    }
+
+    m_table->resizeColumnsToContents();
+    updateUndoButtons();
+}
+
+void DeleteContactsDialog::setRow(int row, ContactId id, const ContactView& c)
+{
+    auto set = [&](int col, const QString& text) {
+        if (auto* item = m_table->item(row, col)) item->setText(text);
+        else m_table->setItem(row, col, new QTableWidgetItem(text));
+    };
+
+    set(0, QString::number(id));
+    set(1, qs(c.firstName));
+    set(2, qs(c.lastName));
+    set(3, qs(c.email));
+    set(4, qs(c.numbers.number1));
+    m_idItems.insert(id, m_table->item(row, 0));
+}
 
-        auto set = [&](int col, const QString& text) {
-            auto* it = new QTableWidgetItem(text);
-            m_table->setItem(r, col, it);
-        };
+// One event, one row: O(change) instead of a rebuild of the whole table.
+void DeleteContactsDialog::applyChange(const ContactChange& change)
+{
+    if (change.kind == ContactChange::Kind::Reset) {
+        refreshTable();
+        return;
+    }
 
-        set(0, QString::number(id));
-        set(1, qs(c.firstName));
-        set(2, qs(c.lastName));
-        set(3, qs(c.email));
-        set(4, qs(c.numbers.number1));
+    QTableWidgetItem* idItem = m_idItems.value(change.id, nullptr);
+    if (change.kind == ContactChange::Kind::Removed) {
+        if (idItem) m_table->removeRow(idItem->row());
+        m_idItems.remove(change.id);
+    }
+    else if (change.kind == ContactChange::Kind::Inserted || idItem) {
+        const bool shown = change.touches(ContactField::FirstName) || change.touches(ContactField::LastName) ||
+                           change.touches(ContactField::Email) || change.touches(ContactField::WorkPhone);
+        auto it = m_book->mainStorage.find(change.id);
+        if (shown && it != m_book->mainStorage.end()) {
+            const int row = idItem ? idItem->row() : insertionRow(change.id);
+            if (!idItem) m_table->insertRow(row);
+            setRow(row, change.id, it->second);
+        }
     }
+    updateUndoButtons();
+}
 
-    m_table->resizeColumnsToContents();
+void DeleteContactsDialog::updateUndoButtons()
+{
+    m_btnUndo->setEnabled(m_book->can_undo());
+    m_btnRedo->setEnabled(m_book->can_redo());
+}
+
+// Rows are in storage order: new contacts go last.
+int DeleteContactsDialog::insertionRow(ContactId) const
+{
+    return m_table->rowCount();
+}
+
+void DeleteContactsDialog::undoLast()
+{
+    std::string err;
+    if (!m_book->undo(&err)) {
+        QMessageBox::warning(this, "Undo Failed", QString::fromStdString(err));
+    }
+}
+
+void DeleteContactsDialog::redoLast()
+{
+    std::string err;
+    if (!m_book->redo(&err)) {
+        QMessageBox::warning(this, "Redo Failed", QString::fromStdString(err));
+    }
 }
 
 void DeleteContactsDialog::deleteSelected()
@@ -90,40 +170,60 @@ void DeleteContactsDialog::deleteSelected()
         return;
     }
 
-    const int row = ranges.first().topRow();
-    auto* idItem = m_table->item(row, 0);
-    if (!idItem) return;
+    std::set<ContactId> ids;
+    for (const auto& range : ranges) {
+        for (int row = range.topRow(); row <= range.bottomRow(); ++row) {
+            auto* idItem = m_table->item(row, 0);
+            if (!idItem) continue;
 
-    bool ok = false;
-    const unsigned int id = idItem->text().toUInt(&ok);
-    if (!ok) return;
-
-    auto it = m_book->mainStorage.find(id);
-    if (it == m_book->mainStorage.end()) {
-        QMessageBox::warning(this, "Not Found", "The selected contact no longer exists.");
+            bool ok = false;
+            const ContactId id = idItem->text().toULongLong(&ok);
+            if (ok && m_book->mainStorage.find(id) != m_book->mainStorage.end()) ids.insert(id);
+        }
+    }
+    if (ids.empty()) {
+        QMessageBox::warning(this, "Not Found", "The selected contacts no longer exist.");
         refreshTable();
         return;
     }
 
-    const Contact& c = it->second;
-
-    const QString msg = QString("Delete this contact?\n\nID: %1\nName: %2 %3\nEmail: %4")
-                            .arg(id)
-                            .arg(qs(c.firstName))
-                            .arg(qs(c.lastName))
-                            .arg(qs(c.email));
+    QString msg;
+    if (ids.size() == 1) {
+        const ContactId id = *ids.begin();
+        const ContactView c = m_book->mainStorage.find(id)->second;
+        msg = QString("Delete this contact?\n\nID: %1\nName: %2 %3\nEmail: %4")
+                  .arg(id)
+                  .arg(qs(c.firstName))
+                  .arg(qs(c.lastName))
+                  .arg(qs(c.email));
+    }
+    else {
+        msg = QString("Delete %1 contacts?").arg(ids.size());
+    }
 
     if (QMessageBox::question(this, "Confirm Delete", msg,
                               QMessageBox::Yes | QMessageBox::No) != QMessageBox::Yes) {
         return;
     }
 
+    // All or nothing, saved once.
     std::string err;
-    if (!m_book->remove_contact(id, &err)) {
+    if (!m_book->begin_batch(&err)) {
+        QMessageBox::warning(this, "Delete Failed", QString::fromStdString(err));
+        return;
+    }
+    for (ContactId id : ids) {
+        if (!m_book->remove_contact(id, &err)) {
+            m_book->rollback_batch();
+            QMessageBox::warning(this, "Delete Failed", QString::fromStdString(err));
+            return;
+        }
+    }
+    if (!m_book->commit_batch(&err)) {
         QMessageBox::warning(this, "Delete Failed", QString::fromStdString(err));
         return;
     }
 
+    // The rows went with the commit's change events.
     QMessageBox::information(this, "Success", "Deletion Successful.");
-    refreshTable();
 }
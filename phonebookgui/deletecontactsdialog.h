@@ -3,9 +3,11 @@
 
 
 #include <QDialog>
+#include <QHash>
 #include "PhoneBookgui.h"
 
 class QTableWidget;
+class QTableWidgetItem;
 class QPushButton;
 
 class DeleteContactsDialog : public QDialog
@@ -13,16 +15,29 @@ class DeleteContactsDialog : public QDialog
     Q_OBJECT
 public:
     explicit DeleteContactsDialog(PhoneBook* book, QWidget* parent = nullptr);
+    ~DeleteContactsDialog() override;
 
 private slots:
     void refreshTable();
+    void undoLast();
+    void redoLast();
     void deleteSelected();
 
 private:
+    void applyChange(const ContactChange& change);
+    void setRow(int row, ContactId id, const ContactView& c);
+    void updateUndoButtons();
+    int insertionRow(ContactId id) const;
+
     PhoneBook* m_book;
+    unsigned int m_subscription = 0;
+    // Id cell of each contact's row; its row() follows inserts and removals.
+    QHash<ContactId, QTableWidgetItem*> m_idItems;
     QTableWidget* m_table;
     QPushButton* m_btnDelete;
     QPushButton* m_btnRefresh;
+    QPushButton* m_btnUndo;
+    QPushButton* m_btnRedo;
 };
 
 
@@ -0,0 +1,199 @@
+#include "duplicatesdialog.h"
+
+#include <QApplication>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QMessageBox>
+#include <QStringList>
+
+#include <string_view>
+
+static QString qs(std::string_view s) { return QString::fromUtf8(s.data(), static_cast<int>(s.size())); }
+
+static QString phonesOf(const ContactView& c)
+{
+    QStringList phones;
+    for (std::string_view phone : { c.numbers.number1, c.numbers.number2, c.numbers.number3 }) {
+        if (!phone.empty()) phones << qs(phone);
+    }
+    return phones.join(", ");
+}
+
+DuplicatesDialog::DuplicatesDialog(PhoneBook* book, QWidget* parent)
+    : QDialog(parent), m_book(book)
+{
+    setWindowTitle("Find Duplicates");
+    setModal(true);
+
+    auto* root = new QVBoxLayout(this);
+
+    auto* hint = new QLabel("Groups of contacts that look like the same person. "
+                            "The lowest ID is kept and filled in from the others. "
+                            "Double-click a row for details.", this);
+    hint->setWordWrap(true);
+    root->addWidget(hint);
+
+    m_table = new QTableWidget(this);
+    m_table->setColumnCount(6);
+    m_table->setHorizontalHeaderLabels({"Merge", "Keep ID", "Duplicate IDs", "Name", "Email", "Phones after merge"});
+    m_table->horizontalHeader()->setStretchLastSection(true);
+    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_table->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    root->addWidget(m_table);
+
+    m_status = new QLabel(this);
+    root->addWidget(m_status);
+
+    auto* bottom = new QHBoxLayout();
+    root->addLayout(bottom);
+
+    m_btnMerge = new QPushButton("Merge Checked", this);
+    auto* btnAll = new QPushButton("Check All", this);
+    auto* btnNone = new QPushButton("Check None", this);
+    auto* btnRescan = new QPushButton("Rescan", this);
+    auto* closeBtn = new QPushButton("Close", this);
+
+    bottom->addWidget(m_btnMerge);
+    bottom->addWidget(btnAll);
+    bottom->addWidget(btnNone);
+    bottom->addWidget(btnRescan);
+    bottom->addStretch();
+    bottom->addWidget(closeBtn);
+
+    connect(closeBtn, &QPushButton::clicked, this, &QDialog::accept);
+    connect(btnRescan, &QPushButton::clicked, this, &DuplicatesDialog::rescan);
+    connect(btnAll, &QPushButton::clicked, this, [this]{ setAllChecked(true); });
+    connect(btnNone, &QPushButton::clicked, this, [this]{ setAllChecked(false); });
+    connect(m_btnMerge, &QPushButton::clicked, this, &DuplicatesDialog::mergeChecked);
+    connect(m_table, &QTableWidget::cellDoubleClicked, this, [this](int row, int){ showDetails(row); });
+
+    resize(900, 480);
+    rescan();
+}
+
+void DuplicatesDialog::rescan()
+{
+    if (!m_book) {
+        QMessageBox::critical(this, "Error", "Internal error: PhoneBook is not available.");
+        return;
+    }
+
+    m_status->setText(QString("Scanning %1 contacts...").arg(m_book->mainStorage.size()));
+    qApp->processEvents(); // Update UI
+
+    m_proposals = findDuplicates(*m_book);
+
+    m_table->setRowCount(static_cast<int>(m_proposals.size()));
+    for (int r = 0; r < static_cast<int>(m_proposals.size()); ++r) {
+        const MergeProposal& p = m_proposals[r];
+
+        auto set = [&](int col, const QString& text) {
+            auto* it = new QTableWidgetItem(text);
+            m_table->setItem(r, col, it);
+        };
+
+        auto* check = new QTableWidgetItem(QString::number(p.score, 'f', 2));
+        check->setFlags(Qt::ItemIsUserCheckable | Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+        check->setCheckState(Qt::Checked);
+        m_table->setItem(r, 0, check);
+
+        QStringList ids;
+        for (ContactId id : p.duplicateIds) ids << QString::number(id);
+
+        set(1, QString::number(p.keepId));
+        set(2, ids.join(", "));
+        set(3, qs(p.merged.firstName) + " " + qs(p.merged.lastName));
+        set(4, qs(p.merged.email));
+        set(5, phonesOf(p.merged));
+    }
+    m_table->resizeColumnsToContents();
+
+    std::size_t removable = 0;
+    for (const MergeProposal& p : m_proposals) removable += p.duplicateIds.size();
+    m_status->setText(m_proposals.empty()
+                          ? QString("No likely duplicates found.")
+                          : QString("%1 group(s); merging all removes %2 contact(s). "
+                                    "The Merge column shows the similarity.")
+                                .arg(m_proposals.size()).arg(removable));
+    m_btnMerge->setEnabled(!m_proposals.empty());
+}
+
+void DuplicatesDialog::setAllChecked(bool checked)
+{
+    for (int r = 0; r < m_table->rowCount(); ++r) {
+        if (auto* it = m_table->item(r, 0)) it->setCheckState(checked ? Qt::Checked : Qt::Unchecked);
+    }
+}
+
+void DuplicatesDialog::showDetails(int row)
+{
+    if (row < 0 || row >= static_cast<int>(m_proposals.size())) return;
+    const MergeProposal& p = m_proposals[row];
+
+    auto describe = [this](ContactId id) {
+        auto it = m_book->mainStorage.find(id);
+        if (it == m_book->mainStorage.end()) return QString("ID %1: (no longer exists)").arg(id);
+        const ContactView c = it->second;
+        return QString("ID %1: %2 %3 <%4> %5")
+            .arg(id).arg(qs(c.firstName)).arg(qs(c.lastName)).arg(qs(c.email)).arg(phonesOf(c));
+    };
+
+    QString msg = "Keep " + describe(p.keepId) + "\n";
+    for (ContactId id : p.duplicateIds) msg += "Merge " + describe(id) + "\n";
+
+    const Contact& m = p.merged;
+    msg += QString("\nAfter merge:\nName: %1 %2 %3\nEmail: %4\nPhones: %5\nAddress: %6\nBirthday: %7")
+               .arg(qs(m.firstName)).arg(qs(m.middleName)).arg(qs(m.lastName))
+               .arg(qs(m.email)).arg(phonesOf(m)).arg(qs(m.address)).arg(qs(m.birthday));
+
+    if (!p.droppedPhones.empty()) {
+        QStringList dropped;
+        for (const std::string& phone : p.droppedPhones) dropped << qs(phone);
+        msg += "\n\nNo free phone slot for: " + dropped.join(", ");
+    }
+
+    QMessageBox::information(this, "Duplicate Group", msg);
+}
+
+void DuplicatesDialog::mergeChecked()
+{
+    std::vector<MergeProposal> accepted;
+    for (int r = 0; r < m_table->rowCount() && r < static_cast<int>(m_proposals.size()); ++r) {
+        auto* it = m_table->item(r, 0);
+        if (it && it->checkState() == Qt::Checked) accepted.push_back(m_proposals[r]);
+    }
+
+    if (accepted.empty()) {
+        QMessageBox::information(this, "Merge", "Check at least one group first.");
+        return;
+    }
+
+    const QString msg = QString("Merge %1 group(s)? The duplicate contacts will be deleted.")
+                            .arg(accepted.size());
+    if (QMessageBox::question(this, "Confirm Merge", msg,
+                              QMessageBox::Yes | QMessageBox::No) != QMessageBox::Yes) {
+        return;
+    }
+
+    std::size_t applied = 0;
+    std::string err;
+    if (!m_book->apply_merges(accepted, &applied, &err)) {
+        QMessageBox::warning(this, "Merge Failed", qs(err));
+        rescan();
+        return;
+    }
+
+    QString result = QString("Merged %1 group(s).").arg(applied);
+    if (applied < accepted.size()) {
+        result += QString("\n%1 group(s) skipped: their contacts changed since the scan, "
+                          "or the merged contact is no longer valid.")
+                      .arg(accepted.size() - applied);
+    }
+    QMessageBox::information(this, "Success", result);
+    rescan();
+}
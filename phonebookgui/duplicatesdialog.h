@@ -0,0 +1,34 @@
+#ifndef DUPLICATESDIALOG_H
+#define DUPLICATESDIALOG_H
+
+#include <QDialog>
+#include <vector>
+#include "PhoneBookgui.h"
+#include "Dedupgui.h"
+
+class QTableWidget;
+class QLabel;
+class QPushButton;
+
+class DuplicatesDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit DuplicatesDialog(PhoneBook* book, QWidget* parent = nullptr);
+
+private slots:
+    void rescan();
+    void setAllChecked(bool checked);
+    void showDetails(int row);
+    void mergeChecked();
+
+private:
+    PhoneBook* m_book;
+    std::vector<MergeProposal> m_proposals;   // one per table row
+
+    QTableWidget* m_table;
+    QLabel* m_status;
+    QPushButton* m_btnMerge;
+};
+
+#endif // DUPLICATESDIALOG_H
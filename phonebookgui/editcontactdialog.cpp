@@ -13,6 +13,8 @@
 #include <QPushButton>
 #include <QLabel>
 
+#include <utility>
+
 static std::string toStdTrimmed(const QString& s)
 {
     return s.trimmed().toStdString();
@@ -24,7 +26,7 @@ static std::string toStdEmailNormalized(QString s)
     return s.toStdString();
 }
 
-EditContactDialog::EditContactDialog(PhoneBook* book, unsigned int id, QWidget* parent)
+EditContactDialog::EditContactDialog(PhoneBook* book, ContactId id, QWidget* parent)
     : QDialog(parent), m_book(book), m_id(id)
 {
     setWindowTitle(QString("Edit Contact (ID: %1)").arg(id));
@@ -172,7 +174,7 @@ void EditContactDialog::onTryUpdate()
     }
 
     std::string err;
-    if (!m_book->update_contact(m_id, c, &err)) {
+    if (!m_book->update_contact(m_id, std::move(c), &err)) {
         QMessageBox::warning(this, "Update Failed", QString::fromStdString(err));
         return;
     }
@@ -16,7 +16,7 @@ class EditContactDialog : public QDialog
 {
     Q_OBJECT
 public:
-    explicit EditContactDialog(PhoneBook* book, unsigned int id, QWidget* parent = nullptr);
+    explicit EditContactDialog(PhoneBook* book, ContactId id, QWidget* parent = nullptr);
 
 private slots:
     void onTryUpdate();
@@ -25,7 +25,7 @@ private slots:
 
 private:
     PhoneBook* m_book;
-    unsigned int m_id;
+    ContactId m_id;
 
     QLineEdit* m_firstName;
     QLineEdit* m_middleName;
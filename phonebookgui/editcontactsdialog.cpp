@@ -8,10 +8,11 @@
 #include <QPushButton>
 #include <QMessageBox>
 
+#include <string_view>
 #include <vector>
 #include <algorithm>
 
-static QString qs(const std::string& s) { return QString::fromStdString(s); }
+static QString qs(std::string_view s) { return QString::fromUtf8(s.data(), static_cast<int>(s.size())); }
 
 EditContactsDialog::EditContactsDialog(PhoneBook* book, QWidget* parent)
     : QDialog(parent), m_book(book)
@@ -35,23 +36,39 @@ EditContactsDialog::EditContactsDialog(PhoneBook* book, QWidget* parent)
 
     m_btnEdit = new QPushButton("Edit Selected", this);
     m_btnRefresh = new QPushButton("Refresh", this);
+    m_btnUndo = new QPushButton("Undo", this);
+    m_btnRedo = new QPushButton("Redo", this);
     auto* closeBtn = new QPushButton("Close", this);
 
     bottom->addWidget(m_btnEdit);
     bottom->addWidget(m_btnRefresh);
+    bottom->addWidget(m_btnUndo);
+    bottom->addWidget(m_btnRedo);
     bottom->addStretch();
     bottom->addWidget(closeBtn);
 
     connect(closeBtn, &QPushButton::clicked, this, &QDialog::accept);
     connect(m_btnRefresh, &QPushButton::clicked, this, &EditContactsDialog::refreshTable);
+    connect(m_btnUndo, &QPushButton::clicked, this, &EditContactsDialog::undoLast);
+    connect(m_btnRedo, &QPushButton::clicked, this, &EditContactsDialog::redoLast);
     connect(m_btnEdit, &QPushButton::clicked, this, &EditContactsDialog::editSelected);
 
     connect(m_table, &QTableWidget::cellDoubleClicked, this, [this](int, int){ editSelected(); });
 
+    // Follow the book's changes instead of rebuilding after each one.
+    if (m_book) {
+        m_subscription = m_book->subscribe([this](const ContactChange& change) { applyChange(change); });
+    }
+
     resize(760, 420);
     refreshTable();
 }
 
+EditContactsDialog::~EditContactsDialog()
+{
+    if (m_book) m_book->unsubscribe(m_subscription);
+}
+
 void EditContactsDialog::refreshTable()
 {
     if (!m_book) {
@@ -59,31 +76,100 @@ void EditContactsDialog::refreshTable()
         return;
     }
 
-    std::vector<std::pair<unsigned int, Contact>> rows;
+    // Views into the book: the rows are built without copying contacts.
+    std::vector<std::pair<ContactId, const ContactRecord*>> rows;
     rows.reserve(m_book->mainStorage.size());
-    for (const auto& p : m_book->mainStorage) rows.push_back(p);
+    for (const auto& p : m_book->mainStorage) rows.emplace_back(p.first, &p.second);
 
     std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b){ return a.first < b.first; });
 
+    m_table->clearContents();
     m_table->setRowCount(static_cast<int>(rows.size()));
+    m_idItems.clear();
+    m_idItems.reserve(static_cast<int>(rows.size()));
 
     for (int r = 0; r < static_cast<int>(rows.size()); ++r) {
-        const unsigned int id = rows[r].first;
-        const Contact& c = rows[r].second;
-
-        auto set = [&](int col, const QString& text) {
-            auto* it = new QTableWidgetItem(text);
-            m_table->setItem(r, col, it);
-        };
-
-        set(0, QString::number(id));
-        set(1, qs(c.firstName));
-        set(2, qs(c.lastName));
-        set(3, qs(c.email));
-        set(4, qs(c.numbers.number1));
+        setRow(r, rows[r].first, *rows[r].second);
     }
 
     m_table->resizeColumnsToContents();
+    updateUndoButtons();
+}
+
+void EditContactsDialog::setRow(int row, ContactId id, const ContactView& c)
+{
+    auto set = [&](int col, const QString& text) {
+        if (auto* item = m_table->item(row, col)) item->setText(text);
+        else m_table->setItem(row, col, new QTableWidgetItem(text));
+    };
+
+    set(0, QString::number(id));
+    set(1, qs(c.firstName));
+    set(2, qs(c.lastName));
+    set(3, qs(c.email));
+    set(4, qs(c.numbers.number1));
+    m_idItems.insert(id, m_table->item(row, 0));
+}
+
+// One event, one row: O(change) instead of a rebuild of the whole table.
+void EditContactsDialog::applyChange(const ContactChange& change)
+{
+    if (change.kind == ContactChange::Kind::Reset) {
+        refreshTable();
+        return;
+    }
+
+    QTableWidgetItem* idItem = m_idItems.value(change.id, nullptr);
+    if (change.kind == ContactChange::Kind::Removed) {
+        if (idItem) m_table->removeRow(idItem->row());
+        m_idItems.remove(change.id);
+    }
+    else if (change.kind == ContactChange::Kind::Inserted || idItem) {
+        const bool shown = change.touches(ContactField::FirstName) || change.touches(ContactField::LastName) ||
+                           change.touches(ContactField::Email) || change.touches(ContactField::WorkPhone);
+        auto it = m_book->mainStorage.find(change.id);
+        if (shown && it != m_book->mainStorage.end()) {
+            const int row = idItem ? idItem->row() : insertionRow(change.id);
+            if (!idItem) m_table->insertRow(row);
+            setRow(row, change.id, it->second);
+        }
+    }
+    updateUndoButtons();
+}
+
+void EditContactsDialog::updateUndoButtons()
+{
+    m_btnUndo->setEnabled(m_book->can_undo());
+    m_btnRedo->setEnabled(m_book->can_redo());
+}
+
+// Rows are in id order: binary search for a new id's place.
+int EditContactsDialog::insertionRow(ContactId id) const
+{
+    int lo = 0, hi = m_table->rowCount();
+    while (lo < hi) {
+        const int mid = (lo + hi) / 2;
+        const QTableWidgetItem* item = m_table->item(mid, 0);
+        if (item && item->text().toULongLong() < id) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+void EditContactsDialog::undoLast()
+{
+    std::string err;
+    if (!m_book->undo(&err)) {
+        QMessageBox::warning(this, "Undo Failed", QString::fromStdString(err));
+    }
+}
+
+void EditContactsDialog::redoLast()
+{
+    std::string err;
+    if (!m_book->redo(&err)) {
+        QMessageBox::warning(this, "Redo Failed", QString::fromStdString(err));
+    }
 }
 
 void EditContactsDialog::editSelected()
@@ -99,11 +185,10 @@ void EditContactsDialog::editSelected()
     if (!idItem) return;
 
     bool ok = false;
-    const unsigned int id = idItem->text().toUInt(&ok);
+    const ContactId id = idItem->text().toULongLong(&ok);
     if (!ok) return;
 
+    // The row follows the edit through the change feed.
     EditContactDialog dlg(m_book, id, this);
-    if (dlg.exec() == QDialog::Accepted) {
-        refreshTable();
-    }
+    dlg.exec();
 }
@@ -2,9 +2,11 @@
 #define EDITCONTACTSDIALOG_H
 
 #include <QDialog>
+#include <QHash>
 #include "PhoneBookgui.h"
 
 class QTableWidget;
+class QTableWidgetItem;
 class QPushButton;
 
 class EditContactsDialog : public QDialog
@@ -12,16 +14,29 @@ class EditContactsDialog : public QDialog
     Q_OBJECT
 public:
     explicit EditContactsDialog(PhoneBook* book, QWidget* parent = nullptr);
+    ~EditContactsDialog() override;
 
 private slots:
     void refreshTable();
+    void undoLast();
+    void redoLast();
     void editSelected();
 
 private:
+    void applyChange(const ContactChange& change);
+    void setRow(int row, ContactId id, const ContactView& c);
+    void updateUndoButtons();
+    int insertionRow(ContactId id) const;
+
     PhoneBook* m_book;
+    unsigned int m_subscription = 0;
+    // Id cell of each contact's row; its row() follows inserts and removals.
+    QHash<ContactId, QTableWidgetItem*> m_idItems;
     QTableWidget* m_table;
     QPushButton* m_btnEdit;
     QPushButton* m_btnRefresh;
+    QPushButton* m_btnUndo;
+    QPushButton* m_btnRedo;
 };
 
 #endif // EDITCONTACTSDIALOG_H
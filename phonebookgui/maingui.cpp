@@ -1,4 +1,5 @@
 #include "mainwindow.h"
+#include "PhoneFormatsgui.h"
 #include <QSqlDatabase>
 #include <QDebug>
 #include <QApplication>
@@ -11,6 +12,14 @@ int main(int argc, char *argv[])
 {
     qDebug() << "Available drivers:" << QSqlDatabase::drivers();
     QApplication a(argc, argv);
+
+    std::string formatsError;
+    const QString formatsFile = QCoreApplication::applicationDirPath() + "/phone_formats.txt";
+    if (!loadPhoneFormats(formatsFile.toStdString(), &formatsError)) {
+        QMessageBox::warning(nullptr, "Phone formats",
+            QString::fromStdString(formatsError) + "\nUsing the built-in phone formats.");
+    }
+
     MainWindow w;
     w.show();
     return a.exec();
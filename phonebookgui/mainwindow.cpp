@@ -7,6 +7,7 @@
 #include "deletecontactsdialog.h"
 #include "searchcontactsdialog.h"
 #include "editcontactsdialog.h"
+#include "duplicatesdialog.h"
 
 
 MainWindow::MainWindow(QWidget *parent)
@@ -58,6 +59,11 @@ void MainWindow::on_btnSort_clicked()
     ViewContactsDialog dlg(&m_book, this);
     dlg.exec();
 }
+void MainWindow::on_btnDuplicates_clicked()
+{
+    DuplicatesDialog dlg(&m_book, this);
+    dlg.exec();
+}
 void MainWindow::on_btnMigration_clicked()
 {
     MigrationDialog dlg(this);
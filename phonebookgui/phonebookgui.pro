@@ -12,29 +12,52 @@ SOURCES += \
     DatabaseManager.cpp \
     MigrationDialog.cpp \
     actionwindow.cpp \
+    addressindexgui.cpp \
     checkersgui.cpp \
     contactdetailsdialog.cpp \
     contactgui.cpp \
+    contactrecordgui.cpp \
     createcontactdialog.cpp \
+    dedupgui.cpp \
     definitionsgui.cpp \
     deletecontactsdialog.cpp \
+    duplicatesdialog.cpp \
     editcontactdialog.cpp \
     editcontactsdialog.cpp \
+    idallocatorgui.cpp \
     maingui.cpp \
     mainwindow.cpp \
+    paginggui.cpp \
+    phoneformatsgui.cpp \
+    querygui.cpp \
     searchcontactsdialog.cpp \
+    undologgui.cpp \
     viewcontactsdialog.cpp
 
 HEADERS += \
     Checkersgui.h \
     Contactgui.h \
+    ContactRecordgui.h \
+    FlatHashMapgui.h \
+    IdAllocatorgui.h \
+    BloomFiltergui.h \
+    ChangeFeedgui.h \
+    AddressIndexgui.h \
+    OrderedIndexgui.h \
+    Paginggui.h \
+    ParallelSortgui.h \
+    Dedupgui.h \
     DatabaseManager.h \
     MigrationDialog.h \
     PhoneBookgui.h \
+    PhoneFormatsgui.h \
+    Querygui.h \
+    UndoLoggui.h \
     actionwindow.h \
     contactdetailsdialog.h \
     createcontactdialog.h \
     deletecontactsdialog.h \
+    duplicatesdialog.h \
     editcontactdialog.h \
     editcontactsdialog.h \
     mainwindow.h \
@@ -50,4 +73,5 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 !isEmpty(target.path): INSTALLS += target
 
 DISTFILES += \
+    phone_formats.txt \
     schema.sql
@@ -14,7 +14,7 @@ CREATE SEQUENCE contacts_id_seq START 1;
 -- CONTACTS TABLE
 -- =====================================================
 CREATE TABLE contacts (
-    id INTEGER PRIMARY KEY DEFAULT nextval('contacts_id_seq'),
+    id BIGINT PRIMARY KEY DEFAULT nextval('contacts_id_seq'),
     first_name VARCHAR(100) NOT NULL,
     middle_name VARCHAR(100),
     last_name VARCHAR(100) NOT NULL,
@@ -34,15 +34,17 @@ CREATE TABLE contacts (
 -- PHONES TABLE (One-to-Many relationship)
 -- =====================================================
 CREATE TABLE phones (
-    id SERIAL PRIMARY KEY,
-    contact_id INTEGER NOT NULL REFERENCES contacts(id) ON DELETE CASCADE,
+    id BIGSERIAL PRIMARY KEY,
+    contact_id BIGINT NOT NULL REFERENCES contacts(id) ON DELETE CASCADE,
     phone_type VARCHAR(20) NOT NULL, -- 'work', 'home', 'office'
     phone_number VARCHAR(30) NOT NULL,
     
     -- Constraints
     CONSTRAINT chk_phone_type CHECK (phone_type IN ('work', 'home', 'office')),
+    -- Exact formats are configurable (phone_formats.txt) and enforced by
+    -- the application; the database only guards the character set.
     CONSTRAINT chk_phone_format CHECK (
-        phone_number ~ '^(\+7|8)(\d{10}|\(\d{3}\)\d{7}|\(\d{3}\)\d{3}-\d{2}-\d{2})$'
+        phone_number ~ '^[0-9+()./-]+$'
     ),
     CONSTRAINT unq_contact_phone UNIQUE (contact_id, phone_type)
 );
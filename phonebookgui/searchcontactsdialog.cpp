@@ -1,5 +1,6 @@
 #include "searchcontactsdialog.h"
 #include "contactdetailsdialog.h"
+#include "Querygui.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -11,22 +12,19 @@
 #include <QLabel>
 #include <QTableWidget>
 #include <QHeaderView>
+#include <QStringList>
 #include <QMessageBox>
 
+#include <string_view>
 #include <vector>
 #include <algorithm>
+#include <cmath>
+#include <unordered_map>
 
-static QString qs(const std::string& s) { return QString::fromStdString(s); }
+static QString qs(std::string_view s) { return QString::fromUtf8(s.data(), static_cast<int>(s.size())); }
 
-static bool matchText(const QString& field,
-                      const QString& needle,
-                      bool exact,
-                      Qt::CaseSensitivity cs)
-{
-    if (needle.isEmpty()) return true;              // no filter
-    if (exact) return field.compare(needle, cs) == 0;
-    return field.contains(needle, cs);
-}
+// Ranked address matches shown when the address is the only filter.
+static constexpr std::size_t kAddressResults = 100;
 
 SearchContactsDialog::SearchContactsDialog(PhoneBook* book, QWidget* parent)
     : QDialog(parent), m_book(book)
@@ -48,14 +46,19 @@ SearchContactsDialog::SearchContactsDialog(PhoneBook* book, QWidget* parent)
     m_email     = new QLineEdit(this);
     m_phoneAny  = new QLineEdit(this);
     m_address   = new QLineEdit(this);
+    m_domain    = new QComboBox(this);
 
     m_phoneAny->setPlaceholderText("Matches work/home/office");
+    m_address->setPlaceholderText("Words, best matches first (Contains mode)");
+    m_domain->setEditable(true);
+    m_domain->setInsertPolicy(QComboBox::NoInsert);
 
     form->addRow("First name:", m_firstName);
     form->addRow("Last name:",  m_lastName);
     form->addRow("Email:",      m_email);
     form->addRow("Phone (any):",m_phoneAny);
     form->addRow("Address:",    m_address);
+    form->addRow("Email domain:", m_domain);
 
     auto* options = new QVBoxLayout();
     filtersBox->addLayout(options);
@@ -92,8 +95,8 @@ SearchContactsDialog::SearchContactsDialog(PhoneBook* book, QWidget* parent)
 
     // Results table
     m_table = new QTableWidget(this);
-    m_table->setColumnCount(6);
-    m_table->setHorizontalHeaderLabels({"ID", "First", "Last", "Email", "Phone", "Address"});
+    m_table->setColumnCount(7);
+    m_table->setHorizontalHeaderLabels({"ID", "First", "Last", "Email", "Phone", "Address", "Relevance"});
     m_table->horizontalHeader()->setStretchLastSection(true);
     m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
     m_table->setSelectionMode(QAbstractItemView::SingleSelection);
@@ -108,12 +111,24 @@ SearchContactsDialog::SearchContactsDialog(PhoneBook* book, QWidget* parent)
 
     connect(m_table, &QTableWidget::cellDoubleClicked, this, [this](int, int){ viewSelected(); });
 
+    // Follow the book's changes instead of searching again after each one.
+    if (m_book) {
+        m_subscription = m_book->subscribe([this](const ContactChange& change) { applyChange(change); });
+    }
+
     resize(980, 560);
 
+    refreshDomains();
+
     // Optional: show all results initially
     runSearch();
 }
 
+SearchContactsDialog::~SearchContactsDialog()
+{
+    if (m_book) m_book->unsubscribe(m_subscription);
+}
+
 void SearchContactsDialog::clearFilters()
 {
     m_firstName->clear();
@@ -121,12 +136,27 @@ void SearchContactsDialog::clearFilters()
     m_email->clear();
     m_phoneAny->clear();
     m_address->clear();
+    refreshDomains();
     m_matchMode->setCurrentIndex(0);
     m_caseSensitive->setChecked(false);
 
     runSearch();
 }
 
+// "(any)" first, then every domain by number of contacts. The item text
+// shows the count; the item data is the domain itself.
+void SearchContactsDialog::refreshDomains()
+{
+    m_domain->clear();
+    m_domain->addItem("(any)", QString());
+    if (!m_book) return;
+
+    for (const auto& entry : m_book->domain_counts()) {
+        m_domain->addItem(QString("%1 (%2)").arg(qs(entry.first)).arg(entry.second), qs(entry.first));
+    }
+    m_domain->setCurrentIndex(0);
+}
+
 void SearchContactsDialog::runSearch()
 {
     if (!m_book) {
@@ -145,76 +175,180 @@ void SearchContactsDialog::runSearch()
     const QString ph = m_phoneAny->text().trimmed();
     const QString ad = m_address->text().trimmed();
 
-    std::vector<std::pair<unsigned int, Contact>> hits;
-    hits.reserve(m_book->mainStorage.size());
-
-    for (const auto& p : m_book->mainStorage) {
-        const unsigned int id = p.first;
-        const Contact& c = p.second;
-
-        const QString cFirst = qs(c.firstName).trimmed();
-        const QString cLast  = qs(c.lastName).trimmed();
-        const QString cEmail = qs(c.email).trimmed();
-        const QString cAddr  = qs(c.address).trimmed();
-
-        const QString w = qs(c.numbers.number1).trimmed();
-        const QString h = qs(c.numbers.number2).trimmed();
-        const QString o = qs(c.numbers.number3).trimmed();
-
-        bool ok = true;
-
-        ok = ok && matchText(cFirst, fn, exact, cs);
-        ok = ok && matchText(cLast,  ln, exact, cs);
-        ok = ok && matchText(cEmail, em, exact, cs);
-        ok = ok && matchText(cAddr,  ad, exact, cs);
-
-        if (!ph.isEmpty()) {
-            const bool phoneOk =
-                matchText(w, ph, exact, cs) ||
-                matchText(h, ph, exact, cs) ||
-                matchText(o, ph, exact, cs);
-            ok = ok && phoneOk;
+    // A picked entry carries its domain; typed text is the domain.
+    QString dom = m_domain->currentText().trimmed();
+    const int domIndex = m_domain->findText(dom);
+    if (domIndex >= 0) dom = m_domain->itemData(domIndex).toString();
+
+    // One conjunction of the filters that are set; the engine drives it
+    // from the most selective index and checks the rest.
+    const QueryMatch mode = exact ? QueryMatch::Exact : QueryMatch::Contains;
+    std::vector<QueryPredicate> filters;
+    auto addFilter = [&](QueryField field, QueryMatch match, const QString& value) {
+        if (!value.isEmpty()) filters.push_back({ field, match, value.toStdString(), std::string() });
+    };
+    addFilter(QueryField::FirstName, mode, fn);
+    addFilter(QueryField::LastName,  mode, ln);
+    addFilter(QueryField::Email,     mode, em);
+    addFilter(QueryField::AnyPhone,  mode, ph);
+    addFilter(QueryField::EmailDomain, QueryMatch::Exact, dom);
+
+    // In Contains mode the address is matched by words through the
+    // full-text index and the results are ranked by BM25. Alone it keeps
+    // the best kAddressResults.
+    const bool ranked = !ad.isEmpty() && !exact;
+    addFilter(QueryField::Address, ranked ? QueryMatch::Words : QueryMatch::Exact, ad);
+
+    Query query;
+    query.anyOf.push_back(filters);
+    query.caseSensitive = (cs == Qt::CaseSensitive);
+
+    QueryStats stats;
+    std::vector<ContactId> ids = runQuery(*m_book, query, &stats);
+
+    const bool otherFilters =
+        !fn.isEmpty() || !ln.isEmpty() || !em.isEmpty() || !ph.isEmpty() || !dom.isEmpty();
+
+    std::unordered_map<ContactId, double> relevance;
+    if (ranked) {
+        const std::string words = ad.toStdString();
+        relevance.reserve(ids.size());
+        for (ContactId id : ids) relevance[id] = m_book->addressIndex.score(words, id);
+
+        if (!otherFilters && ids.size() > kAddressResults) {
+            std::partial_sort(ids.begin(), ids.begin() + kAddressResults, ids.end(),
+                              [&](ContactId a, ContactId b) {
+                                  const double sa = relevance[a], sb = relevance[b];
+                                  return sa != sb ? sa > sb : a < b;
+                              });
+            ids.resize(kAddressResults);
         }
+    }
 
-        if (ok) hits.push_back({id, c});
+    std::vector<std::pair<ContactId, ContactView>> hits;
+    hits.reserve(ids.size());
+    for (ContactId id : ids) {
+        ContactView c;
+        if (m_book->find_contact(id, &c)) hits.emplace_back(id, c);
     }
 
     // deterministic ordering by ID
     std::sort(hits.begin(), hits.end(), [](const auto& a, const auto& b){ return a.first < b.first; });
 
+    m_query = query;
+    m_ranked = ranked;
+    m_words = ranked ? ad.toStdString() : std::string();
+    m_capped = ranked && !otherFilters;
+
+    // Rows are placed by index; sorting while filling would move them.
+    m_table->setSortingEnabled(false);
+    m_table->clearContents();
     m_table->setRowCount(static_cast<int>(hits.size()));
+    m_idItems.clear();
 
     for (int r = 0; r < static_cast<int>(hits.size()); ++r) {
-        const unsigned int id = hits[r].first;
-        const Contact& c = hits[r].second;
-
-        auto set = [&](int col, const QString& text) {
-            auto* it = new QTableWidgetItem(text);
-            m_table->setItem(r, col, it);
-        };
-
-        set(0, QString::number(id));
-        set(1, qs(c.firstName));
-        set(2, qs(c.lastName));
-        set(3, qs(c.email));
-
-        // Show one “best” phone for the row (first non-empty)
-        QString phoneShown = qs(c.numbers.number1);
-        if (phoneShown.trimmed().isEmpty()) phoneShown = qs(c.numbers.number2);
-        if (phoneShown.trimmed().isEmpty()) phoneShown = qs(c.numbers.number3);
-        set(4, phoneShown);
-
-        set(5, qs(c.address));
+        const ContactId id = hits[r].first;
+        setRow(r, id, hits[r].second, ranked ? relevance[id] : 0.0);
     }
 
+    m_table->setSortingEnabled(true);
+    if (ranked) m_table->sortItems(6, Qt::DescendingOrder);
+    else m_table->sortItems(0, Qt::AscendingOrder);
+
     m_table->resizeColumnsToContents();
 
-    const bool anyFilter =
-        !fn.isEmpty() || !ln.isEmpty() || !em.isEmpty() || !ph.isEmpty() || !ad.isEmpty();
+    const bool anyFilter = otherFilters || !ad.isEmpty();
+
+    m_note.clear();
+    if (!anyFilter) m_note = " (no filters applied; showing all)";
+    else if (ranked && !otherFilters) m_note = QString(" (best %1 address matches)").arg(kAddressResults);
+    showMatchCount();
+
+    // How the engine answered, for the curious.
+    QStringList plan;
+    for (const std::string& step : stats.plan) plan << qs(step);
+    m_status->setToolTip(QString("%1\nChecked %2 contact(s)").arg(plan.join("\n")).arg(stats.examined));
+}
+
+void SearchContactsDialog::setRow(int row, ContactId id, const ContactView& c, double relevance)
+{
+    // Called with sorting off, so the row stays put while it is written.
+    auto set = [&](int col, const QString& text) {
+        auto* it = new QTableWidgetItem(text);
+        m_table->setItem(row, col, it);
+    };
+
+    auto* idItem = new QTableWidgetItem();
+    idItem->setData(Qt::DisplayRole, static_cast<qulonglong>(id));
+    m_table->setItem(row, 0, idItem);
+    set(1, qs(c.firstName));
+    set(2, qs(c.lastName));
+    set(3, qs(c.email));
+
+    // Show one “best” phone for the row (first non-empty)
+    QString phoneShown = qs(c.numbers.number1);
+    if (phoneShown.trimmed().isEmpty()) phoneShown = qs(c.numbers.number2);
+    if (phoneShown.trimmed().isEmpty()) phoneShown = qs(c.numbers.number3);
+    set(4, phoneShown);
+
+    set(5, qs(c.address));
+
+    // Numeric data (as for the ID), so the column sorts by value.
+    auto* score = new QTableWidgetItem();
+    if (m_ranked) score->setData(Qt::DisplayRole, std::round(relevance * 100.0) / 100.0);
+    m_table->setItem(row, 6, score);
+
+    m_idItems.insert(id, idItem);
+}
+
+void SearchContactsDialog::showMatchCount()
+{
+    m_status->setText(QString("Matches: %1%2").arg(m_table->rowCount()).arg(m_note));
+}
+
+// Whether the contact passes the search shown: all predicates of one
+// conjunction, as runQuery() checks its candidates.
+bool SearchContactsDialog::matches(ContactId id, const ContactView& c) const
+{
+    for (const std::vector<QueryPredicate>& conjunction : m_query.anyOf) {
+        bool all = true;
+        for (const QueryPredicate& predicate : conjunction) {
+            all = all && matchesPredicate(c, id, predicate, m_query.caseSensitive);
+        }
+        if (all) return true;
+    }
+    return false;
+}
+
+// The changed contact alone is checked against the search: its row is
+// added, rewritten or dropped, O(change). A capped address ranking
+// searches again, since one change can move the cut.
+void SearchContactsDialog::applyChange(const ContactChange& change)
+{
+    if (change.kind == ContactChange::Kind::Reset || m_capped) {
+        runSearch();
+        return;
+    }
+
+    m_table->setSortingEnabled(false);
+
+    QTableWidgetItem* idItem = m_idItems.value(change.id, nullptr);
+    auto it = m_book->mainStorage.find(change.id);
+    const bool keep = it != m_book->mainStorage.end() && matches(change.id, it->second);
+
+    if (keep) {
+        const int row = idItem ? idItem->row() : m_table->rowCount();
+        if (!idItem) m_table->insertRow(row);
+        const double relevance = m_ranked ? m_book->addressIndex.score(m_words, change.id) : 0.0;
+        setRow(row, change.id, it->second, relevance);
+    }
+    else if (idItem) {
+        m_table->removeRow(idItem->row());
+        m_idItems.remove(change.id);
+    }
 
-    m_status->setText(QString("Matches: %1%2")
-                          .arg(hits.size())
-                          .arg(anyFilter ? "" : " (no filters applied; showing all)"));
+    m_table->setSortingEnabled(true);   // re-sorts by the column chosen
+    showMatchCount();
 }
 
 void SearchContactsDialog::viewSelected()
@@ -230,7 +364,7 @@ void SearchContactsDialog::viewSelected()
     if (!idItem) return;
 
     bool ok = false;
-    const unsigned int id = idItem->text().toUInt(&ok);
+    const ContactId id = idItem->text().toULongLong(&ok);
     if (!ok) return;
 
     auto it = m_book->mainStorage.find(id);
@@ -2,12 +2,17 @@
 #define SEARCHCONTACTSDIALOG_H
 
 #include <QDialog>
+#include <QHash>
+#include <QString>
+#include <string>
 #include "PhoneBookgui.h"
+#include "Querygui.h"
 
 class QLineEdit;
 class QComboBox;
 class QCheckBox;
 class QTableWidget;
+class QTableWidgetItem;
 class QLabel;
 class QPushButton;
 
@@ -16,14 +21,30 @@ class SearchContactsDialog : public QDialog
     Q_OBJECT
 public:
     explicit SearchContactsDialog(PhoneBook* book, QWidget* parent = nullptr);
+    ~SearchContactsDialog() override;
 
 private slots:
     void runSearch();
     void clearFilters();
     void viewSelected();
+    void refreshDomains();
 
 private:
+    void setRow(int row, ContactId id, const ContactView& c, double relevance);
+    void applyChange(const ContactChange& change);
+    bool matches(ContactId id, const ContactView& c) const;
+    void showMatchCount();
+
     PhoneBook* m_book;
+    unsigned int m_subscription = 0;
+
+    // The search shown, so a change is checked against it alone.
+    Query m_query;
+    bool m_ranked = false;   // address words: a relevance column
+    std::string m_words;     // ... ranked by these
+    bool m_capped = false;   // best kAddressResults only: any change may reorder the cut
+    QString m_note;
+    QHash<ContactId, QTableWidgetItem*> m_idItems;
 
     // Filters
     QLineEdit* m_firstName;
@@ -31,6 +52,7 @@ private:
     QLineEdit* m_email;
     QLineEdit* m_phoneAny;   // checks work/home/office
     QLineEdit* m_address;
+    QComboBox* m_domain;     // editable; lists every domain with its count
 
     QComboBox* m_matchMode;  // Contains / Exact
     QCheckBox* m_caseSensitive;
@@ -10,10 +10,11 @@
 #include <QLabel>
 #include <QMessageBox>
 
+#include <string_view>
 #include <vector>
 #include <algorithm>
 
-static QString qs(const std::string& s) { return QString::fromStdString(s); }
+static QString qs(std::string_view s) { return QString::fromUtf8(s.data(), static_cast<int>(s.size())); }
 
 ViewContactsDialog::ViewContactsDialog(PhoneBook* book, QWidget* parent)
     : QDialog(parent), m_book(book)
@@ -72,6 +73,11 @@ ViewContactsDialog::ViewContactsDialog(PhoneBook* book, QWidget* parent)
     m_btnViewSelected = new QPushButton("View Selected", this);
     bottom->addWidget(m_btnViewSelected);
 
+    m_btnPrevPage = new QPushButton("< Previous", this);
+    m_btnNextPage = new QPushButton("Next >", this);
+    bottom->addWidget(m_btnPrevPage);
+    bottom->addWidget(m_btnNextPage);
+
     auto* closeBtn = new QPushButton("Close", this);
     bottom->addWidget(closeBtn);
     bottom->addStretch();
@@ -80,84 +86,193 @@ ViewContactsDialog::ViewContactsDialog(PhoneBook* book, QWidget* parent)
     connect(m_btnRefresh, &QPushButton::clicked, this, &ViewContactsDialog::refreshTable);
     connect(m_btnApplySort, &QPushButton::clicked, this, &ViewContactsDialog::applySortAndRefresh);
     connect(m_btnViewSelected, &QPushButton::clicked, this, &ViewContactsDialog::viewSelected);
+    connect(m_btnPrevPage, &QPushButton::clicked, this, &ViewContactsDialog::previousPage);
+    connect(m_btnNextPage, &QPushButton::clicked, this, &ViewContactsDialog::nextPage);
 
     // Double-click row to view details
     connect(m_table, &QTableWidget::cellDoubleClicked, this, [this](int, int){ viewSelected(); });
 
+    // Follow the book's changes instead of re-reading it after each one.
+    if (m_book) {
+        m_subscription = m_book->subscribe([this](const ContactChange& change) { applyChange(change); });
+    }
+
     resize(980, 520);
     refreshTable();
 }
 
+ViewContactsDialog::~ViewContactsDialog()
+{
+    if (m_book) m_book->unsubscribe(m_subscription);
+}
+
 void ViewContactsDialog::applySortAndRefresh()
 {
     refreshTable();
 }
 
+// Back to the first page of the chosen ordering.
 void ViewContactsDialog::refreshTable()
+{
+    m_cursors.assign(1, std::string());
+
+    // Email has no ordered index, so every page would scan the whole
+    // book: sort it once (in parallel) and page through that snapshot,
+    // with offsets into it as the cursors.
+    m_order.clear();
+    m_snapshot = m_book && static_cast<SortField>(m_sortField->currentIndex()) == SortField::Email;
+    if (m_snapshot) m_order = m_book->sorted_ids(SortKey::Email, m_sortOrder->currentIndex() == 1);
+
+    loadPage();
+}
+
+void ViewContactsDialog::nextPage()
+{
+    if (m_nextCursor.empty()) return;
+    m_cursors.push_back(m_nextCursor);
+    loadPage();
+}
+
+void ViewContactsDialog::previousPage()
+{
+    if (m_cursors.size() < 2) return;
+    m_cursors.pop_back();
+    loadPage();
+}
+
+// Only the rows of one page are fetched and built, whatever the book size.
+void ViewContactsDialog::loadPage()
 {
     if (!m_book) {
         QMessageBox::critical(this, "Error", "Internal error: PhoneBook is not available.");
         return;
     }
 
-    // Copy unordered_map into sortable vector
-    std::vector<std::pair<unsigned int, Contact>> rows;
-    rows.reserve(m_book->mainStorage.size());
-    for (const auto& p : m_book->mainStorage) {
-        rows.push_back(p);
+    PageRequest request;
+    switch (static_cast<SortField>(m_sortField->currentIndex())) {
+    case SortField::FirstName: request.key = SortKey::FirstName; break;
+    case SortField::LastName:  request.key = SortKey::LastName; break;
+    case SortField::Email:     request.key = SortKey::Email; break;
+    default:                   request.key = SortKey::Id; break;
     }
-
-    const int fieldIdx = m_sortField->currentIndex();
-    const bool desc = (m_sortOrder->currentIndex() == 1);
-
-    auto cmp = [&](const auto& a, const auto& b) {
-        const unsigned int ida = a.first, idb = b.first;
-        const Contact& ca = a.second;
-        const Contact& cb = b.second;
-
-        auto lessStr = [&](const std::string& sa, const std::string& sb) {
-            // Simple lexical comparison; can be improved later (case-insensitive).
-            return sa < sb;
-        };
-
-        bool res = false;
-        switch (fieldIdx) {
-        case 0: res = ida < idb; break;
-        case 1: res = lessStr(ca.firstName, cb.firstName); break;
-        case 2: res = lessStr(ca.lastName, cb.lastName); break;
-        case 3: res = lessStr(ca.email, cb.email); break;
-        default: res = ida < idb; break;
+    request.descending = (m_sortOrder->currentIndex() == 1);
+    request.pageSize = kPageSize;
+    request.cursor = m_cursors.back();
+
+    Page page;
+    std::string error;
+    if (m_snapshot) {
+        const std::size_t begin = std::min<std::size_t>(
+            m_order.size(), m_cursors.back().empty() ? 0 : std::stoul(m_cursors.back()));
+        const std::size_t end = std::min(m_order.size(), begin + kPageSize);
+        page.ids.assign(m_order.begin() + begin, m_order.begin() + end);
+        if (end < m_order.size()) page.nextCursor = std::to_string(end);
+    }
+    else if (!m_book->page(request, &page, &error)) {
+        // The ordering changed under a stale cursor: start over.
+        if (m_cursors.size() > 1) {
+            refreshTable();
+            return;
         }
-        return desc ? !res : res;
+        QMessageBox::warning(this, "View Contacts", QString::fromStdString(error));
+        return;
+    }
+    m_nextCursor = page.nextCursor;
+
+    m_table->clearContents();
+    m_table->setRowCount(static_cast<int>(page.ids.size()));
+    m_idItems.clear();
+
+    int r = 0;
+    for (ContactId id : page.ids) {
+        auto found = m_book->mainStorage.find(id);
+        if (found == m_book->mainStorage.end()) continue;
+        setRow(r++, id, found->second);
+    }
+    m_table->setRowCount(r);
+
+    const std::size_t first = (m_cursors.size() - 1) * kPageSize;
+    m_countLabel->setText(r == 0 ? QString("Count: %1").arg(m_book->mainStorage.size())
+                                 : QString("%1-%2 of %3")
+                                       .arg(first + 1)
+                                       .arg(first + static_cast<std::size_t>(r))
+                                       .arg(m_book->mainStorage.size()));
+    m_btnPrevPage->setEnabled(m_cursors.size() > 1);
+    m_btnNextPage->setEnabled(!m_nextCursor.empty());
+    m_table->resizeColumnsToContents();
+}
+
+void ViewContactsDialog::setRow(int row, ContactId id, const ContactView& c)
+{
+    auto set = [&](int col, const QString& text) {
+        if (auto* item = m_table->item(row, col)) item->setText(text);
+        else m_table->setItem(row, col, new QTableWidgetItem(text));
     };
 
-    std::sort(rows.begin(), rows.end(), cmp);
-
-    m_table->setRowCount(static_cast<int>(rows.size()));
-
-    for (int r = 0; r < static_cast<int>(rows.size()); ++r) {
-        const unsigned int id = rows[r].first;
-        const Contact& c = rows[r].second;
-
-        auto set = [&](int col, const QString& text) {
-            auto* it = new QTableWidgetItem(text);
-            m_table->setItem(r, col, it);
-        };
-
-        set(0, QString::number(id));
-        set(1, qs(c.firstName));
-        set(2, qs(c.middleName));
-        set(3, qs(c.lastName));
-        set(4, qs(c.email));
-        set(5, qs(c.numbers.number1));
-        set(6, qs(c.numbers.number2));
-        set(7, qs(c.numbers.number3));
-        set(8, qs(c.address));
-        set(9, qs(c.birthday));
+    set(0, QString::number(id));
+    set(1, qs(c.firstName));
+    set(2, qs(c.middleName));
+    set(3, qs(c.lastName));
+    set(4, qs(c.email));
+    set(5, qs(c.numbers.number1));
+    set(6, qs(c.numbers.number2));
+    set(7, qs(c.numbers.number3));
+    set(8, qs(c.address));
+    set(9, qs(c.birthday));
+    m_idItems.insert(id, m_table->item(row, 0));
+}
+
+// An edit that keeps the row's place rewrites that row; anything that
+// can move rows (insert, remove, a changed sort key) reloads the page
+// shown, O(page), never the book.
+void ViewContactsDialog::applyChange(const ContactChange& change)
+{
+    if (change.kind == ContactChange::Kind::Reset) {
+        refreshTable();
+        return;
     }
 
-    m_countLabel->setText(QString("Count: %1").arg(rows.size()));
-    m_table->resizeColumnsToContents();
+    bool moves = change.kind != ContactChange::Kind::Updated;
+    switch (static_cast<SortField>(m_sortField->currentIndex())) {
+    case SortField::FirstName: moves = moves || change.touches(ContactField::FirstName); break;
+    case SortField::LastName:  moves = moves || change.touches(ContactField::LastName); break;
+    case SortField::Email:     moves = moves || change.touches(ContactField::Email); break;
+    default: break;
+    }
+
+    if (moves) {
+        if (m_snapshot) placeInOrder(change.id);
+        loadPage();
+        return;
+    }
+
+    QTableWidgetItem* idItem = m_idItems.value(change.id, nullptr);
+    auto it = m_book->mainStorage.find(change.id);
+    if (idItem && it != m_book->mainStorage.end()) setRow(idItem->row(), change.id, it->second);
+}
+
+// Keeps the email snapshot sorted: `id` leaves it, and goes back in at
+// its binary-searched place if it still exists.
+void ViewContactsDialog::placeInOrder(ContactId id)
+{
+    auto old = std::find(m_order.begin(), m_order.end(), id);
+    if (old != m_order.end()) m_order.erase(old);
+
+    auto it = m_book->mainStorage.find(id);
+    if (it == m_book->mainStorage.end()) return;
+
+    // sorted_ids() order: by key then id, reversed when descending.
+    const bool descending = m_sortOrder->currentIndex() == 1;
+    const std::string key = pageSortKey(it->second, SortKey::Email);
+    auto before = [&](ContactId other) {
+        auto found = m_book->mainStorage.find(other);
+        if (found == m_book->mainStorage.end()) return true;   // stale; anywhere will do
+        const std::string otherKey = pageSortKey(found->second, SortKey::Email);
+        const bool less = otherKey != key ? otherKey < key : other < id;
+        return descending ? !less : less;
+    };
+    auto pos = std::partition_point(m_order.begin(), m_order.end(), before);
+    m_order.insert(pos, id);
 }
 
 void ViewContactsDialog::viewSelected()
@@ -173,13 +288,13 @@ void ViewContactsDialog::viewSelected()
     if (!idItem) return;
 
     bool ok = false;
-    const unsigned int id = idItem->text().toUInt(&ok);
+    const ContactId id = idItem->text().toULongLong(&ok);
     if (!ok) return;
 
     auto it = m_book->mainStorage.find(id);
     if (it == m_book->mainStorage.end()) {
         QMessageBox::warning(this, "Not Found", "The selected contact no longer exists.");
-        refreshTable();
+        loadPage();
         return;
     }
 
@@ -2,9 +2,13 @@
 #define VIEWCONTACTSDIALOG_H
 
 #include <QDialog>
+#include <QHash>
+#include <string>
+#include <vector>
 #include "PhoneBookgui.h"
 
 class QTableWidget;
+class QTableWidgetItem;
 class QComboBox;
 class QPushButton;
 class QLabel;
@@ -14,17 +18,39 @@ class ViewContactsDialog : public QDialog
     Q_OBJECT
 public:
     explicit ViewContactsDialog(PhoneBook* book, QWidget* parent = nullptr);
+    ~ViewContactsDialog() override;
 
 private slots:
     void refreshTable();
     void applySortAndRefresh();
     void viewSelected();
+    void nextPage();
+    void previousPage();
 
 private:
     enum class SortField { Id, FirstName, LastName, Email };
 
+    static constexpr std::size_t kPageSize = 200;
+
     PhoneBook* m_book;
 
+    // m_cursors[i] fetches page i; the last entry is the page shown.
+    std::vector<std::string> m_cursors;
+    std::string m_nextCursor;
+    // Whole ordering for a key without an index (email), sorted once per
+    // refresh; rows deleted since are skipped.
+    bool m_snapshot = false;
+    std::vector<ContactId> m_order;
+
+    void loadPage();
+    void setRow(int row, ContactId id, const ContactView& c);
+    void applyChange(const ContactChange& change);
+    void placeInOrder(ContactId id);
+
+    unsigned int m_subscription = 0;
+    // Id cell of each row on the page.
+    QHash<ContactId, QTableWidgetItem*> m_idItems;
+
     QTableWidget* m_table;
     QComboBox* m_sortField;
     QComboBox* m_sortOrder;
@@ -33,6 +59,8 @@ private:
     QPushButton* m_btnRefresh;
     QPushButton* m_btnApplySort;
     QPushButton* m_btnViewSelected;
+    QPushButton* m_btnPrevPage;
+    QPushButton* m_btnNextPage;
 };
 
 #endif // VIEWCONTACTSDIALOG_H